@@ -13,6 +13,7 @@
 #include "../Misc/Allocator.h"
 #include "../Synth/Portamento.h"
 #include "../Synth/SynthNote.h"
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <iostream>
@@ -369,6 +370,14 @@ int NotePool::getRunningVoices(void) const
     return running_count;
 }
 
+float NotePool::getAmplitude(NoteDescriptor &d)
+{
+    float amplitude = 0.0f;
+    for(auto &s:activeNotes(d))
+        amplitude = std::max(amplitude, s.note->getAmplitude());
+    return amplitude;
+}
+
 // Silence one voice, trying to the select the one that will be the least
 // intrusive, preferably preferred_note if possible..
 void NotePool::limitVoice(int preferred_note)
@@ -142,6 +142,8 @@ class NotePool
         int getRunningNotes(void) const;
         void enforceKeyLimit(int limit);
         int getRunningVoices(void) const;
+        //Loudest current envelope amplitude of the synths of a note
+        float getAmplitude(NoteDescriptor &d);
         void enforceVoiceLimit(int limit, int preferred_note);
         void limitVoice(int preferred_note);
 
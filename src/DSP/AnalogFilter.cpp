@@ -65,6 +65,7 @@ void AnalogFilter::cleanup()
         history[i].y2 = 0.0f;
         oldHistory[i] = history[i];
     }
+    memset(stereoHistory, 0, sizeof(stereoHistory));
 }
 
 AnalogFilter::Coeff AnalogFilter::computeCoeff(int type, float cutoff, float q,
@@ -430,9 +431,53 @@ void AnalogFilter::filterout(float *smp)
         smp[i] *= outgain;
 }
 
+void AnalogFilter::filterout(float *l, float *r)
+{
+    float freqbuf[freqbufsize];
+    BiquadCoeff sections[MAX_FILTER_STAGES + 1];
+
+    if ( freq_smoothing.apply( freqbuf, freqbufsize, freq ) )
+    {
+        /* in transition, all stages share the coefficients of each block */
+        for(int j = 0; j < freqbufsize; ++j)
+        {
+            computefiltercoefs(freqbuf[j], q);
+            for(int i = 0; i < stages + 1; ++i)
+                sections[i] = {coeff.c[0], coeff.c[1], coeff.c[2],
+                               coeff.d[1], coeff.d[2]};
+            stereoBiquadCascade(sections, nullptr, stereoHistory, stages + 1,
+                                &l[j*8], &r[j*8], 8);
+        }
+        recompute = false;
+    }
+    else
+    {
+        if ( recompute )
+        {
+            computefiltercoefs(freq, q);
+            recompute = false;
+        }
+        for(int i = 0; i < stages + 1; ++i)
+            sections[i] = {coeff.c[0], coeff.c[1], coeff.c[2],
+                           coeff.d[1], coeff.d[2]};
+        stereoBiquadCascade(sections, nullptr, stereoHistory, stages + 1,
+                            l, r, buffersize);
+    }
+
+    for(int i = 0; i < buffersize; ++i) {
+        l[i] *= outgain;
+        r[i] *= outgain;
+    }
+}
+
 float AnalogFilter::H(float freq)
 {
-    float fr = freq / samplerate_f * PI * 2.0f;
+    return H(coeff, stages, freq, samplerate_f);
+}
+
+float AnalogFilter::H(const Coeff &coeff, int stages, float freq, float fs)
+{
+    float fr = freq / fs * PI * 2.0f;
     float x  = coeff.c[0], y = 0.0f;
     for(int n = 1; n < 3; ++n) {
         x += cosf(n * fr) * coeff.c[n];
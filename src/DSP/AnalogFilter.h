@@ -19,6 +19,7 @@
 #include "../globals.h"
 #include "Filter.h"
 #include "Value_Smoothing_Filter.h"
+#include "BiquadCascade.h"
 
 namespace zyn {
 
@@ -32,6 +33,8 @@ class AnalogFilter:public Filter
                      unsigned char Fstages, unsigned int srate, int bufsize);
         ~AnalogFilter();
         void filterout(float *smp);
+        //Filter both channels with the same coefficients
+        void filterout(float *l, float *r);
         void setfreq(float frequency);
         void setfreq_and_q(float frequency, float q_);
         void setq(float q_);
@@ -51,12 +54,15 @@ class AnalogFilter:public Filter
 
         static Coeff computeCoeff(int type, float cutoff, float q, int stages,
                 float gain, float fs, int &order);
+        //Response of stages+1 cascaded sections with the given coefficients
+        static float H(const Coeff &coeff, int stages, float freq, float fs);
 
     private:
         struct fstage {
             float x1, x2; //Input History
             float y1, y2; //Output History
         } history[MAX_FILTER_STAGES + 1], oldHistory[MAX_FILTER_STAGES + 1];
+        StereoBiquadHistory stereoHistory[MAX_FILTER_STAGES + 1];
 
         //old coeffs are used for interpolation when parameters change quickly
 
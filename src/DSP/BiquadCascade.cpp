@@ -0,0 +1,60 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BiquadCascade.cpp - Stereo linked cascade of biquad sections
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include "BiquadCascade.h"
+
+namespace zyn {
+
+static inline void section(const BiquadCoeff &c, StereoBiquadHistory &h,
+                           float x[2])
+{
+    for(int ch = 0; ch < 2; ++ch) {
+        const float y = x[ch] * c.c0 + h.x1[ch] * c.c1 + h.x2[ch] * c.c2
+                        + h.y1[ch] * c.d1 + h.y2[ch] * c.d2;
+        h.x2[ch] = h.x1[ch];
+        h.x1[ch] = x[ch];
+        h.y2[ch] = h.y1[ch];
+        h.y1[ch] = y;
+        x[ch]    = y;
+    }
+}
+
+void stereoBiquadCascade(BiquadCoeff *coeff, const BiquadCoeff *delta,
+                         StereoBiquadHistory *hist, int sections,
+                         float *l, float *r, int nsamples)
+{
+    if(delta) {
+        for(int i = 0; i < nsamples; ++i) {
+            float x[2] = {l[i], r[i]};
+            for(int j = 0; j < sections; ++j) {
+                section(coeff[j], hist[j], x);
+                coeff[j].c0 += delta[j].c0;
+                coeff[j].c1 += delta[j].c1;
+                coeff[j].c2 += delta[j].c2;
+                coeff[j].d1 += delta[j].d1;
+                coeff[j].d2 += delta[j].d2;
+            }
+            l[i] = x[0];
+            r[i] = x[1];
+        }
+        return;
+    }
+
+    for(int i = 0; i < nsamples; ++i) {
+        float x[2] = {l[i], r[i]};
+        for(int j = 0; j < sections; ++j)
+            section(coeff[j], hist[j], x);
+        l[i] = x[0];
+        r[i] = x[1];
+    }
+}
+
+}
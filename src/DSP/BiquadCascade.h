@@ -0,0 +1,47 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BiquadCascade.h - Stereo linked cascade of biquad sections
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef BIQUAD_CASCADE_H
+#define BIQUAD_CASCADE_H
+
+namespace zyn {
+
+//Coefficients of one section
+//y = c0*x + c1*x1 + c2*x2 + d1*y1 + d2*y2 (first order sections use c2=d2=0)
+struct BiquadCoeff {
+    float c0, c1, c2, d1, d2;
+};
+
+//History of one section for both channels, left in [0] and right in [1]
+struct StereoBiquadHistory {
+    float x1[2], x2[2]; //Input History
+    float y1[2], y2[2]; //Output History
+};
+
+/**
+ * Filters the left and right channel in place with a cascade of sections.
+ *
+ * Both channels share the coefficients, so they are kept side by side and
+ * all sections are applied to every sample in a single pass over the buffer.
+ *
+ * @param coeff    coefficients of each section
+ * @param delta    per sample increment of the coefficients or nullptr;
+ *                 if set, coeff is advanced over the buffer
+ * @param hist     history of each section
+ * @param sections number of sections in the cascade
+ */
+void stereoBiquadCascade(BiquadCoeff *coeff, const BiquadCoeff *delta,
+                         StereoBiquadHistory *hist, int sections,
+                         float *l, float *r, int nsamples);
+
+}
+
+#endif
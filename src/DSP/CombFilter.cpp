@@ -16,12 +16,10 @@ CombFilter::CombFilter(Allocator *alloc, unsigned char Ftype, float Ffreq, float
     unsigned int srate, int bufsize)
     :Filter(srate, bufsize), gain(1.0f), q(Fq), type(Ftype), memory(*alloc)
 {
-    //worst case: looking back from smps[0] at 25Hz using higher order interpolation
-    mem_size = (int)ceilf((float)samplerate/25.0) + buffersize + 2; // 2178 at 48000Hz and 256Samples
-    input = (float*)memory.alloc_mem(mem_size*sizeof(float));
-    output = (float*)memory.alloc_mem(mem_size*sizeof(float));
-    memset(input, 0, mem_size*sizeof(float));
-    memset(output, 0, mem_size*sizeof(float));
+    //worst case: looking back at 25Hz using higher order interpolation
+    int mem_size = (int)ceilf((float)samplerate/25.0) + 2;
+    input = memory.alloc<DelayLine<float>>(memory, mem_size);
+    output = memory.alloc<DelayLine<float>>(memory, mem_size);
 
     setfreq_and_q(Ffreq, q);
     settype(type);
@@ -42,34 +40,22 @@ inline float CombFilter::tanhX(const float x)
     return (x*(105.0f+10.0f*x2)/(105.0f+(45.0f+x2)*x2)); //
 }
 
-inline float CombFilter::sampleLerp(float *smp, float pos) {
-    int poshi = (int)pos; // integer part (pos >= 0)
-    float poslo = pos - (float) poshi; // decimal part
-    // linear interpolation between samples
-    return smp[poshi] + poslo * (smp[poshi+1]-smp[poshi]); 
-}
-
 void CombFilter::filterout(float *smp)
 {
-    // shift the buffer content to the left
-    memmove(&input[0], &input[buffersize], (mem_size-buffersize)*sizeof(float));
-    // copy new input samples to the right end of the buffer
-    memcpy(&input[mem_size-buffersize], smp, buffersize*sizeof(float));
     for (int i = 0; i < buffersize; i ++)
     {
-        // calculate the feedback sample positions in the buffer
-        float pos = float(mem_size-buffersize+i)-delay;
+        // the feedback samples of both buffers are delay samples old
+        const float fwd = input->linear(delay);
+        const float bwd = output->linear(delay);
+        // copy new sample to input buffer
+        input->write(smp[i]);
         // add the fwd and bwd feedback samples to current sample
-        smp[i] = smp[i]*gain + tanhX(
-            gainfwd * sampleLerp( input, pos) - 
-            gainbwd * sampleLerp(output, pos)); 
+        smp[i] = smp[i]*gain + tanhX(gainfwd * fwd - gainbwd * bwd);
         // copy new sample to output buffer
-        output[mem_size-buffersize+i] = smp[i];
+        output->write(smp[i]);
         // apply output gain
         smp[i] *= outgain;
     }
-    // shift the buffer content one buffersize to the left
-    memmove(&output[0], &output[buffersize], (mem_size-buffersize)*sizeof(float));
 }
 
 void CombFilter::setfreq_and_q(float freq, float q)
@@ -81,7 +67,9 @@ void CombFilter::setfreq_and_q(float freq, float q)
 void CombFilter::setfreq(float freq)
 {
     float ff = limit(freq, 25.0f, 40000.0f);
-    delay = ((float)samplerate)/ff;
+    //at low sample rates high frequencies would ask for less than the one
+    //sample the delay lines can interpolate from
+    delay = fmaxf(((float)samplerate)/ff, 1.0f);
 }
 
 void CombFilter::setq(float q_)
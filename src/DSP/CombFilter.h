@@ -12,6 +12,7 @@
 */
 
 #pragma once
+#include "DelayLine.h"
 #include "Filter.h"
 #include "Value_Smoothing_Filter.h"
 
@@ -33,8 +34,8 @@ class CombFilter:public Filter
 
     private:
     
-        float* input;
-        float* output;
+        DelayLine<float> *input;
+        DelayLine<float> *output;
         float gain;
         float q;
         unsigned char type;
@@ -42,14 +43,12 @@ class CombFilter:public Filter
         float step(float x);
 
         float tanhX(const float x);
-        float sampleLerp(float *smp, float pos);
 
         float gainfwd;
         float gainbwd;
         float delay;        
         
         Allocator &memory;
-        int mem_size;
 
 };
 
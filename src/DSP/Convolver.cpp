@@ -0,0 +1,315 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Convolver.cpp - Partitioned FFT convolution
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include "Convolver.h"
+#include "FFTwrapper.h"
+#include "../Misc/Denormals.h"
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+namespace zyn {
+
+PartitionedConvolution::PartitionedConvolution(int channels_,
+        const float *const *ir, int len, int blocksize_)
+    :blocksize(blocksize_),
+      partitions(len > blocksize_ ? (len + blocksize_ - 1) / blocksize_ : 1),
+      channels(channels_),
+      bins(blocksize_ + 1),
+      stride((bins + 1) & ~1),
+      fft(FFTwrapper::acquire(2 * blocksize_)),
+      irspectra(new fft_t[channels_ * partitions * stride]),
+      fdl(new fft_t[channels_ * partitions * stride]),
+      history(new float[channels_ * 2 * blocksize_]),
+      fdlpos(0),
+      smps(new float[2 * blocksize_]),
+      scratch(new float[2 * blocksize_]),
+      acc(new fft_t[2 * blocksize_ + 1])
+{
+    //Each partition is zero padded to the FFT size and scaled by the inverse
+    //FFT normalization
+    const float norm = 1.0f / (2 * blocksize);
+    for(int c = 0; c < channels; ++c)
+        for(int p = 0; p < partitions; ++p) {
+            memset(smps, 0, 2 * blocksize * sizeof(float));
+            for(int i = 0; i < blocksize && p * blocksize + i < len; ++i)
+                smps[i] = ir[c][p * blocksize + i] * norm;
+            fft->smps2freqs(fft->allocSampleBuf(smps),
+                            fft->allocFreqBuf(irspectra + (c * partitions + p) * stride),
+                            fft->allocSampleBuf(scratch));
+        }
+    cleanup();
+}
+
+PartitionedConvolution::~PartitionedConvolution()
+{
+    FFTwrapper::release(fft);
+    delete[] irspectra;
+    delete[] fdl;
+    delete[] history;
+    delete[] smps;
+    delete[] scratch;
+    delete[] acc;
+}
+
+void PartitionedConvolution::cleanup(void)
+{
+    memset((void *)fdl, 0, channels * partitions * stride * sizeof(fft_t));
+    memset(history, 0, channels * 2 * blocksize * sizeof(float));
+    fdlpos = 0;
+}
+
+//acc += a * b
+void PartitionedConvolution::mac(const fft_t *a, const fft_t *b,
+                                 fft_t *acc) const
+{
+    const float *x = (const float *)a;
+    const float *y = (const float *)b;
+    float       *z = (float *)acc;
+    for(int i = 0; i < 2 * bins; i += 2) {
+        z[i]     += x[i] * y[i] - x[i + 1] * y[i + 1];
+        z[i + 1] += x[i] * y[i + 1] + x[i + 1] * y[i];
+    }
+}
+
+void PartitionedConvolution::process(const float *const *in,
+                                     float *const *out)
+{
+    for(int c = 0; c < channels; ++c) {
+        //overlap-save input of the previous and the current block
+        float *h = history + c * 2 * blocksize;
+        memcpy(h, h + blocksize, blocksize * sizeof(float));
+        memcpy(h + blocksize, in[c], blocksize * sizeof(float));
+
+        fft_t *spectra = fdl + c * partitions * stride;
+        fft->smps2freqs(fft->allocSampleBuf(h),
+                        fft->allocFreqBuf(spectra + fdlpos * stride),
+                        fft->allocSampleBuf(scratch));
+
+        //partition p filters the input from p blocks ago
+        memset((void *)acc, 0, bins * sizeof(fft_t));
+        const fft_t *ir = irspectra + c * partitions * stride;
+        for(int p = 0, pos = fdlpos; p < partitions; ++p) {
+            mac(ir + p * stride, spectra + pos * stride, acc);
+            if(--pos < 0)
+                pos = partitions - 1;
+        }
+
+        //freqs2smps() drops the nyquist bin, which is added back here
+        const float nyquist = acc[blocksize].real();
+        fft->freqs2smps_noconst_input(fft->allocFreqBuf(acc),
+                                      fft->allocSampleBuf(smps));
+        for(int i = 0; i < blocksize; ++i)
+            out[c][i] = smps[blocksize + i]
+                        + ((blocksize + i) & 1 ? -nyquist : nyquist);
+    }
+    if(++fdlpos >= partitions)
+        fdlpos = 0;
+}
+
+Convolver::Convolver(int channels_, const float *const *ir, int len,
+                     int bufsize_, bool threaded_)
+    :channels(channels_), length(len), bufsize(bufsize_), tail(NULL),
+      tailpos(0), block(0), inready(false), outready(false), stalled(false),
+      resettail(false), jobwrite(0), jobread(0), threaded(threaded_),
+      quit(false)
+{
+    for(int i = 0; i < slots; ++i) {
+        tailin[i]  = NULL;
+        tailout[i] = NULL;
+    }
+
+    //Pick the tail partition size with the least multiply-adds per sample.
+    //The head has to cover delay tail partitions, as the output of one tail
+    //block is only played delay blocks after its input has started.
+    int tailblock = 0;
+    int best      = (len + bufsize - 1) / bufsize;
+    for(int size = 4 * bufsize; delay * size < len; size *= 2) {
+        const int cost = delay * size / bufsize + (len - size - 1) / size;
+        if(cost < best) {
+            best      = cost;
+            tailblock = size;
+        }
+    }
+
+    const int headlen = tailblock ? delay * tailblock : len;
+    head = new PartitionedConvolution(channels, ir, headlen, bufsize);
+    if(!tailblock)
+        return;
+
+    std::vector<const float *> segment(channels);
+    for(int c = 0; c < channels; ++c)
+        segment[c] = ir[c] + headlen;
+    tail = new PartitionedConvolution(channels, segment.data(),
+                                      len - headlen, tailblock);
+    for(int i = 0; i < slots; ++i) {
+        tailin[i]  = new float[channels * tailblock];
+        tailout[i] = new float[channels * tailblock];
+        queued[i]  = -1;
+        reset[i]   = false;
+        finished[i].store(-1);
+    }
+    cleanup();
+
+    if(threaded) {
+        work.init(0, 0);
+        try {
+            thread = std::thread(&Convolver::tailthread, this);
+        } catch(std::system_error &) {
+            threaded = false;
+        }
+    }
+}
+
+Convolver::~Convolver()
+{
+    if(thread.joinable()) {
+        quit = true;
+        work.post();
+        thread.join();
+    }
+    delete head;
+    delete tail;
+    for(int i = 0; i < slots; ++i) {
+        delete[] tailin[i];
+        delete[] tailout[i];
+    }
+}
+
+//If the tail thread is done with the last job of the slot
+bool Convolver::slotfree(int slot) const
+{
+    return queued[slot] < 0
+           || finished[slot].load(std::memory_order_acquire) == queued[slot];
+}
+
+bool Convolver::idle(void) const
+{
+    for(int i = 0; i < slots; ++i)
+        if(!slotfree(i))
+            return false;
+    return true;
+}
+
+//Jobs which are still running finish in the background. Skipping the block
+//numbers keeps their output from being played, and the tail history is
+//cleaned up by the tail thread before the next job.
+void Convolver::cleanup(void)
+{
+    head->cleanup();
+    if(!tail)
+        return;
+    tailpos   = 0;
+    block    += slots;
+    resettail = true;
+}
+
+void Convolver::drain(void)
+{
+    if(!tail)
+        return;
+    while(!idle())
+        std::this_thread::yield();
+}
+
+void Convolver::tailjob(int job)
+{
+    const int   size = tail->blocksize;
+    const int   slot = job % slots;
+    const float *in[channels];
+    float       *out[channels];
+    for(int c = 0; c < channels; ++c) {
+        in[c]  = tailin[slot] + c * size;
+        out[c] = tailout[slot] + c * size;
+    }
+    if(reset[slot])
+        tail->cleanup();
+    tail->process(in, out);
+    finished[slot].store(job, std::memory_order_release);
+}
+
+void Convolver::tailthread(void)
+{
+    DenormalGuard flush;
+    while(true) {
+        work.wait();
+        if(quit)
+            break;
+        tailjob(jobs[jobread]);
+        jobread = (jobread + 1) % slots;
+    }
+}
+
+/*
+ * Tail block j is collected in slot j % slots and its job is queued once it
+ * is complete. The output is played during block j + delay, so the job has
+ * delay - 1 blocks to finish. If it has not finished by then, the block is
+ * played without its tail. If the slot for the input of a block is still in
+ * use, the tail thread is more than a block late; the input is then dropped
+ * until the tail thread has caught up, which restarts the tail.
+ */
+void Convolver::beginblock(void)
+{
+    const int out = block - delay;
+    outready = out >= 0
+               && finished[out % slots].load(std::memory_order_acquire) == out;
+
+    if(!stalled && !slotfree(block % slots))
+        stalled = true;
+    if(stalled && idle()) {
+        stalled   = false;
+        resettail = true;
+    }
+    inready = !stalled;
+}
+
+void Convolver::process(const float *const *in, float *const *out)
+{
+    head->process(in, out);
+    if(!tail)
+        return;
+
+    const int size = tail->blocksize;
+    if(tailpos == 0)
+        beginblock();
+    for(int c = 0; c < channels; ++c) {
+        if(outready) {
+            const float *t = tailout[(block - delay) % slots] + c * size
+                             + tailpos;
+            for(int i = 0; i < bufsize; ++i)
+                out[c][i] += t[i];
+        }
+        if(inready)
+            memcpy(tailin[block % slots] + c * size + tailpos, in[c],
+                   bufsize * sizeof(float));
+    }
+
+    tailpos += bufsize;
+    if(tailpos < size)
+        return;
+    tailpos = 0;
+
+    if(inready) {
+        const int slot = block % slots;
+        queued[slot] = block;
+        reset[slot]  = resettail;
+        resettail    = false;
+        if(threaded) {
+            jobs[jobwrite] = block;
+            jobwrite       = (jobwrite + 1) % slots;
+            work.post();
+        } else
+            tailjob(block);
+    }
+    block++;
+}
+
+}
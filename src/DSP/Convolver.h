@@ -0,0 +1,140 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Convolver.h - Partitioned FFT convolution
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <atomic>
+#include <thread>
+#include "../globals.h"
+#include "../Nio/ZynSema.h"
+
+namespace zyn {
+
+class FFTwrapper;
+
+/**
+ * Uniformly partitioned overlap-save convolution of one impulse response
+ * segment, with a frequency domain delay line of the input spectra
+ */
+class PartitionedConvolution
+{
+    public:
+        /**
+         * @param channels   number of independent channels
+         * @param ir         impulse response of each channel
+         * @param len        samples of the segment
+         * @param blocksize  samples per partition and per process() call
+         */
+        PartitionedConvolution(int channels, const float *const *ir, int len,
+                               int blocksize);
+        ~PartitionedConvolution();
+
+        //Convolve one block of each channel
+        void process(const float *const *in, float *const *out) REALTIME;
+        void cleanup(void) REALTIME;
+
+        const int blocksize;
+        const int partitions;
+    private:
+        void mac(const fft_t *a, const fft_t *b, fft_t *acc) const;
+
+        const int   channels;
+        const int   bins;   //blocksize + 1 bins of a 2 * blocksize FFT
+        //bins rounded up to an even number, so each spectrum is as aligned
+        //as the arrays fftw planned with and may be its output directly
+        const int   stride;
+        FFTwrapper *fft;
+        fft_t      *irspectra; //[channels][partitions][stride]
+        fft_t      *fdl;       //[channels][partitions][stride], ring of inputs
+        float      *history;   //[channels][2 * blocksize]
+        int         fdlpos;
+
+        float *smps, *scratch;
+        fft_t *acc;
+};
+
+/**
+ * Convolution with a long impulse response at a low latency
+ *
+ * The impulse response is split into a head, which is convolved within the
+ * audio buffer using partitions of the buffer size, and a tail with larger
+ * partitions. The tail of one block of input is only needed delay - 1 blocks
+ * later, so it is computed by a background thread while the head is processed
+ * in the realtime thread. The realtime thread never waits for it: a tail block
+ * which is not ready in time is dropped (silent) instead.
+ */
+class Convolver
+{
+    public:
+        /**
+         * @param channels number of independent channels
+         * @param ir       impulse response of each channel
+         * @param len      samples of the impulse responses
+         * @param bufsize  samples per process() call
+         * @param threaded compute the tail in a background thread
+         */
+        Convolver(int channels, const float *const *ir, int len, int bufsize,
+                  bool threaded = true) NONREALTIME;
+        ~Convolver() NONREALTIME;
+
+        //Convolve one buffer of each channel
+        void process(const float *const *in, float *const *out) REALTIME;
+        void cleanup(void) REALTIME;
+        //Wait until the background thread has completed all tail blocks, for
+        //offline rendering. Call it from the thread which calls process().
+        void drain(void) NONREALTIME;
+
+        //Partition sizes of head and tail (0 without a tail)
+        int headsize(void) const { return head->blocksize; }
+        int tailsize(void) const { return tail ? tail->blocksize : 0; }
+
+        const int channels;
+        const int length;
+
+        //tail blocks between the input of a tail block and its output
+        static const int delay = 3;
+    private:
+        static const int slots = delay + 1;
+
+        void tailjob(int job);
+        void tailthread(void);
+        void beginblock(void) REALTIME;
+        bool slotfree(int slot) const REALTIME;
+        bool idle(void) const REALTIME;
+
+        const int bufsize;
+        PartitionedConvolution *head;
+        PartitionedConvolution *tail;
+
+        //tail input and output of each job, see process()
+        float *tailin[slots], *tailout[slots];
+        int    tailpos;
+        int    block;
+        bool   inready, outready;
+        bool   stalled;    //the tail thread has fallen behind
+        bool   resettail;  //the next job cleans up the tail first
+
+        int              queued[slots]; //last job of each slot, -1 for none
+        bool             reset[slots];  //if the job of the slot cleans up
+        std::atomic<int> finished[slots];
+        int              jobs[slots];   //ring of jobs for the tail thread
+        int              jobwrite, jobread;
+
+        bool              threaded;
+        std::atomic<bool> quit;
+        ZynSema           work;
+        std::thread       thread;
+};
+
+}
+
+#endif
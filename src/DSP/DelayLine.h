@@ -0,0 +1,162 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  DelayLine.h - Power of two ring buffer for delay based effects
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef DELAY_LINE_H
+#define DELAY_LINE_H
+
+#include <cassert>
+#include <cstring>
+#include "../Misc/Allocator.h"
+
+namespace zyn {
+
+/**
+ * Ring buffer of the last written samples
+ *
+ * The size is rounded up to a power of two, so positions wrap with a mask
+ * instead of a compare or a modulo per sample. Delays are given as the age
+ * of a sample: 1 is the last written one and the line keeps at least
+ * maxdelay samples, reads up to size() - 1 are valid.
+ */
+template<class T>
+class DelayLine
+{
+    public:
+        DelayLine(Allocator &memory_, int maxdelay)
+            :memory(memory_), mask(1), head(0)
+        {
+            while(mask < (unsigned)maxdelay + 1)
+                mask <<= 1;
+            buf = memory.valloc<T>(mask);
+            --mask;
+        }
+
+        ~DelayLine()
+        {
+            memory.devalloc(mask + 1, buf);
+        }
+
+        void clear(void)
+        {
+            for(unsigned i = 0; i <= mask; ++i)
+                buf[i] = T();
+        }
+
+        int size(void) const { return mask + 1; }
+
+        /**Sample written delay samples ago*/
+        T read(int delay) const { return buf[(head - delay) & mask]; }
+
+        /**Slot relative to the write position, for lines written ahead*/
+        T &at(int offset) { return buf[(head + offset) & mask]; }
+
+        void write(const T &smp) { buf[head++ & mask] = smp; }
+
+        /**Move the write position without storing anything*/
+        void advance(int n = 1) { head += n; }
+
+        void write(const T *smps, int n)
+        {
+            const unsigned w   = head & mask;
+            const unsigned len = n < (int)(mask + 1 - w) ? n : mask + 1 - w;
+            memcpy(buf + w, smps, len * sizeof(T));
+            memcpy(buf, smps + len, (n - len) * sizeof(T));
+            head += n;
+        }
+
+        /**Copy n samples starting delay samples ago, oldest first*/
+        void read(int delay, T *smps, int n) const
+        {
+            const unsigned r   = (head - delay) & mask;
+            const unsigned len = n < (int)(mask + 1 - r) ? n : mask + 1 - r;
+            memcpy(smps, buf + r, len * sizeof(T));
+            memcpy(smps + len, buf, (n - len) * sizeof(T));
+        }
+
+        /**
+         * Run a block through the line, where every written sample only
+         * depends on the one read delay samples before it.
+         *
+         * f(src, dst, i, len) is called with contiguous runs of the block:
+         * src holds the delayed samples of i..i+len-1 and dst the slots they
+         * are written to. Runs never overlap, so f may treat them as
+         * restricted pointers. The runs would be empty for a delay of 0 or
+         * size(), so 1 <= delay <= size() - 1.
+         */
+        template<class F>
+        void process(int delay, int n, F f)
+        {
+            assert(delay >= 1 && delay < size());
+            for(int i = 0; i < n;) {
+                const unsigned r = (head - delay) & mask, w = head & mask;
+                unsigned len = n - i;
+                len = len < w - r ? len : w - r;
+                len = len < r - w ? len : r - w;
+                len = len < mask + 1 - r ? len : mask + 1 - r;
+                len = len < mask + 1 - w ? len : mask + 1 - w;
+                f(buf + r, buf + w, i, (int)len);
+                head += len;
+                i    += len;
+            }
+        }
+
+        /**Linear interpolation, 1 <= delay <= size() - 1*/
+        T linear(float delay) const
+        {
+            const int   n     = (int)delay + 1;
+            const float frac  = n - delay;
+            const T     older = buf[(head - n) & mask];
+            return older + frac * (buf[(head - n + 1) & mask] - older);
+        }
+
+        /**Catmull-Rom interpolation, 2 <= delay <= size() - 2*/
+        T cubic(float delay) const
+        {
+            const int   n   = (int)delay + 1;
+            const float t   = n - delay;
+            const T     ym1 = buf[(head - n - 1) & mask];
+            const T     y0  = buf[(head - n) & mask];
+            const T     y1  = buf[(head - n + 1) & mask];
+            const T     y2  = buf[(head - n + 2) & mask];
+            const T     c1  = 0.5f * (y1 - ym1);
+            const T     c2  = ym1 - 2.5f * y0 + 2.0f * y1 - 0.5f * y2;
+            const T     c3  = 0.5f * (y2 - ym1) + 1.5f * (y0 - y1);
+            return ((c3 * t + c2) * t + c1) * t + y0;
+        }
+
+        /**
+         * First order allpass interpolation, 1.5 <= delay <= size() - 1
+         *
+         * This is a filter, so it has to be called once for every written
+         * sample with the same state. The fractional part is kept in
+         * [0.5, 1.5) where the coefficient stays small.
+         */
+        T allpass(float delay, T &state) const
+        {
+            const int   n   = (int)(delay - 0.5f);
+            const float eta = (1.0f - (delay - n)) / (1.0f + (delay - n));
+            state = eta * (buf[(head - n) & mask] - state)
+                    + buf[(head - n - 1) & mask];
+            return state;
+        }
+
+    private:
+        DelayLine(const DelayLine &) = delete;
+        DelayLine &operator=(const DelayLine &) = delete;
+
+        Allocator &memory;
+        T        *buf;
+        unsigned  mask, head;
+};
+
+}
+
+#endif
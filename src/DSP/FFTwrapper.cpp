@@ -14,24 +14,25 @@
 #include <cmath>
 #include <cassert>
 #include <cstring>
-#include <pthread.h>
+#include <map>
+#include <mutex>
+#include <utility>
 #include "FFTwrapper.h"
 
 namespace zyn {
 
-static pthread_mutex_t *mutex = NULL;
+//fftw planning is not thread-safe
+static std::mutex plan_lock;
+
+//wrappers shared with acquire() and their reference counts
+static std::mutex shared_lock;
+static std::map<int, std::pair<FFTwrapper*, int>> shared_plans;
 
 FFTwrapper::FFTwrapper(int fftsize_) : m_fftsize(fftsize_)
 {
-    //first one will spawn the mutex (yeah this may be a race itself)
-    if(!mutex) {
-        mutex = new pthread_mutex_t;
-        pthread_mutex_init(mutex, NULL);
-    }
-
     time      = new fftwf_real[m_fftsize];
     fft       = new fftwf_complex[m_fftsize + 1];
-    pthread_mutex_lock(mutex);
+    plan_lock.lock();
     planfftw = fftwf_plan_dft_r2c_1d(m_fftsize,
                                     time,
                                     fft,
@@ -40,20 +41,43 @@ FFTwrapper::FFTwrapper(int fftsize_) : m_fftsize(fftsize_)
                                         fft,
                                         time,
                                         FFTW_ESTIMATE);
-    pthread_mutex_unlock(mutex);
+    plan_lock.unlock();
 }
 
 FFTwrapper::~FFTwrapper()
 {
-    pthread_mutex_lock(mutex);
+    plan_lock.lock();
     fftwf_destroy_plan(planfftw);
     fftwf_destroy_plan(planfftw_inv);
-    pthread_mutex_unlock(mutex);
+    plan_lock.unlock();
 
     delete [] time;
     delete [] fft;
 }
 
+FFTwrapper *FFTwrapper::acquire(int fftsize)
+{
+    std::lock_guard<std::mutex> guard(shared_lock);
+    auto &entry = shared_plans[fftsize];
+    if(!entry.first)
+        entry.first = new FFTwrapper(fftsize);
+    entry.second++;
+    return entry.first;
+}
+
+void FFTwrapper::release(FFTwrapper *fft)
+{
+    if(!fft)
+        return;
+    std::lock_guard<std::mutex> guard(shared_lock);
+    auto itr = shared_plans.find(fft->fftsize());
+    assert(itr != shared_plans.end() && itr->second.first == fft);
+    if(--itr->second.second)
+        return;
+    delete fft;
+    shared_plans.erase(itr);
+}
+
 void FFTwrapper::smps2freqs(const FFTsampleBuffer smps, FFTfreqBuffer freqs, FFTsampleBuffer scratch) const
 {
     //Load data
@@ -101,10 +125,8 @@ void FFTwrapper::freqs2smps_noconst_input(FFTfreqBuffer freqs, FFTsampleBuffer s
 
 void FFT_cleanup()
 {
+    std::lock_guard<std::mutex> guard(plan_lock);
     fftwf_cleanup();
-    pthread_mutex_destroy(mutex);
-    delete mutex;
-    mutex = NULL;
 }
 
 }
@@ -64,6 +64,8 @@ private:
 /**
     A wrapper for the FFTW library (Fast Fourier Transforms)
     All methods (except CTOR/DTOR) are static/const. This class is thread-safe.
+    Since the plans are never modified after construction, one wrapper per
+    size can be shared by all Masters of a process, see acquire().
 */
 class FFTwrapper
 {
@@ -73,6 +75,11 @@ class FFTwrapper
         FFTwrapper(int fftsize_);
         /**Destructor*/
         ~FFTwrapper();
+
+        /**Shared wrapper for a size, created on first use (non-realtime)
+         * It stays valid until it has been released as often as acquired*/
+        static FFTwrapper *acquire(int fftsize);
+        static void release(FFTwrapper *fft);
         /**Convert Samples to Frequencies using Fourier Transform
          * @param smps Pointer to Samples to be converted; has length fftsize_
          * @param freqs Structure FFTFREQS which stores the frequencies*/
@@ -13,6 +13,7 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include "../Misc/Util.h"
 #include "../Misc/Allocator.h"
 #include "FormantFilter.h"
@@ -21,12 +22,25 @@
 
 namespace zyn {
 
-FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigned int srate, int bufsize)
-    :Filter(srate, bufsize), memory(*alloc)
+const float MAX_FREQ = 20000.0f;
+
+FormantFilter::FormantFilter(const FilterParams *pars, Allocator * /*alloc*/, unsigned int srate, int bufsize)
+    :Filter(srate, bufsize)
 {
     numformants = pars->Pnumformants;
-    for(int i = 0; i < numformants; ++i)
-        formant[i] = memory.alloc<AnalogFilter>(4 /*BPF*/, 1000.0f, 10.0f, pars->Pstages, srate, bufsize);
+    lanes  = (numformants + 3) & ~3;
+    stages = pars->Pstages;
+    if(stages >= MAX_FILTER_STAGES)
+        stages = MAX_FILTER_STAGES;
+
+    memset(&target, 0, sizeof(target));
+    for(int i = 0; i < numformants; ++i) {
+        formantfreq[i] = 1000.0f;
+        formantq[i]    = 10.0f;
+        setformant(i, 1000.0f, 10.0f, true);
+    }
+    coeff    = target;
+    morphing = false;
     cleanup();
 
     for(int j = 0; j < FF_MAX_VOWELS; ++j)
@@ -40,10 +54,7 @@ FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigne
         }
 
     for(int i = 0; i < FF_MAX_FORMANTS; ++i)
-    {
-        formant_amp_smoothing[i].sample_rate(srate);
-        formant_amp_smoothing[i].reset(1.0f);
-    }
+        oldamp[i] = i < numformants ? 1.0f : 0.0f;
 
     for(int i = 0; i < numformants; ++i) {
         currentformants[i].freq = 1000.0f;
@@ -74,15 +85,42 @@ FormantFilter::FormantFilter(const FilterParams *pars, Allocator *alloc, unsigne
 }
 
 FormantFilter::~FormantFilter()
+{}
+
+void FormantFilter::cleanup()
 {
-    for(int i = 0; i < numformants; ++i)
-        memory.dealloc(formant[i]);
+    memset(history, 0, sizeof(history));
 }
 
-void FormantFilter::cleanup()
+void FormantFilter::setformant(int n, float freq, float q, bool force)
 {
-    for(int i = 0; i < numformants; ++i)
-        formant[i]->cleanup();
+    if(freq < 0.1f)
+        freq = 0.1f;
+    else if(freq > MAX_FREQ)
+        freq = MAX_FREQ;
+    freq = ceilf(freq);
+
+    //Only recompute for Q changes of more than 10% or changes >= 1Hz
+    const float oldq = formantq[n];
+    bool recompute = force || oldq == 0.0f || q == 0.0f
+                     || (oldq > q ? oldq / q : q / oldq) > 1.1f;
+    if(fabsf(freq - formantfreq[n]) >= 1.0f) {
+        formantfreq[n] = freq;
+        recompute = true;
+    }
+    if(!recompute)
+        return;
+
+    formantq[n] = q;
+    int order;
+    const AnalogFilter::Coeff c = AnalogFilter::computeCoeff(4 /*BPF*/,
+            formantfreq[n], q, stages, 1.0f, samplerate_f, order);
+    target.c0[n] = c.c[0];
+    target.c1[n] = c.c[1];
+    target.c2[n] = c.c[2];
+    target.d1[n] = c.d[1];
+    target.d2[n] = c.d[2];
+    morphing = true;
 }
 
 inline float log_2(float x)
@@ -140,9 +178,12 @@ void FormantFilter::setpos(float frequency)
                 * (1.0f - pos) + formantpar[p2][i].amp * pos;
             currentformants[i].q =
                 formantpar[p1][i].q * (1.0f - pos) + formantpar[p2][i].q * pos;
-            formant[i]->setfreq_and_q(currentformants[i].freq,
-                                      currentformants[i].q * Qfactor);
+            setformant(i, currentformants[i].freq,
+                       currentformants[i].q * Qfactor, false);
         }
+        //Start at the first position instead of morphing towards it
+        coeff     = target;
+        morphing  = false;
         firsttime = false;
     }
     else
@@ -165,8 +206,8 @@ void FormantFilter::setpos(float frequency)
                                       * pos) * formantslowness;
 
 
-            formant[i]->setfreq_and_q(currentformants[i].freq,
-                                      currentformants[i].q * Qfactor);
+            setformant(i, currentformants[i].freq,
+                       currentformants[i].q * Qfactor, false);
         }
 
     oldQfactor = Qfactor;
@@ -181,7 +222,7 @@ void FormantFilter::setq(float q_)
 {
     Qfactor = q_;
     for(int i = 0; i < numformants; ++i)
-        formant[i]->setq(Qfactor * currentformants[i].q);
+        setformant(i, formantfreq[i], Qfactor * currentformants[i].q, true);
 }
 
 void FormantFilter::setgain(float /*dBgain*/)
@@ -196,32 +237,66 @@ void FormantFilter::setfreq_and_q(float frequency, float q_)
 
 void FormantFilter::filterout(float *smp)
 {
-    float inbuffer[buffersize];
-
-    memcpy(inbuffer, smp, bufferbytes);
-    memset(smp, 0, bufferbytes);
-
-    float formantbuf[buffersize];
-
-    for(int j = 0; j < numformants; ++j) {
-
-        float tmpbuf[buffersize];
-
-        for(int i = 0; i < buffersize; ++i)
-            tmpbuf[i] = inbuffer[i] * outgain;
+    //Coefficients and amplitudes are interpolated linearly over the buffer
+    bank_coeff c = coeff, dc;
+    float amp[FF_MAX_FORMANTS], damp[FF_MAX_FORMANTS];
+
+    for(int j = 0; j < lanes; ++j) {
+        const float newamp = j < numformants ? currentformants[j].amp : 0.0f;
+        amp[j]    = oldamp[j];
+        damp[j]   = (newamp - oldamp[j]) / buffersize_f;
+        oldamp[j] = newamp;
+    }
 
-        formant[j]->filterout(tmpbuf);
+    if(morphing)
+        for(int j = 0; j < lanes; ++j) {
+            dc.c0[j] = (target.c0[j] - c.c0[j]) / buffersize_f;
+            dc.c1[j] = (target.c1[j] - c.c1[j]) / buffersize_f;
+            dc.c2[j] = (target.c2[j] - c.c2[j]) / buffersize_f;
+            dc.d1[j] = (target.d1[j] - c.d1[j]) / buffersize_f;
+            dc.d2[j] = (target.d2[j] - c.d2[j]) / buffersize_f;
+        }
 
-        if ( formant_amp_smoothing[j].apply( formantbuf, buffersize, currentformants[j].amp ) )
-        {
-            for(int i = 0; i < buffersize; ++i)
-                smp[i] += tmpbuf[i] * formantbuf[i];
+    for(int i = 0; i < buffersize; ++i) {
+        float x[FF_MAX_FORMANTS];
+        const float input = smp[i] * outgain;
+        for(int j = 0; j < lanes; ++j)
+            x[j] = input;
+
+        for(int k = 0; k < stages + 1; ++k) {
+            bank_stage &h = history[k];
+            for(int j = 0; j < lanes; ++j) {
+                const float y = x[j] * c.c0[j] + h.x1[j] * c.c1[j]
+                                + h.x2[j] * c.c2[j] + h.y1[j] * c.d1[j]
+                                + h.y2[j] * c.d2[j];
+                h.x2[j] = h.x1[j];
+                h.x1[j] = x[j];
+                h.y2[j] = h.y1[j];
+                h.y1[j] = y;
+                x[j]    = y;
+            }
         }
-        else
-        {
-            for(int i = 0; i < buffersize; ++i)
-                smp[i] += tmpbuf[i] * currentformants[j].amp;
+
+        float out = 0.0f;
+        for(int j = 0; j < lanes; ++j) {
+            out    += x[j] * amp[j];
+            amp[j] += damp[j];
         }
+        smp[i] = out;
+
+        if(morphing)
+            for(int j = 0; j < lanes; ++j) {
+                c.c0[j] += dc.c0[j];
+                c.c1[j] += dc.c1[j];
+                c.c2[j] += dc.c2[j];
+                c.d1[j] += dc.d1[j];
+                c.d2[j] += dc.d2[j];
+            }
+    }
+
+    if(morphing) {
+        coeff    = target;
+        morphing = false;
     }
 }
 
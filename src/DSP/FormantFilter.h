@@ -16,7 +16,6 @@
 
 #include "../globals.h"
 #include "Filter.h"
-#include "Value_Smoothing_Filter.h"
 
 namespace zyn {
 
@@ -35,9 +34,28 @@ class FormantFilter:public Filter
 
     private:
         void setpos(float input);
-
-
-        class AnalogFilter * formant[FF_MAX_FORMANTS];
+        //Update the target biquad of one formant (with the hysteresis of
+        //AnalogFilter::setfreq_and_q())
+        void setformant(int n, float freq, float q, bool force);
+
+        /* All formants are 2 pole bandpass filters which are fed with the
+         * same input, so they are kept in structure of arrays form with one
+         * lane per formant and filtered together.
+         * Unused lanes up to the next multiple of 4 have zero coefficients.*/
+        struct bank_coeff {
+            float c0[FF_MAX_FORMANTS], c1[FF_MAX_FORMANTS],
+                  c2[FF_MAX_FORMANTS], d1[FF_MAX_FORMANTS],
+                  d2[FF_MAX_FORMANTS];
+        } coeff, //coefficients in use
+          target; //coefficients reached at the end of the next buffer
+        struct bank_stage {
+            float x1[FF_MAX_FORMANTS], x2[FF_MAX_FORMANTS]; //Input History
+            float y1[FF_MAX_FORMANTS], y2[FF_MAX_FORMANTS]; //Output History
+        } history[MAX_FILTER_STAGES + 1];
+        float formantfreq[FF_MAX_FORMANTS], formantq[FF_MAX_FORMANTS];
+        float oldamp[FF_MAX_FORMANTS];
+        int   lanes, stages;
+        bool  morphing;
 
         struct {
             float freq, amp, q; //frequency,amplitude,Q
@@ -53,9 +71,6 @@ class FormantFilter:public Filter
         float oldinput, slowinput;
         float Qfactor, formantslowness, oldQfactor;
         float vowelclearness, sequencestretch;
-        Allocator &memory;
-
-        Value_Smoothing_Filter formant_amp_smoothing[FF_MAX_FORMANTS];
 };
 
 }
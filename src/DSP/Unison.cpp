@@ -12,9 +12,9 @@
 */
 
 #include <cmath>
-#include <cstring>
 
 #include "../Misc/Allocator.h"
+#include "DelayLine.h"
 #include "Unison.h"
 #include "globals.h"
 
@@ -33,7 +33,6 @@ Unison::Unison(Allocator *alloc_, int update_period_samples_, float max_delay_se
       update_period_samples(update_period_samples_),
       update_period_sample_k(0),
       max_delay((int)(srate_f * max_delay_sec_) + 1),
-      delay_k(0),
       first_time(false),
       delay_buffer(NULL),
       unison_amplitude_samples(0.0f),
@@ -43,13 +42,12 @@ Unison::Unison(Allocator *alloc_, int update_period_samples_, float max_delay_se
 {
     if(max_delay < 10)
         max_delay = 10;
-    delay_buffer = alloc.valloc<float>(max_delay);
-    memset(delay_buffer, 0, max_delay * sizeof(float));
+    delay_buffer = alloc.alloc<DelayLine<float>>(alloc, max_delay);
     setSize(1);
 }
 
 Unison::~Unison() {
-    alloc.devalloc(delay_buffer);
+    alloc.dealloc(delay_buffer);
     alloc.devalloc(uv);
 }
 
@@ -139,23 +137,12 @@ void Unison::process(int bufsize, float *inbuf, float *outbuf)
         float sign = 1.0f;
         for(int k = 0; k < unison_size; ++k) {
             float vpos = uv[k].realpos1 * (1.0f - xpos) + uv[k].realpos2 * xpos;        //optimize
-            float pos  = (float)(delay_k + max_delay) - vpos - 1.0f;
-            int   posi;
-            F2I(pos, posi); //optimize!
-            int posi_next = posi + 1;
-            if(posi >= max_delay)
-                posi -= max_delay;
-            if(posi_next >= max_delay)
-                posi_next -= max_delay;
-            float posf = pos - floorf(pos);
-            out += ((1.0f - posf) * delay_buffer[posi] + posf
-                 * delay_buffer[posi_next]) * sign;
+            out += delay_buffer->linear(vpos + 1.0f) * sign;
             sign = -sign;
         }
         outbuf[i] = out * volume;
 //		printf("%d %g\n",i,outbuf[i]);
-        delay_buffer[delay_k] = in;
-        delay_k = (++delay_k < max_delay) ? delay_k : 0;
+        delay_buffer->write(in);
     }
 }
 
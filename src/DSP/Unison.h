@@ -22,6 +22,7 @@
 namespace zyn {
 
 class Allocator;
+template<class T> class DelayLine;
 
 class Unison
 {
@@ -60,9 +61,9 @@ class Unison
 
         int    update_period_samples;
         int    update_period_sample_k;
-        int    max_delay, delay_k;
+        int    max_delay;
         bool   first_time;
-        float *delay_buffer;
+        DelayLine<float> *delay_buffer;
         float  unison_amplitude_samples;
         float  unison_bandwidth_cents;
 
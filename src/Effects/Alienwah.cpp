@@ -69,8 +69,8 @@ rtosc::Ports Alienwah::ports = {
 Alienwah::Alienwah(EffectParams pars)
     :Effect(pars),
       lfo(pars.srate, pars.bufsize),
-      oldl(NULL),
-      oldr(NULL)
+      oldl(memory.alloc<DelayLine<complex<float>>>(memory, MAX_ALIENWAH_DELAY)),
+      oldr(memory.alloc<DelayLine<complex<float>>>(memory, MAX_ALIENWAH_DELAY))
 {
     setpreset(Ppreset);
     cleanup();
@@ -80,10 +80,31 @@ Alienwah::Alienwah(EffectParams pars)
 
 Alienwah::~Alienwah()
 {
-    memory.devalloc(oldl);
-    memory.devalloc(oldr);
+    memory.dealloc(oldl);
+    memory.dealloc(oldr);
 }
 
+//Process one channel, the line only feeds back after Pdelay samples
+void Alienwah::outchannel(DelayLine<complex<float>> &line,
+                          complex<float> clfo, complex<float> oldclfo,
+                          const float *smp, float pangain, float *efxout)
+{
+    line.process(Pdelay, buffersize,
+                 [&](const complex<float> *__restrict src,
+                     complex<float> *__restrict dst, int i, int len) {
+        for(int k = 0; k < len; ++k) {
+            float x  = ((float) (i + k)) / buffersize_f;
+            float x1 = 1.0f - x;
+            complex<float> tmp = clfo * x + oldclfo * x1;
+
+            complex<float> out = tmp * src[k];
+            out += (1 - fabsf(fb)) * smp[i + k] * pangain;
+
+            dst[k] = out;
+            efxout[i + k] = out.real() * 10.0f * (fb + 0.1f);
+        }
+    });
+}
 
 //Apply the effect
 void Alienwah::out(const Stereo<float *> &smp)
@@ -100,30 +121,12 @@ void Alienwah::out(const Stereo<float *> &smp)
     clfol = complex<float>(cosf(lfol + phase) * fb, sinf(lfol + phase) * fb); //rework
     clfor = complex<float>(cosf(lfor + phase) * fb, sinf(lfor + phase) * fb); //rework
 
-    for(int i = 0; i < buffersize; ++i) {
-        float x  = ((float) i) / buffersize_f;
-        float x1 = 1.0f - x;
-        //left
-        complex<float> tmp = clfol * x + oldclfol * x1;
-
-        complex<float> out = tmp * oldl[oldk];
-        out += (1 - fabsf(fb)) * smp.l[i] * pangainL;
-
-        oldl[oldk] = out;
-        float l = out.real() * 10.0f * (fb + 0.1f);
+    outchannel(*oldl, clfol, oldclfol, smp.l, pangainL, efxoutl);
+    outchannel(*oldr, clfor, oldclfor, smp.r, pangainR, efxoutr);
 
-        //right
-        tmp = clfor * x + oldclfor * x1;
-
-        out = tmp * oldr[oldk];
-        out += (1 - fabsf(fb)) * smp.r[i] * pangainR;
-
-        oldr[oldk] = out;
-        float r = out.real() * 10.0f * (fb + 0.1f);
-
-
-        if(++oldk >= Pdelay)
-            oldk = 0;
+    for(int i = 0; i < buffersize; ++i) {
+        float l = efxoutl[i];
+        float r = efxoutr[i];
         //LRcross
         efxoutl[i] = l * (1.0f - lrcross) + r * lrcross;
         efxoutr[i] = r * (1.0f - lrcross) + l * lrcross;
@@ -136,11 +139,8 @@ void Alienwah::out(const Stereo<float *> &smp)
 //Cleanup the effect
 void Alienwah::cleanup(void)
 {
-    for(int i = 0; i < Pdelay; ++i) {
-        oldl[i] = complex<float>(0.0f, 0.0f);
-        oldr[i] = complex<float>(0.0f, 0.0f);
-    }
-    oldk = 0;
+    oldl->clear();
+    oldr->clear();
 }
 
 
@@ -180,11 +180,7 @@ void Alienwah::setphase(unsigned char _Pphase)
 
 void Alienwah::setdelay(unsigned char _Pdelay)
 {
-    memory.devalloc(oldl);
-    memory.devalloc(oldr);
     Pdelay = limit<int>(_Pdelay, 1, MAX_ALIENWAH_DELAY);
-    oldl   = memory.valloc<complex<float>>(Pdelay);
-    oldr   = memory.valloc<complex<float>>(Pdelay);
     cleanup();
 }
 
@@ -16,6 +16,7 @@
 
 #include "Effect.h"
 #include "EffectLFO.h"
+#include "../DSP/DelayLine.h"
 #include <complex>
 
 #define MAX_ALIENWAH_DELAY 100
@@ -54,11 +55,14 @@ class Alienwah final:public Effect
         void setdelay(unsigned char _Pdelay);
         void setphase(unsigned char _Pphase);
 
+        void outchannel(DelayLine<std::complex<float>> &line,
+                        std::complex<float> clfo, std::complex<float> oldclfo,
+                        const float *smp, float pangain, float *efxout);
+
         //Internal Values
         float fb, depth, phase;
-        std::complex<float> *oldl, *oldr;
-        std::complex<float>  oldclfol, oldclfor;
-        int oldk;
+        DelayLine<std::complex<float>> *oldl, *oldr;
+        std::complex<float> oldclfol, oldclfor;
 };
 
 }
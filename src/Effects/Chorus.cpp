@@ -77,10 +77,9 @@ Chorus::Chorus(EffectParams pars)
     :Effect(pars),
       lfo(pars.srate, pars.bufsize),
       maxdelay((int)(MAX_CHORUS_DELAY / 1000.0f * samplerate_f)),
-      delaySample(memory.valloc<float>(maxdelay), memory.valloc<float>(maxdelay))
+      delaySample(memory.alloc<DelayLine<float>>(memory, maxdelay),
+                  memory.alloc<DelayLine<float>>(memory, maxdelay))
 {
-    dlk = 0;
-    drk = 0;
     setpreset(Ppreset);
     changepar(1, 64);
     lfo.effectlfoout(&lfol, &lfor);
@@ -91,8 +90,8 @@ Chorus::Chorus(EffectParams pars)
 
 Chorus::~Chorus()
 {
-    memory.devalloc(delaySample.l);
-    memory.devalloc(delaySample.r);
+    memory.dealloc(delaySample.l);
+    memory.dealloc(delaySample.r);
 }
 
 //get the delay value in samples; xlfo is the current lfo value
@@ -112,6 +111,17 @@ float Chorus::getdelay(float xlfo)
     return result;
 }
 
+//get the sample mdel samples ago using linear interpolation
+//delays of less than a sample wrap around to the oldest samples of the line
+float Chorus::getsample(const DelayLine<float> &line, float mdel) const
+{
+    const int   age   = (int)ceilf(mdel);
+    const float frac  = age - mdel;
+    const float older = line.read(age > 0 ? age : age + maxdelay);
+    const float newer = line.read(age > 1 ? age - 1 : age - 1 + maxdelay);
+    return older * (1.0f - frac) + newer * frac;
+}
+
 //Apply the effect
 void Chorus::out(const Stereo<float *> &input)
 {
@@ -135,37 +145,15 @@ void Chorus::out(const Stereo<float *> &input)
         //compute the delay in samples using linear interpolation between the lfo delays
         float mdel =
             (dl1 * (buffersize - i) + dl2 * i) / buffersize_f;
-        if(++dlk >= maxdelay)
-            dlk = 0;
-        float tmp = dlk - mdel + maxdelay * 2.0f; //where should I get the sample from
-
-        dlhi  = (int) tmp;
-        dlhi %= maxdelay;
-
-        float dlhi2 = (dlhi - 1 + maxdelay) % maxdelay;
-        float dllo  = 1.0f + floorf(tmp) - tmp;
-        efxoutl[i] = cinterpolate(delaySample.l, maxdelay, dlhi2) * dllo
-                     + cinterpolate(delaySample.l, maxdelay,
-                                    dlhi) * (1.0f - dllo);
-        delaySample.l[dlk] = inL + efxoutl[i] * fb;
+        efxoutl[i] = getsample(*delaySample.l, mdel);
+        delaySample.l->write(inL + efxoutl[i] * fb);
 
         //Right channel
 
         //compute the delay in samples using linear interpolation between the lfo delays
         mdel = (dr1 * (buffersize - i) + dr2 * i) / buffersize_f;
-        if(++drk >= maxdelay)
-            drk = 0;
-        tmp = drk * 1.0f - mdel + maxdelay * 2.0f; //where should I get the sample from
-
-        dlhi  = (int) tmp;
-        dlhi %= maxdelay;
-
-        dlhi2      = (dlhi - 1 + maxdelay) % maxdelay;
-        dllo       = 1.0f + floorf(tmp) - tmp;
-        efxoutr[i] = cinterpolate(delaySample.r, maxdelay, dlhi2) * dllo
-                     + cinterpolate(delaySample.r, maxdelay,
-                                    dlhi) * (1.0f - dllo);
-        delaySample.r[dlk] = inR + efxoutr[i] * fb;
+        efxoutr[i] = getsample(*delaySample.r, mdel);
+        delaySample.r->write(inR + efxoutr[i] * fb);
     }
 
     if(Poutsub)
@@ -183,8 +171,8 @@ void Chorus::out(const Stereo<float *> &input)
 //Cleanup the effect
 void Chorus::cleanup(void)
 {
-    memset(delaySample.l, 0, maxdelay * sizeof(float));
-    memset(delaySample.r, 0, maxdelay * sizeof(float));
+    delaySample.l->clear();
+    delaySample.r->clear();
 }
 
 //Parameter control
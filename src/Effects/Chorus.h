@@ -15,6 +15,7 @@
 #define CHORUS_H
 #include "Effect.h"
 #include "EffectLFO.h"
+#include "../DSP/DelayLine.h"
 #include "../Misc/Stereo.h"
 
 #define MAX_CHORUS_DELAY 250.0f //ms
@@ -93,9 +94,9 @@ class Chorus final:public Effect
         float depth, delay, fb;
         float dl1, dl2, dr1, dr2, lfol, lfor;
         int   maxdelay;
-        Stereo<float *> delaySample;
-        int dlk, drk, dlhi;
+        Stereo<DelayLine<float> *> delaySample;
         float getdelay(float xlfo);
+        float getsample(const DelayLine<float> &line, float mdel) const;
 };
 
 }
@@ -20,7 +20,6 @@ namespace zyn {
         gain_smoothing.thresh(0.02f); // TBD: 2% jump audible?
         gain_smoothing.cutoff(1.0f);
         gain_smoothing.reset(gainbwd);
-        pos_writer = 0;
     }
 
     CombFilterBank::~CombFilterBank()
@@ -42,31 +41,23 @@ namespace zyn {
             if(nrOfStringsNew>nrOfStrings)
             {
                 for(unsigned int i = nrOfStrings; i < nrOfStringsNew; ++i)
-                {
-                    string_smps[i] = memory.valloc<float>(mem_size);
-                    memset(string_smps[i], 0, mem_size*sizeof(float));
-                }
+                    strings[i] = memory.alloc<DelayLine<float>>(memory, mem_size);
             }
             else if(nrOfStringsNew<nrOfStrings)
                 for(unsigned int i = nrOfStringsNew; i < nrOfStrings; ++i)
-                    memory.devalloc(string_smps[i]);
+                    memory.dealloc(strings[i]);
         } else
         {
             // free the old buffers (wrong size for baseFreqNew)
             for(unsigned int i = 0; i < nrOfStrings; ++i)
-                memory.devalloc(string_smps[i]);
+                memory.dealloc(strings[i]);
 
             // allocate buffers with new size
             for(unsigned int i = 0; i < nrOfStringsNew; ++i)
-            {
-                string_smps[i] = memory.valloc<float>(mem_size_new);
-                memset(string_smps[i], 0, mem_size_new*sizeof(float));
-            }
+                strings[i] = memory.alloc<DelayLine<float>>(memory, mem_size_new);
             // update mem_size and baseFreq
             mem_size = mem_size_new;
             baseFreq = baseFreqNew;
-            // reset writer position
-            pos_writer = 0;
         }
         // update nrOfStrings
         nrOfStrings = nrOfStringsNew;
@@ -80,13 +71,6 @@ namespace zyn {
         return (x*(105.0f+10.0f*x2)/(105.0f+(45.0f+x2)*x2));
     }
 
-    inline float CombFilterBank::sampleLerp(const float *smp, const float pos) const {
-        int poshi = (int)pos; // integer part (pos >= 0)
-        float poslo = pos - (float) poshi; // decimal part
-        // linear interpolation between samples
-        return smp[poshi] + poslo * (smp[(poshi+1)%mem_size]-smp[poshi]);
-    }
-
     void CombFilterBank::filterout(float *smp)
     {
         // no string -> no sound
@@ -105,33 +89,27 @@ namespace zyn {
             // apply input gain
             const float input_smp = smp[i]*inputgain;
 
-            for (unsigned int j = 0; j < nrOfStrings; ++j)
-            {
-                if (delays[j] == 0.0f) continue;
-                assert(float(mem_size)>delays[j]);
-                // calculate the feedback sample positions in the buffer
-                const float pos_reader = fmodf(float(pos_writer+mem_size) - delays[j], float(mem_size));
-
-                // sample at that position
-                const float sample = sampleLerp(string_smps[j], pos_reader);
-                string_smps[j][pos_writer] = input_smp + tanhX(sample*gainbuf[i/16]);
-            }
             // mix output buffer samples to output sample
             smp[i]=0.0f;
             unsigned int nrOfActualStrings = 0;
             for (unsigned int j = 0; j < nrOfStrings; ++j)
-                if (delays[j] != 0.0f) {
-					smp[i] += string_smps[j][pos_writer];
-					nrOfActualStrings++;
-				}
+            {
+                if (delays[j] == 0.0f) continue;
+                // the feedback sample, below one sample the interpolation
+                // would read the slot which is written next
+                const float delay = limit(delays[j], 1.0f,
+                                          (float)(strings[j]->size() - 1));
+                const float sample = strings[j]->linear(delay);
+                const float out = input_smp + tanhX(sample*gainbuf[i/16]);
+                strings[j]->write(out);
+                smp[i] += out;
+                nrOfActualStrings++;
+            }
 
             // apply output gain to sum of strings and
             // divide by nrOfStrings to get mean value
             // division by zero is catched at the beginning filterOut()
             smp[i] *= outgain / (float)nrOfActualStrings;
-
-            // increment writing position
-            ++pos_writer %= mem_size;
         }
     }
 }
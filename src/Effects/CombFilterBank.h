@@ -1,5 +1,6 @@
 #include "../Misc/Allocator.h"
 #include "../globals.h"
+#include "../DSP/DelayLine.h"
 #include "../DSP/Value_Smoothing_Filter.h"
 
 #pragma once
@@ -25,12 +26,10 @@ class CombFilterBank
 
     private:
     static float tanhX(const float x);
-    float sampleLerp(const float *smp, const float pos) const;
 
-    float* string_smps[NUM_SYMPATHETIC_STRINGS] = {};
+    DelayLine<float>* strings[NUM_SYMPATHETIC_STRINGS] = {};
     float baseFreq;
     unsigned int nrOfStrings=0;
-    unsigned int pos_writer = 0;
 
     /* for smoothing gain jump when using binary valued sustain pedal */
     Value_Smoothing_Filter gain_smoothing;
@@ -0,0 +1,239 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Convolution.cpp - Convolution reverb effect
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <rtosc/ports.h>
+#include <rtosc/port-sugar.h>
+#include "../DSP/Convolver.h"
+#include "../Misc/WavFile.h"
+#include "Convolution.h"
+
+//Longest impulse response which is used
+#define MAX_IR_SECONDS 20
+
+namespace zyn {
+
+#define rObject Convolution
+#define rBegin [](const char *msg, rtosc::RtData &d) {
+#define rEnd }
+
+rtosc::Ports Convolution::ports = {
+    {"preset::i", rOptions(Default)
+                  rDefault(0)
+                  rProp(alias)
+                  rProp(parameter)
+                  rDoc("Instrument Presets"), 0,
+                  rBegin;
+                  rObject *o = (rObject*)d.obj;
+                  if(rtosc_narguments(msg))
+                      o->setpreset(rtosc_argument(msg, 0).i);
+                  else
+                      d.reply(d.loc, "i", o->Ppreset);
+                  rEnd},
+    rPresetForVolume,
+    rEffParVol(rDefaultDepends(presetOfVolume), rDefault(80),
+               rPresetsAt(16, 40)),
+    rEffParPan(),
+    rEffPar(Plrcross, 2, rShort("cross"), rDefault(0),
+            "Left/Right Crossover"),
+};
+#undef rBegin
+#undef rEnd
+#undef rObject
+
+ImpulseResponse::ImpulseResponse(const std::string &filename_,
+                                 Convolver *convolver_)
+    :filename(filename_), convolver(convolver_)
+{}
+
+ImpulseResponse::~ImpulseResponse()
+{
+    delete convolver;
+}
+
+ImpulseResponse *ImpulseResponse::load(const std::string &filename,
+                                       const SYNTH_T &synth)
+{
+    std::vector<float> smps;
+    int channels, samplerate;
+    if(readWavFile(filename, smps, channels, samplerate) || smps.empty()) {
+        fprintf(stderr, "Could not read impulse response <%s>\n",
+                filename.c_str());
+        return NULL;
+    }
+    //stereo input is convolved per channel, more channels are not used
+    const int used = channels > 1 ? 2 : 1;
+    const int frames = smps.size() / channels;
+
+    //linear interpolation to the synth samplerate
+    const double ratio = (double)samplerate / synth.samplerate;
+    int len = (frames - 1) / ratio + 1;
+    if(len > MAX_IR_SECONDS * (int)synth.samplerate)
+        len = MAX_IR_SECONDS * synth.samplerate;
+    std::vector<float> ir[2];
+    for(int c = 0; c < used; ++c) {
+        ir[c].resize(len);
+        for(int i = 0; i < len; ++i) {
+            const double pos  = i * ratio;
+            const int    k    = pos;
+            const float  frac = pos - k;
+            const float  a    = smps[k * channels + c];
+            const float  b    = k + 1 < frames ? smps[(k + 1) * channels + c]
+                                               : 0.0f;
+            ir[c][i] = a + (b - a) * frac;
+        }
+    }
+
+    //normalize the energy of the louder channel
+    double energy = 0.0;
+    for(int c = 0; c < used; ++c) {
+        double e = 0.0;
+        for(int i = 0; i < len; ++i)
+            e += ir[c][i] * ir[c][i];
+        energy = fmax(energy, e);
+    }
+    if(energy > 0.0) {
+        const float norm = 1.0 / sqrt(energy);
+        for(int c = 0; c < used; ++c)
+            for(int i = 0; i < len; ++i)
+                ir[c][i] *= norm;
+    }
+
+    const float *irs[2] = {ir[0].data(), ir[1].data()};
+    return new ImpulseResponse(filename,
+            new Convolver(used, irs, len, synth.buffersize));
+}
+
+Convolution::Convolution(EffectParams pars)
+    :Effect(pars),
+      Pvolume(80),
+      ir(NULL)
+{
+    setpreset(Ppreset);
+}
+
+Convolution::~Convolution()
+{}
+
+void Convolution::cleanup(void)
+{
+    if(ir)
+        ir->convolver->cleanup();
+}
+
+void Convolution::setir(ImpulseResponse *ir_)
+{
+    ir = ir_;
+    cleanup();
+}
+
+void Convolution::out(const Stereo<float *> &smp)
+{
+    if(!ir || (!Pvolume && insertion))
+        return;
+
+    Convolver &convolver = *ir->convolver;
+    if(convolver.channels == 1) {
+        float inputbuf[buffersize];
+        for(int i = 0; i < buffersize; ++i)
+            inputbuf[i] = (smp.l[i] + smp.r[i]) / 2.0f;
+        const float *in[1]  = {inputbuf};
+        float       *out[1] = {efxoutl};
+        convolver.process(in, out);
+        memcpy(efxoutr, efxoutl, bufferbytes);
+    } else {
+        const float *in[2]  = {smp.l, smp.r};
+        float       *out[2] = {efxoutl, efxoutr};
+        convolver.process(in, out);
+    }
+
+    for(int i = 0; i < buffersize; ++i) {
+        float l = efxoutl[i] * pangainL;
+        float r = efxoutr[i] * pangainR;
+        crossover(l, r, lrcross);
+        efxoutl[i] = l;
+        efxoutr[i] = r;
+    }
+}
+
+void Convolution::setvolume(unsigned char _Pvolume)
+{
+    Pvolume = _Pvolume;
+    if(!insertion) {
+        if(Pvolume == 0)
+            outvolume = 0.0f;
+        else
+            outvolume = powf(0.01f, (1.0f - Pvolume / 127.0f)) * 4.0f;
+        volume = 1.0f;
+    }
+    else
+        volume = outvolume = Pvolume / 127.0f;
+    if(Pvolume == 0)
+        cleanup();
+}
+
+unsigned char Convolution::getpresetpar(unsigned char npreset,
+                                        unsigned int npar)
+{
+#define PRESET_SIZE 3
+#define NUM_PRESETS 1
+    static const unsigned char presets[NUM_PRESETS][PRESET_SIZE] = {
+        //Default
+        {80, 64, 0}
+    };
+    if(npreset < NUM_PRESETS && npar < PRESET_SIZE) {
+        if(npar == 0 && insertion != 0) {
+            /* lower the volume if this is insertion effect */
+            return presets[npreset][npar] / 2;
+        }
+        return presets[npreset][npar];
+    }
+    return 0;
+}
+
+void Convolution::setpreset(unsigned char npreset)
+{
+    if(npreset >= NUM_PRESETS)
+        npreset = NUM_PRESETS - 1;
+    for(int n = 0; n != 128; n++)
+        changepar(n, getpresetpar(npreset, n));
+    Ppreset = npreset;
+}
+
+void Convolution::changepar(int npar, unsigned char value)
+{
+    switch(npar) {
+        case 0:
+            setvolume(value);
+            break;
+        case 1:
+            setpanning(value);
+            break;
+        case 2:
+            setlrcross(value);
+            break;
+    }
+}
+
+unsigned char Convolution::getpar(int npar) const
+{
+    switch(npar) {
+        case 0:  return Pvolume;
+        case 1:  return Ppanning;
+        case 2:  return Plrcross;
+        default: return 0;
+    }
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Convolution.h - Convolution reverb effect
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <string>
+#include "Effect.h"
+
+namespace zyn {
+
+class Convolver;
+
+/**Impulse response which is loaded and partitioned outside of the realtime
+ * thread and is owned by the EffectMgr*/
+struct ImpulseResponse
+{
+    ImpulseResponse(const std::string &filename, Convolver *convolver);
+    ~ImpulseResponse();
+
+    /**Read a wave file, resampled to the synth samplerate
+     * @return NULL if the file could not be read*/
+    static ImpulseResponse *load(const std::string &filename,
+                                 const SYNTH_T &synth) NONREALTIME;
+
+    const std::string filename;
+    Convolver *const  convolver;
+};
+
+/**Convolves the input with a recorded impulse response*/
+class Convolution final:public Effect
+{
+    public:
+        Convolution(EffectParams pars);
+        ~Convolution();
+        void out(const Stereo<float *> &smp);
+        void cleanup(void);
+
+        unsigned char getpresetpar(unsigned char npreset, unsigned int npar);
+        void setpreset(unsigned char npreset);
+        void changepar(int npar, unsigned char value);
+        unsigned char getpar(int npar) const;
+
+        void setir(ImpulseResponse *ir_) REALTIME;
+
+        static rtosc::Ports ports;
+    private:
+        //Parameters
+        unsigned char Pvolume;
+
+        void setvolume(unsigned char _Pvolume);
+
+        ImpulseResponse *ir;
+};
+
+}
+
+#endif
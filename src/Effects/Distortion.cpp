@@ -71,6 +71,9 @@ rtosc::Ports Distortion::ports = {
             rLinear(0, 127), "Shape of the wave shaping function"),
     rEffPar(Poffset,   12, rShort("offset"), rDefault(64),
             rLinear(0, 127), "Input DC Offset"),
+    rEffParOpt(Poversampling, 13, rShort("o.s."),
+            rOptions(1x, 2x, 4x, 8x), rDefault(1x),
+            "Oversampling of the non-linearity"),
     {"waveform:", 0, 0, [](const char *, rtosc::RtData &d)
         {
             Distortion  &dd = *(Distortion*)d.obj;
@@ -109,7 +112,9 @@ Distortion::Distortion(EffectParams pars)
       Pstereo(0),
       Pprefiltering(0),
       Pfuncpar(32),
-      Poffset(64)
+      Poffset(64),
+      Poversampling(0),
+      requested(-1)
 {
     lpfl = memory.alloc<AnalogFilter>(2, 22000, 1, 0, pars.srate, pars.bufsize);
     lpfr = memory.alloc<AnalogFilter>(2, 22000, 1, 0, pars.srate, pars.bufsize);
@@ -134,6 +139,7 @@ void Distortion::cleanup(void)
     hpfl->cleanup();
     lpfr->cleanup();
     hpfr->cleanup();
+    shaper.cleanup();
 }
 
 
@@ -168,9 +174,9 @@ void Distortion::out(const Stereo<float *> &smp)
     if(Pprefiltering)
         applyfilters(efxoutl, efxoutr);
 
-    waveShapeSmps(buffersize, efxoutl, Ptype + 1, Pdrive, Poffset, Pfuncpar);
+    shaper.shape(buffersize, efxoutl, 0);
     if(Pstereo)
-        waveShapeSmps(buffersize, efxoutr, Ptype + 1, Pdrive, Poffset, Pfuncpar);
+        shaper.shape(buffersize, efxoutr, 1);
 
     if(!Pprefiltering)
         applyfilters(efxoutl, efxoutr);
@@ -224,7 +230,41 @@ void Distortion::sethpf(unsigned char _Phpf)
     hpfr->setfreq(fr);
 }
 
+void Distortion::setshape(void)
+{
+    shaper.setup(Ptype + 1, Pdrive, Poffset, Pfuncpar, 1 << Poversampling);
+}
+
+void Distortion::setshapetable(const WaveShaper::Table *table)
+{
+    shaper.settable(table);
+}
+
+bool Distortion::requestshapetable(unsigned char shape[4])
+{
+    if(!shaper.needstable())
+        return false;
+    const int key = (Ptype << 24) | (Pdrive << 16) | (Poffset << 8) | Pfuncpar;
+    if(key == requested)
+        return false;
+    requested = key;
+    shape[0]  = Ptype + 1;
+    shape[1]  = Pdrive;
+    shape[2]  = Poffset;
+    shape[3]  = Pfuncpar;
+    return true;
+}
+
 unsigned char Distortion::getpresetpar(unsigned char npreset, unsigned int npar)
+{
+    if(npar == 0 && insertion == 0) {
+        /* lower the volume if this is system effect */
+        return (2 * presetpar(npreset, npar)) / 3;
+    }
+    return presetpar(npreset, npar);
+}
+
+unsigned char Distortion::presetpar(unsigned char npreset, unsigned int npar)
 {
 #define	PRESET_SIZE 13
 #define	NUM_PRESETS 6
@@ -242,13 +282,8 @@ unsigned char Distortion::getpresetpar(unsigned char npreset, unsigned int npar)
         //Quantisize
         {127, 64, 35, 88, 75, 4, 0, 127, 0,   1, 0, 32, 64}
     };
-    if(npreset < NUM_PRESETS && npar < PRESET_SIZE) {
-        if(npar == 0 && insertion == 0) {
-            /* lower the volume if this is system effect */
-            return (2 * presets[npreset][npar]) / 3;
-        }
+    if(npreset < NUM_PRESETS && npar < PRESET_SIZE)
         return presets[npreset][npar];
-    }
     return 0;
 }
 
@@ -276,6 +311,7 @@ void Distortion::changepar(int npar, unsigned char value)
             break;
         case 3:
             Pdrive = value;
+            setshape();
             break;
         case 4:
             Plevel = value;
@@ -285,6 +321,7 @@ void Distortion::changepar(int npar, unsigned char value)
                 Ptype = 16;  //this must be increased if more distortion types are added
             else
                 Ptype = value;
+            setshape();
             break;
         case 6:
             if(value > 1)
@@ -306,9 +343,15 @@ void Distortion::changepar(int npar, unsigned char value)
             break;
         case 11:
             Pfuncpar = value;
+            setshape();
             break;
         case 12:
             Poffset = value;
+            setshape();
+            break;
+        case 13:
+            Poversampling = value > 3 ? 3 : value;
+            setshape();
             break;
     }
 }
@@ -329,6 +372,7 @@ unsigned char Distortion::getpar(int npar) const
         case 10: return Pprefiltering;
         case 11: return Pfuncpar;
         case 12: return Poffset;
+        case 13: return Poversampling;
         default: return 0; //in case of bogus parameter number
     }
 }
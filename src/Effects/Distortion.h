@@ -15,6 +15,7 @@
 #define DISTORTION_H
 
 #include "Effect.h"
+#include "../Misc/WaveShapeSmps.h"
 
 namespace zyn {
 
@@ -32,6 +33,17 @@ class Distortion final :public Effect
         void cleanup(void);
         void applyfilters(float *efxoutl, float *efxoutr);
 
+        //Preset values without the adjustment for system effects
+        static unsigned char presetpar(unsigned char npreset,
+                                       unsigned int npar);
+
+        //Table of the shaper, owned by the EffectMgr
+        void setshapetable(const WaveShaper::Table *table);
+        //If the table of the current shape has to be built, each shape is
+        //requested only once
+        //@param shape type, drive, offset and funcpar for buildtable()
+        bool requestshapetable(unsigned char shape[4]);
+
         static rtosc::Ports ports;
     private:
         //Parameters
@@ -46,13 +58,17 @@ class Distortion final :public Effect
         unsigned char Pprefiltering; //if you want to do the filtering before the distortion
         unsigned char Pfuncpar;      //for parametric functions
         unsigned char Poffset;       //the input offset
+        unsigned char Poversampling; //0=off, 1=2x, 2=4x, 3=8x
 
         void setvolume(unsigned char _Pvolume);
         void setlpf(unsigned char _Plpf);
         void sethpf(unsigned char _Phpf);
+        void setshape(void);
 
         //Real Parameters
         class AnalogFilter * lpfl, *lpfr, *hpfl, *hpfr;
+        WaveShaper shaper;
+        int        requested; //last requested shape, -1 for none
 };
 
 }
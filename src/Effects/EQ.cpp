@@ -12,11 +12,10 @@
 */
 
 #include <cmath>
+#include <cstring>
 #include <rtosc/ports.h>
 #include <rtosc/port-sugar.h>
 #include "EQ.h"
-#include "../DSP/AnalogFilter.h"
-#include "../Misc/Allocator.h"
 
 namespace zyn {
 
@@ -103,11 +102,14 @@ rtosc::Ports EQ::ports = {
 #undef rEnd
 
 EQ::EQ(EffectParams pars)
-    :Effect(pars)
+    :Effect(pars), nsections(0), morphing(false)
 {
     for(int i = 0; i < MAX_EQ_BANDS; ++i) {
-        filter[i].l = memory.alloc<AnalogFilter>(6, 1000.0f, 1.0f, 0, pars.srate, pars.bufsize);
-        filter[i].r = memory.alloc<AnalogFilter>(6, 1000.0f, 1.0f, 0, pars.srate, pars.bufsize);
+        filter[i].Ptype   = 0;
+        filter[i].Pstages = 0;
+        filter[i].freq    = 1000.0f;
+        filter[i].gain    = 1.0f;
+        filter[i].q       = 1.0f;
     }
     //default values
     Pvolume = 50;
@@ -117,20 +119,12 @@ EQ::EQ(EffectParams pars)
 }
 
 EQ::~EQ()
-{
-       for(int i = 0; i < MAX_EQ_BANDS; ++i) {
-           memory.dealloc(filter[i].l);
-           memory.dealloc(filter[i].r);
-       }
-}
+{}
 
 // Cleanup the effect
 void EQ::cleanup(void)
 {
-    for(int i = 0; i < MAX_EQ_BANDS; ++i) {
-        filter[i].l->cleanup();
-        filter[i].r->cleanup();
-    }
+    memset(history, 0, sizeof(history));
 }
 
 //Effect output
@@ -141,12 +135,70 @@ void EQ::out(const Stereo<float *> &smp)
         efxoutr[i] = smp.r[i] * volume;
     }
 
+    if(morphing) {
+        BiquadCoeff delta[MAX_SECTIONS];
+        for(int i = 0; i < nsections; ++i) {
+            delta[i].c0 = (target[i].c0 - sections[i].c0) / buffersize_f;
+            delta[i].c1 = (target[i].c1 - sections[i].c1) / buffersize_f;
+            delta[i].c2 = (target[i].c2 - sections[i].c2) / buffersize_f;
+            delta[i].d1 = (target[i].d1 - sections[i].d1) / buffersize_f;
+            delta[i].d2 = (target[i].d2 - sections[i].d2) / buffersize_f;
+        }
+        stereoBiquadCascade(sections, delta, history, nsections,
+                            efxoutl, efxoutr, buffersize);
+        memcpy(sections, target, sizeof(sections));
+        morphing = false;
+    }
+    else
+        stereoBiquadCascade(sections, nullptr, history, nsections,
+                            efxoutl, efxoutr, buffersize);
+}
+
+void EQ::updateband(int nb)
+{
+    auto &F = filter[nb];
+    if(F.Ptype != 0) {
+        int order;
+        F.coeff = AnalogFilter::computeCoeff(F.Ptype - 1, F.freq, F.q,
+                F.Pstages, F.gain, samplerate_f, order);
+    }
+
+    //Lay out the sections of all active bands
+    int           n = 0;
+    unsigned char band[MAX_SECTIONS], stage[MAX_SECTIONS];
     for(int i = 0; i < MAX_EQ_BANDS; ++i) {
         if(filter[i].Ptype == 0)
             continue;
-        filter[i].l->filterout(efxoutl);
-        filter[i].r->filterout(efxoutr);
+        const AnalogFilter::Coeff &c = filter[i].coeff;
+        for(int j = 0; j < filter[i].Pstages + 1; ++j) {
+            target[n] = {c.c[0], c.c[1], c.c[2], c.d[1], c.d[2]};
+            band[n]   = i;
+            stage[n]  = j;
+            n++;
+        }
+    }
+
+    bool samelayout = n == nsections;
+    for(int i = 0; samelayout && i < n; ++i)
+        samelayout = band[i] == sectionband[i] && stage[i] == sectionstage[i];
+    if(samelayout) {
+        morphing = true;
+        return;
     }
+
+    //Keep the history of sections which stay in use
+    StereoBiquadHistory newhistory[MAX_SECTIONS];
+    memset(newhistory, 0, sizeof(newhistory));
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < nsections; ++j)
+            if(band[i] == sectionband[j] && stage[i] == sectionstage[j])
+                newhistory[i] = history[j];
+    memcpy(history, newhistory, sizeof(history));
+    memcpy(sectionband, band, sizeof(band));
+    memcpy(sectionstage, stage, sizeof(stage));
+    memcpy(sections, target, sizeof(sections));
+    nsections = n;
+    morphing  = false;
 }
 
 
@@ -201,43 +253,31 @@ void EQ::changepar(int npar, unsigned char value)
         return;
     int bp = npar % 5; //band paramenter
 
-    float tmp;
     switch(bp) {
         case 0:
             filter[nb].Ptype = value;
             if(value > 9)
                 filter[nb].Ptype = 0;  //has to be changed if more filters will be added
-            if(filter[nb].Ptype != 0) {
-                filter[nb].l->settype(value - 1);
-                filter[nb].r->settype(value - 1);
-            }
             break;
         case 1:
             filter[nb].Pfreq = value;
-            tmp = 600.0f * powf(30.0f, (value - 64.0f) / 64.0f);
-            filter[nb].l->setfreq(tmp);
-            filter[nb].r->setfreq(tmp);
+            filter[nb].freq  = 600.0f * powf(30.0f, (value - 64.0f) / 64.0f);
             break;
         case 2:
             filter[nb].Pgain = value;
-            tmp = 30.0f * (value - 64.0f) / 64.0f;
-            filter[nb].l->setgain(tmp);
-            filter[nb].r->setgain(tmp);
+            filter[nb].gain  = dB2rap(30.0f * (value - 64.0f) / 64.0f);
             break;
         case 3:
             filter[nb].Pq = value;
-            tmp = powf(30.0f, (value - 64.0f) / 64.0f);
-            filter[nb].l->setq(tmp);
-            filter[nb].r->setq(tmp);
+            filter[nb].q  = powf(30.0f, (value - 64.0f) / 64.0f);
             break;
         case 4:
             filter[nb].Pstages = value;
             if(value >= MAX_FILTER_STAGES)
                 filter[nb].Pstages = MAX_FILTER_STAGES - 1;
-            filter[nb].l->setstages(value);
-            filter[nb].r->setstages(value);
             break;
     }
+    updateband(nb);
 }
 
 unsigned char EQ::getpar(int npar) const
@@ -282,7 +322,8 @@ float EQ::getfreqresponse(float freq)
     for(int i = 0; i < MAX_EQ_BANDS; ++i) {
         if(filter[i].Ptype == 0)
             continue;
-        resp *= filter[i].l->H(freq);
+        resp *= AnalogFilter::H(filter[i].coeff, filter[i].Pstages, freq,
+                                samplerate_f);
     }
     return rap2dB(resp * outvolume);
 }
@@ -298,8 +339,8 @@ void EQ::getFilter(float *a, float *b) const
         auto &F = filter[i];
         if(F.Ptype == 0)
             continue;
-        const float Fb[3] = {F.l->coeff.c[0], F.l->coeff.c[1], F.l->coeff.c[2]};
-        const float Fa[3] = {1.0f, -F.l->coeff.d[1], -F.l->coeff.d[2]};
+        const float Fb[3] = {F.coeff.c[0], F.coeff.c[1], F.coeff.c[2]};
+        const float Fa[3] = {1.0f, -F.coeff.d[1], -F.coeff.d[2]};
 
         for(int j=0; j<F.Pstages+1; ++j) {
             for(int k=0; k<3; ++k) {
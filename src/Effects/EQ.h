@@ -15,6 +15,8 @@
 #define EQ_H
 
 #include "Effect.h"
+#include "../DSP/AnalogFilter.h"
+#include "../DSP/BiquadCascade.h"
 
 namespace zyn {
 
@@ -41,19 +43,26 @@ class EQ final:public Effect
         unsigned char Pvolume;
 
         void setvolume(unsigned char _Pvolume);
+        //Redesign one band and update the cascade of all active bands
+        void updateband(int nb);
 
         struct {
             //parameters
             unsigned char Ptype, Pfreq, Pgain, Pq, Pstages;
             //internal values
-
-            /* TODO
-             * The analog filters here really ought to be dumbed down some as
-             * you are just looking to do a batch convolution in the end
-             * Perhaps some static functions to do the filter design?
-             */
-            class AnalogFilter *l, *r;
+            float freq, gain, q;
+            AnalogFilter::Coeff coeff;
         } filter[MAX_EQ_BANDS];
+
+        /* All stages of all active bands form one cascade, which filters both
+         * channels in a single pass. Coefficient changes are interpolated over
+         * the next buffer, unless the bands or stages in use change. */
+        static const int MAX_SECTIONS = MAX_EQ_BANDS * MAX_FILTER_STAGES;
+        int                 nsections;
+        unsigned char       sectionband[MAX_SECTIONS], sectionstage[MAX_SECTIONS];
+        BiquadCoeff         sections[MAX_SECTIONS], target[MAX_SECTIONS];
+        StereoBiquadHistory history[MAX_SECTIONS];
+        bool                morphing;
 };
 
 }
@@ -76,10 +76,9 @@ Echo::Echo(EffectParams pars)
       delayTime(1),
       lrdelay(0),
       avgDelay(0),
-      delay(memory.valloc<float>(MAX_DELAY * pars.srate),
-            memory.valloc<float>(MAX_DELAY * pars.srate)),
+      delay(memory.alloc<DelayLine<float>>(memory, MAX_DELAY * pars.srate),
+            memory.alloc<DelayLine<float>>(memory, MAX_DELAY * pars.srate)),
       old(0.0f),
-      pos(0),
       delta(1),
       ndelta(1)
 {
@@ -89,15 +88,15 @@ Echo::Echo(EffectParams pars)
 
 Echo::~Echo()
 {
-    memory.devalloc(delay.l);
-    memory.devalloc(delay.r);
+    memory.dealloc(delay.l);
+    memory.dealloc(delay.r);
 }
 
 //Cleanup the effect
 void Echo::cleanup(void)
 {
-    memset(delay.l, 0, MAX_DELAY * samplerate * sizeof(float));
-    memset(delay.r, 0, MAX_DELAY * samplerate * sizeof(float));
+    delay.l->clear();
+    delay.r->clear();
     old = Stereo<float>(0.0f);
 }
 
@@ -125,8 +124,8 @@ void Echo::initdelays(void)
 void Echo::out(const Stereo<float *> &input)
 {
     for(int i = 0; i < buffersize; ++i) {
-        float ldl = delay.l[pos.l];
-        float rdl = delay.r[pos.r];
+        float ldl = delay.l->at(0);
+        float rdl = delay.r->at(0);
         ldl = ldl * (1.0f - lrcross) + rdl * lrcross;
         rdl = rdl * (1.0f - lrcross) + ldl * lrcross;
 
@@ -137,18 +136,12 @@ void Echo::out(const Stereo<float *> &input)
         rdl = input.r[i] * pangainR - rdl * fb;
 
         //LowPass Filter
-        old.l = delay.l[(pos.l + delta.l) % (MAX_DELAY * samplerate)] =
-                    ldl * hidamp + old.l * (1.0f - hidamp);
-        old.r = delay.r[(pos.r + delta.r) % (MAX_DELAY * samplerate)] =
-                    rdl * hidamp + old.r * (1.0f - hidamp);
+        old.l = delay.l->at(delta.l) = ldl * hidamp + old.l * (1.0f - hidamp);
+        old.r = delay.r->at(delta.r) = rdl * hidamp + old.r * (1.0f - hidamp);
 
         //increment
-        ++pos.l; // += delta.l;
-        ++pos.r; // += delta.r;
-
-        //ensure that pos is still in bounds
-        pos.l %= MAX_DELAY * samplerate;
-        pos.r %= MAX_DELAY * samplerate;
+        delay.l->advance();
+        delay.r->advance();
 
         //adjust delay if needed
         delta.l = (15 * delta.l + ndelta.l) / 16;
@@ -15,6 +15,7 @@
 #define ECHO_H
 
 #include "Effect.h"
+#include "../DSP/DelayLine.h"
 #include "../Misc/Stereo.h"
 
 namespace zyn {
@@ -86,12 +87,13 @@ class Echo final:public Effect
         float       avgDelay;
 
         void initdelays(void);
-        //2 channel ring buffer
-        Stereo<float *> delay;
-        Stereo<float>   old;
+        //2 channel ring buffer, written delta samples ahead of the reading.
+        //It is longer than MAX_DELAY seconds (a power of two), so while delta
+        //glides the reads may hit other stale samples than a ring of the
+        //exact length did; for a constant delay the output is the same.
+        Stereo<DelayLine<float> *> delay;
+        Stereo<float> old;
 
-        //position of reading/writing from delaysample
-        Stereo<int> pos;
         //step size for delay buffer
         Stereo<int> delta;
         Stereo<int> ndelta;
@@ -15,6 +15,8 @@
 #include <rtosc/port-sugar.h>
 #include <iostream>
 #include <cassert>
+#include <cctype>
+#include <cstring>
 
 #include "EffectMgr.h"
 #include "Effect.h"
@@ -27,6 +29,8 @@
 #include "DynamicFilter.h"
 #include "Phaser.h"
 #include "Sympathetic.h"
+#include "Convolution.h"
+#include "../Misc/Denormals.h"
 #include "../Misc/XMLwrapper.h"
 #include "../Misc/Util.h"
 #include "../Misc/Time.h"
@@ -35,6 +39,31 @@
 
 namespace zyn {
 
+//Whether a message writes a distortion parameter the shape table depends on
+//(the type, drive, shape and offset, or the oversampling which decides
+//whether a table is used at all), given as name or effect parameter number
+static bool writesshape(const char *msg)
+{
+    if(!rtosc_narguments(msg))
+        return false;
+    if(!strncmp(msg, "parameter", 9)) {
+        switch(atoi(msg + 9)) {
+            case 3: case 5: case 11: case 12: case 13:
+                return true;
+            default:
+                return false;
+        }
+    }
+    static const char *const names[] = {"Ptype", "Pdrive", "Pfuncpar",
+                                        "Poffset", "Poversampling"};
+    for(const char *name:names) {
+        const size_t len = strlen(name);
+        if(!strncmp(msg, name, len) && !isalnum(msg[len]))
+            return true;
+    }
+    return false;
+}
+
 #define rObject EffectMgr
 #define rSubtype(name) \
     {STRINGIFY(name)"/", NULL, &name::ports,\
@@ -45,6 +74,9 @@ namespace zyn {
                 return; \
             SNIP \
             name::ports.dispatch(msg, data); \
+            data.obj = &o; \
+            if(writesshape(msg)) \
+                o.requestshapetable(data); \
         }}
 static const rtosc::Ports local_ports = {
     rSelf(EffectMgr, rEnabledByCondition(self-enabled)),
@@ -59,6 +91,7 @@ static const rtosc::Ports local_ports = {
             else {
                 eff->changepresetrt(rtosc_argument(msg, 0).i);
                 d.broadcast(d.loc, "i", eff->getpreset());
+                eff->requestshapetable(d);
 
                 //update parameters as well
                 fast_strcpy(loc, d.loc, sizeof(loc));
@@ -119,6 +152,8 @@ static const rtosc::Ports local_ports = {
                 eff->seteffectparrt(atoi(mm), 0);
                 d.broadcast(d.loc, "i", eff->geteffectparrt(atoi(mm)));
             }
+            if(writesshape(msg))
+                eff->requestshapetable(d);
         }},
     {"numerator::i", rShort("num") rDefault(0) rLinear(0,99)
         rProp(parameter) rDoc("Numerator of ratio to bpm"), NULL,
@@ -229,9 +264,11 @@ static const rtosc::Ports local_ports = {
             d.reply(d.loc, "bb", sizeof(a), a, sizeof(b), b);
         }},
     {"efftype::i:c:S", rOptions(Disabled, Reverb, Echo, Chorus,
-     Phaser, Alienwah, Distortion, EQ, DynFilter, Sympathetic) rDefault(Disabled)
+     Phaser, Alienwah, Distortion, EQ, DynFilter, Sympathetic, Convolution)
+     rDefault(Disabled)
      rProp(parameter) rDoc("Get Effect Type"), NULL,
-     rCOptionCb(obj->nefx, obj->changeeffectrt(var))},
+     rCOptionCb(obj->nefx, (obj->changeeffectrt(var),
+                            obj->requestshapetable(data)))},
     {"efftype:b", rProp(internal) rDoc("Pointer swap EffectMgr"), NULL,
         [](const char *msg, rtosc::RtData &d)
         {
@@ -245,12 +282,48 @@ static const rtosc::Ports local_ports = {
             std::swap(eff->filterpars,eff_->filterpars);
             std::swap(eff->efxoutl, eff_->efxoutl);
             std::swap(eff->efxoutr, eff_->efxoutr);
+            std::swap(eff->shapetable, eff_->shapetable);
 
             //Return the old data for destruction
             d.reply("/free", "sb", "EffectMgr", sizeof(EffectMgr*), &eff_);
         }},
+    {"ir-file::s", rDoc("Impulse response of the convolution effect, "
+                        "which is loaded by the middleware"), NULL,
+        [](const char *msg, rtosc::RtData &d)
+        {
+            EffectMgr *eff = (EffectMgr*)d.obj;
+            if(!rtosc_narguments(msg))
+                d.reply(d.loc, "s", eff->ir ? eff->ir->filename.c_str() : "");
+        }},
+    {"ir:b", rProp(internal) rDoc("Pointer swap ImpulseResponse"), NULL,
+        [](const char *msg, rtosc::RtData &d)
+        {
+            EffectMgr *eff = (EffectMgr*)d.obj;
+            ImpulseResponse *ir = *(ImpulseResponse**)rtosc_argument(msg,0).b.data;
+            std::swap(eff->ir, ir);
+            if(Convolution *conv = dynamic_cast<Convolution*>(eff->efx))
+                conv->setir(eff->ir);
+            if(ir)
+                d.reply("/free", "sb", "ImpulseResponse",
+                        sizeof(ImpulseResponse*), &ir);
+        }},
+    {"shapetable:b", rProp(internal) rDoc("Pointer swap table of the "
+                                          "distortion shape"), NULL,
+        [](const char *msg, rtosc::RtData &d)
+        {
+            EffectMgr *eff = (EffectMgr*)d.obj;
+            WaveShaper::Table *table =
+                *(WaveShaper::Table**)rtosc_argument(msg,0).b.data;
+            std::swap(eff->shapetable, table);
+            if(Distortion *dist = dynamic_cast<Distortion*>(eff->efx))
+                dist->setshapetable(eff->shapetable);
+            if(table)
+                d.reply("/free", "sb", "WaveShaperTable",
+                        sizeof(WaveShaper::Table*), &table);
+        }},
     rSubtype(Alienwah),
     rSubtype(Chorus),
+    rSubtype(Convolution),
     rSubtype(Distortion),
     rSubtype(DynamicFilter),
     rSubtype(Echo),
@@ -270,6 +343,8 @@ EffectMgr::EffectMgr(Allocator &alloc, const SYNTH_T &synth_,
       filterpars(new FilterParams(in_effect, time_)),
       nefx(0),
       efx(NULL),
+      ir(NULL),
+      shapetable(NULL),
       time(time_),
       numerator(0),
       denominator(4),
@@ -288,6 +363,8 @@ EffectMgr::EffectMgr(Allocator &alloc, const SYNTH_T &synth_,
 EffectMgr::~EffectMgr()
 {
     memory.dealloc(efx);
+    delete ir;
+    delete shapetable;
     delete filterpars;
     delete [] efxoutl;
     delete [] efxoutr;
@@ -336,6 +413,7 @@ void EffectMgr::changeeffectrt(int _nefx, bool avoidSmash)
                 break;
             case 6:
                 efx = memory.alloc<Distortion>(pars);
+                static_cast<Distortion*>(efx)->setshapetable(shapetable);
                 break;
             case 7:
                 efx = memory.alloc<EQ>(pars);
@@ -346,6 +424,10 @@ void EffectMgr::changeeffectrt(int _nefx, bool avoidSmash)
             case 9:
                 efx = memory.alloc<Sympathetic>(pars);
                 break;
+            case 10:
+                efx = memory.alloc<Convolution>(pars);
+                static_cast<Convolution*>(efx)->setir(ir);
+                break;
             //put more effect here
             default:
                 efx = NULL;
@@ -424,6 +506,29 @@ void EffectMgr::changesettingsrt(const short int *p_value)
     }
 }
 
+void EffectMgr::requestshapetable(rtosc::RtData &d)
+{
+    Distortion *dist = nefx == 6 ? dynamic_cast<Distortion*>(efx) : nullptr;
+    unsigned char shape[4];
+    if(dist && dist->requestshapetable(shape))
+        d.reply("/shapetable", "siiii", d.loc, shape[0], shape[1], shape[2],
+                shape[3]);
+}
+
+void EffectMgr::prepareshapetable(void)
+{
+    //type, drive, offset and funcpar as for WaveShaper::buildtable()
+    const int npar[4] = {5, 3, 12, 11};
+    unsigned char shape[4];
+    for(int i = 0; i < 4; ++i) {
+        const short int value = settings[npar[i]];
+        shape[i] = value >= 0 ? value : Distortion::presetpar(preset, npar[i]);
+    }
+    shape[0] = (shape[0] > 16 ? 16 : shape[0]) + 1;
+    delete shapetable;
+    shapetable = WaveShaper::buildtable(shape[0], shape[1], shape[2], shape[3]);
+}
+
 // Initialize An Effect in RT context
 void EffectMgr::init(void)
 {
@@ -514,12 +619,17 @@ void EffectMgr::out(float *smpsl, float *smpsr)
             }
         return;
     }
+#if ZYN_FLUSH_DENORMALS
+    memset(efxoutl, 0, synth.bufferbytes);
+    memset(efxoutr, 0, synth.bufferbytes);
+#else
     for(int i = 0; i < synth.buffersize; ++i) {
         smpsl[i]  += synth.denormalkillbuf[i];
         smpsr[i]  += synth.denormalkillbuf[i];
         efxoutl[i] = 0.0f;
         efxoutr[i] = 0.0f;
     }
+#endif
     efx->out(smpsl, smpsr);
 
     float volume = efx->volume;
@@ -595,6 +705,14 @@ void EffectMgr::paste(EffectMgr &e)
         std::swap(filterpars, e.filterpars);
         efx->filterpars = filterpars;
     }
+    //the impulse response of e is freed together with e
+    std::swap(ir, e.ir);
+    if(Convolution *conv = dynamic_cast<Convolution*>(efx))
+        conv->setir(ir);
+    //so is the table of the distortion shape
+    std::swap(shapetable, e.shapetable);
+    if(Distortion *dist = dynamic_cast<Distortion*>(efx))
+        dist->setshapetable(shapetable);
     cleanup(); // cleanup the effect and recompute its parameters
 }
 
@@ -631,6 +749,8 @@ void EffectMgr::add2XML(XMLwrapper& xml)
         xml.endbranch();
     }
     xml.endbranch();
+    if(nefx == 10 && ir)
+        xml.addparstr("ir_file", ir->filename);
     xml.addpar("numerator", numerator);
     xml.addpar("denominator", denominator);
 }
@@ -680,6 +800,13 @@ void EffectMgr::getfromXML(XMLwrapper& xml)
     }
     numerator = xml.getpar("numerator", numerator, 0, 99);
     denominator = xml.getpar("denominator", denominator, 1, 99);
+    const std::string ir_file = xml.getparstr("ir_file", "");
+    if(geteffect() == 10 && !ir_file.empty()) {
+        delete ir;
+        ir = ImpulseResponse::load(ir_file, synth);
+    }
+    if(geteffect() == 6)
+        prepareshapetable();
     cleanup();
 }
 
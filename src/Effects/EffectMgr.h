@@ -18,6 +18,9 @@
 
 #include "../Params/FilterParams.h"
 #include "../Params/Presets.h"
+#include "../Misc/WaveShapeSmps.h"
+
+namespace rtosc {struct RtData;}
 
 namespace zyn {
 
@@ -25,6 +28,7 @@ class Effect;
 class FilterParams;
 class XMLwrapper;
 class Allocator;
+struct ImpulseResponse;
 
 /** Effect manager, an interface between the program and effects */
 class EffectMgr:public Presets
@@ -51,6 +55,10 @@ class EffectMgr:public Presets
         void cleanup(void) REALTIME;
 
         void changesettingsrt(const short int *) REALTIME;
+        //Ask the middleware for the table of the distortion shape
+        void requestshapetable(rtosc::RtData &d) REALTIME;
+        //Build the table of the distortion shape from the settings
+        void prepareshapetable(void) NONREALTIME;
         void changeeffectrt(int nefx_, bool avoidSmash=false) REALTIME;
         void changeeffect(int nefx_) NONREALTIME;
         int geteffect(void);
@@ -72,6 +80,11 @@ class EffectMgr:public Presets
         static const rtosc::Ports &ports;
         int     nefx;
         Effect *efx;
+        //impulse response of the convolution effect, kept across changes of
+        //the effect type
+        ImpulseResponse *ir;
+        //table of the distortion shape, built by the middleware
+        WaveShaper::Table *shapetable;
         const AbsTime *time;
         
         int numerator;
@@ -100,6 +100,7 @@ Reverb::Reverb(EffectParams pars)
       roomsize(1.0f),
       rs(1.0f),
       bandwidth(NULL),
+      combbuf(NULL),
       idelay(NULL),
       lpf(NULL),
       hpf(NULL) // no filter
@@ -114,7 +115,6 @@ Reverb::Reverb(EffectParams pars)
 
     for(int i = 0; i < REV_APS * 2; ++i) {
         aplen[i] = 500 + (int)(RND * 500.0f);
-        apk[i]   = 0;
         ap[i]    = NULL;
     }
     setpreset(Ppreset);
@@ -124,14 +124,13 @@ Reverb::Reverb(EffectParams pars)
 
 Reverb::~Reverb()
 {
-    memory.devalloc(idelay);
+    memory.dealloc(idelay);
     memory.dealloc(hpf);
     memory.dealloc(lpf);
 
     for(int i = 0; i < REV_APS * 2; ++i)
-        memory.devalloc(ap[i]);
-    for(int i = 0; i < REV_COMBS * 2; ++i)
-        memory.devalloc(comb[i]);
+        memory.dealloc(ap[i]);
+    memory.devalloc(combbuf);
 
     memory.dealloc(bandwidth);
 }
@@ -139,61 +138,108 @@ Reverb::~Reverb()
 //Cleanup the effect
 void Reverb::cleanup(void)
 {
+    int total = 0;
     for(int i = 0; i < REV_COMBS * 2; ++i) {
         lpcomb[i] = 0.0f;
-        for(int j = 0; j < comblen[i]; ++j)
-            comb[i][j] = 0.0f;
+        total    += comblen[i];
     }
+    if(combbuf)
+        memset(combbuf, 0, total * sizeof(float));
 
     for(int i = 0; i < REV_APS * 2; ++i)
-        for(int j = 0; j < aplen[i]; ++j)
-            ap[i][j] = 0.0f;
+        ap[i]->clear();
 
     if(idelay)
-        for(int i = 0; i < idelaylen; ++i)
-            idelay[i] = 0.0f;
+        idelay->clear();
     if(hpf)
         hpf->cleanup();
     if(lpf)
         lpf->cleanup();
 }
 
-//Process one channel; 0=left, 1=right
-void Reverb::processmono(int ch, float *output, float *inputbuf)
+//One step of the lowpassed feedback for all combs of both channels
+//The combs do not depend on each other, so this loop gets vectorized
+static void combstep(int n, float (*smp)[REV_COMBS * 2],
+                     float *__restrict lpcomb, const float *__restrict combfb,
+                     float lohifb)
 {
-    //todo: implement the high part from lohidamp
-
-    for(int j = REV_COMBS * ch; j < REV_COMBS * (ch + 1); ++j) {
-        int &ck = combk[j];
-        const int comblength = comblen[j];
-        float    &lpcombj    = lpcomb[j];
+    const float hifb = 1.0f - lohifb;
+    for(int i = 0; i < n; ++i)
+        for(int j = 0; j < REV_COMBS * 2; ++j) {
+            float fbout = smp[i][j] * combfb[j];
+            fbout     = fbout * hifb + lpcomb[j] * lohifb;
+            lpcomb[j] = fbout;
+            smp[i][j] = fbout;
+        }
+}
 
-        for(int i = 0; i < buffersize; ++i) {
-            float fbout = comb[j][ck] * combfb[j];
-            fbout   = fbout * (1.0f - lohifb) + lpcombj * lohifb;
-            lpcombj = fbout;
+//Process the combs of both channels, adding them to efxoutl and efxoutr
+//
+//The combs are processed in chunks which contain no wrap around of any comb,
+//so each chunk is copied into an interleaved buffer, filtered for all combs
+//at once and copied back. A chunk is never longer than a comb, so no sample
+//written within it is read again. The operations and the order in which the
+//combs are summed are the same as when each comb is processed on its own.
+void Reverb::processcombs(const float *inputbuf)
+{
+    //todo: implement the high part from lohidamp
+    float smp[REV_CHUNK][REV_COMBS * 2];
+
+    for(int pos = 0; pos < buffersize;) {
+        int n = buffersize - pos;
+        if(n > REV_CHUNK)
+            n = REV_CHUNK;
+        for(int j = 0; j < REV_COMBS * 2; ++j)
+            if(comblen[j] - combk[j] < n)
+                n = comblen[j] - combk[j];
+
+        for(int j = 0; j < REV_COMBS * 2; ++j) {
+            const float *c = comb[j] + combk[j];
+            for(int i = 0; i < n; ++i)
+                smp[i][j] = c[i];
+        }
 
-            comb[j][ck] = inputbuf[i] + fbout;
-            output[i]  += fbout;
+        combstep(n, smp, lpcomb, combfb, lohifb);
 
-            if((++ck) >= comblength)
-                ck = 0;
+        for(int j = 0; j < REV_COMBS * 2; ++j) {
+            float *c = comb[j] + combk[j];
+            for(int i = 0; i < n; ++i)
+                c[i] = inputbuf[pos + i] + smp[i][j];
+            combk[j] += n;
+            if(combk[j] >= comblen[j])
+                combk[j] = 0;
         }
-    }
 
-    for(int j = REV_APS * ch; j < REV_APS * (1 + ch); ++j) {
-        int &ak = apk[j];
-        const int aplength = aplen[j];
-        for(int i = 0; i < buffersize; ++i) {
-            float tmp = ap[j][ak];
-            ap[j][ak] = 0.7f * tmp + output[i];
-            output[i] = tmp - 0.7f * ap[j][ak];
-            if((++ak) >= aplength)
-                ak = 0;
+        for(int i = 0; i < n; ++i) {
+            float l = efxoutl[pos + i];
+            float r = efxoutr[pos + i];
+            for(int j = 0; j < REV_COMBS; ++j) {
+                l += smp[i][j];
+                r += smp[i][REV_COMBS + j];
+            }
+            efxoutl[pos + i] = l;
+            efxoutr[pos + i] = r;
         }
+        pos += n;
     }
 }
 
+//Process the allpasses of one channel; 0=left, 1=right
+void Reverb::processmono(int ch, float *output)
+{
+    for(int j = REV_APS * ch; j < REV_APS * (1 + ch); ++j)
+        ap[j]->process(aplen[j], buffersize,
+                       [output](const float *__restrict src,
+                                float *__restrict dst, int i, int n) {
+            float *out = output + i;
+            for(int k = 0; k < n; ++k) {
+                float tmp = src[k];
+                dst[k] = 0.7f * tmp + out[k];
+                out[k] = tmp - 0.7f * dst[k];
+            }
+        });
+}
+
 //Effect output
 void Reverb::out(const Stereo<float *> &smp)
 {
@@ -204,16 +250,20 @@ void Reverb::out(const Stereo<float *> &smp)
     for(int i = 0; i < buffersize; ++i)
         inputbuf[i] = (smp.l[i] + smp.r[i]) / 2.0f;
 
-    if(idelay)
-        for(int i = 0; i < buffersize; ++i) {
+    if(idelay) {
+        float *in = inputbuf;
+        const float fb = idelayfb;
+        idelay->process(idelaylen, buffersize,
+                        [in, fb](const float *__restrict src,
+                                 float *__restrict dst, int i, int n) {
             //Initial delay r
-            float tmp = inputbuf[i] + idelay[idelayk] * idelayfb;
-            inputbuf[i]     = idelay[idelayk];
-            idelay[idelayk] = tmp;
-            idelayk++;
-            if(idelayk >= idelaylen)
-                idelayk = 0;
-        }
+            for(int k = 0; k < n; ++k) {
+                float tmp = in[i + k] + src[k] * fb;
+                in[i + k] = src[k];
+                dst[k] = tmp;
+            }
+        });
+    }
 
     if(bandwidth)
         bandwidth->process(buffersize, inputbuf);
@@ -223,8 +273,9 @@ void Reverb::out(const Stereo<float *> &smp)
     if(hpf)
         hpf->filterout(inputbuf);
 
-    processmono(0, efxoutl, inputbuf); //left
-    processmono(1, efxoutr, inputbuf); //right
+    processcombs(inputbuf);
+    processmono(0, efxoutl); //left
+    processmono(1, efxoutr); //right
 
     float lvol = rs / REV_COMBS * pangainL;
     float rvol = rs / REV_COMBS * pangainR;
@@ -295,14 +346,11 @@ void Reverb::setidelay(unsigned char _Pidelay)
     if(newDelayLen == idelaylen)
         return;
 
-    memory.devalloc(idelay);
+    memory.dealloc(idelay);
 
     idelaylen = newDelayLen;
-    if(idelaylen > 1) {
-        idelayk = 0;
-        idelay  = memory.valloc<float>(idelaylen);
-        memset(idelay, 0, idelaylen * sizeof(float));
-    }
+    if(idelaylen > 1)
+        idelay = memory.alloc<DelayLine<float>>(memory, idelaylen);
 }
 
 void Reverb::setidelayfb(unsigned char _Pidelayfb)
@@ -367,6 +415,7 @@ void Reverb::settype(unsigned char _Ptype)
     // adjust the combs according to the samplerate
     float samplerate_adjust = samplerate_f / 44100.0f;
     float tmp;
+    bool  resized = combbuf == NULL;
     for(int i = 0; i < REV_COMBS * 2; ++i) {
         if(Ptype == 0)
             tmp = 800.0f + (int)(RND * 1400.0f);
@@ -380,12 +429,20 @@ void Reverb::settype(unsigned char _Ptype)
             tmp = 10.0f;
         combk[i]   = 0;
         lpcomb[i]  = 0;
-        if(comblen[i] != (int)tmp || comb[i] == NULL) {
+        if(comblen[i] != (int)tmp) {
             comblen[i] = (int) tmp;
-            memory.devalloc(comb[i]);
-            comb[i] = memory.valloc<float>(comblen[i]);
+            resized    = true;
         }
     }
+    if(resized) {
+        int total = 0;
+        for(int i = 0; i < REV_COMBS * 2; ++i)
+            total += comblen[i];
+        memory.devalloc(combbuf);
+        combbuf = memory.valloc<float>(total);
+        for(int i = 0, offset = 0; i < REV_COMBS * 2; offset += comblen[i++])
+            comb[i] = combbuf + offset;
+    }
 
     for(int i = 0; i < REV_APS * 2; ++i) {
         if(Ptype == 0)
@@ -398,11 +455,10 @@ void Reverb::settype(unsigned char _Ptype)
         tmp *= samplerate_adjust; //adjust the combs according to the samplerate
         if(tmp < 10)
             tmp = 10;
-        apk[i]   = 0;
         if(aplen[i] != (int)tmp || ap[i] == NULL) {
             aplen[i] = (int) tmp;
-            memory.devalloc(ap[i]);
-            ap[i] = memory.valloc<float>(aplen[i]);
+            memory.dealloc(ap[i]);
+            ap[i] = memory.alloc<DelayLine<float>>(memory, aplen[i]);
         }
     }
     memory.dealloc(bandwidth);
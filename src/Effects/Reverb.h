@@ -15,9 +15,12 @@
 #define REVERB_H
 
 #include "Effect.h"
+#include "../DSP/DelayLine.h"
 
 #define REV_COMBS 8
 #define REV_APS 4
+//samples of the combs which are processed together
+#define REV_CHUNK 32
 
 namespace zyn {
 
@@ -60,13 +63,13 @@ class Reverb final:public Effect
         void settype(unsigned char _Ptype);
         void setroomsize(unsigned char _Proomsize);
         void setbandwidth(unsigned char _Pbandwidth);
-        void processmono(int ch, float *output, float *inputbuf);
+        void processcombs(const float *inputbuf);
+        void processmono(int ch, float *output);
 
 
         //Parameters
         int   lohidamptype;   //0=disable, 1=highdamp (lowpass), 2=lowdamp (highpass)
         int   idelaylen;
-        int   idelayk;
         float lohifb;
         float idelayfb;
         float roomsize;
@@ -76,13 +79,14 @@ class Reverb final:public Effect
         class Unison * bandwidth;
 
         //Internal Variables
+        //the combs of both channels are stored one after another in combbuf
+        float *combbuf;
         float *comb[REV_COMBS * 2];
         int    combk[REV_COMBS * 2];
         float  combfb[REV_COMBS * 2]; //feedback-ul fiecarui filtru "comb"
         float  lpcomb[REV_COMBS * 2]; //pentru Filtrul LowPass
-        float *ap[REV_APS * 2];
-        int    apk[REV_APS * 2];
-        float *idelay;
+        DelayLine<float> *ap[REV_APS * 2];
+        DelayLine<float> *idelay;
         class AnalogFilter * lpf, *hpf; //filters
 };
 
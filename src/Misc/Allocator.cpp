@@ -14,6 +14,7 @@
 #include <cassert>
 #include <utility>
 #include <cstdio>
+#include <mutex>
 #include "../../tlsf/tlsf.h"
 #include "Allocator.h"
 
@@ -44,6 +45,9 @@ struct AllocatorImpl
     //nice values
     next_t *pools = 0;
     unsigned long long totalAlloced = 0;
+
+    //only set while the allocator is shared by several threads
+    std::mutex *lock = 0;
 };
 
 Allocator::Allocator(void) : transaction_active()
@@ -67,11 +71,25 @@ Allocator::~Allocator(void)
         free(n);
         n = nn;
     }
+    delete impl->lock;
     delete impl;
 }
 
+void Allocator::setConcurrent(bool concurrent)
+{
+    if(concurrent && !impl->lock)
+        impl->lock = new std::mutex;
+    else if(!concurrent) {
+        delete impl->lock;
+        impl->lock = 0;
+    }
+}
+
 void *AllocatorClass::alloc_mem(size_t mem_size)
 {
+    std::unique_lock<std::mutex> guard;
+    if(impl->lock)
+        guard = std::unique_lock<std::mutex>(*impl->lock);
     impl->totalAlloced += mem_size;
     void *mem = tlsf_malloc(impl->tlsf, mem_size);
     //printf("Allocator.malloc(%p, %d) = %p\n", impl, mem_size, mem);
@@ -82,6 +100,9 @@ void *AllocatorClass::alloc_mem(size_t mem_size)
 void AllocatorClass::dealloc_mem(void *memory)
 {
     //printf("dealloc_mem(%d)\n", tlsf_block_size(memory));
+    std::unique_lock<std::mutex> guard;
+    if(impl->lock)
+        guard = std::unique_lock<std::mutex>(*impl->lock);
     tlsf_free(impl->tlsf, memory);
     //free(memory);
 }
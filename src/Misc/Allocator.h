@@ -107,6 +107,10 @@ class Allocator
     void beginTransaction();
     void endTransaction();
 
+    //Serialize (de)allocations, so several non realtime threads can share
+    //the allocator (e.g. while the parts of a new Master are loaded)
+    void setConcurrent(bool concurrent);
+
     virtual void addMemory(void *, size_t mem_size) = 0;
 
     //Return true if the current pool cannot allocate n chunks of chunk_size
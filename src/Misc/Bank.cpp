@@ -61,7 +61,7 @@ Bank::Bank(Config *config)
 {
     clearbank();
     bankfiletitle = dirname;
-    rescanforbanks();
+    rescanforbanks(true);
     loadbank(config->cfg.currentBankDir);
 
     for(unsigned i=0; i<banks.size(); ++i) {
@@ -371,7 +371,7 @@ bool Bank::bankstruct::operator<(const bankstruct &b) const
  * Re-scan for directories containing instrument banks
  */
 
-void Bank::rescanforbanks()
+void Bank::rescanforbanks(bool reuse)
 {
     db->clear();
     //remove old banks
@@ -431,7 +431,7 @@ void Bank::rescanforbanks()
         if(dupl)
             j += dupl;
     }
-    db->scanBanks();
+    db->scanBanks(reuse);
 }
 
 void Bank::setMsb(uint8_t msb)
@@ -58,7 +58,9 @@ class Bank
         std::string bankfiletitle; //this is shown on the UI of the bank (the title of the window)
         int locked();
 
-        void rescanforbanks();
+        /**@param reuse take the instrument index of another Bank of the
+         *              process with the same banks instead of rescanning*/
+        void rescanforbanks(bool reuse = false);
 
         void setMsb(uint8_t msb);
         void setLsb(uint8_t lsb);
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <mutex>
 
 namespace zyn {
 
@@ -14,6 +15,20 @@ using std::string;
 typedef BankDb::svec svec;
 typedef BankDb::bvec bvec;
 
+//The result of a scan is immutable, so searches only need to hold the lock to
+//grab the current one, and a scan only to publish its result. Scans of the
+//same banks are serialized by their own mutex, so the second of two instances
+//starting together waits for the first and reuses its scan.
+struct BankIndex
+{
+    std::mutex scan;
+    std::mutex lock;
+    std::shared_ptr<const bvec> fields;
+};
+
+static std::mutex index_lock;
+static std::map<svec, std::weak_ptr<BankIndex>> indices;
+
 BankEntry::BankEntry(void)
     :id(0), add(false), pad(false), sub(false), time(0)
 {}
@@ -95,8 +110,16 @@ static svec split(string s)
 bvec BankDb::search(std::string ss) const
 {
     bvec vec;
+    std::shared_ptr<const bvec> fields;
+    if(index) {
+        std::lock_guard<std::mutex> guard(index->lock);
+        fields = index->fields;
+    }
+    if(!fields)
+        return vec;
+
     const svec sterm = split(ss);
-    for(auto field:fields) {
+    for(auto &field:*fields) {
         bool match = true;
         for(auto s:sterm)
             match &= field.match(s);
@@ -122,7 +145,7 @@ void BankDb::addBankDir(std::string bnk)
 void BankDb::clear(void)
 {
     banks.clear();
-    fields.clear();
+    index.reset();
 }
 
 static std::string getCacheName(void)
@@ -187,9 +210,34 @@ static void saveCache(bvec vec)
     xml.saveXMLfile(getCacheName(), 0);
 }
 
-void BankDb::scanBanks(void)
+void BankDb::scanBanks(bool reuse)
 {
-    fields.clear();
+    {
+        std::lock_guard<std::mutex> guard(index_lock);
+        std::weak_ptr<BankIndex> &shared = indices[banks];
+        index = shared.lock();
+        if(!index) {
+            index  = std::make_shared<BankIndex>();
+            shared = index;
+        }
+
+        //drop the indices of bank lists no BankDb uses anymore, e.g. the
+        //previous list of this one after a root was removed
+        for(auto itr = indices.begin(); itr != indices.end();)
+            if(itr->second.expired())
+                itr = indices.erase(itr);
+            else
+                ++itr;
+    }
+
+    std::lock_guard<std::mutex> scan(index->scan);
+    if(reuse) {
+        std::lock_guard<std::mutex> guard(index->lock);
+        if(index->fields)
+            return;
+    }
+
+    bvec fields;
     bvec cache = loadCache();
     bmap cc;
     for(auto c:cache)
@@ -222,6 +270,11 @@ void BankDb::scanBanks(void)
 
     }
     saveCache(ncache);
+
+    std::shared_ptr<const bvec> result =
+        std::make_shared<const bvec>(std::move(fields));
+    std::lock_guard<std::mutex> guard(index->lock);
+    index->fields = std::move(result);
 }
 
 BankEntry BankDb::processXiz(std::string filename,
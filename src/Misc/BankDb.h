@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 namespace zyn {
 
@@ -48,12 +49,15 @@ class BankDb
         svec tags(void) const;
 
         //scan banks
-        void scanBanks(void);
+        //with reuse, the index is taken from another BankDb of the process
+        //which has scanned the same banks, if there is one
+        void scanBanks(bool reuse = false);
 
     private:
         BankEntry processXiz(std::string, std::string, bmap&) const;
-        bvec fields;
         svec banks;
+        //shared by all BankDbs with the same banks
+        std::shared_ptr<struct BankIndex> index;
 };
 
 }
@@ -0,0 +1,738 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BinaryPreset.cpp - Binary form of saved parameter trees
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include "BinaryPreset.h"
+#include "XmlDocument.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+namespace zyn {
+
+typedef BinaryPresetNode Node;
+
+static uint32_t keyKind(const Node &node)
+{
+    return node.type >> 8 & 0x7f;
+}
+
+static uint32_t attrCount(const Node &node)
+{
+    return node.type >> 16;
+}
+
+static bool bigEndian(void)
+{
+    const uint16_t one = 1;
+    return *(const uint8_t *)&one == 0;
+}
+
+static void swapWords(void *data, size_t words)
+{
+    uint32_t *w = (uint32_t *)data;
+    for(size_t i = 0; i < words; ++i)
+        w[i] = (w[i] >> 24) | ((w[i] >> 8) & 0xff00)
+               | ((w[i] << 8) & 0xff0000) | (w[i] << 24);
+}
+
+//FNV-1a hash of the parent, the tag and the key
+static uint32_t hashKey(uint32_t parent, const char *tag, uint32_t key,
+                        const char *value)
+{
+    uint32_t h = 2166136261u;
+    for(int i = 0; i < 4; ++i)
+        h = (h ^ ((parent >> (8 * i)) & 0xff)) * 16777619u;
+    for(; *tag; ++tag)
+        h = (h ^ (uint8_t)*tag) * 16777619u;
+    h = (h ^ 0xff) * 16777619u;
+    h = (h ^ key) * 16777619u;
+    for(; *value; ++value)
+        h = (h ^ (uint8_t)*value) * 16777619u;
+    return h;
+}
+
+//Formatting of XMLwrapper::addpar() and addparreal()
+static std::string formatInt(int val)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", val);
+    return buf;
+}
+
+static std::string formatReal(float val)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%g", val);
+    return buf;
+}
+
+static std::string formatExact(uint32_t bits)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "0x%.8X", bits);
+    return buf;
+}
+
+static void escape(std::string &out, const char *str)
+{
+    for(; *str; ++str)
+        switch(*str) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += *str;
+        }
+}
+
+/* Writer */
+
+BinaryPresetWriter::BinaryPresetWriter(void)
+    :strings(1, '\0')
+{
+    stringmap[""] = 0;
+    Node root;
+    memset(&root, 0, sizeof(root));
+    nodes.push_back(root);
+    stack.push_back(std::make_pair(0u, 0u));
+}
+
+uint32_t BinaryPresetWriter::string(const char *str)
+{
+    auto itr = stringmap.find(str);
+    if(itr != stringmap.end())
+        return itr->second;
+    const uint32_t offset = strings.size();
+    strings.append(str, strlen(str) + 1);
+    stringmap[str] = offset;
+    return offset;
+}
+
+void BinaryPresetWriter::begin(const char *name, const char *const *attrs_,
+                               int nattrs)
+{
+    const uint32_t idx    = nodes.size();
+    const uint32_t parent = stack.back().first;
+
+    Node node;
+    memset(&node, 0, sizeof(node));
+    node.name   = string(name);
+    node.parent = parent;
+    node.value  = attrs.size();
+
+    uint32_t keykind = Node::NoKey;
+    for(int i = 0; i < nattrs; ++i) {
+        const char *key   = attrs_[2 * i];
+        const char *value = attrs_[2 * i + 1] ? attrs_[2 * i + 1] : "";
+        if(!*key)
+            continue;
+        attrs.push_back(string(key));
+        attrs.push_back(string(value));
+        if(!strcmp(key, "name") && keykind != Node::NameKey) {
+            keykind  = Node::NameKey;
+            node.key = attrs.back();
+        } else if(!strcmp(key, "id") && keykind == Node::NoKey) {
+            keykind  = Node::IdKey;
+            node.key = attrs.back();
+        }
+    }
+    node.type = Node::Generic | keykind << 8
+                | (uint32_t)(attrs.size() - node.value) / 2 << 16;
+
+    if(stack.back().second)
+        nodes[stack.back().second].next = idx;
+    else
+        nodes[parent].type |= Node::HasChild;
+    stack.back().second = idx;
+
+    nodes.push_back(node);
+    stack.push_back(std::make_pair(idx, 0u));
+}
+
+void BinaryPresetWriter::text(const char *text)
+{
+    Node &node = nodes[stack.back().first];
+    //only character data before the first child is kept, which is
+    //contiguous with the other attributes
+    if(!text || !*text || stack.size() < 2 || stack.back().second
+       || node.value + 2 * attrCount(node) != attrs.size()
+       || getText(node))
+        return;
+    attrs.push_back(0);
+    attrs.push_back(string(text));
+    node.type += 1 << 16;
+}
+
+void BinaryPresetWriter::end(void)
+{
+    if(stack.size() < 2)
+        return;
+    typed(nodes[stack.back().first]);
+    stack.pop_back();
+}
+
+const char *BinaryPresetWriter::getText(const Node &node) const
+{
+    const uint32_t nattrs = attrCount(node);
+    for(uint32_t i = 0; i < nattrs; ++i)
+        if(!attrs[node.value + 2 * i])
+            return strings.c_str() + attrs[node.value + 2 * i + 1];
+    return NULL;
+}
+
+//Store the parameters of XMLwrapper as typed values, if they can be
+//reproduced exactly
+void BinaryPresetWriter::typed(Node &node)
+{
+    const int   nattrs = attrCount(node);
+    const char *name   = strings.c_str() + node.name;
+    if((node.type & Node::HasChild) || !nattrs
+       || keyKind(node) != Node::NameKey
+       || strcmp(strings.c_str() + attrs[node.value], "name"))
+        return;
+
+    auto key = [this, &node](int i) {
+        return strings.c_str() + attrs[node.value + 2 * i];
+    };
+    auto value = [this, &node](int i) {
+        return std::string(strings.c_str() + attrs[node.value + 2 * i + 1]);
+    };
+
+    uint32_t type = Node::Generic;
+    uint32_t bits = 0;
+    if(!strcmp(name, "par") && nattrs == 2 && !strcmp(key(1), "value")) {
+        const std::string str = value(1);
+        const int val = (int)strtol(str.c_str(), NULL, 10);
+        if(formatInt(val) == str) {
+            type = Node::Int;
+            bits = (uint32_t)val;
+        }
+    } else if(!strcmp(name, "par_real") && nattrs == 3
+              && !strcmp(key(1), "value") && !strcmp(key(2), "exact_value")) {
+        const std::string str = value(2);
+        unsigned int exact = 0;
+        if(sscanf(str.c_str(), "0x%x", &exact) == 1
+           && formatExact(exact) == str) {
+            union { uint32_t in; float out; } convert;
+            convert.in = exact;
+            if(formatReal(convert.out) == value(1)) {
+                type = Node::Real;
+                bits = exact;
+            }
+        }
+    } else if(!strcmp(name, "par_bool") && nattrs == 2
+              && !strcmp(key(1), "value")) {
+        const std::string str = value(1);
+        if(str == "yes" || str == "no") {
+            type = Node::Bool;
+            bits = str == "yes";
+        }
+    } else if(!strcmp(name, "string") && nattrs <= 2
+              && (nattrs == 1 || !*key(1))) {
+        type = Node::String;
+        bits = nattrs == 2 ? attrs[node.value + 3] : 0;
+    }
+    if(type == Node::Generic)
+        return;
+
+    //the attributes of a leaf are the last ones written
+    attrs.resize(node.value);
+    node.value = bits;
+    node.type  = type | Node::NameKey << 8;
+}
+
+std::string BinaryPresetWriter::finish(void)
+{
+    while(stack.size() > 1)
+        end();
+    compact();
+
+    //every element is found by its tag, the first one of its siblings with
+    //the tag wins
+    std::unordered_set<uint64_t> tags;
+    size_t entries = 0;
+    for(uint32_t n = 1; n < nodes.size(); ++n)
+        entries += tags.insert((uint64_t)nodes[n].parent << 32
+                               | nodes[n].name).second
+                   + !!keyKind(nodes[n]);
+    std::vector<uint32_t> slots(4);
+    while(2 * slots.size() < 3 * entries)
+        slots.resize(slots.size() * 2);
+    const uint32_t mask = slots.size() - 1;
+    auto insert = [&](uint32_t n, uint32_t keykind) {
+        const Node &node = nodes[n];
+        const char *value = keykind ? strings.c_str() + node.key : "";
+        uint32_t i = hashKey(node.parent, strings.c_str() + node.name,
+                             keykind, value) & mask;
+        for(; slots[i]; i = (i + 1) & mask) {
+            const Node &other = nodes[slots[i] & BINARY_PRESET_SLOT_NODE];
+            //strings are unique, so their offsets can be compared
+            if(slots[i] >> 30 == keykind && other.parent == node.parent
+               && other.name == node.name
+               && (!keykind || other.key == node.key))
+                return;
+        }
+        slots[i] = n | keykind << 30;
+    };
+    for(uint32_t n = 1; n < nodes.size(); ++n) {
+        insert(n, Node::NoKey);
+        const uint32_t keykind = keyKind(nodes[n]);
+        if(keykind)
+            insert(n, keykind);
+    }
+
+    BinaryPresetHeader header;
+    memcpy(header.magic, BINARY_PRESET_MAGIC, 4);
+    header.version  = BINARY_PRESET_VERSION;
+    header.nnodes   = nodes.size();
+    header.nodes    = sizeof(header);
+    header.nattrs   = attrs.size();
+    header.attrs    = header.nodes + nodes.size() * sizeof(Node);
+    header.nslots   = slots.size();
+    header.slots    = header.attrs + attrs.size() * sizeof(uint32_t);
+    header.nstrings = strings.size();
+    header.strings  = header.slots + slots.size() * sizeof(uint32_t);
+    header.size     = (header.strings + strings.size() + 3) & ~3u;
+
+    std::string image(header.size, '\0');
+    char *p = &image[0];
+    memcpy(p, &header, sizeof(header));
+    memcpy(p + header.nodes, nodes.data(), nodes.size() * sizeof(Node));
+    if(!attrs.empty())
+        memcpy(p + header.attrs, attrs.data(),
+               attrs.size() * sizeof(uint32_t));
+    memcpy(p + header.slots, slots.data(), slots.size() * sizeof(uint32_t));
+    memcpy(p + header.strings, strings.data(), strings.size());
+
+    //the words between the header magic and the string pool
+    if(bigEndian())
+        swapWords(p + 4, (header.strings - 4) / 4);
+    return image;
+}
+
+//Drop the strings only used by the attributes of typed values
+void BinaryPresetWriter::compact(void)
+{
+    std::string used(1, '\0');
+    std::unordered_map<uint32_t, uint32_t> remap;
+    remap[0] = 0;
+    auto move = [&](uint32_t &offset) {
+        auto itr = remap.find(offset);
+        if(itr == remap.end()) {
+            const char *str = strings.c_str() + offset;
+            itr = remap.insert(std::make_pair(offset, (uint32_t)used.size()))
+                  .first;
+            used.append(str, strlen(str) + 1);
+        }
+        offset = itr->second;
+    };
+    for(auto &node:nodes) {
+        move(node.name);
+        move(node.key);
+        if((node.type & 0xff) == Node::String)
+            move(node.value);
+    }
+    for(auto &a:attrs)
+        move(a);
+    strings.swap(used);
+    stringmap.clear();
+}
+
+static void addXml(BinaryPresetWriter &writer, const XmlElement *elm)
+{
+    writer.begin(elm->name, elm->attrs, elm->nattrs);
+    //whitespace between child elements is not kept
+    if(!elm->child && elm->text)
+        writer.text(elm->text);
+    for(const XmlElement *c = elm->child; c; c = c->next)
+        addXml(writer, c);
+    writer.end();
+}
+
+std::string BinaryPresetWriter::fromXml(const XmlElement *elm)
+{
+    BinaryPresetWriter writer;
+    if(elm)
+        addXml(writer, elm);
+    return writer.finish();
+}
+
+/* Reader */
+
+BinaryPreset::BinaryPreset(void)
+    :buffer(NULL), length(0), mapped(false), header(NULL), nodes(NULL),
+      attrs(NULL), slots(NULL), strings(NULL)
+{}
+
+BinaryPreset::~BinaryPreset(void)
+{
+    release();
+}
+
+void BinaryPreset::release(void)
+{
+#ifndef WIN32
+    if(mapped)
+        munmap(buffer, length);
+    else
+#endif
+    free(buffer);
+    buffer  = NULL;
+    length  = 0;
+    mapped  = false;
+    header  = NULL;
+    nodes   = NULL;
+    attrs   = NULL;
+    slots   = NULL;
+    strings = NULL;
+}
+
+bool BinaryPreset::isBinaryFile(const std::string &filename)
+{
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(!file)
+        return false;
+    char magic[4];
+    const bool res = fread(magic, 1, 4, file) == 4
+                     && !memcmp(magic, BINARY_PRESET_MAGIC, 4);
+    fclose(file);
+    return res;
+}
+
+bool BinaryPreset::loadFile(const std::string &filename)
+{
+    release();
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    if(size < (long)sizeof(BinaryPresetHeader)) {
+        fclose(file);
+        return false;
+    }
+#ifndef WIN32
+    //big endian hosts swap the words in a private copy
+    if(!bigEndian()) {
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if(map != MAP_FAILED) {
+            fclose(file);
+            buffer = (char *)map;
+            length = size;
+            mapped = true;
+            if(check())
+                return true;
+            release();
+            return false;
+        }
+    }
+#endif
+    buffer = (char *)malloc(size);
+    fseek(file, 0, SEEK_SET);
+    length = buffer ? fread(buffer, 1, size, file) : 0;
+    fclose(file);
+    if(buffer && length == (size_t)size && check())
+        return true;
+    release();
+    return false;
+}
+
+bool BinaryPreset::setData(const char *data, size_t size)
+{
+    release();
+    if(size < sizeof(BinaryPresetHeader))
+        return false;
+    buffer = (char *)malloc(size);
+    if(!buffer)
+        return false;
+    memcpy(buffer, data, size);
+    length = size;
+    if(check())
+        return true;
+    release();
+    return false;
+}
+
+//Check that every offset and link stays within the file, so a corrupted
+//file can not cause out of bounds reads or endless loops
+bool BinaryPreset::check(void)
+{
+    if(memcmp(buffer, BINARY_PRESET_MAGIC, 4))
+        return false;
+    if(bigEndian())
+        swapWords(buffer + 4, sizeof(BinaryPresetHeader) / 4 - 1);
+
+    const BinaryPresetHeader &h = *(const BinaryPresetHeader *)buffer;
+    auto region = [this](uint32_t offset, uint64_t count, size_t size) {
+        return offset % 4 == 0 && offset + count * size <= length;
+    };
+    if(h.version >> 16 != BINARY_PRESET_VERSION >> 16 || h.size != length
+       || h.nnodes < 1 || h.nnodes > BINARY_PRESET_SLOT_NODE
+       || h.nstrings < 1 || h.nattrs % 2
+       || h.nslots < 1 || (h.nslots & (h.nslots - 1))
+       || h.nodes < sizeof(h)
+       || !region(h.nodes, h.nnodes, sizeof(Node))
+       || !region(h.attrs, h.nattrs, sizeof(uint32_t))
+       || !region(h.slots, h.nslots, sizeof(uint32_t))
+       || h.strings < h.slots + (uint64_t)h.nslots * sizeof(uint32_t)
+       || h.strings > length || h.nstrings > length - h.strings)
+        return false;
+
+    if(bigEndian())
+        swapWords(buffer + sizeof(h), (h.strings - sizeof(h)) / 4);
+
+    header  = &h;
+    nodes   = (const Node *)(buffer + h.nodes);
+    attrs   = (const uint32_t *)(buffer + h.attrs);
+    slots   = (const uint32_t *)(buffer + h.slots);
+    strings = buffer + h.strings;
+    if(strings[h.nstrings - 1])
+        return false;
+
+    for(uint32_t n = 0; n < h.nnodes; ++n) {
+        const Node &node = nodes[n];
+        const uint32_t type    = node.type & 0xff;
+        const uint32_t keykind = keyKind(node);
+        if(node.name >= h.nstrings || node.key >= h.nstrings
+           || type > Node::String || keykind > Node::IdKey
+           || (n && node.parent >= n)
+           || (node.next && (node.next <= n || node.next >= h.nnodes)))
+            return false;
+        //the links have to form a tree
+        if(node.next && nodes[node.next].parent != node.parent)
+            return false;
+        if((node.type & Node::HasChild)
+           ? n + 1 >= h.nnodes || nodes[n + 1].parent != n
+           : n + 1 < h.nnodes && nodes[n + 1].parent == n)
+            return false;
+        if(type == Node::String && node.value >= h.nstrings)
+            return false;
+        if(type == Node::Generic
+           && (uint64_t)node.value + 2 * attrCount(node) > h.nattrs)
+            return false;
+    }
+    for(uint32_t i = 0; i < h.nattrs; ++i)
+        if(attrs[i] >= h.nstrings)
+            return false;
+    for(uint32_t i = 0; i < h.nslots; ++i)
+        if((slots[i] & BINARY_PRESET_SLOT_NODE) >= h.nnodes
+           || slots[i] >> 30 > Node::IdKey)
+            return false;
+    return true;
+}
+
+uint32_t BinaryPreset::find(uint32_t parent, const char *tag,
+                            BinaryPresetNode::Key key,
+                            const char *value) const
+{
+    if(!header)
+        return 0;
+    if(!value)
+        key = Node::NoKey;
+    const uint32_t mask = header->nslots - 1;
+    uint32_t i = hashKey(parent, tag, key, key ? value : "") & mask;
+    for(uint32_t probes = 0; probes <= mask; ++probes, i = (i + 1) & mask) {
+        const uint32_t slot = slots[i];
+        if(!slot)
+            return 0;
+        const uint32_t n = slot & BINARY_PRESET_SLOT_NODE;
+        const Node &node = nodes[n];
+        if(slot >> 30 == (uint32_t)key && node.parent == parent
+           && !strcmp(strings + node.name, tag)
+           && (!key || !strcmp(strings + node.key, value)))
+            return n;
+    }
+    return 0;
+}
+
+uint32_t BinaryPreset::findElement(const char *tag) const
+{
+    if(!header)
+        return 0;
+    for(uint32_t n = 1; n < header->nnodes; ++n)
+        if(!strcmp(strings + nodes[n].name, tag))
+            return n;
+    return 0;
+}
+
+const char *BinaryPreset::attr(uint32_t n, const char *key) const
+{
+    const Node &node = nodes[n];
+    if(type(n) == Node::Generic) {
+        const uint32_t nattrs = attrCount(node);
+        for(uint32_t i = 0; i < nattrs; ++i)
+            if(!strcmp(strings + attrs[node.value + 2 * i], key))
+                return strings + attrs[node.value + 2 * i + 1];
+        return NULL;
+    }
+    return strcmp(key, "name") ? NULL : strings + node.key;
+}
+
+void BinaryPreset::getAttrs(uint32_t n, Attrs &res) const
+{
+    const Node &node = nodes[n];
+    res.clear();
+    if(type(n) == Node::Generic) {
+        const uint32_t nattrs = attrCount(node);
+        for(uint32_t i = 0; i < nattrs; ++i) {
+            const char *key = strings + attrs[node.value + 2 * i];
+            if(*key) //not the character data
+                res.push_back(std::make_pair(
+                    std::string(key),
+                    std::string(strings + attrs[node.value + 2 * i + 1])));
+        }
+        return;
+    }
+
+    res.push_back(std::make_pair(std::string("name"),
+                                 std::string(strings + node.key)));
+    switch(type(n)) {
+        case Node::Int:
+            res.push_back(std::make_pair(std::string("value"),
+                                         formatInt((int)node.value)));
+            break;
+        case Node::Real: {
+            float val;
+            getReal(n, val);
+            res.push_back(std::make_pair(std::string("value"),
+                                         formatReal(val)));
+            res.push_back(std::make_pair(std::string("exact_value"),
+                                         formatExact(node.value)));
+            break;
+        }
+        case Node::Bool:
+            res.push_back(std::make_pair(std::string("value"),
+                                         std::string(node.value ? "yes"
+                                                                : "no")));
+            break;
+        default:
+            break;
+    }
+}
+
+bool BinaryPreset::getInt(uint32_t n, int &val) const
+{
+    if(type(n) == Node::Int) {
+        val = (int)nodes[n].value;
+        return true;
+    }
+    const char *str = type(n) == Node::Generic ? attr(n, "value") : NULL;
+    if(!str)
+        return false;
+    val = (int)strtol(str, NULL, 10);
+    return true;
+}
+
+bool BinaryPreset::getReal(uint32_t n, float &val) const
+{
+    union { uint32_t in; float out; } convert;
+    if(type(n) == Node::Real) {
+        convert.in = nodes[n].value;
+        val = convert.out;
+        return true;
+    }
+    if(type(n) != Node::Generic)
+        return false;
+    const char *str = attr(n, "exact_value");
+    if(str && strlen(str) > 2 && sscanf(str + 2, "%x", &convert.in) == 1) {
+        val = convert.out;
+        return true;
+    }
+    str = attr(n, "value");
+    if(!str)
+        return false;
+    val = strtof(str, NULL);
+    return true;
+}
+
+bool BinaryPreset::getBool(uint32_t n, bool &val) const
+{
+    if(type(n) == Node::Bool) {
+        val = nodes[n].value;
+        return true;
+    }
+    const char *str = type(n) == Node::Generic ? attr(n, "value") : NULL;
+    if(!str)
+        return false;
+    val = str[0] == 'Y' || str[0] == 'y';
+    return true;
+}
+
+const char *BinaryPreset::getText(uint32_t n) const
+{
+    switch(type(n)) {
+        case Node::String:
+            return nodes[n].value ? strings + nodes[n].value : NULL;
+        case Node::Generic:
+            return attr(n, "");
+        default:
+            return NULL;
+    }
+}
+
+std::string BinaryPreset::toXml(void) const
+{
+    std::string out = "<?xml version=\"1.0f\" encoding=\"UTF-8\"?>\n"
+                      "<!DOCTYPE ZynAddSubFX-data>";
+    if(!header)
+        return out;
+
+    Attrs attrlist;
+    uint32_t n = child(0);
+    while(n) {
+        out += "\n<";
+        out += name(n);
+        getAttrs(n, attrlist);
+        for(auto &a:attrlist) {
+            out += ' ';
+            out += a.first;
+            out += "=\"";
+            escape(out, a.second.c_str());
+            out += '"';
+        }
+        const char *text = getText(n);
+        if(child(n))
+            out += '>';
+        else if(text) {
+            out += '>';
+            escape(out, text);
+            out += "</";
+            out += name(n);
+            out += '>';
+        } else
+            out += " />";
+
+        //descend, or close the finished elements
+        if(child(n)) {
+            n = child(n);
+            continue;
+        }
+        while(n && !next(n)) {
+            n = parent(n);
+            if(n) {
+                out += "\n</";
+                out += name(n);
+                out += '>';
+            }
+        }
+        if(n)
+            n = next(n);
+    }
+    out += '\n';
+    return out;
+}
+
+}
@@ -0,0 +1,193 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BinaryPreset.h - Binary form of saved parameter trees
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef BINARY_PRESET_H
+#define BINARY_PRESET_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define BINARY_PRESET_MAGIC "ZYNB"
+#define BINARY_PRESET_VERSION 0x00010000u //major << 16 | minor
+
+namespace zyn {
+
+struct XmlElement;
+
+/*
+ * Layout of a binary preset
+ *
+ * All fields are 32 bit little endian words, so the file can be used directly
+ * after mapping it. It consists of the header, the elements, the attributes
+ * of generic elements, the index and the string pool.
+ *
+ * Parameters written by XMLwrapper (par, par_real, par_bool and string) are
+ * stored as typed values, every other element keeps its attributes as
+ * strings, so the conversion from and to XML is lossless.
+ *
+ * The elements are stored in document order, so the first child of an
+ * element directly follows it. The character data of a generic element is
+ * kept as an attribute with an empty name.
+ *
+ * The index is a hash table over (parent, tag) and (parent, tag, key), where
+ * the key is the name attribute of an element or its id attribute if it has
+ * no name. This makes every lookup done while loading O(1).
+ */
+struct BinaryPresetHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t size;     //of the whole file
+    uint32_t nnodes, nodes;
+    uint32_t nattrs, attrs;
+    uint32_t nslots, slots;
+    uint32_t nstrings, strings;
+};
+
+struct BinaryPresetNode {
+    enum Type { Generic, Int, Real, Bool, String };
+    enum Key  { NoKey, NameKey, IdKey };
+    enum { HasChild = 1 << 15 };
+
+    uint32_t name;   //string offset
+    uint32_t key;    //string offset of the key attribute
+    uint32_t parent; //node index
+    uint32_t next;   //next sibling, 0 if none
+    uint32_t type;   //type | key << 8 | HasChild | attribute count << 16
+    uint32_t value;  //value bits, string offset of the text or the first
+                     //attribute of a generic element
+};
+
+//Slots of the index hold node | key << 30, 0 if the slot is empty
+#define BINARY_PRESET_SLOT_NODE 0x3fffffffu
+
+/**Builds a binary preset from a tree of elements*/
+class BinaryPresetWriter
+{
+    public:
+        BinaryPresetWriter(void);
+
+        /**Open a child of the current element
+         * @param attrs name, value pairs*/
+        void begin(const char *name, const char *const *attrs, int nattrs);
+        /**Set the character data of the current element*/
+        void text(const char *text);
+        void end(void);
+
+        /**@return the finished file image*/
+        std::string finish(void);
+
+        /**Convert a parsed XML element with all of its children*/
+        static std::string fromXml(const XmlElement *elm);
+
+    private:
+        uint32_t string(const char *str);
+        const char *getText(const BinaryPresetNode &node) const;
+        void typed(BinaryPresetNode &node);
+        void compact(void);
+
+        std::vector<BinaryPresetNode> nodes;
+        std::vector<uint32_t>         attrs;
+        std::string                   strings;
+        std::unordered_map<std::string, uint32_t> stringmap;
+        //open elements and their last child
+        std::vector<std::pair<uint32_t, uint32_t>> stack;
+};
+
+/**
+ * Read only binary preset
+ *
+ * Elements are addressed by their index, 0 is the document itself and the
+ * parent of the top level element.
+ */
+class BinaryPreset
+{
+    public:
+        typedef std::vector<std::pair<std::string, std::string>> Attrs;
+
+        BinaryPreset(void);
+        ~BinaryPreset(void);
+
+        /**@return true if the file starts with the binary preset magic*/
+        static bool isBinaryFile(const std::string &filename);
+
+        /**Map a file and check its structure
+         * @return false if it can not be read or is corrupted*/
+        bool loadFile(const std::string &filename);
+
+        /**Copy and check a file image*/
+        bool setData(const char *data, size_t size);
+
+        /**Child of parent with the tag, where the key attribute of the given
+         * kind has the value. Without a key the first child with the tag is
+         * returned.
+         * @return 0 if there is no such child*/
+        uint32_t find(uint32_t parent, const char *tag,
+                      BinaryPresetNode::Key key = BinaryPresetNode::NoKey,
+                      const char *value = NULL) const;
+
+        /**First element with the tag in document order, or 0*/
+        uint32_t findElement(const char *tag) const;
+
+        uint32_t parent(uint32_t n) const { return nodes[n].parent; }
+        uint32_t child(uint32_t n) const {
+            return nodes[n].type & BinaryPresetNode::HasChild ? n + 1 : 0;
+        }
+        uint32_t next(uint32_t n) const { return nodes[n].next; }
+        const char *name(uint32_t n) const { return strings + nodes[n].name; }
+        BinaryPresetNode::Type type(uint32_t n) const {
+            return (BinaryPresetNode::Type)(nodes[n].type & 0xff);
+        }
+
+        /**Attribute of an element, only generic elements and the key
+         * attribute are stored as strings
+         * @return NULL if it is not present*/
+        const char *attr(uint32_t n, const char *key) const;
+        /**All attributes, typed values are formatted like XMLwrapper does*/
+        void getAttrs(uint32_t n, Attrs &attrs) const;
+
+        /**Typed values, generic elements are converted from their attributes
+         * @return false if there is no such value*/
+        bool getInt(uint32_t n, int &val) const;
+        bool getReal(uint32_t n, float &val) const;
+        bool getBool(uint32_t n, bool &val) const;
+        /**@return the character data or NULL*/
+        const char *getText(uint32_t n) const;
+
+        /**Lossless conversion to XML as written by XMLwrapper*/
+        std::string toXml(void) const;
+
+        size_t size(void) const { return length; }
+
+    private:
+        BinaryPreset(const BinaryPreset &) = delete;
+        BinaryPreset &operator=(const BinaryPreset &) = delete;
+
+        void release(void);
+        bool check(void);
+
+        char  *buffer;
+        size_t length;
+        bool   mapped;
+
+        const BinaryPresetHeader *header;
+        const BinaryPresetNode   *nodes;
+        const uint32_t           *attrs;
+        const uint32_t           *slots;
+        const char               *strings;
+};
+
+}
+
+#endif
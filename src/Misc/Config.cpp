@@ -46,12 +46,17 @@ static const rtosc::Ports ports = {
     rParamI(cfg.SampleRate, "samples of audio per second"),
     rParamI(cfg.SoundBufferSize, "Size of processed audio buffer"),
     rParamI(cfg.OscilSize, "Size Of Oscillator Wavetable"),
+    rParamI(cfg.ControlSize, "Samples between updates of the note modulation, "
+            "0 for once per buffer"),
     rToggle(cfg.SwapStereo, "Swap Left And Right Channels"),
     rToggle(cfg.AudioOutputCompressor, "Apply Compressor to Audio Output"),
     rToggle(cfg.BankUIAutoClose, "Automatic Closing of BackUI After Patch Selection"),
     rParamI(cfg.GzipCompression, "Level of Gzip Compression For Save Files"),
+    rToggle(cfg.BinarySaves, "Save Sessions And Autosaves As Binary Presets"),
     rParamI(cfg.Interpolation, "Level of Interpolation, Linear/Cubic"),
     rToggle(cfg.SaveFullXml, "Include Disabled parts in save"),
+    rParamI(cfg.UndoHistorySize, rLinear(1, 1024), rUnit(MiB),
+            "Memory Kept For Undo (Applies On Restart)"),
     {"cfg.presetsDirList", rDoc("list of preset search directories"), 0,
         [](const char *msg, rtosc::RtData &d)
         {
@@ -194,6 +199,7 @@ void Config::init()
     cfg.SampleRate      = 44100;
     cfg.SoundBufferSize = 256;
     cfg.OscilSize  = 1024;
+    cfg.ControlSize = 0;
     cfg.SwapStereo = 0;
     cfg.AudioOutputCompressor = 0;
 
@@ -208,9 +214,11 @@ void Config::init()
     cfg.BankUIAutoClose = 0;
 
     cfg.GzipCompression = 3;
+    cfg.BinarySaves     = 0;
 
     cfg.Interpolation = 0;
     cfg.SaveFullXml = 0;
+    cfg.UndoHistorySize = 16;
     cfg.CheckPADsynth = 1;
     cfg.IgnoreProgramChange = 0;
 
@@ -320,6 +328,10 @@ void Config::readConfig(const char *filename)
                                       cfg.OscilSize,
                                       MAX_AD_HARMONICS * 2,
                                       131072);
+        cfg.ControlSize = xmlcfg.getpar("control_size",
+                                        cfg.ControlSize,
+                                        0,
+                                        8192);
         cfg.SwapStereo = xmlcfg.getpar("swap_stereo",
                                        cfg.SwapStereo,
                                        0,
@@ -337,6 +349,10 @@ void Config::readConfig(const char *filename)
                                             cfg.GzipCompression,
                                             0,
                                             9);
+        cfg.BinarySaves = xmlcfg.getpar("binary_saves",
+                                        cfg.BinarySaves,
+                                        0,
+                                        1);
 
         cfg.currentBankDir = xmlcfg.getparstr("bank_current", "");
         cfg.Interpolation  = xmlcfg.getpar("interpolation",
@@ -349,6 +365,11 @@ void Config::readConfig(const char *filename)
                                            0,
                                            1);
 
+        cfg.UndoHistorySize = xmlcfg.getpar("undo_history_size",
+                                            cfg.UndoHistorySize,
+                                            1,
+                                            1024);
+
         cfg.CheckPADsynth = xmlcfg.getpar("check_pad_synth",
                                           cfg.CheckPADsynth,
                                           0,
@@ -423,11 +444,13 @@ void Config::saveConfig(const char *filename) const
     xmlcfg->addpar("sample_rate", cfg.SampleRate);
     xmlcfg->addpar("sound_buffer_size", cfg.SoundBufferSize);
     xmlcfg->addpar("oscil_size", cfg.OscilSize);
+    xmlcfg->addpar("control_size", cfg.ControlSize);
     xmlcfg->addpar("swap_stereo", cfg.SwapStereo);
     xmlcfg->addpar("audio_output_compressor", cfg.AudioOutputCompressor);
     xmlcfg->addpar("bank_window_auto_close", cfg.BankUIAutoClose);
 
     xmlcfg->addpar("gzip_compression", cfg.GzipCompression);
+    xmlcfg->addpar("binary_saves", cfg.BinarySaves);
 
     xmlcfg->addpar("check_pad_synth", cfg.CheckPADsynth);
     xmlcfg->addpar("ignore_program_change", cfg.IgnoreProgramChange);
@@ -461,6 +484,7 @@ void Config::saveConfig(const char *filename) const
 
     xmlcfg->addpar("interpolation", cfg.Interpolation);
     xmlcfg->addpar("SaveFullXml", cfg.SaveFullXml);
+    xmlcfg->addpar("undo_history_size", cfg.UndoHistorySize);
 
     //linux stuff
     xmlcfg->addparstr("linux_oss_wave_out_dev", cfg.oss_devs.linux_wave_out);
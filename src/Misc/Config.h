@@ -42,12 +42,15 @@ class Config
         struct {
             oss_devs_t oss_devs;
             int   SampleRate, SoundBufferSize, OscilSize, SwapStereo;
+            int   ControlSize; //samples between note updates, 0 per buffer
             bool  AudioOutputCompressor;
             int   WindowsWaveOutId, WindowsMidiInId;
             int   BankUIAutoClose;
             int   GzipCompression;
+            int   BinarySaves; //save sessions as binary presets
             int   Interpolation;
             int   SaveFullXml; // when saving to a file save entire tree including disabled parts (Zynmuse)
+            int   UndoHistorySize; //MiB kept for undo, the oldest steps are dropped
             std::string bankRootDirList[MAX_BANK_ROOT_DIRS], currentBankDir;
             std::string presetsDirList[MAX_BANK_ROOT_DIRS];
             std::string favoriteList[MAX_BANK_ROOT_DIRS];
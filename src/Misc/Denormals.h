@@ -0,0 +1,105 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  Denormals.h - Flush denormal floats to zero in hardware
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#ifndef DENORMALS_H
+#define DENORMALS_H
+
+/*
+ * Decaying feedback paths (reverb combs, delays, resonating filters) end up
+ * in denormal numbers, which are very slow on most CPUs. Where the FPU can
+ * flush them to zero, every thread which renders audio enables that mode.
+ * Otherwise SYNTH_T::denormalkillbuf is filled with a tiny noise, which is
+ * added to the signal paths instead.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define ZYN_DENORMALS_SSE   1
+#define ZYN_FLUSH_DENORMALS 1
+#define ZYN_DENORMAL_FLAGS  0x8040u //FTZ and DAZ bits of MXCSR
+#elif defined(__aarch64__)
+#define ZYN_DENORMALS_A64   1
+#define ZYN_FLUSH_DENORMALS 1
+#define ZYN_DENORMAL_FLAGS  (1u << 24) //FZ bit of FPCR
+#elif defined(__arm__) && defined(__ARM_FP)
+#define ZYN_DENORMALS_VFP   1
+#define ZYN_FLUSH_DENORMALS 1
+#define ZYN_DENORMAL_FLAGS  (1u << 24) //FZ bit of FPSCR
+#else
+#define ZYN_FLUSH_DENORMALS 0
+#define ZYN_DENORMAL_FLAGS  0u
+#endif
+
+namespace zyn {
+
+/**Enables flush to zero for the lifetime of the object in the current
+ * thread and restores the previous mode afterwards, so plugin hosts do not
+ * see a changed FPU state*/
+class DenormalGuard
+{
+    public:
+        DenormalGuard(void) : old(getMode())
+        {
+            setMode(old | ZYN_DENORMAL_FLAGS);
+        }
+
+        ~DenormalGuard(void)
+        {
+            setMode(old);
+        }
+
+        DenormalGuard(const DenormalGuard &) = delete;
+        DenormalGuard &operator=(const DenormalGuard &) = delete;
+
+        //True if the current thread flushes denormals to zero
+        static bool active(void)
+        {
+            return ZYN_FLUSH_DENORMALS &&
+                   (getMode() & ZYN_DENORMAL_FLAGS) == ZYN_DENORMAL_FLAGS;
+        }
+
+    private:
+        static unsigned getMode(void)
+        {
+#if ZYN_DENORMALS_SSE
+            return _mm_getcsr();
+#elif ZYN_DENORMALS_A64
+            unsigned long fpcr;
+            __asm__ __volatile__ ("mrs %0, fpcr" : "=r" (fpcr));
+            return fpcr;
+#elif ZYN_DENORMALS_VFP
+            unsigned fpscr;
+            __asm__ __volatile__ ("vmrs %0, fpscr" : "=r" (fpscr));
+            return fpscr;
+#else
+            return 0;
+#endif
+        }
+
+        static void setMode(unsigned mode)
+        {
+#if ZYN_DENORMALS_SSE
+            _mm_setcsr(mode);
+#elif ZYN_DENORMALS_A64
+            unsigned long fpcr = mode;
+            __asm__ __volatile__ ("msr fpcr, %0" : : "r" (fpcr));
+#elif ZYN_DENORMALS_VFP
+            __asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (mode));
+#else
+            (void)mode;
+#endif
+        }
+
+        const unsigned old;
+};
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  EventNotifier.cpp - Wakeup of a thread waiting for events
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "EventNotifier.h"
+#include <stdint.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+namespace zyn {
+
+EventNotifier::EventNotifier(void)
+    :readfd(-1), writefd(-1), pending(false)
+{
+#if defined(__linux__)
+    readfd = writefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(WIN32)
+    int fds[2];
+    if(pipe(fds) == 0) {
+        for(int i = 0; i < 2; ++i) {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+        readfd  = fds[0];
+        writefd = fds[1];
+    }
+#endif
+}
+
+EventNotifier::~EventNotifier(void)
+{
+#ifndef WIN32
+    if(writefd != readfd)
+        close(writefd);
+    if(readfd != -1)
+        close(readfd);
+#endif
+}
+
+void EventNotifier::notify(void)
+{
+#ifndef WIN32
+    if(writefd == -1 || pending.exchange(true))
+        return;
+    const uint64_t one = 1;
+    ssize_t res = write(writefd, &one, writefd == readfd ? sizeof(one) : 1);
+    (void)res;
+#endif
+}
+
+void EventNotifier::clear(void)
+{
+#ifndef WIN32
+    if(readfd == -1)
+        return;
+    //drain first, so a notify() racing with this call is never lost
+    uint64_t buf[8];
+    while(read(readfd, buf, sizeof(buf)) > 0 && readfd != writefd);
+    pending = false;
+#endif
+}
+
+}
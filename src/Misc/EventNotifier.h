@@ -0,0 +1,42 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  EventNotifier.h - Wakeup of a thread waiting for events
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <atomic>
+
+namespace zyn {
+
+//A file descriptor which becomes readable when notify() is called, so it
+//can be waited on together with sockets.
+//notify() makes at most one system call until the next clear(), so it may
+//be called once per audio buffer from the realtime thread.
+struct EventNotifier
+{
+    EventNotifier(void);
+    ~EventNotifier(void);
+
+    //Wake up the waiting thread (any thread)
+    void notify(void);
+
+    //Consume the pending notification before handling the events
+    void clear(void);
+
+    //-1 if there is no such descriptor on this platform
+    int fd(void) const { return readfd; }
+
+    private:
+        EventNotifier(const EventNotifier&) = delete;
+        EventNotifier &operator=(const EventNotifier&) = delete;
+
+        int readfd, writefd;
+        std::atomic<bool> pending;
+};
+
+}
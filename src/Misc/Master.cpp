@@ -23,9 +23,12 @@
 #include "../Effects/EffectMgr.h"
 #include "../DSP/FFTwrapper.h"
 #include "../Misc/Allocator.h"
+#include "../Misc/Denormals.h"
+#include "../Misc/EventNotifier.h"
 #include "../Containers/ScratchString.h"
 #include "../Nio/Nio.h"
 #include "PresetExtractor.h"
+#include "ParamBlock.h"
 
 #include <rtosc/ports.h>
 #include <rtosc/port-sugar.h>
@@ -38,6 +41,7 @@
 #include <algorithm>
 #include <cmath>
 #include <atomic>
+#include <thread>
 #include <unistd.h>
 
 using namespace std;
@@ -393,6 +397,7 @@ static const Ports master_ports = {
     rRecursp(sysefx, 4, "System Effect"),//NUM_SYS_EFX
     rRecursp(insefx, 8, "Insertion Effect"),//NUM_INS_EFX
     rRecur(HDDRecorder, "HDD recorder"),
+    rRecur(governor, "Adaptive polyphony limit"),
     rRecur(microtonal, "Microtonal Mapping Functionality"),
     rRecur(ctl, "Controller"),
     rArrayOption(Pinsparts, NUM_INS_EFX, rOpt(-2, Master), rOpt(-1, Off),
@@ -443,6 +448,12 @@ static const Ports master_ports = {
        p->initialize_rt();
        memset(m->activeNotes, 0, sizeof(m->activeNotes));
        }},
+    {"param-block:b", rProp(internal) rDoc("Apply a packed block of parameter changes"), 0,
+        [](const char *msg, RtData &d) {
+       Master *m = (Master*)d.obj;
+       const auto blob = rtosc_argument(msg, 0).b;
+       m->applyParamBlock(blob.data, blob.len, d);
+       }},
     {"active_keys:", rProp("Obtain a list of active notes"), 0,
         rBegin;
         char keys[129] = {};
@@ -671,6 +682,42 @@ class DataObj:public rtosc::RtData
         rtosc::ThreadLink *bToU;
 };
 
+//Swallows the echoes of the single changes within a parameter block (the
+//block answers with one "/damage" instead), but passes on every other reply,
+//e.g. for the MiddleWare's bookkeeping or tables it has to prepare
+class BlockDataObj:public DataObj
+{
+    public:
+        BlockDataObj(char *loc_, size_t loc_size_, void *obj_,
+                     rtosc::ThreadLink *bToU_)
+            :DataObj(loc_, loc_size_, obj_, bToU_), broadcasting(false)
+        {}
+
+        virtual void reply(const char *msg) override
+        {
+            //a broadcast is sent as "/broadcast" followed by the message
+            if(!strcmp(msg, "/broadcast")) {
+                broadcasting = true;
+                return;
+            }
+            const bool echo = !strcmp(msg, loc);
+            if(!echo && broadcasting) {
+                char marker[16];
+                rtosc_message(marker, sizeof(marker), "/broadcast", "");
+                DataObj::reply(marker);
+            }
+            broadcasting = false;
+            if(!echo)
+                DataObj::reply(msg);
+        }
+        virtual void forward(const char *) override
+        {
+            forwarded = true;
+        }
+    private:
+        bool broadcasting;
+};
+
 vuData::vuData(void)
     :outpeakl(0.0f), outpeakr(0.0f), maxoutpeakl(0.0f), maxoutpeakr(0.0f),
       rmspeakl(0.0f), rmspeakr(0.0f), clipped(0)
@@ -766,15 +813,17 @@ void Master::loadAutomation(XMLwrapper &xml, rtosc::AutomationMgr &midi)
 }
 
 Master::Master(const SYNTH_T &synth_, Config* config)
-    :HDDRecorder(synth_), time(synth_), ctl(synth_, &time),
+    :HDDRecorder(synth_), governor(synth_), time(synth_), ctl(synth_, &time),
     microtonal(config->cfg.GzipCompression), bank(config),
     automate(16,4,8),
     frozenState(false), pendingMemory(false),
-    synth(synth_), gzip_compression(config->cfg.GzipCompression)
+    synth(synth_), gzip_compression(config->cfg.GzipCompression),
+    binary_saves(config->cfg.BinarySaves)
 {
     SaveFullXml=(config->cfg.SaveFullXml==1);
     bToU = NULL;
     uToB = NULL;
+    bToUnotify = NULL;
     
     // set default tempo
     time.tempo = 120;
@@ -794,7 +843,7 @@ Master::Master(const SYNTH_T &synth_, Config* config)
     bufr = new float[synth.buffersize];
 
     last_xmz[0] = 0;
-    fft = new FFTwrapper(synth.oscilsize);
+    fft = FFTwrapper::acquire(synth.oscilsize);
 
     shutup = 0;
     for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
@@ -926,6 +975,43 @@ bool Master::applyOscEvent(const char *msg, bool nio, int msg_id)
     return applyOscEvent(msg, NULL, NULL, true, nio, msg_id);
 }
 
+void Master::applyParamBlock(const void *data, size_t len, rtosc::RtData &d)
+{
+    ParamBlockReader block(data, len);
+    if(!block.valid()) {
+        fprintf(stderr, "Warning: ignoring malformed parameter block\n");
+        return;
+    }
+
+    char loc_buf[1024];
+    BlockDataObj bd{loc_buf, sizeof(loc_buf), this, bToU};
+    int applied = 0, unknown = 0;
+    while(const char *msg = block.next()) {
+        //Master swaps can not be part of a block
+        if(!strcmp(msg, "/load-master") || !strcmp(msg, "/switch-master")
+           || !strcmp(msg, "/param-block")) {
+            ++unknown;
+            continue;
+        }
+        bd.matches   = 0;
+        bd.forwarded = false;
+        ports.dispatch(msg, bd, true);
+        if(bd.forwarded) {
+            bToU->write("/forward", "");
+            bToU->raw_write(msg);
+        }
+        if(bd.matches)
+            ++applied;
+        else
+            ++unknown;
+    }
+
+    //One reply for the whole block instead of one per parameter
+    if(*block.damage())
+        d.broadcast("/damage", "s", block.damage());
+    d.reply("/param-block", "ii", applied, unknown);
+}
+
 void Master::defaults()
 {
     union {float f; uint32_t i;} convert;
@@ -1255,6 +1341,8 @@ bool Master::runOSC(float *outl, float *outr, bool offline,
  */
 bool Master::AudioOut(float *outl, float *outr)
 {
+    DenormalGuard flush;
+
     //Danger Limits
     if(memory->lowMemory(2,1024*1024))
         printf("QUITE LOW MEMORY IN THE RT POOL BE PREPARED FOR WEIRD BEHAVIOR!!\n");
@@ -1269,6 +1357,7 @@ bool Master::AudioOut(float *outl, float *outr)
     if(!runOSC(outl, outr, false))
         return false;
 
+    governor.begin();
 
     //Handle watch points
     if(bToU)
@@ -1438,6 +1527,9 @@ bool Master::AudioOut(float *outl, float *outr)
         ShutUp();
     }
 
+    //Compare the render time with the buffer time, shed voices if needed
+    governor.end(part, NUM_MIDI_PARTS);
+
     //update the global frame timer
     time++;
 
@@ -1455,6 +1547,10 @@ bool Master::AudioOut(float *outl, float *outr)
     //Update pulse
     last_ack = last_beat;
 
+    //Let a waiting MiddleWare handle the replies of this buffer
+    if(bToUnotify && bToU->hasNext())
+        bToUnotify->notify();
+
 
     return true;
 }
@@ -1511,7 +1607,7 @@ Master::~Master()
     for(int nefx = 0; nefx < NUM_SYS_EFX; ++nefx)
         delete sysefx[nefx];
 
-    delete fft;
+    FFTwrapper::release(fft);
     delete memory;
 }
 
@@ -1576,10 +1672,18 @@ void Master::vuresetpeaks()
     vu.clipped     = 0;
 }
 
-void Master::applyparameters(void)
+void Master::applyparameters(unsigned threads)
 {
-    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart)
-        part[npart]->applyparameters();
+    //Parts and their PADsynth generators share one budget of a thread per
+    //core, so a parallel load does not start a full set of PAD threads per
+    //part
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned workers =
+        std::min<unsigned>(threads ? threads : cores, NUM_MIDI_PARTS);
+    const unsigned padthreads = std::max(1u, cores / workers);
+    parallel_for(NUM_MIDI_PARTS, threads, [this,padthreads](int npart) {
+            part[npart]->applyparameters([]{return false;}, padthreads);
+            });
 }
 
 void Master::initialize_rt(void)
@@ -1691,6 +1795,8 @@ int Master::saveXML(const char *filename)
     add2XML(xml);
     xml.endbranch();
 
+    if(binary_saves)
+        return xml.saveBinaryFile(filename);
     return xml.saveXMLfile(filename, gzip_compression);
 }
 
@@ -1713,7 +1819,7 @@ int Master::loadXML(const char *filename)
     return 0;
 }
 
-void Master::getfromXML(XMLwrapper& xml)
+void Master::getfromXML(XMLwrapper& xml, unsigned threads)
 {
     if (xml.hasparreal("volume")) {
         Volume = xml.getparreal("volume", Volume);
@@ -1724,13 +1830,21 @@ void Master::getfromXML(XMLwrapper& xml)
     ctl.NRPN.receive = xml.getparbool("nrpn_receive", ctl.NRPN.receive);
 
 
+    //Parts are independent of each other, so they are parsed in parallel,
+    //each from its own read only view of the tree
     part[0]->Penabled = 0;
-    for(int npart = 0; npart < NUM_MIDI_PARTS; ++npart) {
-        if(xml.enterbranch("PART", npart) == 0)
-            continue;
-        part[npart]->getfromXML(xml);
-        xml.exitbranch();
+    memory->setConcurrent(true);
+    try {
+        parallel_for(NUM_MIDI_PARTS, threads, [this,&xml](int npart) {
+                XMLwrapper view(&xml);
+                if(view.enterbranch("PART", npart))
+                    part[npart]->getfromXML(view);
+                });
+    } catch(...) {
+        memory->setConcurrent(false);
+        throw;
     }
+    memory->setConcurrent(false);
 
     if(xml.enterbranch("MICROTONAL")) {
         microtonal.getfromXML(xml);
@@ -25,6 +25,7 @@
 #include "Time.h"
 #include "Bank.h"
 #include "Recorder.h"
+#include "VoiceGovernor.h"
 
 #include "../Params/Controller.h"
 #include "../Synth/WatchPoint.h"
@@ -62,6 +63,11 @@ class Master
                            bool offline, bool nio = true, int msg_id = -1);
         bool applyOscEvent(const char *event, bool nio = true, int msg_id = -1);
 
+        /**Apply all changes of a packed ParamBlock within the current buffer
+         * and answer with a single "/param-block" reply*/
+        void applyParamBlock(const void *data, size_t len,
+                             rtosc::RtData &d) REALTIME;
+
         /**Saves all settings to a XML file
          * @return 0 for ok or <0 if there is an error*/
         int saveXML(const char *filename);
@@ -87,13 +93,16 @@ class Master
                     rtosc::savefile_dispatcher_t* dispatcher);
 
         /**Regenerate PADsynth and other non-RT parameters
-         * It is NOT SAFE to call this from a RT context*/
-        void applyparameters(void) NONREALTIME;
+         * It is NOT SAFE to call this from a RT context
+         * @param threads number of parts handled at once (0: one per core);
+         *        PADsynth generation gets the cores left per part*/
+        void applyparameters(unsigned threads = 0) NONREALTIME;
 
         //This must be called prior-to/at-the-time-of RT insertion
         void initialize_rt(void) REALTIME;
 
-        void getfromXML(XMLwrapper& xml);
+        /**@param threads number of parts parsed at once (0: one per core)*/
+        void getfromXML(XMLwrapper& xml, unsigned threads = 0) NONREALTIME;
 
         /**get all data to a newly allocated array (used for plugin)
          * @return the datasize*/
@@ -173,6 +182,9 @@ class Master
         //HDD recorder
         Recorder HDDRecorder;
 
+        //Sheds voices of all parts when the render time gets too long
+        VoiceGovernor governor;
+
         //part that's apply the insertion effect; -1 to disable
         short int Pinsparts[NUM_INS_EFX];
 
@@ -195,6 +207,7 @@ class Master
         //Strictly Non-RT instrument bank object
         Bank bank;
 
+        //Plans shared by all Masters with the same oscilsize
         class FFTwrapper * fft;
 
         static const rtosc::Ports &ports;
@@ -217,9 +230,12 @@ class Master
         Allocator *memory;
         rtosc::ThreadLink *bToU;
         rtosc::ThreadLink *uToB;
+        //Wakes the MiddleWare once bToU has messages (may be NULL)
+        struct EventNotifier *bToUnotify;
         bool pendingMemory;
         const SYNTH_T &synth;
         const int& gzip_compression; //!< value from config
+        const int& binary_saves; //!< value from config
         bool SaveFullXml; // value from config
 
         //Heartbeat for identifying plugin offline modes
@@ -32,6 +32,8 @@ using namespace rtosc;
 namespace zyn {
 
 #define rObject Microtonal
+#undef rChangeCb
+#define rChangeCb obj->updatekeytable();
 
 /**
  * TODO
@@ -39,7 +41,8 @@ namespace zyn {
  * All the rt side needs is a function to map notes at various keyshifts to
  * frequencies, which does not require this many parameters...
  *
- * A good lookup table should be a good finalization of this
+ * The rt side reads the frequencies of the keys from a table, so every port
+ * which changes a parameter rebuilds it
  */
 const rtosc::Ports Microtonal::ports = {
     rToggle(Pinvertupdown, rShort("inv."), rDefault(false),
@@ -156,6 +159,7 @@ const rtosc::Ports Microtonal::ports = {
 
             for(int i=0; i<self.octavesize; ++i)
                 self.octave[i] = other->octave[i];
+            self.updatekeytable();
             d.reply("/free", "sb", "Microtonal", b.len, b.data);
         }},
     {"paste_scl:b", rProp(internal) rDoc("Clone Input scl Object"), 0,
@@ -171,6 +175,7 @@ const rtosc::Ports Microtonal::ports = {
 
             for(int i=0; i<self.octavesize; ++i)
                 self.octave[i] = other->octave[i];
+            self.updatekeytable();
             d.reply("/free", "sb", "SclInfo", b.len, b.data);
         }},
     {"paste_kbm:b", rProp(internal) rDoc("Clone Input kbm Object"), 0,
@@ -190,10 +195,12 @@ const rtosc::Ports Microtonal::ports = {
 
             for(int i=0; i<128; ++i)
                 self.Pmapping[i] = other->Pmapping[i];
+            self.updatekeytable();
             d.reply("/free", "sb", "KbmInfo", b.len, b.data);
         }},
 #undef COPY
 };
+#undef rChangeCb
 
 
 Microtonal::Microtonal(const int &gzip_compression)
@@ -239,6 +246,7 @@ void Microtonal::defaults()
              MICROTONAL_MAX_NAME_LEN,
              "Equal Temperament 12 notes per octave");
     Pglobalfinedetune = 64;
+    updatekeytable();
 }
 
 Microtonal::~Microtonal()
@@ -256,18 +264,112 @@ unsigned char Microtonal::getoctavesize() const
 }
 
 /*
- * Update the logarithmic power of two frequency according the note number
+ * Rebuild the frequencies of the MIDI notes
  */
-bool Microtonal::updatenotefreq_log2(float &note_log2_freq, int keyshift) const
+void Microtonal::updatekeytable()
 {
-    note_t note = roundf(12.0f * note_log2_freq);
-    float freq_log2 = note_log2_freq;
+    for(int note = 0; note < 128; ++note)
+        keymapped[note] = scalefreq_log2(note, keyfreq_log2[note]);
+    PAfreq_log2 = log2f(PAfreq);
+}
 
+/*
+ * Compute the logarithmic power of two frequency of a note in the scale
+ * relative to the "A" note, without the keyshift
+ */
+bool Microtonal::scalefreq_log2(note_t note, float &freq_log2) const
+{
     // in this function will appears many times things like this:
     // var=(a+b*100)%b
     // I had written this way because if I use var=a%b gives unwanted results when a<0
     // This is the same with divisions.
 
+    const int scaleshift =
+        ((int)Pscaleshift - 64 + (int) octavesize * 100) % octavesize;
+
+    /* if the mapping is enabled */
+    if(Pmappingenabled) {
+        if((note < Pfirstkey) || (note > Plastkey))
+            return false;
+
+        /*
+         * Compute how many mapped keys are from middle note to reference note
+         * and find out the proportion between the freq. of middle note and "A" note
+         */
+        int tmp = PAnote - Pmiddlenote;
+        const bool minus = (tmp < 0);
+        if(minus)
+            tmp = -tmp;
+
+        int deltanote = 0;
+        for(int i = 0; i < tmp; ++i)
+            if(Pmapping[i % Pmapsize] >= 0)
+                deltanote++;
+
+        float rap_anote_middlenote_log2;
+        if(deltanote == 0) {
+            rap_anote_middlenote_log2 = 0.0f;
+        }
+        else {
+            rap_anote_middlenote_log2 =
+                octave[(deltanote - 1) % octavesize].tuning_log2 +
+                octave[octavesize - 1].tuning_log2 * ((deltanote - 1) / octavesize);
+        }
+        if(minus)
+            rap_anote_middlenote_log2 = -rap_anote_middlenote_log2;
+
+        /* Convert from note (midi) to degree (note from the tuning) */
+        int degoct =
+            (note - (int)Pmiddlenote + (int) Pmapsize
+             * 200) / (int)Pmapsize - 200;
+        int degkey = (note - Pmiddlenote + (int)Pmapsize * 100) % Pmapsize;
+        degkey = Pmapping[degkey];
+
+        /* check if key is not mapped */
+        if(degkey < 0)
+            return false;
+
+        /*
+         * Invert the keyboard upside-down if it is asked for
+         * TODO: do the right way by using Pinvertupdowncenter
+         */
+        if(Pinvertupdown != 0) {
+            degkey = octavesize - degkey - 1;
+            degoct = -degoct;
+        }
+
+        degkey  = degkey + scaleshift;
+        degoct += degkey / octavesize;
+        degkey %= octavesize;
+
+        /* compute the logrithmic frequency of the note */
+        freq_log2 =
+            ((degkey == 0) ? 0.0f : octave[degkey - 1].tuning_log2) +
+            (octave[octavesize - 1].tuning_log2 * degoct) -
+            rap_anote_middlenote_log2;
+    }
+    else {  /* if the mapping is disabled */
+        const int nt    = note - PAnote + scaleshift;
+        const int ntkey = (nt + (int)octavesize * 100) % octavesize;
+        const int ntoct = (nt - ntkey) / octavesize;
+
+        freq_log2 =
+            octave[(ntkey + octavesize - 1) % octavesize].tuning_log2 +
+            octave[octavesize - 1].tuning_log2 * (ntkey ? ntoct : (ntoct - 1));
+    }
+    if(scaleshift)
+        freq_log2 -= octave[scaleshift - 1].tuning_log2;
+    return true;
+}
+
+/*
+ * Update the logarithmic power of two frequency according the note number
+ */
+bool Microtonal::updatenotefreq_log2(float &note_log2_freq, int keyshift) const
+{
+    note_t note = roundf(12.0f * note_log2_freq);
+    float freq_log2 = note_log2_freq;
+
     if((Pinvertupdown != 0) && ((Pmappingenabled == 0) || (Penabled == 0))) {
         note = (int) Pinvertupdowncenter * 2 - note;
         freq_log2 = Pinvertupdowncenter * (2.0f / 12.0f) - freq_log2;
@@ -280,9 +382,6 @@ bool Microtonal::updatenotefreq_log2(float &note_log2_freq, int keyshift) const
         freq_log2 += (keyshift - PAnote) / 12.0f;
     }
     else { /* Microtonal */
-        const int scaleshift =
-            ((int)Pscaleshift - 64 + (int) octavesize * 100) % octavesize;
-
         /* compute the keyshift */
         float rap_keyshift_log2;
         if(keyshift != 0) {
@@ -297,91 +396,24 @@ bool Microtonal::updatenotefreq_log2(float &note_log2_freq, int keyshift) const
             rap_keyshift_log2 = 0.0f;
         }
 
-        /* if the mapping is enabled */
-        if(Pmappingenabled) {
-            if((note < Pfirstkey) || (note > Plastkey))
-                goto failure;
-
-            /*
-             * Compute how many mapped keys are from middle note to reference note
-             * and find out the proportion between the freq. of middle note and "A" note
-             */
-            int tmp = PAnote - Pmiddlenote;
-            const bool minus = (tmp < 0);
-            if(minus)
-                tmp = -tmp;
-
-            int deltanote = 0;
-            for(int i = 0; i < tmp; ++i)
-                if(Pmapping[i % Pmapsize] >= 0)
-                    deltanote++;
-
-            float rap_anote_middlenote_log2;
-            if(deltanote == 0) {
-                rap_anote_middlenote_log2 = 0.0f;
-            }
-            else {
-                rap_anote_middlenote_log2 =
-                    octave[(deltanote - 1) % octavesize].tuning_log2 +
-                    octave[octavesize - 1].tuning_log2 * ((deltanote - 1) / octavesize);
-            }
-            if(minus)
-                rap_anote_middlenote_log2 = -rap_anote_middlenote_log2;
-
-            /* Convert from note (midi) to degree (note from the tuning) */
-            int degoct =
-                (note - (int)Pmiddlenote + (int) Pmapsize
-                 * 200) / (int)Pmapsize - 200;
-            int degkey = (note - Pmiddlenote + (int)Pmapsize * 100) % Pmapsize;
-            degkey = Pmapping[degkey];
-
-            /* check if key is not mapped */
-            if(degkey < 0)
-                goto failure;
-
-            /*
-             * Invert the keyboard upside-down if it is asked for
-             * TODO: do the right way by using Pinvertupdowncenter
-             */
-            if(Pinvertupdown != 0) {
-                degkey = octavesize - degkey - 1;
-                degoct = -degoct;
-            }
-
-            degkey  = degkey + scaleshift;
-            degoct += degkey / octavesize;
-            degkey %= octavesize;
-
-            /* compute the logrithmic frequency of the note */
-            freq_log2 =
-                ((degkey == 0) ? 0.0f : octave[degkey - 1].tuning_log2) +
-                (octave[octavesize - 1].tuning_log2 * degoct) -
-                rap_anote_middlenote_log2;
-        }
-        else {  /* if the mapping is disabled */
-            const int nt    = note - PAnote + scaleshift;
-            const int ntkey = (nt + (int)octavesize * 100) % octavesize;
-            const int ntoct = (nt - ntkey) / octavesize;
-
-            freq_log2 =
-                octave[(ntkey + octavesize - 1) % octavesize].tuning_log2 +
-                octave[octavesize - 1].tuning_log2 * (ntkey ? ntoct : (ntoct - 1));
+        /* the inversion may give notes above the table */
+        if(note < 128) {
+            if(!keymapped[note])
+                return false;
+            freq_log2 = keyfreq_log2[note];
         }
-        if(scaleshift)
-            freq_log2 -= octave[scaleshift - 1].tuning_log2;
+        else if(!scalefreq_log2(note, freq_log2))
+            return false;
         freq_log2 += rap_keyshift_log2;
     }
 
     /* common part */
-    freq_log2 += log2f(PAfreq);
+    freq_log2 += PAfreq_log2;
     freq_log2 += globalfinedetunerap_log2;
 
     /* update value */
     note_log2_freq = freq_log2;
     return true;
-
-failure:
-    return false;
 }
 
 /*
@@ -548,6 +580,7 @@ int Microtonal::texttotunings(const char *text)
         octave[i].x1     = tmpoctave[i].x1;
         octave[i].x2     = tmpoctave[i].x2;
     }
+    updatekeytable();
     return -1; //ok
 }
 
@@ -587,6 +620,7 @@ void Microtonal::texttomapping(const char *text)
     if(tx == 0)
         tx = 1;
     Pmapsize = tx;
+    updatekeytable();
 }
 
 /*
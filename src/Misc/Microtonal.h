@@ -75,6 +75,10 @@ class Microtonal
         /**Calculates the frequency for a given note
          */
         float getnotefreq(float note_log2_freq, int keyshift) const;
+        /**Rebuilds the table of the note frequencies, which has to follow
+         * every change of the parameters outside of the ports and loaders
+         */
+        void updatekeytable();
 
         //Parameters
         /**if the keys are inversed (the pitch is lower to keys from the right direction)*/
@@ -159,6 +163,13 @@ class Microtonal
 
         static int linetotunings(struct OctaveTuning &tune, const char *line);
         void apply(void);
+        //frequency of a note relative to "A" without the keyshift
+        bool scalefreq_log2(note_t note, float &freq_log2) const;
+
+        //scalefreq_log2() of the MIDI notes, from updatekeytable()
+        float keyfreq_log2[128];
+        bool  keymapped[128];
+        float PAfreq_log2;
 
         const int& gzip_compression;
 };
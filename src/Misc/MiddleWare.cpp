@@ -20,13 +20,15 @@
 #include <sys/stat.h>
 #include <mutex>
 
-#include <rtosc/undo-history.h>
 #include <rtosc/thread-link.h>
 #include <rtosc/ports.h>
 #include <rtosc/port-sugar.h>
 #include <lo/lo.h>
 
 #include <unistd.h>
+#ifndef WIN32
+#include <poll.h>
+#endif
 
 #include "../UI/Connection.h"
 #include "../UI/Fl_Osc_Interface.h"
@@ -36,16 +38,22 @@
 
 #include "Util.h"
 #include "CallbackRepeater.h"
+#include "EventNotifier.h"
 #include "Master.h"
 #include "MsgParsing.h"
+#include "OscIngest.h"
+#include "ParamBlock.h"
 #include "Part.h"
 #include "PresetExtractor.h"
+#include "UndoStore.h"
+#include "WaveShapeSmps.h"
 #include "../Containers/MultiPseudoStack.h"
 #include "../Params/PresetsStore.h"
 #include "../Params/EnvelopeParams.h"
 #include "../Params/LFOParams.h"
 #include "../Params/FilterParams.h"
 #include "../Effects/EffectMgr.h"
+#include "../Effects/Convolution.h"
 #include "../Synth/Resonance.h"
 #include "../Params/ADnoteParameters.h"
 #include "../Params/SUBnoteParameters.h"
@@ -56,6 +64,8 @@
 
 #include <string>
 #include <future>
+#include <chrono>
+#include <thread>
 #include <atomic>
 #include <list>
 
@@ -106,28 +116,14 @@ static void liblo_error_cb(int i, const char *m, const char *loc)
 // bad style?
 static const rtosc::Ports& getNonRtParamPorts();
 
-static int handler_function(const char *path, const char *types, lo_arg **argv,
-        int argc, lo_message msg, void *user_data)
+//Handle a message of a remote, source is its URL if known
+static void handle_remote_msg(MiddleWare *mw, char *buffer, const char *source)
 {
-    (void) types;
-    (void) argv;
-    (void) argc;
-    MiddleWare *mw = (MiddleWare*)user_data;
-    lo_address addr = lo_message_get_source(msg);
-    if(addr) {
-        const char *tmp = lo_address_get_url(addr);
-        if(tmp != mw->activeUrl()) {
-            mw->transmitMsg("/echo", "ss", "OSC_URL", tmp);
-            mw->activeUrl(tmp);
-        }
-        free((void*)tmp);
+    if(source && source != mw->activeUrl()) {
+        mw->transmitMsg("/echo", "ss", "OSC_URL", source);
+        mw->activeUrl(source);
     }
 
-    char buffer[2048];
-    memset(buffer, 0, sizeof(buffer));
-    size_t size = 2048;
-    lo_message_serialise(msg, path, buffer, &size);
-
     if(!strcmp(buffer, "/path-search") &&
        (!strcmp("ss",  rtosc_argument_string(buffer)) ||
         !strcmp("ssT", rtosc_argument_string(buffer)) ) )
@@ -167,7 +163,25 @@ static int handler_function(const char *path, const char *types, lo_arg **argv,
     {
         mw->transmitMsg(rtosc::Ports::collapsePath(buffer));
     }
+}
 
+static int handler_function(const char *path, const char *types, lo_arg **argv,
+        int argc, lo_message msg, void *user_data)
+{
+    (void) types;
+    (void) argv;
+    (void) argc;
+    MiddleWare *mw = (MiddleWare*)user_data;
+    lo_address addr = lo_message_get_source(msg);
+    const char *url = addr ? lo_address_get_url(addr) : nullptr;
+
+    char buffer[2048];
+    memset(buffer, 0, sizeof(buffer));
+    size_t size = 2048;
+    lo_message_serialise(msg, path, buffer, &size);
+
+    handle_remote_msg(mw, buffer, url);
+    free((void*)url);
     return 0;
 }
 
@@ -222,8 +236,13 @@ void deallocate(const char *str, void *v)
         delete (Resonance*)v;
     else if(!strcmp(str, "rtosc::AutomationMgr"))
         delete (rtosc::AutomationMgr*)v;
+    else if(!strcmp(str, "ImpulseResponse"))
+        delete (ImpulseResponse*)v;
+    else if(!strcmp(str, "WaveShaperTable"))
+        delete (WaveShaper::Table*)v;
     else if(!strcmp(str, "PADsample"))
-        delete[] (float*)v;
+        PADnoteParameters::SampleData::release(
+                (PADnoteParameters::SampleData*)v);
     else
         fprintf(stderr, "Unknown type '%s', leaking pointer %p!!\n", str, v);
 }
@@ -247,7 +266,7 @@ void preparePadSynth(string path, PADnoteParameters *p, rtosc::RtData &d)
                            //printf("sending info to '%s'\n",
                            //       (path+to_s(N)).c_str());
                            d.chain((path+to_s(N)).c_str(), "ifb",
-                                   s.size, s.basefreq, sizeof(float*), &s.smp);
+                                   s.size, s.basefreq, sizeof(void*), &s.data);
                        }, []{return false;}, 1);
 #else
     std::mutex rtdata_mutex;
@@ -259,7 +278,7 @@ void preparePadSynth(string path, PADnoteParameters *p, rtosc::RtData &d)
                            rtdata_mutex.lock();
                            // send non-realtime computed data to PADnoteParameters
                            d.chain((path+to_s(N)).c_str(), "ifb",
-                                   s.size, s.basefreq, sizeof(float*), &s.smp);
+                                   s.size, s.basefreq, sizeof(void*), &s.data);
                            rtdata_mutex.unlock();
                        }, []{return false;});
 #endif
@@ -267,7 +286,7 @@ void preparePadSynth(string path, PADnoteParameters *p, rtosc::RtData &d)
     //clear out unused samples
     for(unsigned i = num; i < PAD_MAX_SAMPLES; ++i) {
         d.chain((path+to_s(i)).c_str(), "ifb",
-                0, 440.0f, sizeof(float*), NULL);
+                0, 440.0f, sizeof(void*), NULL);
     }
 }
 
@@ -703,15 +722,20 @@ public:
     //structures at once...
     int loadMaster(const char *filename, bool osc_format = false)
     {
+        const auto t_on = std::chrono::steady_clock::now();
         Master *m = new Master(synth, config);
         m->uToB = uToB;
         m->bToU = bToU;
+        m->bToUnotify = &notifier;
 
         if(filename) {
             if(osc_format)
             {
                 mw_dispatcher_t dispatcher(parent);
-                if( m->loadOSC(filename, &dispatcher) < 0 ) {
+                beginParamBlock();
+                int res = m->loadOSC(filename, &dispatcher);
+                endParamBlock();
+                if(res < 0) {
                     delete m;
                     return -1;
                 }
@@ -724,6 +748,10 @@ public:
                 }
             }
             m->applyparameters();
+
+            const std::chrono::duration<float> load_time =
+                std::chrono::steady_clock::now() - t_on;
+            printf("Loaded <%s> in %.2f s.\n", filename, load_time.count());
         }
 
         //Update resource locator table
@@ -787,7 +815,9 @@ public:
                     dispatcher.updateMaster(&master2);
                     while(old_master->isMasterSwitchUpcoming()) { os_usleep(50000); }
 
+                    beginParamBlock();
                     res = master2.loadOSCFromStr(savefile.c_str(), &dispatcher);
+                    endParamBlock();
                     // TODO: compare MiddleWare, too?
 
                     // The above call is done by this thread (i.e. the MiddleWare thread), but
@@ -910,6 +940,21 @@ public:
             d.chain("/microtonal/paste_kbm", "b", sizeof(void*), &kbm);
     }
 
+    //Load an impulse response for the effect at path ".../ir-file"
+    void loadImpulseResponse(const char *path, const char *filename,
+                             rtosc::RtData &d)
+    {
+        ImpulseResponse *ir = ImpulseResponse::load(filename, synth);
+        if(!ir) {
+            d.reply("/alert", "s",
+                    "Error: Could not load the impulse response.");
+            return;
+        }
+        string dest = path[0] == '/' ? path : string("/") + path;
+        dest = dest.substr(0, dest.rfind('/') + 1) + "ir";
+        d.chain(dest.c_str(), "b", sizeof(void*), &ir);
+    }
+
     void updateResources(Master *m)
     {
         obj_store.clear();
@@ -930,8 +975,16 @@ public:
 
     void tick(void)
     {
-        if(server)
+        notifier.clear();
+
+        if(server) {
+#ifndef WIN32
+            ingest.drain(lo_server_get_socket_fd(server));
+            ingest.tick(OscIngest::now());
+#else
             while(lo_server_recv_noblock(server, 0));
+#endif
+        }
 
         while(bToU->hasNext()) {
             const char *rtmsg = bToU->read();
@@ -972,6 +1025,17 @@ public:
     void write(const char *path, const char *args, ...);
     void write(const char *path, const char *args, va_list va);
 
+    // Collect messages for the backend into one "/param-block" until the
+    // matching endParamBlock()
+    void beginParamBlock(void) { param_block_depth++; }
+    void endParamBlock(void)
+    {
+        assert(param_block_depth > 0);
+        if(--param_block_depth == 0)
+            flushParamBlock();
+    }
+    void flushParamBlock(void);
+
     void currentUrl(string addr)
     {
         curr_url = addr;
@@ -1024,7 +1088,7 @@ public:
     std::atomic_int actual_load[NUM_MIDI_PARTS];
 
     //Undo/Redo
-    rtosc::UndoHistory undo;
+    UndoStore undo;
 
     //MIDI Learn
     rtosc::MidiMappernRT midi_mapper;
@@ -1036,8 +1100,16 @@ public:
     //Link to the unknown
     MultiQueue multi_thread_source;
 
-    //LIBLO
+    //Signaled when bToU or multi_thread_source get new messages
+    EventNotifier notifier;
+
+    //Pending parameter block and begin/end nesting depth
+    ParamBlock param_block;
+    int param_block_depth = 0;
+
+    //LIBLO, except for reading its socket with ingest
     lo_server server;
+    OscIngest ingest;
     string last_url, curr_url;
     std::set<string> known_remotes;
 
@@ -1592,6 +1664,18 @@ static rtosc::Ports middwareSnoopPortsWithoutNonRtParams = {
         impl.kitEnable(msg);
         d.forward();
         rEnd},
+    {"sysefx*/ir-file:s", 0, 0,
+        rBegin;
+        impl.loadImpulseResponse(msg, rtosc_argument(msg, 0).s, d);
+        rEnd},
+    {"insefx*/ir-file:s", 0, 0,
+        rBegin;
+        impl.loadImpulseResponse(msg, rtosc_argument(msg, 0).s, d);
+        rEnd},
+    {"part*/partefx*/ir-file:s", 0, 0,
+        rBegin;
+        impl.loadImpulseResponse(msg, rtosc_argument(msg, 0).s, d);
+        rEnd},
     {"save_xcz:s", 0, 0,
         rBegin;
         const char *file = rtosc_argument(msg, 0).s;
@@ -1917,6 +2001,31 @@ static rtosc::Ports middlewareReplyPorts = {
         void       *ptr  = *(void**)rtosc_argument(msg, 1).b.data;
         deallocate(type, ptr);
         rEnd},
+    {"shapetable:siiii", 0, 0,
+        rBegin;
+        //The request comes from a port below the effect manager, whose path
+        //ends with "efx<n>/", e.g. /part0/partefx1/Distortion/Pdrive
+        const char *loc = rtosc_argument(msg, 0).s;
+        const char *end = nullptr;
+        for(const char *p = strstr(loc, "efx"); p; p = strstr(p + 1, "efx")) {
+            const char *q = p + 3;
+            if(!isdigit(*q))
+                continue;
+            while(isdigit(*q))
+                ++q;
+            if(*q == '/')
+                end = q + 1;
+        }
+        if(!end)
+            return;
+        WaveShaper::Table *table = WaveShaper::buildtable(
+                rtosc_argument(msg, 1).i, rtosc_argument(msg, 2).i,
+                rtosc_argument(msg, 3).i, rtosc_argument(msg, 4).i);
+        if(!table)
+            return;
+        const string dest = string(loc, end) + "shapetable";
+        impl.uToB->write(dest.c_str(), "b", sizeof(void*), &table);
+        rEnd},
     {"request-memory:", 0, 0,
         rBegin;
         //Generate out more memory for the RT memory pool
@@ -1967,8 +2076,16 @@ static rtosc::Ports middlewareReplyPorts = {
 
 MiddleWareImpl::MiddleWareImpl(MiddleWare *mw, SYNTH_T synth_,
     Config* config, int preferrred_port)
-    :parent(mw), config(config), ui(nullptr), synth(std::move(synth_)),
-    presetsstore(*config), autoSave(-1, [this]() {
+    :parent(mw), config(config), ui(nullptr),
+    //each OSC bundle reaches the backend as one parameter block
+    ingest([mw](char *msg, const char *source) {
+            handle_remote_msg(mw, msg, source);},
+        [this](bool begin) {
+            if(begin)
+                beginParamBlock();
+            else
+                endParamBlock();}),
+    synth(std::move(synth_)), presetsstore(*config), autoSave(-1, [this]() {
             auto master = this->master;
             this->doReadOnlyOp([master](){
                 std::string home = getenv("HOME");
@@ -1979,6 +2096,7 @@ MiddleWareImpl::MiddleWareImpl(MiddleWare *mw, SYNTH_T synth_,
 {
     bToU = new rtosc::ThreadLink(4096*2*16,1024/16);
     uToB = new rtosc::ThreadLink(4096*2*16,1024/16);
+    param_block.max_size = uToB->buffer_size() - ParamBlock::message_overhead;
     midi_mapper.base_ports = &Master::ports;
     midi_mapper.rt_cb      = [this](const char *msg){handleMsg(msg);};
     if(preferrred_port != -1)
@@ -2012,6 +2130,7 @@ MiddleWareImpl::MiddleWareImpl(MiddleWare *mw, SYNTH_T synth_,
     }
 
     //Setup Undo
+    undo.setMaxMemory((size_t)config->cfg.UndoHistorySize << 20);
     undo.setCallback([this](const char *msg) {
            // printf("undo callback <%s>\n", msg);
             char buf[1024];
@@ -2059,6 +2178,7 @@ void zyn::MiddleWareImpl::recreateMinimalMaster()
     master = new Master(synth, config);
     master->bToU = bToU;
     master->uToB = uToB;
+    master->bToUnotify = &notifier;
 }
 
 /** Threading When Saving
@@ -2388,6 +2508,11 @@ void MiddleWareImpl::handleMsg(const char *msg, bool msg_comes_from_realtime)
         return;
     }
 
+    //Snooping ports may write to the backend on their own, so anything
+    //collected so far must arrive there first
+    if(!param_block.empty() && middwareSnoopPorts.apropos(msg))
+        flushParamBlock();
+
     MwDataObj d(this);
     middwareSnoopPorts.dispatch(msg, d, true);
 
@@ -2397,10 +2522,19 @@ void MiddleWareImpl::handleMsg(const char *msg, bool msg_comes_from_realtime)
             // don't reply the same msg to realtime - avoid cycles
             //printf("Message from RT will not be replied to RT: <%s:%s>...\n",
             //       msg, rtosc_argument_string(msg));
+        } else if(param_block_depth && rtosc_narguments(msg)) {
+            if(!param_block.add(msg)) {
+                flushParamBlock();
+                if(!param_block.add(msg))
+                    uToB->raw_write(msg);
+            }
         } else {
             //if(strcmp("/get-vu", msg)) {
             //    printf("Message Continuing on<%s:%s>...\n", msg, rtosc_argument_string(msg));
             //}
+            //A block does not reply per message, so queries go on their
+            //own after the changes before them
+            flushParamBlock();
             uToB->raw_write(msg);
         }
     } else {
@@ -2416,6 +2550,15 @@ void MiddleWareImpl::handleMsg(const char *msg, bool msg_comes_from_realtime)
     }
 }
 
+void MiddleWareImpl::flushParamBlock(void)
+{
+    if(param_block.empty())
+        return;
+    const std::vector<char> blob = param_block.pack();
+    param_block.clear();
+    uToB->write("/param-block", "b", blob.size(), blob.data());
+}
+
 void MiddleWareImpl::write(const char *path, const char *args, ...)
 {
     //We have a free buffer in the threadlink, so use it
@@ -2531,6 +2674,39 @@ void MiddleWare::tick(void)
     impl->tick();
 }
 
+void MiddleWare::waitForEvents(int timeout_ms)
+{
+    //The heart beat and autosave are checked by tick(), so it has to run
+    //at least every 100 ms, and when the next OSC bundle is due
+    timeout_ms = std::min(timeout_ms, 100);
+    const int bundle_ms = impl->ingest.timeout(OscIngest::now());
+    if(bundle_ms >= 0)
+        timeout_ms = std::min(timeout_ms, bundle_ms);
+#ifndef WIN32
+    struct pollfd fds[2];
+    nfds_t nfds = 0;
+    if(impl->notifier.fd() != -1)
+        fds[nfds++] = {impl->notifier.fd(), POLLIN, 0};
+    if(impl->server)
+        fds[nfds++] = {lo_server_get_socket_fd(impl->server), POLLIN, 0};
+    if(nfds) {
+        poll(fds, nfds, timeout_ms);
+        return;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+}
+
+void MiddleWare::beginParamBlock(void)
+{
+    impl->beginParamBlock();
+}
+
+void MiddleWare::endParamBlock(void)
+{
+    impl->endParamBlock();
+}
+
 void MiddleWare::doReadOnlyOp(std::function<void()> fn)
 {
     impl->doReadOnlyOp(fn);
@@ -2612,9 +2788,10 @@ void MiddleWare::messageAnywhere(const char *path, const char *args, ...)
 
     va_list va;
     va_start(va,args);
-    if(rtosc_vmessage(mem->memory,mem->size,path,args,va))
+    if(rtosc_vmessage(mem->memory,mem->size,path,args,va)) {
         impl->multi_thread_source.write(mem);
-    else {
+        impl->notifier.notify();
+    } else {
         fprintf(stderr, "Middleware::messageAnywhere message too big...\n");
         impl->multi_thread_source.free(mem);
     }
@@ -2624,11 +2801,13 @@ void MiddleWare::messageAnywhere(const char *path, const char *args, ...)
 void MiddleWare::pendingSetBank(int bank)
 {
     impl->bToU->write("/setbank", "c", bank);
+    impl->notifier.notify();
 }
 void MiddleWare::pendingSetProgram(int part, int program)
 {
     impl->pending_load[part]++;
     impl->bToU->write("/setprogram", "cc", part, program);
+    impl->notifier.notify();
 }
 
 std::string zyn::MiddleWare::getProgramName(int program) const
@@ -2690,6 +2869,7 @@ void MiddleWare::switchMaster(Master* new_master)
 
     new_master->uToB = impl->uToB;
     new_master->bToU = impl->bToU;
+    new_master->bToUnotify = &impl->notifier;
     impl->updateResources(new_master);
     impl->master = new_master;
 
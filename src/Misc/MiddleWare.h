@@ -56,6 +56,9 @@ class MiddleWare
         void setIdleCallback(void(*cb)(void*),void *ptr);
         //Handle events
         void tick(void);
+        //Sleep until there are events for tick() or timeout_ms passed
+        //Backend replies, messageAnywhere() and OSC packets wake it up
+        void waitForEvents(int timeout_ms);
         //Do A Readonly Operation (For Parameter Copy)
         void doReadOnlyOp(std::function<void()>);
         //Handle a rtosc Message uToB
@@ -72,6 +75,12 @@ class MiddleWare
         //Handle a rtosc Message uToB, if sender is GUI
         void transmitMsgGui_va(const char *, const char *args, va_list va);
 
+        //Collect all following backend bound messages into one
+        //"/param-block" which is applied within a single buffer
+        void beginParamBlock(void);
+        //Send the collected block (calls may be nested)
+        void endParamBlock(void);
+
         //Send a message to middleware from an arbitrary thread
         void messageAnywhere(const char *msg, const char *args, ...);
 
@@ -0,0 +1,197 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OscIngest.cpp - Batched Reading Of OSC Packets From UDP
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "OscIngest.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <rtosc/rtosc.h>
+#ifndef WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#endif
+
+namespace zyn {
+
+constexpr unsigned OscIngest::batch_size;
+constexpr size_t   OscIngest::packet_size;
+constexpr size_t   OscIngest::max_scheduled;
+
+OscIngest::OscIngest(handler_t handler_, bundle_handler_t bundle_handler_)
+    :handler(handler_), bundle_handler(bundle_handler_),
+    buffer(new char[batch_size * packet_size]), sequence(0)
+{}
+
+OscIngest::~OscIngest(void)
+{
+    delete[] buffer;
+}
+
+#ifndef WIN32
+//The URL liblo reports for the same sender
+static void sourceurl(char *url, size_t len, const sockaddr_storage &addr,
+                      socklen_t addrlen)
+{
+    char host[NI_MAXHOST], port[NI_MAXSERV];
+    if(getnameinfo((const sockaddr *)&addr, addrlen, host, sizeof(host),
+                   port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV)) {
+        url[0] = '\0';
+        return;
+    }
+    if(addr.ss_family == AF_INET6)
+        snprintf(url, len, "osc.udp://[%s]:%s/", host, port);
+    else
+        snprintf(url, len, "osc.udp://%s:%s/", host, port);
+}
+#endif
+
+int OscIngest::drain(int fd)
+{
+#ifdef WIN32
+    (void)fd;
+    return 0;
+#else
+    //the URL is only looked up again when the sender changes
+    char             url[NI_MAXHOST + NI_MAXSERV + 16] = "";
+    sockaddr_storage last = {};
+    socklen_t        lastlen = 0;
+    auto handle = [&](char *packet, size_t len, const sockaddr_storage &addr,
+                      socklen_t addrlen, uint64_t t) {
+        if(addrlen != lastlen || memcmp(&addr, &last, addrlen)) {
+            sourceurl(url, sizeof(url), addr, addrlen);
+            last    = addr;
+            lastlen = addrlen;
+        }
+        dispatch(packet, len, url[0] ? url : nullptr, t);
+    };
+
+    int total = 0;
+#ifdef __linux__
+    mmsghdr          msgs[batch_size];
+    iovec            iovs[batch_size];
+    sockaddr_storage addrs[batch_size];
+    while(true) {
+        for(unsigned i = 0; i < batch_size; ++i) {
+            iovs[i].iov_base = buffer + i * packet_size;
+            iovs[i].iov_len  = packet_size;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name    = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+            msgs[i].msg_hdr.msg_iov     = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        const int n = recvmmsg(fd, msgs, batch_size, MSG_DONTWAIT, nullptr);
+        if(n <= 0)
+            break;
+        const uint64_t t = now();
+        for(int i = 0; i < n; ++i)
+            if(!(msgs[i].msg_hdr.msg_flags & MSG_TRUNC))
+                handle(buffer + i * packet_size, msgs[i].msg_len, addrs[i],
+                       msgs[i].msg_hdr.msg_namelen, t);
+        total += n;
+        if(n < (int)batch_size)
+            break;
+    }
+#else
+    while(true) {
+        sockaddr_storage addr;
+        socklen_t addrlen = sizeof(addr);
+        const ssize_t len = recvfrom(fd, buffer, packet_size, MSG_DONTWAIT,
+                                     (sockaddr *)&addr, &addrlen);
+        if(len < 0)
+            break;
+        //a datagram filling the buffer may have been truncated
+        if((size_t)len < packet_size)
+            handle(buffer, len, addr, addrlen, now());
+        ++total;
+    }
+#endif
+    return total;
+#endif
+}
+
+void OscIngest::dispatch(char *packet, size_t len, const char *source,
+                         uint64_t now)
+{
+    if(len >= 16 && !memcmp(packet, "#bundle", 8))
+        unpack(packet, len, source, now);
+    else if(len && *packet == '/' && rtosc_message_length(packet, len))
+        handler(packet, source);
+}
+
+void OscIngest::unpack(char *bundle, size_t len, const char *source,
+                       uint64_t now)
+{
+    //the timetag 1 means immediately and is always in the past
+    const uint64_t time = rtosc_bundle_timetag(bundle);
+    if(time > now) {
+        if(queue.size() >= max_scheduled) {
+            fprintf(stderr, "Warning: dropping scheduled OSC bundle\n");
+            return;
+        }
+        queue.push_back({time, sequence++, source ? source : "",
+                         std::vector<char>(bundle, bundle + len)});
+        std::push_heap(queue.begin(), queue.end());
+        return;
+    }
+
+    if(bundle_handler)
+        bundle_handler(true);
+    const size_t elements = rtosc_bundle_elements(bundle, len);
+    for(size_t i = 0; i < elements; ++i)
+        dispatch((char *)rtosc_bundle_fetch(bundle, i),
+                 rtosc_bundle_size(bundle, i), source, now);
+    if(bundle_handler)
+        bundle_handler(false);
+}
+
+int OscIngest::tick(uint64_t now)
+{
+    int bundles = 0;
+    while(!queue.empty() && queue.front().time <= now) {
+        std::pop_heap(queue.begin(), queue.end());
+        Bundle b = std::move(queue.back());
+        queue.pop_back();
+        unpack(b.data.data(), b.data.size(),
+               b.source.empty() ? nullptr : b.source.c_str(), now);
+        ++bundles;
+    }
+    return bundles;
+}
+
+int OscIngest::timeout(uint64_t now) const
+{
+    if(queue.empty())
+        return -1;
+    if(queue.front().time <= now)
+        return 0;
+    //round up, so the bundle is due once the time has passed
+    const uint64_t dt = queue.front().time - now;
+    const uint64_t ms = (dt >> 32) * 1000
+                        + (((dt & 0xffffffff) * 1000 + 0xffffffff) >> 32);
+    return ms > INT_MAX ? INT_MAX : (int)ms;
+}
+
+uint64_t OscIngest::now(void)
+{
+    using namespace std::chrono;
+    //seconds from 1900 (NTP) to 1970 (unix)
+    const uint64_t epoch = 2208988800u;
+    const uint64_t ns = duration_cast<nanoseconds>(
+            system_clock::now().time_since_epoch()).count();
+    const uint64_t sec  = ns / 1000000000 + epoch;
+    const uint64_t frac = ((ns % 1000000000) << 32) / 1000000000;
+    return (sec << 32) | frac;
+}
+
+}
@@ -0,0 +1,93 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OscIngest.h - Batched Reading Of OSC Packets From UDP
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace zyn {
+
+/**
+ * Reads the OSC packets of a UDP socket with as few system calls as
+ * possible (recvmmsg() where available) and unpacks bundles.
+ *
+ * The messages of a bundle are passed on between two calls of the bundle
+ * handler, so they can be applied together. Bundles with a timetag in the
+ * future are kept until tick() is called at or after their time.
+ */
+class OscIngest
+{
+    public:
+        //@param msg    a single OSC message, may be modified by the handler
+        //@param source osc.udp URL of the sender
+        typedef std::function<void(char *msg, const char *source)> handler_t;
+        //@param begin true before the messages of a bundle, false after them
+        typedef std::function<void(bool begin)> bundle_handler_t;
+
+        //Datagrams read per system call and their maximum size
+        static constexpr unsigned batch_size  = 32;
+        static constexpr size_t   packet_size = 16384;
+        //Bundles kept for later, any further ones are dropped
+        static constexpr size_t   max_scheduled = 4096;
+
+        OscIngest(handler_t handler,
+                  bundle_handler_t bundle_handler = bundle_handler_t());
+        ~OscIngest(void);
+
+        //Read all datagrams pending on a UDP socket without blocking
+        //@return number of datagrams
+        int drain(int fd);
+
+        //Handle a message or bundle
+        //@param now current time as OSC timetag
+        void dispatch(char *packet, size_t len, const char *source,
+                      uint64_t now);
+
+        //Handle the scheduled bundles which are due
+        //@return number of bundles
+        int tick(uint64_t now);
+
+        //Milliseconds until the next scheduled bundle, -1 if there is none
+        int timeout(uint64_t now) const;
+
+        size_t scheduled(void) const { return queue.size(); }
+
+        //Current time as OSC timetag (NTP format)
+        static uint64_t now(void);
+
+    private:
+        OscIngest(const OscIngest&) = delete;
+        OscIngest &operator=(const OscIngest&) = delete;
+
+        struct Bundle {
+            uint64_t          time;
+            uint64_t          sequence; //keeps the order at the same time
+            std::string       source;
+            std::vector<char> data;
+            //the heap has the earliest bundle on top
+            bool operator<(const Bundle &b) const {
+                return time != b.time ? time > b.time : sequence > b.sequence;
+            }
+        };
+
+        void unpack(char *bundle, size_t len, const char *source,
+                    uint64_t now);
+
+        handler_t           handler;
+        bundle_handler_t    bundle_handler;
+        char               *buffer;
+        std::vector<Bundle> queue;
+        uint64_t            sequence;
+};
+
+}
@@ -0,0 +1,133 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ParamBlock.cpp - Packed Block Of Parameter Changes
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "ParamBlock.h"
+#include <rtosc/rtosc.h>
+#include <cstring>
+
+namespace zyn {
+
+static size_t pad4(size_t len)
+{
+    return (len + 3) & ~(size_t)3;
+}
+
+static void put32(std::vector<char> &v, uint32_t x)
+{
+    const char *p = (const char*)&x;
+    v.insert(v.end(), p, p + 4);
+}
+
+//Bytes used by the (nul terminated and padded) damage path
+static size_t damageBytes(const std::string &damage)
+{
+    return pad4(damage.size() + 1);
+}
+
+ParamBlock::ParamBlock(size_t max_size_)
+    :max_size(max_size_), entries_count(0)
+{}
+
+bool ParamBlock::add(const char *msg)
+{
+    const size_t len = rtosc_message_length(msg, -1);
+    if(!len)
+        return false;
+
+    //Common parent path of all entries
+    std::string path = msg;
+    std::string damage_ = entries_count ? damage : path;
+    size_t common = 0;
+    while(common < damage_.size() && common < path.size()
+          && damage_[common] == path[common])
+        ++common;
+    damage_.resize(common);
+    damage_.resize(damage_.rfind('/') + 1);
+
+    if(max_size && 12 + damageBytes(damage_) + entries.size() + 4 + len > max_size)
+        return false;
+
+    damage = damage_;
+    put32(entries, len);
+    entries.insert(entries.end(), msg, msg + len);
+    entries_count++;
+    return true;
+}
+
+void ParamBlock::clear(void)
+{
+    entries.clear();
+    damage.clear();
+    entries_count = 0;
+}
+
+size_t ParamBlock::size(void) const
+{
+    return 12 + damageBytes(damage) + entries.size();
+}
+
+std::vector<char> ParamBlock::pack(void) const
+{
+    std::vector<char> blob;
+    blob.reserve(size());
+    put32(blob, magic);
+    put32(blob, entries_count);
+    put32(blob, damageBytes(damage));
+    blob.insert(blob.end(), damage.begin(), damage.end());
+    blob.resize(12 + damageBytes(damage), 0);
+    blob.insert(blob.end(), entries.begin(), entries.end());
+    return blob;
+}
+
+static uint32_t get32(const char *p)
+{
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return x;
+}
+
+ParamBlockReader::ParamBlockReader(const void *data, size_t len)
+    :pos((const char*)data), end((const char*)data + len),
+    damage_path(""), entries_count(0), ok(false)
+{
+    if(len < 12 || get32(pos) != ParamBlock::magic)
+        return;
+
+    entries_count = get32(pos + 4);
+    const uint32_t damage_len = get32(pos + 8);
+    if(damage_len == 0 || damage_len > len - 12 || pos[12 + damage_len - 1])
+        return;
+    damage_path = pos + 12;
+    pos += 12 + damage_len;
+
+    //Verify all entries before anything gets applied
+    const char *itr = pos;
+    for(unsigned i = 0; i < entries_count; ++i) {
+        if(end - itr < 4)
+            return;
+        const uint32_t msg_len = get32(itr);
+        if(msg_len > (size_t)(end - itr - 4)
+           || rtosc_message_length(itr + 4, msg_len) != msg_len)
+            return;
+        itr += 4 + msg_len;
+    }
+    ok = itr == end;
+}
+
+const char *ParamBlockReader::next(void)
+{
+    if(!ok || pos >= end)
+        return nullptr;
+    const char *msg = pos + 4;
+    pos += 4 + get32(pos);
+    return msg;
+}
+
+}
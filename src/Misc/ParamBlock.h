@@ -0,0 +1,82 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ParamBlock.h - Packed Block Of Parameter Changes
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zyn {
+
+/**
+ * Packs many parameter changes into the blob of a single "/param-block"
+ * message, so the backend can apply all of them within one buffer and answer
+ * with one reply instead of one per parameter.
+ *
+ * Blob layout (all fields 4 byte aligned, native endianness):
+ *   uint32 magic, uint32 count, uint32 damage length, damage path,
+ *   count times {uint32 length, OSC message}
+ *
+ * The damage path is the longest common parent of all entries and is used
+ * for refreshing views once the block has been applied.
+ */
+class ParamBlock
+{
+    public:
+        static constexpr uint32_t magic = 0x5a504231; //"ZPB1"
+        //Bytes of the "/param-block" message around the blob
+        static constexpr size_t message_overhead = 24;
+
+        //@param max_size maximum size of the packed blob
+        ParamBlock(size_t max_size = 0);
+
+        //Append an OSC message
+        //@return false if the block would exceed max_size
+        bool add(const char *msg);
+
+        void clear(void);
+        bool empty(void) const { return entries_count == 0; }
+        unsigned count(void) const { return entries_count; }
+
+        //Size of the blob if it was packed now
+        size_t size(void) const;
+        //Build the blob for the "/param-block" message
+        std::vector<char> pack(void) const;
+
+        size_t max_size;
+    private:
+        std::vector<char> entries;
+        std::string       damage;
+        unsigned          entries_count;
+};
+
+//! Realtime safe iteration over a packed ParamBlock
+class ParamBlockReader
+{
+    public:
+        ParamBlockReader(const void *data, size_t len);
+
+        //true if the header and all entry lengths are consistent
+        bool valid(void) const { return ok; }
+        unsigned count(void) const { return entries_count; }
+        const char *damage(void) const { return damage_path; }
+
+        //@return next message or nullptr at the end of the block
+        const char *next(void);
+    private:
+        const char *pos;
+        const char *end;
+        const char *damage_path;
+        unsigned    entries_count;
+        bool        ok;
+};
+
+}
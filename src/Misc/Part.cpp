@@ -208,6 +208,22 @@ static const Ports partPorts = {
                 d.reply("/alert", "s",
                         "Failed To Save File, please check file permissions");
         }},
+    {"sample-memory:", rProp(internal)
+        rDoc("Bytes of PADsynth wavetables used by the part and how many of "
+             "them are shared with other kit items or parts"), 0,
+        [](const char *, RtData &d)
+        {
+            Part *p = (Part*)d.obj;
+            int64_t total = 0, shared = 0;
+            for(int i = 0; i < NUM_KIT_ITEMS; ++i) {
+                if(!p->kit[i].padpars)
+                    continue;
+                size_t kit_shared;
+                total  += p->kit[i].padpars->sampleMemory(&kit_shared);
+                shared += kit_shared;
+            }
+            d.reply(d.loc, "hh", total, shared);
+        }},
     //{"kit#16::T:F", "::Enables or disables kit item", 0,
     //    [](const char *m, RtData &d) {
     //        auto loc = d.loc;
@@ -297,10 +313,20 @@ Part::Part(Allocator &alloc, const SYNTH_T &synth_, const AbsTime &time_,
     synth(synth_),
     time(time_),
     gzip_compression(gzip_compression),
-    interpolation(interpolation)
+    interpolation(interpolation),
+    ctltime(ctlsynth),
+    modbank(alloc)
 {
     loaded_file[0] = '\0';
 
+    ctlsynth.samplerate  = synth.samplerate;
+    ctlsynth.buffersize  = synth.controlperiod();
+    ctlsynth.controlsize = 0;
+    ctlsynth.oscilsize   = synth.oscilsize;
+    ctlsynth.alias(false);
+    for(int i = 0; i < ctlsynth.buffersize; ++i)
+        ctlsynth.denormalkillbuf[i] = synth.denormalkillbuf[i];
+
     if(prefix_)
         fast_strcpy(prefix, prefix_, sizeof(prefix));
     else
@@ -573,7 +599,7 @@ bool Part::NoteOnInternal(note_t note,
     // portamento, but it remains for Portamento.init to make the
     // final decision depending on the portamento enable, threshold and
     // other parameters.
-    Portamento portamento(ctl, synth, isRunningNote, oldfreq_log2, oldportamentofreq_log2, note_log2_freq);
+    Portamento portamento(ctl, ctlsynth, isRunningNote, oldfreq_log2, oldportamentofreq_log2, note_log2_freq);
     if(portamento.active) {
         // If we're doing legato and we already have a portamento structure,
         // reuse it.
@@ -649,8 +675,8 @@ bool Part::NoteOnInternal(note_t note,
         if(Pkitmode != 0 && !item.validNote(note))
             continue;
 
-        SynthParams pars{memory, ctl, synth, time, vel,
-            portamentoptr, note_log2_freq, false, prng()};
+        SynthParams pars{memory, ctl, ctlsynth, ctltime, vel,
+            portamentoptr, note_log2_freq, false, prng(), &modbank};
         const int sendto = Pkitmode ? item.sendto() : 0;
 
         // Enforce voice limit, before we trigger new note
@@ -1047,24 +1073,30 @@ void Part::ComputePartSmps()
         memset(partfxinputr[nefx], 0, synth.bufferbytes);
     }
 
-    for(auto &d:notePool.activeDesc()) {
-        d.age++;
-        for(auto &s:notePool.activeNotes(d)) {
-            float tmpoutr[synth.buffersize];
-            float tmpoutl[synth.buffersize];
-            auto &note = *s.note;
-            note.noteout(&tmpoutl[0], &tmpoutr[0]);
-
-            for(int i = 0; i < synth.buffersize; ++i) { //add the note to part(mix)
-                partfxinputl[d.sendto][i] += tmpoutl[i];
-                partfxinputr[d.sendto][i] += tmpoutr[i];
-            }
+    //the notes update their modulation once per control period
+    const int period = ctlsynth.buffersize;
+    ctltime.sync(time);
+    for(int off = 0; off < synth.buffersize; off += period, ctltime++) {
+        modbank.tick();
+        for(auto &d:notePool.activeDesc()) {
+            d.age++;
+            for(auto &s:notePool.activeNotes(d)) {
+                float tmpoutr[period];
+                float tmpoutl[period];
+                auto &note = *s.note;
+                note.noteout(&tmpoutl[0], &tmpoutr[0]);
+
+                for(int i = 0; i < period; ++i) { //add the note to part(mix)
+                    partfxinputl[d.sendto][off + i] += tmpoutl[i];
+                    partfxinputr[d.sendto][off + i] += tmpoutr[i];
+                }
 
-            if(note.finished())
-                notePool.kill(s);
+                if(note.finished())
+                    notePool.kill(s);
+            }
+        if (d.portamentoRealtime)
+            d.portamentoRealtime->portamento.update();
         }
-    if (d.portamentoRealtime)
-        d.portamentoRealtime->portamento.update();
     }
 
     //Apply part's effects and mix them
@@ -1312,11 +1344,12 @@ void Part::applyparameters(void)
     applyparameters([]{return false;});
 }
 
-void Part::applyparameters(std::function<bool()> do_abort)
+void Part::applyparameters(std::function<bool()> do_abort,
+                           unsigned max_threads)
 {
     for(int n = 0; n < NUM_KIT_ITEMS; ++n)
         if(kit[n].Ppadenabled && kit[n].padpars)
-            kit[n].padpars->applyparameters(do_abort);
+            kit[n].padpars->applyparameters(do_abort, max_threads);
 }
 
 void Part::initialize_rt(void)
@@ -17,7 +17,9 @@
 #define MAX_INFO_TEXT_SIZE 1000
 
 #include "../globals.h"
+#include "Time.h"
 #include "../Params/Controller.h"
+#include "../Synth/ModulationBank.h"
 #include "../Containers/NotePool.h"
 
 #include <functional>
@@ -90,7 +92,9 @@ class Part
         void defaultsinstrument();
 
         void applyparameters(void) NONREALTIME;
-        void applyparameters(std::function<bool()> do_abort) NONREALTIME;
+        //max_threads bounds the PADsynth sample generation (0: one per core)
+        void applyparameters(std::function<bool()> do_abort,
+                             unsigned max_threads = 0) NONREALTIME;
 
         void initialize_rt(void) REALTIME;
         void kill_rt(void) REALTIME;
@@ -197,6 +201,7 @@ class Part
         bool silent; // An output buffer with zeros has been generated
 
         NotePool notePool;
+        friend class VoiceGovernor;
 
         void limit_voices(int new_note);
 
@@ -232,6 +237,11 @@ class Part
         const SYNTH_T &synth;
         const AbsTime &time;
         const int &gzip_compression, &interpolation;
+        //notes run in control periods of the buffer with their own clock
+        SYNTH_T ctlsynth;
+        AbsTime ctltime;
+        //envelopes and LFOs of the notes
+        ModulationBank modbank;
 };
 
 }
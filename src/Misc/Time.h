@@ -23,6 +23,12 @@ class AbsTime
             s(synth){};
         void operator++(){++frames;};
         void operator++(int){frames++;};
+        /**Move to the start of the current frame of a clock with longer
+         * frames, which have to be a multiple of the own ones*/
+        void sync(const AbsTime &t) {
+            frames = t.frames * (t.s.buffersize / s.buffersize);
+            tempo  = t.tempo;
+        }
         int64_t time() const {return frames;};
         unsigned int tempo;
         float dt() const { return s.dt(); }
@@ -0,0 +1,364 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UndoStore.cpp - Bounded History Of Parameter Changes
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "UndoStore.h"
+#include <chrono>
+#include <cstring>
+#include <rtosc/rtosc.h>
+
+namespace zyn {
+
+/*
+ * Entry encoding:
+ *   varint path id, old type, new type, old value, new value
+ * i, c, r and h values are zigzag varints, a new integer following an old
+ * integer is stored as the difference. s, S and b values are a varint
+ * length and the bytes, the others their plain bytes.
+ */
+
+static bool supported(char type)
+{
+    return type && strchr("icrhmftdTFNIsSb", type);
+}
+
+static bool integer(char type)
+{
+    return type == 'i' || type == 'c' || type == 'r' || type == 'h';
+}
+
+static int64_t intValue(char type, const rtosc_arg_t &arg)
+{
+    return type == 'h' ? arg.h : arg.i;
+}
+
+static void putVarint(std::vector<char> &out, uint64_t x)
+{
+    while(x >= 0x80) {
+        out.push_back((char)(x | 0x80));
+        x >>= 7;
+    }
+    out.push_back((char)x);
+}
+
+static uint64_t getVarint(const char *&p)
+{
+    uint64_t x = 0;
+    for(int shift = 0; ; shift += 7) {
+        const uint8_t b = *p++;
+        x |= (uint64_t)(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            return x;
+    }
+}
+
+static void putZigzag(std::vector<char> &out, int64_t x)
+{
+    putVarint(out, ((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+}
+
+static int64_t getZigzag(const char *&p)
+{
+    const uint64_t x = getVarint(p);
+    return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+}
+
+static void putBytes(std::vector<char> &out, const void *bytes, size_t len)
+{
+    out.insert(out.end(), (const char *)bytes, (const char *)bytes + len);
+}
+
+//@param ref old integer value the new one is relative to, or nullptr
+static void putValue(std::vector<char> &out, char type, const rtosc_arg_t &arg,
+                     const int64_t *ref)
+{
+    switch(type) {
+        case 'i': case 'c': case 'r': case 'h':
+            putZigzag(out, intValue(type, arg) - (ref ? *ref : 0));
+            break;
+        case 'm': putBytes(out, arg.m, 4); break;
+        case 'f': putBytes(out, &arg.f, 4); break;
+        case 't': putBytes(out, &arg.t, 8); break;
+        case 'd': putBytes(out, &arg.d, 8); break;
+        case 's': case 'S': {
+            const size_t len = strlen(arg.s);
+            putVarint(out, len);
+            putBytes(out, arg.s, len);
+            break;
+        }
+        case 'b':
+            putVarint(out, arg.b.len);
+            putBytes(out, arg.b.data, arg.b.len);
+            break;
+        default: //T F N I have no value
+            break;
+    }
+}
+
+//Strings and blobs point into the entry, the strings are not terminated
+static rtosc_arg_t getValue(const char *&p, char type, const int64_t *ref,
+                            size_t &strlen_)
+{
+    rtosc_arg_t arg;
+    memset(&arg, 0, sizeof(arg));
+    switch(type) {
+        case 'i': case 'c': case 'r':
+            arg.i = (int32_t)(getZigzag(p) + (ref ? *ref : 0));
+            break;
+        case 'h': arg.h = getZigzag(p) + (ref ? *ref : 0); break;
+        case 'm': memcpy(arg.m, p, 4); p += 4; break;
+        case 'f': memcpy(&arg.f, p, 4); p += 4; break;
+        case 't': memcpy(&arg.t, p, 8); p += 8; break;
+        case 'd': memcpy(&arg.d, p, 8); p += 8; break;
+        case 's': case 'S':
+            strlen_ = getVarint(p);
+            arg.s   = p;
+            p      += strlen_;
+            break;
+        case 'b':
+            arg.b.len  = getVarint(p);
+            arg.b.data = (uint8_t *)p;
+            p         += arg.b.len;
+            break;
+        default:
+            break;
+    }
+    return arg;
+}
+
+static void putEntry(std::vector<char> &out, uint32_t id,
+                     char oldtype, const rtosc_arg_t &oldval,
+                     char newtype, const rtosc_arg_t &newval)
+{
+    putVarint(out, id);
+    out.push_back(oldtype);
+    out.push_back(newtype);
+    putValue(out, oldtype, oldval, nullptr);
+    const int64_t ref = intValue(oldtype, oldval);
+    putValue(out, newtype, newval,
+             integer(oldtype) && integer(newtype) ? &ref : nullptr);
+}
+
+struct UndoEntry
+{
+    uint32_t    id;
+    char        types[2];
+    rtosc_arg_t values[2];
+    size_t      strlens[2];
+
+    UndoEntry(const char *p)
+    {
+        strlens[0] = strlens[1] = 0;
+        id       = getVarint(p);
+        types[0] = *p++;
+        types[1] = *p++;
+        values[0] = getValue(p, types[0], nullptr, strlens[0]);
+        const int64_t ref = intValue(types[0], values[0]);
+        values[1] = getValue(p, types[1],
+                             integer(types[0]) && integer(types[1]) ? &ref
+                                                                    : nullptr,
+                             strlens[1]);
+    }
+};
+
+UndoStore::UndoStore(size_t max_memory_, double merge_time_)
+    :max_memory(max_memory_), merge_time(merge_time_), base(0), pos(0),
+    path_bytes(0), mergeable(false), last_time(0.0)
+{}
+
+void UndoStore::setCallback(callback_t cb_)
+{
+    cb = cb_;
+}
+
+void UndoStore::setMaxMemory(size_t bytes)
+{
+    max_memory = bytes;
+    shrink();
+}
+
+void UndoStore::clear(void)
+{
+    data.clear();
+    offsets.clear();
+    base = pos = 0;
+    paths.clear();
+    path_ids.clear();
+    path_bytes = 0;
+    mergeable  = false;
+}
+
+size_t UndoStore::memoryUsage(void) const
+{
+    return data.size() + offsets.size() * sizeof(size_t) + path_bytes;
+}
+
+uint32_t UndoStore::pathId(const char *path)
+{
+    auto itr = path_ids.find(path);
+    if(itr != path_ids.end())
+        return itr->second;
+    return addPath(path);
+}
+
+uint32_t UndoStore::addPath(std::string path)
+{
+    const uint32_t id = paths.size();
+    //the string is kept twice, with the node of the map
+    path_bytes += 2 * (sizeof(std::string) + path.size() + 1)
+                  + sizeof(uint32_t) + 2 * sizeof(void *);
+    path_ids.emplace(path, id);
+    paths.push_back(std::move(path));
+    return id;
+}
+
+void UndoStore::recordEvent(const char *msg)
+{
+    using namespace std::chrono;
+    recordEvent(msg, duration<double>(
+                steady_clock::now().time_since_epoch()).count());
+}
+
+void UndoStore::recordEvent(const char *msg, double time)
+{
+    //"/undo_change" path old new
+    const char *types = rtosc_argument_string(msg);
+    if(types[0] != 's' || !supported(types[1]) || !supported(types[2])
+       || types[3])
+        return;
+
+    //a change after undoing starts a new branch of the history
+    truncate(pos);
+
+    const uint32_t id = pathId(rtosc_argument(msg, 0).s);
+    char        oldtype = types[1];
+    rtosc_arg_t oldval  = rtosc_argument(msg, 1);
+    const rtosc_arg_t newval = rtosc_argument(msg, 2);
+    std::string oldstr;
+
+    //continue the last entry, keeping its old value
+    if(mergeable && !offsets.empty() && time - last_time <= merge_time) {
+        const char *last = data.data() + (offsets.back() - base);
+        const UndoEntry e(last);
+        if(e.id == id) {
+            oldtype = e.types[0];
+            oldval  = e.values[0];
+            if(oldtype == 's' || oldtype == 'S') {
+                oldstr.assign(oldval.s, e.strlens[0]);
+                oldval.s = oldstr.c_str();
+            } else if(oldtype == 'b') {
+                oldstr.assign((const char *)oldval.b.data, oldval.b.len);
+                oldval.b.data = (uint8_t *)&oldstr[0];
+            }
+            truncate(offsets.size() - 1);
+        }
+    }
+
+    offsets.push_back(base + data.size());
+    putEntry(data, id, oldtype, oldval, types[2], newval);
+    pos       = offsets.size();
+    mergeable = true;
+    last_time = time;
+    shrink();
+}
+
+void UndoStore::shrink(void)
+{
+    while(memoryUsage() > max_memory && offsets.size() > 1) {
+        if(pos)
+            dropOldest();
+        else //only steps to redo, keep the next ones
+            truncate(offsets.size() - 1);
+    }
+}
+
+void UndoStore::dropOldest(void)
+{
+    offsets.pop_front();
+    if(pos)
+        --pos;
+    //rebuild the buffer once half of it is unused
+    const size_t unused = offsets.empty() ? data.size()
+                                          : offsets.front() - base;
+    if(2 * unused > data.size())
+        compact();
+}
+
+//Move the entries to the front of a new buffer. The path table is rebuilt
+//from the paths the remaining entries use, renumbering them.
+void UndoStore::compact(void)
+{
+    std::vector<char> ndata;
+    ndata.reserve(data.size() - (offsets.empty() ? data.size()
+                                                 : offsets.front() - base));
+    std::vector<std::string> opaths;
+    opaths.swap(paths);
+    path_ids.clear();
+    path_bytes = 0;
+
+    const uint32_t none = UINT32_MAX;
+    std::vector<uint32_t> ids(opaths.size(), none);
+    for(size_t i = 0; i < offsets.size(); ++i) {
+        const char *p   = data.data() + (offsets[i] - base);
+        const char *end = data.data() + (i + 1 < offsets.size()
+                                         ? offsets[i + 1] - base
+                                         : data.size());
+        const uint32_t id = getVarint(p);
+        if(ids[id] == none)
+            ids[id] = addPath(std::move(opaths[id]));
+        offsets[i] = ndata.size();
+        putVarint(ndata, ids[id]);
+        ndata.insert(ndata.end(), p, end);
+    }
+    data.swap(ndata);
+    base = 0;
+}
+
+void UndoStore::truncate(size_t entries)
+{
+    if(entries >= offsets.size())
+        return;
+    data.resize(offsets[entries] - base);
+    offsets.resize(entries);
+    if(pos > entries)
+        pos = entries;
+    mergeable = false;
+}
+
+void UndoStore::seekHistory(int distance)
+{
+    mergeable = false;
+    for(; distance < 0 && pos > 0; ++distance)
+        replay(--pos, false);
+    for(; distance > 0 && pos < offsets.size(); --distance)
+        replay(pos++, true);
+}
+
+void UndoStore::replay(size_t entry, bool redo)
+{
+    const UndoEntry e(data.data() + (offsets[entry] - base));
+    const std::string &path = paths[e.id];
+    const char type[2]  = {e.types[redo], '\0'};
+    rtosc_arg_t     arg = e.values[redo];
+
+    std::string str;
+    if(type[0] == 's' || type[0] == 'S') {
+        str.assign(arg.s, e.strlens[redo]);
+        arg.s = str.c_str();
+    }
+    const size_t len = path.size() + 32 + e.strlens[redo]
+                       + (type[0] == 'b' ? arg.b.len : 0);
+    if(scratch.size() < len)
+        scratch.resize(len);
+    if(rtosc_amessage(scratch.data(), scratch.size(), path.c_str(), type,
+                      &arg) && cb)
+        cb(scratch.data());
+}
+
+}
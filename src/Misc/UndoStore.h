@@ -0,0 +1,98 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UndoStore.h - Bounded History Of Parameter Changes
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace zyn {
+
+/**
+ * History of the parameter changes for undo and redo
+ *
+ * It records the "/undo_change" messages of the backend, which hold the
+ * path, the old and the new value. Entries are packed into one buffer: the
+ * path as index into a table of the paths seen so far, integers in a
+ * variable length code with the new value relative to the old one, and the
+ * other types as their plain bytes. Consecutive changes of the same path
+ * within merge_time seconds are merged into one entry, so a sweep of a knob
+ * is undone in one step. The oldest entries are dropped once the history
+ * takes more than its memory limit, and the paths only they used are dropped
+ * from the table when the buffer is compacted.
+ */
+class UndoStore
+{
+    public:
+        typedef std::function<void(const char *msg)> callback_t;
+
+        UndoStore(size_t max_memory = 16 << 20, double merge_time = 2.0);
+
+        //Receiver of the messages restoring a state
+        void setCallback(callback_t cb);
+
+        //Drops the oldest entries until the history fits
+        void setMaxMemory(size_t bytes);
+
+        //Record an "/undo_change" message, drops the steps to redo
+        //@param time seconds of the change, for merging
+        void recordEvent(const char *msg);
+        void recordEvent(const char *msg, double time);
+
+        //Undo (negative distance) or redo (positive distance) changes
+        void seekHistory(int distance);
+
+        void clear(void);
+
+        //Number of entries and the entries before the current state
+        size_t size(void) const { return offsets.size(); }
+        size_t position(void) const { return pos; }
+
+        //Bytes taken by the entries and the path table
+        size_t memoryUsage(void) const;
+
+    private:
+        UndoStore(const UndoStore&) = delete;
+        UndoStore &operator=(const UndoStore&) = delete;
+
+        uint32_t pathId(const char *path);
+        uint32_t addPath(std::string path);
+        void     shrink(void);
+        void     dropOldest(void);
+        void     compact(void);
+        void     truncate(size_t entries);
+        void     replay(size_t entry, bool redo);
+
+        callback_t         cb;
+        size_t             max_memory;
+        double             merge_time;
+
+        //entry i is data[offsets[i] - base] up to the next entry
+        std::vector<char>  data;
+        std::deque<size_t> offsets;
+        size_t             base;
+        size_t             pos;
+
+        std::vector<std::string>                  paths;
+        std::unordered_map<std::string, uint32_t> path_ids;
+        size_t                                    path_bytes;
+
+        //the last entry may be merged with the next change
+        bool               mergeable;
+        double             last_time;
+
+        std::vector<char>  scratch;
+};
+
+}
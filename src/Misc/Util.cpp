@@ -13,7 +13,12 @@
 
 #include "globals.h"
 #include "Util.h"
+#include "Denormals.h"
 #include <vector>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -161,6 +166,43 @@ void os_usleep(long length)
 }
 #endif
 
+void parallel_for(int n, unsigned threads, std::function<void(int)> f)
+{
+#ifdef WIN32
+    //C++11 threads are broken on mingw cross compilation
+    threads = 1;
+#endif
+    if(!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, std::max(n, 1));
+
+    std::atomic<int>   next(0);
+    std::exception_ptr error;
+    std::mutex         error_lock;
+    auto worker = [&]() {
+        DenormalGuard flush;
+        for(int i; (i = next++) < n;) {
+            try {
+                f(i);
+            } catch(...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if(!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for(auto &t:pool)
+        t.join();
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
 //!< maximum length a pid has on any POSIX system
 //!< this is an estimation, but more than 12 looks insane
 constexpr std::size_t max_pid_len = 12;
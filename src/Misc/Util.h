@@ -18,6 +18,7 @@
 #include <sstream>
 #include <stdint.h>
 #include <algorithm>
+#include <functional>
 #include <set>
 
 #include <rtosc/ports.h>
@@ -61,6 +62,11 @@ void set_realtime();
 /**Os independent sleep in microsecond*/
 void os_usleep(long length);
 
+/**Run f(0) to f(n-1) on up to the given number of threads
+ * (0 for one per core). An exception of any call is rethrown once all
+ * threads have finished.*/
+void parallel_for(int n, unsigned threads, std::function<void(int)> f);
+
 //! returns pid padded to maximum pid length, posix conform
 std::string os_pid_as_padded_string();
 
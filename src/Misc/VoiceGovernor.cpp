@@ -0,0 +1,176 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  VoiceGovernor.cpp - Sheds voices when rendering gets close to the deadline
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include <algorithm>
+#include <rtosc/ports.h>
+#include <rtosc/port-sugar.h>
+#include "VoiceGovernor.h"
+#include "Part.h"
+#include "../Synth/SynthNote.h"
+
+namespace zyn {
+
+//Voices which are never shed, the load may come from effects as well
+#define GOVERNOR_MIN_VOICES 4
+//The limit is only raised below this fraction of the target load
+#define GOVERNOR_HYSTERESIS 0.75f
+//Seconds between raising the limit and release time of the load
+#define GOVERNOR_RECOVERY 0.25f
+//Seconds after the note on during which a note is shed last, as its
+//amplitude is still rising
+#define GOVERNOR_ATTACK 0.25f
+
+#define rObject VoiceGovernor
+#define rBegin [](const char *msg, rtosc::RtData &d) { \
+    rObject *obj = (rObject*)d.obj; (void)msg;
+#define rEnd }
+
+const rtosc::Ports VoiceGovernor::ports = {
+    rToggle(Penabled, rShort("enable"), rDefault(false),
+            "Shed voices when the render time gets close to the deadline"),
+    rParamF(Ptarget, rShort("target"), rLinear(0.1f, 1.0f), rDefault(0.8f),
+            "Fraction of the buffer time which rendering may use"),
+    {"test-load::f", rProp(internal)
+        rDoc("Use a fixed load instead of the measured one (negative to measure)"), 0,
+        rBegin;
+        if(rtosc_narguments(msg))
+            obj->testload = rtosc_argument(msg, 0).f;
+        else
+            d.reply(d.loc, "f", obj->testload);
+        rEnd},
+    {"load:", rDoc("Render time relative to the buffer time"), 0,
+        rBegin;
+        d.reply(d.loc, "f", obj->load);
+        rEnd},
+    {"headroom:", rDoc("Unused fraction of the buffer time"), 0,
+        rBegin;
+        d.reply(d.loc, "f", 1.0f - obj->load);
+        rEnd},
+    {"voice-limit:", rDoc("Current voice limit, 0 if unlimited"), 0,
+        rBegin;
+        d.reply(d.loc, "i", obj->limit);
+        rEnd},
+    {"voices-shed:", rDoc("Number of voices shed since startup"), 0,
+        rBegin;
+        d.reply(d.loc, "i", (int)obj->shed);
+        rEnd},
+};
+#undef rBegin
+#undef rEnd
+#undef rObject
+
+VoiceGovernor::VoiceGovernor(const SYNTH_T &synth)
+    :Penabled(false), Ptarget(0.8f), testload(-1.0f), load(0.0f), limit(0),
+      shed(0), candidates(new Candidate[NUM_MIDI_PARTS * POLYPHONY]),
+      buffertime(synth.buffersize_f / synth.samplerate_f),
+      recovery(std::max(1, (int)(GOVERNOR_RECOVERY / buffertime))),
+      youngage((int)(GOVERNOR_ATTACK * synth.samplerate_f
+                     / synth.controlperiod())),
+      countdown(0), holdoff(0)
+{}
+
+VoiceGovernor::~VoiceGovernor()
+{
+    delete[] candidates;
+}
+
+int VoiceGovernor::runningVoices(Part *const *part, int nparts)
+{
+    int voices = 0;
+    for(int i = 0; i < nparts; ++i)
+        voices += part[i]->notePool.getRunningVoices();
+    return voices;
+}
+
+void VoiceGovernor::begin(void)
+{
+    if(testload < 0.0f)
+        start = std::chrono::steady_clock::now();
+}
+
+void VoiceGovernor::end(Part *const *part, int nparts)
+{
+    float measured = testload;
+    if(measured < 0.0f) {
+        const std::chrono::duration<float> elapsed =
+            std::chrono::steady_clock::now() - start;
+        measured = elapsed.count() / buffertime;
+    }
+
+    //react at once to overloads, but only slowly to free time.
+    //Voices which were just shed are still fading out during the next
+    //buffer, so that buffer does not count.
+    if(holdoff)
+        --holdoff;
+    else if(measured > load)
+        load = measured;
+    else
+        load += (measured - load) / recovery;
+
+    if(!Penabled) {
+        limit = 0;
+        return;
+    }
+
+    //The render time is assumed to be about proportional to the voices
+    const int voices = runningVoices(part, nparts);
+    if(load > Ptarget && voices > GOVERNOR_MIN_VOICES) {
+        int keep = voices * Ptarget / load;
+        keep  = std::max(GOVERNOR_MIN_VOICES, std::min(keep, voices - 1));
+        limit = limit ? std::min(limit, keep) : keep;
+        load      = Ptarget;
+        holdoff   = 1;
+        countdown = recovery;
+    } else if(limit && load < Ptarget * GOVERNOR_HYSTERESIS
+              && --countdown <= 0) {
+        //drop the limit once it is not reached anymore
+        limit     = voices < limit ? 0 : limit + 1 + limit / 8;
+        countdown = recovery;
+    }
+
+    if(limit && voices > limit)
+        shedVoices(part, nparts, voices - limit);
+}
+
+void VoiceGovernor::shedVoices(Part *const *part, int nparts, int n)
+{
+    int count = 0;
+    for(int i = 0; i < nparts; ++i) {
+        NotePool &pool = part[i]->notePool;
+        for(auto &desc:pool.activeDesc()) {
+            if(desc.entombed())
+                continue;
+            Candidate &c = candidates[count++];
+            c.young      = (int)desc.age < youngage;
+            c.amplitude  = pool.getAmplitude(desc) * part[i]->gain;
+            c.age        = desc.age;
+            c.part       = part[i];
+            c.desc       = &desc;
+        }
+    }
+
+    n = std::min(n, count);
+    std::partial_sort(candidates, candidates + n, candidates + count,
+            [](const Candidate &a, const Candidate &b) {
+                if(a.young != b.young)
+                    return b.young;
+                if(a.amplitude != b.amplitude)
+                    return a.amplitude < b.amplitude;
+                return a.age > b.age;
+            });
+
+    //entombed notes fade out within the next buffer
+    for(int i = 0; i < n; ++i)
+        candidates[i].part->notePool.entomb(*candidates[i].desc);
+    shed += n;
+}
+
+}
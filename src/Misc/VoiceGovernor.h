@@ -0,0 +1,85 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  VoiceGovernor.h - Sheds voices when rendering gets close to the deadline
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef VOICE_GOVERNOR_H
+#define VOICE_GOVERNOR_H
+
+#include <chrono>
+#include <rtosc/ports.h>
+#include "../globals.h"
+#include "../Containers/NotePool.h"
+
+namespace zyn {
+
+class Part;
+
+/**
+ * Adaptive polyphony limit over all parts
+ *
+ * The render time of each buffer is compared with the time the buffer takes
+ * to play. When the load gets above the target the quietest (and then the
+ * oldest) voices of all parts are faded out within the next buffer and a
+ * global voice limit keeps new notes from overloading again. Notes which are
+ * still in their attack are quiet as well, so they are only shed after all
+ * older ones. The limit is
+ * raised again while there is enough headroom.
+ */
+class VoiceGovernor
+{
+    public:
+        VoiceGovernor(const SYNTH_T &synth) NONREALTIME;
+        ~VoiceGovernor() NONREALTIME;
+
+        //Start timing a buffer
+        void begin(void) REALTIME;
+        //Update the load with the time since begin() and shed voices
+        void end(Part *const *part, int nparts) REALTIME;
+
+        //Sum of the not yet entombed voices of all parts
+        static int runningVoices(Part *const *part, int nparts) REALTIME;
+
+        //Parameters
+        bool  Penabled;
+        float Ptarget;   //fraction of the buffer time rendering may use
+
+        //Fixed load to use instead of the measured one (negative to measure)
+        //This makes the governor deterministic for tests
+        float testload;
+
+        //Statistics
+        float    load;   //render time / buffer time, fast attack slow release
+        int      limit;  //current voice limit, 0 if unlimited
+        unsigned shed;   //voices shed in total
+
+        static const rtosc::Ports ports;
+    private:
+        void shedVoices(Part *const *part, int nparts, int n) REALTIME;
+
+        struct Candidate {
+            bool                      young;
+            float                     amplitude;
+            unsigned                  age;
+            Part                     *part;
+            NotePool::NoteDescriptor *desc;
+        };
+        Candidate *candidates; //[NUM_MIDI_PARTS * POLYPHONY]
+
+        const float buffertime; //seconds
+        const int   recovery;   //buffers between raising the limit
+        const int   youngage;   //age (control periods) of notes in attack
+        int         countdown;
+        int         holdoff;
+        std::chrono::steady_clock::time_point start;
+};
+
+}
+
+#endif
@@ -12,6 +12,7 @@
   of the License, or (at your option) any later version.
 */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
@@ -93,4 +94,95 @@ void WavFile::writeMonoSamples(int nsmps, short int *smps)
     }
 }
 
+static unsigned int getle(const unsigned char *p, int bytes)
+{
+    unsigned int x = 0;
+    for(int i = bytes - 1; i >= 0; --i)
+        x = (x << 8) | p[i];
+    return x;
+}
+
+int readWavFile(const string &filename, vector<float> &smps,
+                int &channels, int &samplerate)
+{
+    FILE *f = fopen(filename.c_str(), "rb");
+    if(!f)
+        return -1;
+
+    unsigned char header[12];
+    if(fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4)
+       || memcmp(header + 8, "WAVE", 4)) {
+        fclose(f);
+        return -1;
+    }
+
+    int format = 0, bits = 0;
+    channels = 0;
+    samplerate = 0;
+    unsigned char chunk[8];
+    while(fread(chunk, 1, 8, f) == 8) {
+        const unsigned int size = getle(chunk + 4, 4);
+        if(!memcmp(chunk, "fmt ", 4)) {
+            unsigned char fmt[40];
+            if(size < 16 || size > sizeof(fmt)
+               || fread(fmt, 1, size, f) != size)
+                break;
+            format     = getle(fmt, 2);
+            channels   = getle(fmt + 2, 2);
+            samplerate = getle(fmt + 4, 4);
+            bits       = getle(fmt + 14, 2);
+            //WAVE_FORMAT_EXTENSIBLE stores the format in the sub format
+            if(format == 0xFFFE && size >= 26)
+                format = getle(fmt + 24, 2);
+            if(size & 1)
+                fseek(f, 1, SEEK_CUR);
+        } else if(!memcmp(chunk, "data", 4)) {
+            const int bytes = bits / 8;
+            const bool pcm  = format == 1 && bytes >= 1 && bytes <= 4;
+            const bool flt  = format == 3 && (bytes == 4 || bytes == 8);
+            if(channels <= 0 || samplerate <= 0 || !(pcm || flt))
+                break;
+
+            //the size in the header is not trusted (streamed files have
+            //0xFFFFFFFF), only what is left of the file is read
+            const long here = ftell(f);
+            if(here < 0 || fseek(f, 0, SEEK_END))
+                break;
+            const long end = ftell(f);
+            if(end < here || fseek(f, here, SEEK_SET))
+                break;
+            const size_t left = std::min<size_t>(size, end - here);
+
+            vector<unsigned char> data(left);
+            const size_t len = fread(data.data(), 1, left, f);
+            const size_t n   = len / bytes;
+            smps.resize(n - n % channels);
+            for(size_t i = 0; i < smps.size(); ++i) {
+                const unsigned char *p = &data[i * bytes];
+                if(flt && bytes == 4) {
+                    float x;
+                    memcpy(&x, p, 4);
+                    smps[i] = x;
+                } else if(flt) {
+                    double x;
+                    memcpy(&x, p, 8);
+                    smps[i] = x;
+                } else if(bytes == 1) //8 bit samples are unsigned
+                    smps[i] = (p[0] - 128) / 128.0f;
+                else {
+                    //sign extend from the top byte
+                    const int shift = 32 - bits;
+                    const int x = (int)(getle(p, bytes) << shift) >> shift;
+                    smps[i] = x / (float)(1u << (bits - 1));
+                }
+            }
+            fclose(f);
+            return 0;
+        } else if(fseek(f, size + (size & 1), SEEK_CUR))
+            break;
+    }
+    fclose(f);
+    return -1;
+}
+
 }
@@ -15,6 +15,7 @@
 #ifndef WAVFILE_H
 #define WAVFILE_H
 #include <string>
+#include <vector>
 
 namespace zyn {
 
@@ -36,6 +37,16 @@ class WavFile
         FILE *file;
 };
 
+/**
+ * Read a PCM (8, 16, 24 or 32 bit) or IEEE float wave file
+ * @param filename file to read
+ * @param smps interleaved samples in the range [-1,1]
+ * @param channels number of channels
+ * @param samplerate samplerate of the file
+ * @return 0 on success*/
+int readWavFile(const std::string &filename, std::vector<float> &smps,
+                int &channels, int &samplerate);
+
 }
 
 #endif
@@ -12,7 +12,10 @@
 */
 
 #include "WaveShapeSmps.h"
+#include "../globals.h"
 #include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace zyn {
 
@@ -299,4 +302,200 @@ void waveShapeSmps(int n,
     }
 }
 
+//Modified bessel function of the first kind and order zero
+static float besselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for(int k = 1; k < 32; ++k) {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum  += term;
+    }
+    return sum;
+}
+
+WaveShaper::WaveShaper(void)
+    :type(0), drive(0), offset(64), funcpar(0), oversampling(0),
+      table(nullptr)
+{
+    setup(0, 0, 64, 0, 1);
+}
+
+void WaveShaper::setup(unsigned char type_, unsigned char drive_,
+                       unsigned char offset_, unsigned char funcpar_,
+                       int oversampling_)
+{
+    if(oversampling_ != oversampling) {
+        oversampling = oversampling_;
+        if(oversampling < 1)
+            oversampling = 1;
+        else if(oversampling > max_oversampling)
+            oversampling = max_oversampling;
+
+        //Kaiser windowed sinc below the original nyquist frequency
+        const int   len  = taps * oversampling;
+        const float fc   = 0.4f / oversampling;
+        const float beta = 9.0f; //about -90dB sidelobes
+        float       sum  = 0.0f;
+        for(int i = 0; i < len; ++i) {
+            const float t = i - (len - 1) / 2.0f;
+            const float r = 2.0f * i / (len - 1) - 1.0f;
+            const float w = besselI0(beta * sqrtf(1.0f - r * r))
+                            / besselI0(beta);
+            h[i] = w * sinf(2.0f * PI * fc * t) / (PI * t);
+            sum += h[i];
+        }
+        for(int i = 0; i < len; ++i)
+            h[i] /= sum;
+        //Reversed polyphase branches, so both filters run over contiguous
+        //coefficients and samples
+        for(int p = 0; p < oversampling; ++p)
+            for(int t = 0; t < taps; ++t)
+                hup[p * taps + t] = h[(taps - 1 - t) * oversampling + p]
+                                    * oversampling;
+        for(int i = 0; i < len / 2; ++i) {
+            const float tmp  = h[i];
+            h[i]             = h[len - 1 - i];
+            h[len - 1 - i]   = tmp;
+        }
+        cleanup();
+    }
+
+    type    = type_;
+    drive   = drive_;
+    offset  = offset_;
+    funcpar = funcpar_;
+}
+
+void WaveShaper::cleanup(void)
+{
+    memset(history, 0, sizeof(history));
+}
+
+//Only shapes using transcendental functions are worth a table,
+//polynomial and piecewise linear ones are cheaper to evaluate directly
+bool WaveShaper::tabulable(unsigned char type)
+{
+    switch(type) {
+        case 1: case 2: case 4: case 6: case 7: case 10: case 14: case 15:
+            return true;
+        default:
+            return false;
+    }
+}
+
+WaveShaper::Table *WaveShaper::buildtable(unsigned char type,
+        unsigned char drive, unsigned char offset, unsigned char funcpar)
+{
+    if(!tabulable(type))
+        return nullptr;
+
+    Table *t   = new Table;
+    t->type    = type;
+    t->drive   = drive;
+    t->offset  = offset;
+    t->funcpar = funcpar;
+
+    const float step = 2.0f * table_range / table_size;
+    for(int i = 0; i <= table_size; ++i)
+        t->values[i] = -table_range + i * step;
+    waveShapeSmps(table_size + 1, t->values, type, drive, offset, funcpar);
+
+    //Verify the interpolation half way between all points
+    std::vector<float> mid(table_size);
+    for(int i = 0; i < table_size; ++i)
+        mid[i] = -table_range + (i + 0.5f) * step;
+    waveShapeSmps(table_size, mid.data(), type, drive, offset, funcpar);
+
+    t->ok = true;
+    for(int i = 0; i < table_size && t->ok; ++i)
+        t->ok = fabsf(mid[i] - 0.5f * (t->values[i] + t->values[i + 1]))
+                < table_error;
+    return t;
+}
+
+bool WaveShaper::matches(const Table *t) const
+{
+    return t && t->type == type && t->drive == drive && t->offset == offset
+           && t->funcpar == funcpar;
+}
+
+bool WaveShaper::needstable(void) const
+{
+    return tabulable(type) && !matches(table);
+}
+
+bool WaveShaper::tabulated(void) const
+{
+    return matches(table) && table->ok;
+}
+
+void WaveShaper::shapesmps(int n, float *smps) const
+{
+    if(!tabulated()) {
+        waveShapeSmps(n, smps, type, drive, offset, funcpar);
+        return;
+    }
+
+    const float  scale = table_size / (2.0f * table_range);
+    const float *v     = table->values;
+    for(int i = 0; i < n; ++i) {
+        const float pos = (smps[i] + table_range) * scale;
+        if(pos >= 0.0f && pos < table_size) {
+            const int   k = pos;
+            const float f = pos - k;
+            smps[i] = v[k] + (v[k + 1] - v[k]) * f;
+        }
+        else
+            waveShapeSmps(1, &smps[i], type, drive, offset, funcpar);
+    }
+}
+
+void WaveShaper::shape(int n, float *smps, int channel)
+{
+    if(oversampling == 1) {
+        shapesmps(n, smps);
+        return;
+    }
+
+    const int chunk = 64;
+    const int os    = oversampling;
+    const int len   = taps * os;
+    auto &hist = history[channel];
+
+    for(int i = 0; i < n; i += chunk) {
+        const int m = n - i < chunk ? n - i : chunk;
+        float in[taps - 1 + chunk];
+        float up[taps * max_oversampling - 1 + chunk * max_oversampling];
+        memcpy(in, hist.in, sizeof(hist.in));
+        memcpy(in + taps - 1, smps + i, m * sizeof(float));
+        memcpy(up, hist.up, (len - 1) * sizeof(float));
+        float *out = up + len - 1;
+
+        //Zero stuffing and lowpass, one polyphase branch per output sample
+        for(int k = 0; k < m; ++k)
+            for(int p = 0; p < os; ++p) {
+                const float *x   = in + k;
+                const float *c   = hup + p * taps;
+                float        sum = 0.0f;
+                for(int t = 0; t < taps; ++t)
+                    sum += c[t] * x[t];
+                out[k * os + p] = sum;
+            }
+
+        shapesmps(m * os, out);
+
+        //Lowpass and keep every os-th sample
+        for(int k = 0; k < m; ++k) {
+            const float *x   = up + k * os + os - 1;
+            float        sum = 0.0f;
+            for(int j = 0; j < len; ++j)
+                sum += h[j] * x[j];
+            smps[i + k] = sum;
+        }
+
+        memcpy(hist.in, in + m, sizeof(hist.in));
+        memcpy(hist.up, up + m * os, (len - 1) * sizeof(float));
+    }
+}
+
 }
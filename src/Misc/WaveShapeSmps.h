@@ -27,6 +27,78 @@ void waveShapeSmps(int n,
 float polyblampres(float smp,
                    float ws,
                    float dMax);
+
+/**
+ * Tabulated and optionally oversampled waveShapeSmps()
+ *
+ * Smooth shapes built from transcendental functions are looked up in a table
+ * with linear interpolation. Tables are built off the realtime thread by
+ * buildtable() and handed over with settable(); the shaper does not own them.
+ * A table is only used while it matches the current parameters, so after a
+ * change waveShapeSmps() is used until the table for the new parameters
+ * arrives. Shapes which the table can not represent within table_error
+ * (steps, wrapping) and samples outside of the table range use
+ * waveShapeSmps() as well.
+ *
+ * With oversampling the input is upsampled by a polyphase lowpass, shaped at
+ * the higher rate and decimated by the same lowpass. Both filters are linear
+ * phase, which adds a latency of taps - 1/oversampling samples (about 0.7ms
+ * at 48kHz).
+ */
+class WaveShaper
+{
+    public:
+        static const int   taps = 32; //lowpass taps per oversampled phase
+        static const int   max_oversampling = 8;
+        static const int   table_size = 4096;
+        static constexpr float table_range = 4.0f;
+        static constexpr float table_error = 2e-4f;
+
+        struct Table {
+            unsigned char type, drive, offset, funcpar;
+            bool  ok; //false if the interpolation is not accurate enough
+            float values[table_size + 1];
+        };
+
+        WaveShaper(void);
+
+        //If a table is worth building for the shape
+        static bool tabulable(unsigned char type);
+        //Build the table of a shape, nullptr if it is not tabulable
+        //Not realtime safe, the table is freed with delete
+        static Table *buildtable(unsigned char type, unsigned char drive,
+                                 unsigned char offset, unsigned char funcpar);
+
+        //Set the parameters for the following calls of shape()
+        //@param oversampling 1, 2, 4 or 8
+        void setup(unsigned char type, unsigned char drive,
+                   unsigned char offset, unsigned char funcpar,
+                   int oversampling = 1);
+        void cleanup(void);
+
+        //Shape n samples in place; each channel has its own filter history
+        void shape(int n, float *smps, int channel = 0);
+
+        //Use a table from buildtable(), nullptr for none
+        void settable(const Table *table_) { table = table_; }
+        //If the table for the current parameters is missing
+        bool needstable(void) const;
+        bool tabulated(void) const;
+    private:
+        bool matches(const Table *t) const;
+        void shapesmps(int n, float *smps) const;
+
+        unsigned char type, drive, offset, funcpar;
+        int   oversampling;
+        const Table *table;
+
+        float h[taps * max_oversampling];   //anti aliasing lowpass (reversed)
+        float hup[taps * max_oversampling]; //polyphase branches of h
+        struct {
+            float in[taps - 1];                    //input history
+            float up[taps * max_oversampling - 1]; //oversampled history
+        } history[2];
+};
 }
 
 #endif
@@ -14,13 +14,14 @@
 */
 
 #include "XMLwrapper.h"
+#include "XmlDocument.h"
+#include "BinaryPreset.h"
 #include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
 #include <cstdarg>
 #include <zlib.h>
 #include <iostream>
-#include <sstream>
 
 #include "globals.h"
 #include "Util.h"
@@ -88,6 +89,7 @@ const char *mxmlElementGetAttr(const mxml_node_t *node, const char *name)
 }
 
 XMLwrapper::XMLwrapper()
+    :owner(true), doc(NULL), elm(NULL), bin(NULL), bnode(0)
 {
     minimal = true;
     SaveFullXml=false;
@@ -128,16 +130,33 @@ XMLwrapper::XMLwrapper()
     endbranch();
 }
 
+XMLwrapper::XMLwrapper(const XMLwrapper *parent)
+    :minimal(parent->minimal), SaveFullXml(parent->SaveFullXml),
+      tree(parent->tree), root(parent->root), node(parent->node),
+      info(parent->info), owner(false), doc(parent->doc), elm(parent->elm),
+      bin(parent->bin), bnode(parent->bnode),
+      _fileversion(parent->_fileversion)
+{}
+
 void
 XMLwrapper::cleanup(void)
 {
-    if(tree)
+    if(tree && owner)
         mxmlDelete(tree);
+    if(owner) {
+        delete doc;
+        delete bin;
+    }
 
     /* make sure freed memory is not referenced */
     tree = 0;
     node = 0;
     root = 0;
+    doc  = NULL;
+    elm  = NULL;
+    bin  = NULL;
+    bnode = 0;
+    owner = true;
 }
 
 XMLwrapper::~XMLwrapper()
@@ -159,23 +178,37 @@ bool XMLwrapper::hasPadSynth() const
 {
     /**Right now this has a copied implementation of setparbool, so this should
      * be reworked as XMLwrapper evolves*/
-    mxml_node_t *tmp = mxmlFindElement(tree,
-                                       tree,
-                                       "INFORMATION",
-                                       NULL,
-                                       NULL,
-                                       MXML_DESCEND);
-
-    mxml_node_t *parameter = mxmlFindElement(tmp,
-                                             tmp,
-                                             "par_bool",
-                                             "name",
-                                             "PADsynth_used",
-                                             MXML_DESCEND_FIRST);
-    if(parameter == NULL) //no information available
-        return false;
-
-    const char *strval = mxmlElementGetAttr(parameter, "value");
+    const char *strval = NULL;
+    if(bin) {
+        uint32_t tmp = bin->findElement("INFORMATION");
+        if(tmp)
+            tmp = bin->find(tmp, "par_bool", BinaryPresetNode::NameKey,
+                            "PADsynth_used");
+        bool val;
+        return tmp && bin->getBool(tmp, val) && val;
+    } else if(doc) {
+        const XmlElement *tmp = doc->findElement("INFORMATION");
+        if(tmp)
+            tmp = tmp->find("par_bool", "name", "PADsynth_used");
+        if(tmp)
+            strval = tmp->attr("value");
+    } else {
+        mxml_node_t *tmp = mxmlFindElement(tree,
+                                           tree,
+                                           "INFORMATION",
+                                           NULL,
+                                           NULL,
+                                           MXML_DESCEND);
+
+        mxml_node_t *parameter = mxmlFindElement(tmp,
+                                                 tmp,
+                                                 "par_bool",
+                                                 "name",
+                                                 "PADsynth_used",
+                                                 MXML_DESCEND_FIRST);
+        if(parameter != NULL)
+            strval = mxmlElementGetAttr(parameter, "value");
+    }
     if(strval == NULL) //no information available
         return false;
 
@@ -202,6 +235,10 @@ int XMLwrapper::saveXMLfile(const string &filename, int compression) const
 
 char *XMLwrapper::getXMLdata() const
 {
+    //loaded documents are read only
+    if(doc || bin)
+        return NULL;
+
     xml_k = 0;
 
     char *xmldata = mxmlSaveAllocString(tree, XMLwrapper_whitespace_callback);
@@ -241,6 +278,59 @@ int XMLwrapper::dosavefile(const char *filename,
     return 0;
 }
 
+//Add an element of the mxml tree with all of its children
+static void addBinary(BinaryPresetWriter &writer, mxml_node_t *element)
+{
+    std::vector<const char *> attrs;
+#if MXML_MAJOR_VERSION == 3
+    const int count = mxmlElementGetAttrCount(element);
+    for(int i = 0; i < count; ++i) {
+        const char *name;
+        const char *value = mxmlElementGetAttrByIndex(element, i, &name);
+        if(name) {
+            attrs.push_back(name);
+            attrs.push_back(value);
+        }
+    }
+#else
+    for(int i = 0; i < element->value.element.num_attrs; ++i) {
+        attrs.push_back(element->value.element.attrs[i].name);
+        attrs.push_back(element->value.element.attrs[i].value);
+    }
+#endif
+    writer.begin(mxmlGetElement(element), attrs.data(), attrs.size() / 2);
+
+    for(mxml_node_t *child = mxmlGetFirstChild(element); child;
+        child = mxmlWalkNext(child, element, MXML_NO_DESCEND)) {
+        if(mxmlGetType(child) == MXML_ELEMENT)
+            addBinary(writer, child);
+        else if(mxmlGetType(child) == MXML_OPAQUE)
+            writer.text(mxmlGetOpaque(child));
+        else if(mxmlGetType(child) == MXML_TEXT)
+            writer.text(mxmlGetText(child, NULL));
+    }
+    writer.end();
+}
+
+int XMLwrapper::saveBinaryFile(const string &filename) const
+{
+    if(doc || bin || !root)
+        return -2;
+
+    BinaryPresetWriter writer;
+    addBinary(writer, root);
+    const std::string image = writer.finish();
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if(file == NULL)
+        return -1;
+    const bool written = fwrite(image.data(), 1, image.size(), file)
+                         == image.size();
+    if(fclose(file) || !written)
+        return -1;
+    return 0;
+}
+
 
 
 void XMLwrapper::addpar(const string &name, int val)
@@ -299,84 +389,34 @@ void XMLwrapper::endbranch()
 }
 
 
-//workaround for memory leak
-const char *trimLeadingWhite(const char *c)
-{
-    while(isspace(*c))
-        ++c;
-    return c;
-}
-
 /* LOAD XML members */
 
 int XMLwrapper::loadXMLfile(const string &filename)
 {
     cleanup();
 
-    const char *xmldata = doloadfile(filename);
-    if(xmldata == NULL)
-        return -1;  //the file could not be loaded or uncompressed
-
-    root = tree = mxmlLoadString(NULL, trimLeadingWhite(
-                                     xmldata), MXML_OPAQUE_CALLBACK);
-
-    delete[] xmldata;
-
-    if(tree == NULL)
-        return -2;  //this is not XML
+    if(BinaryPreset::isBinaryFile(filename)) {
+        bin = new BinaryPreset;
+        if(!bin->loadFile(filename))
+            return -1;  //the file is truncated or corrupted
+    } else {
+        doc = new XmlDocument;
+        if(!doc->loadFile(filename))
+            return -1;  //the file could not be loaded or uncompressed
+
+        if(!doc->parse())
+            return -2;  //this is not XML
+    }
 
-    node = root = mxmlFindElement(tree,
-                                  tree,
-                                  "ZynAddSubFX-data",
-                                  NULL,
-                                  NULL,
-                                  MXML_DESCEND);
-    if(root == NULL)
+    if(!loadroot())
         return -3;  //the XML doesn't embbed zynaddsubfx data
 
-    //fetch version information
-    _fileversion.set_major(stringTo<int>(mxmlElementGetAttr(root, "version-major")));
-    _fileversion.set_minor(stringTo<int>(mxmlElementGetAttr(root, "version-minor")));
-    _fileversion.set_revision(
-        stringTo<int>(mxmlElementGetAttr(root, "version-revision")));
-
     if(verbose)
         cout << "loadXMLfile() version: " << _fileversion << endl;
 
     return 0;
 }
 
-
-char *XMLwrapper::doloadfile(const string &filename) const
-{
-    char  *xmldata = NULL;
-    gzFile gzfile  = gzopen(filename.c_str(), "rb");
-
-    if(gzfile != NULL) { //The possibly compressed file opened
-        stringstream strBuf;             //reading stream
-        const int    bufSize = 500;      //fetch size
-        char fetchBuf[bufSize + 1];      //fetch buffer
-        int  read = 0;                   //chars read in last fetch
-
-        fetchBuf[bufSize] = 0; //force null termination
-
-        while(bufSize == (read = gzread(gzfile, fetchBuf, bufSize)))
-            strBuf << fetchBuf;
-
-        fetchBuf[read] = 0; //Truncate last partial read
-        strBuf << fetchBuf;
-
-        gzclose(gzfile);
-
-        //Place data in output format
-        string tmp = strBuf.str();
-        xmldata = new char[tmp.size() + 1];
-        strncpy(xmldata, tmp.c_str(), tmp.size() + 1);
-    }
-
-    return xmldata;
-}
-
 bool XMLwrapper::putXMLdata(const char *xmldata)
 {
     cleanup();
@@ -384,25 +424,34 @@ bool XMLwrapper::putXMLdata(const char *xmldata)
     if(xmldata == NULL)
         return false;
 
-    root = tree = mxmlLoadString(NULL, trimLeadingWhite(
-                                     xmldata), MXML_OPAQUE_CALLBACK);
-    if(tree == NULL)
-        return false;
-
-    node = root = mxmlFindElement(tree,
-                                  tree,
-                                  "ZynAddSubFX-data",
-                                  NULL,
-                                  NULL,
-                                  MXML_DESCEND);
-    if(root == NULL)
-        return false;
+    doc = new XmlDocument;
+    doc->setData(xmldata);
+    return doc->parse() && loadroot();
+}
+
+bool XMLwrapper::loadroot(void)
+{
+    const char *major, *minor, *revision;
+    if(bin) {
+        bnode = bin->findElement("ZynAddSubFX-data");
+        if(bnode == 0)
+            return false;
+        major    = bin->attr(bnode, "version-major");
+        minor    = bin->attr(bnode, "version-minor");
+        revision = bin->attr(bnode, "version-revision");
+    } else {
+        elm = doc->findElement("ZynAddSubFX-data");
+        if(elm == NULL)
+            return false;
+        major    = elm->attr("version-major");
+        minor    = elm->attr("version-minor");
+        revision = elm->attr("version-revision");
+    }
 
     //fetch version information
-    _fileversion.set_major(stringTo<int>(mxmlElementGetAttr(root, "version-major")));
-    _fileversion.set_minor(stringTo<int>(mxmlElementGetAttr(root, "version-minor")));
-    _fileversion.set_revision(
-        stringTo<int>(mxmlElementGetAttr(root, "version-revision")));
+    _fileversion.set_major(stringTo<int>(major));
+    _fileversion.set_minor(stringTo<int>(minor));
+    _fileversion.set_revision(stringTo<int>(revision));
 
     return true;
 }
@@ -413,6 +462,23 @@ int XMLwrapper::enterbranch(const string &name)
 {
     if(verbose)
         cout << "enterbranch() " << name << endl;
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, name.c_str());
+        if(tmp == 0)
+            return 0;
+
+        bnode = tmp;
+        return 1;
+    }
+    if(doc) {
+        const XmlElement *tmp = elm ? elm->find(name.c_str()) : NULL;
+        if(tmp == NULL)
+            return 0;
+
+        elm = tmp;
+        return 1;
+    }
+
     mxml_node_t *tmp = mxmlFindElement(node, node,
                                        name.c_str(), NULL, NULL,
                                        MXML_DESCEND_FIRST);
@@ -427,6 +493,27 @@ int XMLwrapper::enterbranch(const string &name, int id)
 {
     if(verbose)
         cout << "enterbranch(" << id << ") " << name << endl;
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, name.c_str(),
+                                       BinaryPresetNode::IdKey,
+                                       stringFrom<int>(id).c_str());
+        if(tmp == 0)
+            return 0;
+
+        bnode = tmp;
+        return 1;
+    }
+    if(doc) {
+        const XmlElement *tmp = elm ? elm->find(name.c_str(), "id",
+                                                stringFrom<int>(id).c_str())
+                                    : NULL;
+        if(tmp == NULL)
+            return 0;
+
+        elm = tmp;
+        return 1;
+    }
+
     mxml_node_t *tmp = mxmlFindElement(node, node,
                                        name.c_str(), "id", stringFrom<int>(
                                            id).c_str(), MXML_DESCEND_FIRST);
@@ -440,6 +527,19 @@ int XMLwrapper::enterbranch(const string &name, int id)
 
 void XMLwrapper::exitbranch()
 {
+    if(bin) {
+        if(verbose)
+            cout << "exitbranch()" << bin->name(bnode) << endl;
+        bnode = bin->parent(bnode);
+        return;
+    }
+    if(doc) {
+        if(verbose)
+            cout << "exitbranch()" << (elm ? elm->name : "") << endl;
+        elm = elm ? elm->parent : NULL;
+        return;
+    }
+
     if(verbose)
         cout << "exitbranch()" << node << "-" << mxmlGetElement(node)
              << " To "
@@ -450,7 +550,10 @@ void XMLwrapper::exitbranch()
 
 int XMLwrapper::getbranchid(int min, int max) const
 {
-    int id = stringTo<int>(mxmlElementGetAttr(node, "id"));
+    const char *strval = bin ? bin->attr(bnode, "id")
+                         : doc ? (elm ? elm->attr("id") : NULL)
+                         : mxmlElementGetAttr(node, "id");
+    int id = stringTo<int>(strval);
     if((min == 0) && (max == 0))
         return id;
 
@@ -466,21 +569,20 @@ int XMLwrapper::getbranchid(int min, int max) const
 int XMLwrapper::getpar(const string &name, int defaultpar, int min,
                        int max) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par",
-                                             "name",
-                                             name.c_str(),
-                                             MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return defaultpar;
-
-    const char *strval = mxmlElementGetAttr(tmp, "value");
-    if(strval == NULL)
-        return defaultpar;
-
-    int val = stringTo<int>(strval);
+    int val;
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, "par", BinaryPresetNode::NameKey,
+                                       name.c_str());
+        if(tmp == 0 || !bin->getInt(tmp, val))
+            return defaultpar;
+    } else {
+        const char *strval = getparattr("par", name.c_str(), "value");
+        if(strval == NULL)
+            return defaultpar;
+
+        //strtol avoids constructing a stream for each of the many parameters
+        val = (int)strtol(strval, NULL, 10);
+    }
     if(val < min)
         val = min;
     else
@@ -497,17 +599,16 @@ int XMLwrapper::getpar127(const string &name, int defaultpar) const
 
 int XMLwrapper::getparbool(const string &name, int defaultpar) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_bool",
-                                             "name",
-                                             name.c_str(),
-                                             MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return defaultpar;
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, "par_bool",
+                                       BinaryPresetNode::NameKey, name.c_str());
+        bool val;
+        if(tmp == 0 || !bin->getBool(tmp, val))
+            return defaultpar;
+        return val;
+    }
 
-    const char *strval = mxmlElementGetAttr(tmp, "value");
+    const char *strval = getparattr("par_bool", name.c_str(), "value");
     if(strval == NULL)
         return defaultpar;
 
@@ -520,82 +621,44 @@ int XMLwrapper::getparbool(const string &name, int defaultpar) const
 void XMLwrapper::getparstr(const string &name, char *par, int maxstrlen) const
 {
     ZERO(par, maxstrlen);
-    mxml_node_t *tmp = mxmlFindElement(node,
-                                       node,
-                                       "string",
-                                       "name",
-                                        name.c_str(),
-                                        MXML_DESCEND_FIRST);
-
-    if(tmp == NULL)
-        return;
-    if(mxmlGetFirstChild(tmp) == NULL)
-        return;
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_OPAQUE) {
-        snprintf(par, maxstrlen, "%s", mxmlGetOpaque(mxmlGetFirstChild(tmp)));
-        return;
-    }
-    if((mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TEXT)
-       && (mxmlGetFirstChild(tmp) != NULL)) {
-        snprintf(par, maxstrlen, "%s", mxmlGetText(mxmlGetFirstChild(tmp),NULL));
-        return;
-    }
+    const char *strval = getpartext(name.c_str());
+    if(strval != NULL)
+        snprintf(par, maxstrlen, "%s", strval);
 }
 
 string XMLwrapper::getparstr(const string &name,
                              const std::string &defaultpar) const
 {
-    mxml_node_t *tmp = mxmlFindElement(node,
-                                       node,
-                                       "string",
-                                       "name",
-                                       name.c_str(),
-                                       MXML_DESCEND_FIRST);
-
-    if((tmp == NULL) || (mxmlGetFirstChild(tmp) == NULL))
+    const char *strval = getpartext(name.c_str());
+    if(strval == NULL)
         return defaultpar;
-
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_OPAQUE
-       && (mxmlGetOpaque(mxmlGetFirstChild(tmp)) != NULL))
-        return mxmlGetOpaque(mxmlGetFirstChild(tmp));
-
-    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TEXT
-       && (mxmlGetText(mxmlGetFirstChild(tmp),NULL) != NULL))
-        return mxmlGetText(mxmlGetFirstChild(tmp),NULL);
-
-    return defaultpar;
+    return strval;
 }
 
 bool XMLwrapper::hasparreal(const char *name) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_real",
-                                             "name",
-                                             name,
-                                             MXML_DESCEND_FIRST);
-    return tmp != nullptr;
+    return getparattr("par_real", name, "name") != NULL;
 }
 
 float XMLwrapper::getparreal(const char *name, float defaultpar) const
 {
-    const mxml_node_t *tmp = mxmlFindElement(node,
-                                             node,
-                                             "par_real",
-                                             "name",
-                                             name,
-                                             MXML_DESCEND_FIRST);
-    if(tmp == NULL)
-        return defaultpar;
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, "par_real",
+                                       BinaryPresetNode::NameKey, name);
+        float val;
+        if(tmp == 0 || !bin->getReal(tmp, val))
+            return defaultpar;
+        return val;
+    }
 
-    const char *strval = mxmlElementGetAttr(tmp, "exact_value");
+    const char *strval = getparattr("par_real", name, "exact_value");
     if (strval != NULL) {
         union { float out; uint32_t in; } convert;
         sscanf(strval+2, "%x", &convert.in);
         return convert.out;
     }
 
-    strval = mxmlElementGetAttr(tmp, "value");
+    strval = getparattr("par_real", name, "value");
     if(strval == NULL)
         return defaultpar;
 
@@ -620,6 +683,58 @@ float XMLwrapper::getparreal(const char *name,
 
 /** Private members **/
 
+const char *XMLwrapper::getparattr(const char *tag, const char *name,
+                                   const char *attr) const
+{
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, tag, BinaryPresetNode::NameKey,
+                                       name);
+        return tmp ? bin->attr(tmp, attr) : NULL;
+    }
+    if(doc) {
+        const XmlElement *tmp = elm ? elm->find(tag, "name", name) : NULL;
+        return tmp ? tmp->attr(attr) : NULL;
+    }
+
+    const mxml_node_t *tmp = mxmlFindElement(node,
+                                             node,
+                                             tag,
+                                             "name",
+                                             name,
+                                             MXML_DESCEND_FIRST);
+    return tmp ? mxmlElementGetAttr(tmp, attr) : NULL;
+}
+
+const char *XMLwrapper::getpartext(const char *name) const
+{
+    if(bin) {
+        const uint32_t tmp = bin->find(bnode, "string",
+                                       BinaryPresetNode::NameKey, name);
+        return tmp ? bin->getText(tmp) : NULL;
+    }
+    if(doc) {
+        const XmlElement *tmp = elm ? elm->find("string", "name", name) : NULL;
+        return tmp ? tmp->text : NULL;
+    }
+
+    mxml_node_t *tmp = mxmlFindElement(node,
+                                       node,
+                                       "string",
+                                       "name",
+                                       name,
+                                       MXML_DESCEND_FIRST);
+    if((tmp == NULL) || (mxmlGetFirstChild(tmp) == NULL))
+        return NULL;
+
+    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_OPAQUE)
+        return mxmlGetOpaque(mxmlGetFirstChild(tmp));
+
+    if(mxmlGetType(mxmlGetFirstChild(tmp)) == MXML_TEXT)
+        return mxmlGetText(mxmlGetFirstChild(tmp), NULL);
+
+    return NULL;
+}
+
 mxml_node_t *XMLwrapper::addparams(const char *name, unsigned int params,
                                    ...) const
 {
@@ -682,6 +797,27 @@ void XMLwrapper::add(const XmlNode &node_)
 std::vector<XmlNode> XMLwrapper::getBranch(void) const
 {
     std::vector<XmlNode> res;
+    if(bin) {
+        BinaryPreset::Attrs attrs;
+        for(uint32_t c = bin->child(bnode); c; c = bin->next(c)) {
+            XmlNode n(bin->name(c));
+            bin->getAttrs(c, attrs);
+            for(auto &a:attrs)
+                n[a.first] = a.second;
+            res.push_back(n);
+        }
+        return res;
+    }
+    if(doc) {
+        for(const XmlElement *c = elm ? elm->child : NULL; c; c = c->next) {
+            XmlNode n(c->name);
+            for(int i = 0; i < c->nattrs; ++i)
+                n[c->attrs[2 * i]] = c->attrs[2 * i + 1];
+            res.push_back(n);
+        }
+        return res;
+    }
+
     mxml_node_t *current = mxmlGetFirstChild(node);
     while(current) {
         if(mxmlGetType(current) == MXML_ELEMENT) {
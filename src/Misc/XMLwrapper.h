@@ -14,6 +14,7 @@
 */
 
 #include <mxml.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include "zyn-version.h"
@@ -27,6 +28,10 @@
 
 namespace zyn {
 
+class XmlDocument;
+struct XmlElement;
+class BinaryPreset;
+
 class XmlAttr
 {
     public:
@@ -56,6 +61,13 @@ class XMLwrapper
          * */
         XMLwrapper();
 
+        /**
+         * Read only view of the branch the parent is currently in.
+         * The tree stays owned by the parent, which has to outlive the view.
+         * Views of different branches may be read from separate threads.
+         * */
+        explicit XMLwrapper(const XMLwrapper *parent);
+
         /**Destructor*/
         ~XMLwrapper();
 
@@ -66,6 +78,14 @@ class XMLwrapper
          */
         int saveXMLfile(const std::string &filename, int compression) const;
 
+        /**
+         * Saves the tree as a binary preset, which loadXMLfile() reads as
+         * well.
+         * @param filename the name of the destination file.
+         * @returns 0 if ok or -1 if the file cannot be saved.
+         */
+        int saveBinaryFile(const std::string &filename) const;
+
         /**
          * Return XML tree as a string.
          * Note: The string must be freed with free() to deallocate
@@ -125,6 +145,7 @@ class XMLwrapper
 
         /**
          * Loads file into XMLwrapper.
+         * The loaded data is read only, it can not be extended or saved.
          * @param filename file to be loaded
          * @returns 0 if ok or -1 if the file cannot be loaded
          */
@@ -132,6 +153,7 @@ class XMLwrapper
 
         /**
          * Loads string into XMLwrapper.
+         * The loaded data is read only, it can not be extended or saved.
          * @param xmldata NULL terminated string of XML data.
          * @returns true if successful.
          */
@@ -262,13 +284,23 @@ class XMLwrapper
                        const char *xmldata) const;
 
         /**
-         * Loads specified file and returns data.
-         *
-         * Will load a gzipped file or an uncompressed file.
-         * @param filename the file
-         * @return The decompressed data
+         * Find the root of the loaded document and its version.
+         * @return false if there is no zynaddsubfx data
+         */
+        bool loadroot(void);
+
+        /**
+         * Attribute of the child element \c tag which is named \c name.
+         * @return NULL if there is no such element or attribute
          */
-        char *doloadfile(const std::string &filename) const;
+        const char *getparattr(const char *tag, const char *name,
+                               const char *attr) const;
+
+        /**
+         * Text of the child element \c string which is named \c name.
+         * @return NULL if there is no such element or it is empty
+         */
+        const char *getpartext(const char *name) const;
 
         /**
          * Cleanup XML tree before loading new one.
@@ -279,6 +311,12 @@ class XMLwrapper
         mxml_node_t *root; /**<xml data used by zynaddsubfx*/
         mxml_node_t *node; /**<current subtree in parsing or writing */
         mxml_node_t *info; /**<Node used to store the information about the data*/
+        bool owner; /**<false for views into the tree of another wrapper*/
+
+        XmlDocument      *doc; /**<loaded data, NULL while writing*/
+        const XmlElement *elm; /**<current element of the loaded data*/
+        BinaryPreset     *bin; /**<loaded binary preset or NULL*/
+        uint32_t          bnode; /**<current element of the binary preset*/
 
         /**
          * Create mxml_node_t with specified name and parameters
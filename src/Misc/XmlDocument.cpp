@@ -0,0 +1,537 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  XmlDocument.cpp - Read only XML tree with indexed child lookup
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include "XmlDocument.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//Elements with more children get an index
+#define XML_INDEX_MIN_CHILDREN 8
+#define XML_ARENA_BLOCK (1 << 16)
+
+namespace zyn {
+
+static const char empty[] = "";
+
+//FNV-1a hash of the tag and the key value
+static uint32_t hashKey(const char *tag, const char *value)
+{
+    uint32_t h = 2166136261u;
+    for(; *tag; ++tag)
+        h = (h ^ (uint8_t)*tag) * 16777619u;
+    h = (h ^ 0xff) * 16777619u;
+    for(; *value; ++value)
+        h = (h ^ (uint8_t)*value) * 16777619u;
+    return h;
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isNameEnd(char c)
+{
+    return isSpace(c) || c == '>' || c == '/' || c == '=';
+}
+
+//First occurrence of s in [p, end) or NULL
+static char *findStr(char *p, char *end, const char *s)
+{
+    const size_t n = strlen(s);
+    for(; p + n <= end; ++p)
+        if(*p == *s && !memcmp(p, s, n))
+            return p;
+    return NULL;
+}
+
+static char *encodeUtf8(char *out, unsigned long code)
+{
+    if(code < 0x80)
+        *out++ = code;
+    else if(code < 0x800) {
+        *out++ = 0xc0 | (code >> 6);
+        *out++ = 0x80 | (code & 0x3f);
+    } else if(code < 0x10000) {
+        *out++ = 0xe0 | (code >> 12);
+        *out++ = 0x80 | ((code >> 6) & 0x3f);
+        *out++ = 0x80 | (code & 0x3f);
+    } else {
+        *out++ = 0xf0 | (code >> 18);
+        *out++ = 0x80 | ((code >> 12) & 0x3f);
+        *out++ = 0x80 | ((code >> 6) & 0x3f);
+        *out++ = 0x80 | (code & 0x3f);
+    }
+    return out;
+}
+
+//Decode the entities of [p, end) in place, an entity is never shorter than
+//its encoding
+//@return the new end
+static char *decode(char *p, char *end)
+{
+    char *out = (char *)memchr(p, '&', end - p);
+    if(!out)
+        return end;
+    p = out;
+    while(p < end) {
+        if(*p != '&') {
+            *out++ = *p++;
+            continue;
+        }
+        char *semi = p + 1;
+        while(semi < end && semi - p < 12 && *semi != ';')
+            ++semi;
+        if(semi >= end || *semi != ';') {
+            *out++ = *p++;
+            continue;
+        }
+
+        const char   *e    = p + 1;
+        const size_t  n    = semi - e;
+        unsigned long code = 0;
+        if(n == 2 && !strncmp(e, "lt", 2))
+            code = '<';
+        else if(n == 2 && !strncmp(e, "gt", 2))
+            code = '>';
+        else if(n == 3 && !strncmp(e, "amp", 3))
+            code = '&';
+        else if(n == 4 && !strncmp(e, "quot", 4))
+            code = '"';
+        else if(n == 4 && !strncmp(e, "apos", 4))
+            code = '\'';
+        else if(n > 1 && e[0] == '#') {
+            char *numend;
+            if(e[1] == 'x' || e[1] == 'X')
+                code = strtoul(e + 2, &numend, 16);
+            else
+                code = strtoul(e + 1, &numend, 10);
+            if(numend != semi || code >= 0x110000)
+                code = 0;
+        }
+
+        if(!code) {
+            *out++ = *p++;
+            continue;
+        }
+        out = encodeUtf8(out, code);
+        p   = semi + 1;
+    }
+    return out;
+}
+
+const char *XmlElement::attr(const char *key) const
+{
+    for(int i = 0; i < nattrs; ++i)
+        if(!strcmp(attrs[2 * i], key))
+            return attrs[2 * i + 1];
+    return NULL;
+}
+
+const XmlElement *XmlElement::find(const char *tag, const char *key,
+                                   const char *value) const
+{
+    //the index holds the first child per tag, and the first child per tag
+    //whose name or id has a value. A miss is final. A hit may have the value
+    //in the other attribute, then the children after it are scanned.
+    const XmlElement *from = child;
+    if(nslots && (!key || !strcmp(key, "name") || !strcmp(key, "id"))) {
+        const char    *v    = key ? value : empty;
+        const uint32_t hash = hashKey(tag, v);
+        const int      mask = nslots - 1;
+        int i = hash & mask;
+        for(; slots[i].elm; i = (i + 1) & mask) {
+            const Slot &s = slots[i];
+            if(s.hash != hash || strcmp(s.value, v) || strcmp(s.elm->name, tag))
+                continue;
+            if(!key)
+                return s.elm;
+            const char *a = s.elm->attr(key);
+            if(a && !strcmp(a, value))
+                return s.elm;
+            break;
+        }
+        if(!key || !slots[i].elm)
+            return NULL;
+        from = slots[i].elm->next;
+    }
+
+    for(const XmlElement *c = from; c; c = c->next) {
+        if(strcmp(c->name, tag))
+            continue;
+        if(!key)
+            return c;
+        const char *a = c->attr(key);
+        if(a && !strcmp(a, value))
+            return c;
+    }
+    return NULL;
+}
+
+XmlDocument::XmlDocument(void)
+    :buffer(NULL), length(0), mapped(false), top(NULL), cursor(NULL), avail(0)
+{}
+
+XmlDocument::~XmlDocument(void)
+{
+    release();
+}
+
+void XmlDocument::release(void)
+{
+#ifndef WIN32
+    if(mapped)
+        munmap(buffer, length);
+    else
+#endif
+    free(buffer);
+    buffer = NULL;
+    length = 0;
+    mapped = false;
+    top    = NULL;
+
+    for(auto b:blocks)
+        delete[] b;
+    blocks.clear();
+    cursor = NULL;
+    avail  = 0;
+}
+
+void *XmlDocument::alloc(size_t bytes)
+{
+    bytes = (bytes + 15) & ~(size_t)15;
+    if(bytes > avail) {
+        avail  = std::max<size_t>(std::max<size_t>(XML_ARENA_BLOCK, length),
+                                  bytes);
+        cursor = new char[avail];
+        blocks.push_back(cursor);
+    }
+    void *ptr = cursor;
+    cursor += bytes;
+    avail  -= bytes;
+    return ptr;
+}
+
+bool XmlDocument::loadFile(const std::string &filename)
+{
+    release();
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(!file)
+        return false;
+
+    unsigned char magic[4] = {0, 0};
+    if(fread(magic, 1, 2, file) == 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        //The gzip trailer holds the uncompressed size (of the last member),
+        //which is enough to inflate in one go
+        size_t size = 0;
+        if(!fseek(file, -4, SEEK_END) && fread(magic, 1, 4, file) == 4)
+            size = magic[0] | magic[1] << 8 | magic[2] << 16
+                   | (uint32_t)magic[3] << 24;
+        fclose(file);
+
+        gzFile gzfile = gzopen(filename.c_str(), "rb");
+        if(!gzfile)
+            return false;
+        //one more byte, so the end of the data is found without growing
+        size_t capacity = size + 1;
+        buffer = (char *)malloc(capacity);
+        while(buffer) {
+            if(length == capacity) {
+                capacity *= 2;
+                char *grown = (char *)realloc(buffer, capacity);
+                if(!grown)
+                    break;
+                buffer = grown;
+            }
+            const int n = gzread(gzfile, buffer + length, capacity - length);
+            if(n <= 0) {
+                gzclose(gzfile);
+                return n == 0;
+            }
+            length += n;
+        }
+        gzclose(gzfile);
+        release();
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    if(size < 0) {
+        fclose(file);
+        return false;
+    }
+#ifndef WIN32
+    //a private mapping can be parsed in place without touching the file
+    if(size > 0) {
+        void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fileno(file), 0);
+        if(map != MAP_FAILED) {
+            fclose(file);
+            buffer = (char *)map;
+            length = size;
+            mapped = true;
+            return true;
+        }
+    }
+#endif
+    buffer = (char *)malloc(size + 1);
+    fseek(file, 0, SEEK_SET);
+    length = buffer ? fread(buffer, 1, size, file) : 0;
+    fclose(file);
+    return buffer && length == (size_t)size;
+}
+
+void XmlDocument::setData(const char *data)
+{
+    release();
+    length = strlen(data);
+    buffer = (char *)malloc(length + 1);
+    memcpy(buffer, data, length + 1);
+}
+
+bool XmlDocument::parse(void)
+{
+    if(!buffer)
+        return false;
+    top = NULL;
+
+    char *p   = buffer;
+    char *end = buffer + length;
+
+    XmlElement               *cur = NULL; //innermost open element
+    std::vector<XmlElement *> tails(1, NULL); //last element per depth
+    std::vector<const char *> attrs;
+    std::vector<char *>       zeros;
+
+    while(p < end) {
+        if(*p != '<') {
+            char *text = p;
+            p = (char *)memchr(p, '<', end - p);
+            if(!p)
+                break; //text after the last tag is ignored
+            //the '<' may be overwritten by the terminator
+            if(cur && !cur->child && !cur->text) {
+                *decode(text, p) = 0;
+                cur->text = text;
+            }
+        }
+        //p is at a '<'
+        if(++p >= end)
+            return false;
+
+        if(*p == '?') { //processing instruction
+            p = findStr(p, end, "?>");
+            if(!p)
+                return false;
+            p += 2;
+            continue;
+        }
+        if(*p == '!') {
+            if(end - p >= 3 && !strncmp(p, "!--", 3)) {
+                p = findStr(p, end, "-->");
+                if(!p)
+                    return false;
+                p += 3;
+            } else if(end - p >= 8 && !strncmp(p, "![CDATA[", 8)) {
+                char *data = p + 8;
+                p = findStr(data, end, "]]>");
+                if(!p)
+                    return false;
+                if(cur && !cur->child && !cur->text) {
+                    *p = 0;
+                    cur->text = data;
+                }
+                p += 3;
+            } else { //DOCTYPE and other declarations
+                int depth = 0;
+                while(p < end && (*p != '>' || depth)) {
+                    depth += (*p == '[') - (*p == ']');
+                    ++p;
+                }
+                if(p >= end)
+                    return false;
+                ++p;
+            }
+            continue;
+        }
+        if(*p == '/') { //closing tag
+            char *name = ++p;
+            while(p < end && !isSpace(*p) && *p != '>')
+                ++p;
+            const size_t n = p - name;
+            if(!cur || strncmp(cur->name, name, n) || cur->name[n])
+                return false;
+            p = (char *)memchr(p, '>', end - p);
+            if(!p)
+                return false;
+            ++p;
+            cur = cur->parent;
+            tails.pop_back();
+            continue;
+        }
+
+        //opening tag, the terminators are only written once it is parsed
+        char *name = p;
+        while(p < end && !isNameEnd(*p))
+            ++p;
+        if(p == name || p >= end)
+            return false;
+        zeros.clear();
+        attrs.clear();
+        zeros.push_back(p);
+
+        bool closed;
+        while(true) {
+            while(p < end && isSpace(*p))
+                ++p;
+            if(p >= end)
+                return false;
+            if(*p == '>') {
+                ++p;
+                closed = false;
+                break;
+            }
+            if(*p == '/') {
+                if(p + 1 >= end || p[1] != '>')
+                    return false;
+                p += 2;
+                closed = true;
+                break;
+            }
+
+            char *key = p;
+            while(p < end && !isNameEnd(*p))
+                ++p;
+            if(p == key || p >= end)
+                return false;
+            zeros.push_back(p);
+            attrs.push_back(key);
+
+            char *eq = p;
+            while(eq < end && isSpace(*eq))
+                ++eq;
+            if(eq >= end || *eq != '=') { //attribute without a value
+                attrs.push_back(empty);
+                continue;
+            }
+            p = eq + 1;
+            while(p < end && isSpace(*p))
+                ++p;
+            if(p >= end || (*p != '"' && *p != '\''))
+                return false;
+            const char quote = *p++;
+            char *value = p;
+            p = (char *)memchr(p, quote, end - p);
+            if(!p)
+                return false;
+            zeros.push_back(decode(value, p));
+            attrs.push_back(value);
+            ++p;
+        }
+        for(auto z:zeros)
+            *z = 0;
+
+        XmlElement *elm = (XmlElement *)alloc(sizeof(XmlElement));
+        memset(elm, 0, sizeof(XmlElement));
+        elm->name   = name;
+        elm->parent = cur;
+        elm->nattrs = attrs.size() / 2;
+        if(!attrs.empty()) {
+            elm->attrs = (const char **)alloc(attrs.size() * sizeof(char *));
+            std::copy(attrs.begin(), attrs.end(), elm->attrs);
+        }
+
+        XmlElement *&tail = tails.back();
+        if(tail)
+            tail->next = elm;
+        else if(cur)
+            cur->child = elm;
+        else
+            top = elm;
+        tail = elm;
+
+        if(!closed) {
+            cur = elm;
+            tails.push_back(NULL);
+        }
+    }
+
+    //like mxml, unclosed elements at the end are accepted
+    if(!top)
+        return false;
+    for(XmlElement *elm = top; elm; elm = elm->next)
+        index(elm);
+    return true;
+}
+
+void XmlDocument::index(XmlElement *elm)
+{
+    int children = 0;
+    for(XmlElement *c = elm->child; c; c = c->next) {
+        index(c);
+        ++children;
+    }
+    if(children <= XML_INDEX_MIN_CHILDREN)
+        return;
+
+    //up to three keys per child with a load of at most 3/4
+    int size = 1;
+    while(size < 4 * children)
+        size *= 2;
+    elm->nslots = size;
+    elm->slots  = (XmlElement::Slot *)alloc(size * sizeof(XmlElement::Slot));
+    memset(elm->slots, 0, size * sizeof(XmlElement::Slot));
+
+    for(XmlElement *c = elm->child; c; c = c->next) {
+        const char *values[3] = {empty, c->attr("name"), c->attr("id")};
+        for(const char *v:values) {
+            if(!v)
+                continue;
+            const uint32_t hash = hashKey(c->name, v);
+            int i = hash & (size - 1);
+            for(; elm->slots[i].elm; i = (i + 1) & (size - 1)) {
+                const XmlElement::Slot &s = elm->slots[i];
+                if(s.hash == hash && !strcmp(s.value, v)
+                   && !strcmp(s.elm->name, c->name))
+                    break; //an earlier child has the same key
+            }
+            if(!elm->slots[i].elm)
+                elm->slots[i] = {hash, v, c};
+        }
+    }
+}
+
+static const XmlElement *findDepthFirst(const XmlElement *elm,
+                                        const char *tag)
+{
+    for(; elm; elm = elm->next) {
+        if(!strcmp(elm->name, tag))
+            return elm;
+        if(const XmlElement *found = findDepthFirst(elm->child, tag))
+            return found;
+    }
+    return NULL;
+}
+
+const XmlElement *XmlDocument::findElement(const char *tag) const
+{
+    return findDepthFirst(top, tag);
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  XmlDocument.h - Read only XML tree with indexed child lookup
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef XML_DOCUMENT_H
+#define XML_DOCUMENT_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace zyn {
+
+/**Element of a parsed document
+ *
+ * All strings point into the document buffer, all elements and tables are
+ * allocated from the arena of the document.*/
+struct XmlElement
+{
+    const char  *name;
+    const char  *text;   //character data before the first child, or NULL
+    XmlElement  *parent;
+    XmlElement  *child;  //first child element
+    XmlElement  *next;   //next sibling element
+    const char **attrs;  //name, value pairs
+    int          nattrs;
+
+    /**@return the value of the attribute or NULL*/
+    const char *attr(const char *key) const;
+
+    /**First child with the tag name and the attribute key set to value.
+     * Without a key the first child with the tag name is returned.
+     * Lookups by "name" and "id" use a hash table for larger elements.
+     * @return NULL if there is no such child*/
+    const XmlElement *find(const char *tag, const char *key = NULL,
+                           const char *value = NULL) const;
+
+    //Index of the children, built once the document is parsed
+    struct Slot {
+        uint32_t    hash;
+        const char *value;
+        XmlElement *elm;
+    };
+    Slot *slots;
+    int   nslots; //power of two or 0 if not indexed
+};
+
+/**
+ * Read only XML document
+ *
+ * The file is memory mapped or inflated into a single buffer, which is then
+ * parsed in place. This keeps loading banks and instruments from being
+ * dominated by allocations and repeated linear searches.
+ */
+class XmlDocument
+{
+    public:
+        XmlDocument(void);
+        ~XmlDocument(void);
+
+        /**Map or inflate a possibly gzip compressed file
+         * @return false if the file can not be read*/
+        bool loadFile(const std::string &filename);
+
+        /**Copy a NULL terminated string*/
+        void setData(const char *data);
+
+        /**Parse the loaded data
+         * @return false if it is not well formed XML*/
+        bool parse(void);
+
+        /**First element with the tag name, searched depth first
+         * @return NULL if there is none*/
+        const XmlElement *findElement(const char *tag) const;
+
+        size_t size(void) const { return length; }
+
+    private:
+        XmlDocument(const XmlDocument &) = delete;
+        XmlDocument &operator=(const XmlDocument &) = delete;
+
+        void release(void);
+        void *alloc(size_t bytes);
+        void index(XmlElement *elm);
+
+        char  *buffer;
+        size_t length;
+        bool   mapped;
+
+        //top level elements
+        XmlElement *top;
+
+        //arena
+        std::vector<char *> blocks;
+        char               *cursor;
+        size_t              avail;
+};
+
+}
+
+#endif
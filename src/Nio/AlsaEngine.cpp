@@ -12,9 +12,13 @@
 */
 
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 #include <poll.h>
+#include <stdint.h>
+#include <cstring>
+#include <vector>
 
 #include "../Misc/Util.h"
 #include "../Misc/Config.h"
@@ -35,6 +39,8 @@ AlsaEngine::AlsaEngine(const SYNTH_T &synth)
     audio.buffer = new short[synth.buffersize * 2];
     name = "ALSA";
     audio.handle = NULL;
+    audio.mmap   = false;
+    audio.format = SND_PCM_FORMAT_S16_LE;
     audio.peaks[0] = 0;
 
     midi.handle  = NULL;
@@ -307,6 +313,140 @@ short *AlsaEngine::interleave(const Stereo<float *> &smps)
     return shortInterleaved;
 }
 
+static inline int32_t floatToS32(float smp)
+{
+    if(smp >= 1.0f)
+        return INT32_MAX;
+    if(smp <= -1.0f)
+        return -INT32_MAX;
+    return lrintf(smp * 2147483647.0f);
+}
+
+/*
+ * Write one buffer straight into the ring of the device
+ */
+void AlsaEngine::writeMmap(snd_pcm_t *handle, const Stereo<float *> &smps)
+{
+    const bool s32 = audio.format != SND_PCM_FORMAT_FLOAT;
+    snd_pcm_uframes_t done = 0;
+    while(done < (snd_pcm_uframes_t)bufferSize) {
+        const snd_pcm_channel_area_t *areas;
+        snd_pcm_uframes_t offset;
+        snd_pcm_uframes_t frames = bufferSize - done;
+        int rc = snd_pcm_mmap_begin(handle, &areas, &offset, &frames);
+        if(rc < 0) {
+            recover(handle, rc);
+            return;
+        }
+
+        char    *dst[2];
+        unsigned step[2];
+        for(int c = 0; c < 2; ++c) {
+            dst[c]  = (char *)areas[c].addr
+                      + (areas[c].first + offset * areas[c].step) / 8;
+            step[c] = areas[c].step / 8;
+        }
+
+        for(snd_pcm_uframes_t i = done; i < done + frames; ++i) {
+            float l = smps.l[i];
+            float r = smps.r[i];
+            if(isOutputCompressionEnabled)
+                stereoCompressor(synth.samplerate, audio.peaks[0], l, r);
+
+            if(s32) {
+                *(int32_t *)dst[0] = floatToS32(l);
+                *(int32_t *)dst[1] = floatToS32(r);
+            } else {
+                *(float *)dst[0] = l;
+                *(float *)dst[1] = r;
+            }
+            dst[0] += step[0];
+            dst[1] += step[1];
+        }
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(handle, offset,
+                                                          frames);
+        if(committed < 0 || (snd_pcm_uframes_t)committed != frames) {
+            recover(handle, committed < 0 ? committed : -EPIPE);
+            return;
+        }
+        done += frames;
+    }
+}
+
+void AlsaEngine::recover(snd_pcm_t *handle, int err)
+{
+    if(err == -EPIPE) {
+        /* EPIPE means underrun */
+        cerr << "underrun occurred" << endl;
+        snd_pcm_prepare(handle);
+    }
+    else {
+        cerr << "AlsaEngine: Recovering connection..." << endl;
+        if(snd_pcm_recover(handle, err, 0) < 0)
+         throw "Could not recover ALSA connection";
+    }
+}
+
+/*
+ * Interleaved mmap access in float or 32 bit format, with one period per
+ * synth buffer. Returns false if the device does not support it.
+ */
+bool AlsaEngine::setMmapParams()
+{
+    snd_pcm_t *handle = audio.handle;
+    snd_pcm_hw_params_any(handle, audio.params);
+
+    if(snd_pcm_hw_params_set_access(handle, audio.params,
+                                    SND_PCM_ACCESS_MMAP_INTERLEAVED) < 0)
+        return false;
+
+    if(snd_pcm_hw_params_set_format(handle, audio.params,
+                                    SND_PCM_FORMAT_FLOAT) == 0)
+        audio.format = SND_PCM_FORMAT_FLOAT;
+    else if(snd_pcm_hw_params_set_format(handle, audio.params,
+                                         SND_PCM_FORMAT_S32) == 0)
+        audio.format = SND_PCM_FORMAT_S32;
+    else
+        return false;
+
+    if(snd_pcm_hw_params_set_channels(handle, audio.params, 2) < 0)
+        return false;
+
+    audio.sampleRate = synth.samplerate;
+    snd_pcm_hw_params_set_rate_near(handle, audio.params,
+                                    &audio.sampleRate, NULL);
+
+    audio.frames = bufferSize;
+    snd_pcm_hw_params_set_period_size_near(handle, audio.params,
+                                           &audio.frames, NULL);
+    audio.periods = 3;
+    snd_pcm_hw_params_set_periods_near(handle, audio.params,
+                                       &audio.periods, NULL);
+
+    if(snd_pcm_hw_params(handle, audio.params) < 0)
+        return false;
+
+    snd_pcm_uframes_t alsa_buffersize;
+    snd_pcm_hw_params_get_period_size(audio.params, &audio.frames, NULL);
+    snd_pcm_hw_params_get_buffer_size(audio.params, &alsa_buffersize);
+    if((int)audio.frames != bufferSize)
+        cerr << "ALSA period size: " << audio.frames << endl;
+
+    /* Wake up once a whole synth buffer fits, even if the period is
+     * shorter, and start once the ring has been filled */
+    snd_pcm_sw_params_t *swparams;
+    snd_pcm_sw_params_alloca(&swparams);
+    snd_pcm_sw_params_current(handle, swparams);
+    snd_pcm_sw_params_set_avail_min(handle, swparams,
+                                    max(audio.frames,
+                                        (snd_pcm_uframes_t)bufferSize));
+    snd_pcm_sw_params_set_start_threshold(handle, swparams,
+                                          alsa_buffersize
+                                          - alsa_buffersize % bufferSize);
+    return snd_pcm_sw_params(handle, swparams) == 0;
+}
+
 bool AlsaEngine::openAudio()
 {
     if(getAudioEn())
@@ -335,6 +475,23 @@ bool AlsaEngine::openAudio()
     /* Allocate a hardware parameters object. */
     snd_pcm_hw_params_alloca(&audio.params);
 
+    /* Prefer rendering into the mmapped ring, ALSA_MMAP=0 disables it */
+    const char *use_mmap = getenv("ALSA_MMAP");
+    audio.mmap = !(use_mmap && !strcmp(use_mmap, "0")) && setMmapParams();
+    if(audio.mmap) {
+        cerr << "ALSA: mmap output in "
+             << snd_pcm_format_name(audio.format) << " with "
+             << audio.periods << " periods of " << audio.frames
+             << " frames" << endl;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+        pthread_create(&audio.pThread, &attr, _AudioThread, this);
+        return true;
+    }
+
+    audio.format = SND_PCM_FORMAT_S16_LE;
+
     /* Fill it in with default values. */
     snd_pcm_hw_params_any(audio.handle, audio.params);
 
@@ -411,22 +568,60 @@ void AlsaEngine::stopAudio()
 
 void *AlsaEngine::processAudio()
 {
+    if(audio.mmap)
+        return processMmapAudio();
+
     while(audio.handle) {
         audio.buffer = interleave(getNext());
         snd_pcm_t *handle = audio.handle;
         int rc = snd_pcm_writei(handle, audio.buffer, synth.buffersize);
-        if(rc == -EPIPE) {
-            /* EPIPE means underrun */
-            cerr << "underrun occurred" << endl;
-            snd_pcm_prepare(handle);
+        if(rc < 0)
+            recover(handle, rc);
+    }
+    return NULL;
+}
+
+/*
+ * Render a buffer whenever the device has room for it, waiting on the PCM
+ * descriptors in between
+ */
+void *AlsaEngine::processMmapAudio()
+{
+    std::vector<struct pollfd> fds(
+        snd_pcm_poll_descriptors_count(audio.handle));
+
+    while(snd_pcm_t *handle = audio.handle) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(handle);
+        if(avail < 0) {
+            recover(handle, avail);
+            continue;
         }
-        else
-        if(rc < 0) {
-            cerr << "AlsaEngine: Recovering connection..." << endl;
-            rc = snd_pcm_recover(handle, rc, 0);
-            if(rc < 0)
-             throw "Could not recover ALSA connection";
+
+        if(avail >= bufferSize) {
+            writeMmap(handle, getNext());
+            continue;
+        }
+
+        //full, but not yet started by the start threshold
+        if(snd_pcm_state(handle) == SND_PCM_STATE_PREPARED) {
+            snd_pcm_start(handle);
+            continue;
         }
+
+        snd_pcm_poll_descriptors(handle, fds.data(), fds.size());
+        if(poll(fds.data(), fds.size(), 100) <= 0)
+            continue;
+
+        //the raw poll events of a plugin PCM do not mean anything by
+        //themselves, ALSA translates them
+        unsigned short revents = 0;
+        int rc = snd_pcm_poll_descriptors_revents(handle, fds.data(),
+                                                  fds.size(), &revents);
+        if(rc < 0)
+            recover(handle, rc);
+        else if(revents & POLLERR)
+            recover(handle, snd_pcm_state(handle) == SND_PCM_STATE_SUSPENDED
+                            ? -ESTRPIPE : -EPIPE);
     }
     return NULL;
 }
@@ -51,8 +51,11 @@ class AlsaEngine:public AudioOut, MidiIn
         void stopMidi();
         bool openAudio();
         void stopAudio();
+        bool setMmapParams();
 
         short *interleave(const Stereo<float *> &smps);
+        void writeMmap(snd_pcm_t *handle, const Stereo<float *> &smps);
+        void recover(snd_pcm_t *handle, int err);
 
         struct {
             std::string device;
@@ -68,12 +71,15 @@ class AlsaEngine:public AudioOut, MidiIn
             unsigned int      sampleRate;
             snd_pcm_uframes_t frames;
             unsigned int      periods;
+            bool              mmap; //render into the ring of the device
+            snd_pcm_format_t  format;
             short    *buffer;
             pthread_t pThread;
             float peaks[1];
         } audio;
 
         void *processAudio();
+        void *processMmapAudio();
 };
 
 }
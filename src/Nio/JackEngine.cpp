@@ -24,6 +24,7 @@
 #include <cstring>
 #include <unistd.h> // access()
 #include <fstream> // std::istream
+#include <rtosc/rtosc.h>
 
 #include "Nio.h"
 #include "Compressor.h"
@@ -300,6 +301,20 @@ string JackEngine::clientName()
     return string("Oh, yoshimi :-(");
 }
 
+//Apply an OSC message or the elements of a bundle. The events already carry
+//the frame they belong to, so the timetags of the bundles are not used
+static void applyOscPacket(const char *packet, size_t len)
+{
+    if(len >= 16 && !memcmp(packet, "#bundle", 8)) {
+        const size_t elements = rtosc_bundle_elements(packet, len);
+        for(size_t i = 0; i < elements; ++i)
+            applyOscPacket(rtosc_bundle_fetch(packet, i),
+                           rtosc_bundle_size(packet, i));
+    }
+    else if(len && *packet == '/' && rtosc_message_length(packet, len))
+        OutMgr::getInstance().applyOscEventRt(packet);
+}
+
 int JackEngine::_processCallback(jack_nframes_t nframes, void *arg)
 {
     return static_cast<JackEngine *>(arg)->processCallback(nframes);
@@ -325,10 +340,7 @@ bool JackEngine::processAudio(jack_nframes_t nframes)
         jack_osc_event_t event;
         if(jack_osc_event_get(&event, oscport, i))
             continue;
-        if(*event.buffer!='/') //Bundles are unhandled
-            continue;
-        //TODO validate message length
-        OutMgr::getInstance().applyOscEventRt((char*)event.buffer);
+        applyOscPacket((const char*)event.buffer, event.size);
     }
 
     for(int port = 0; port < 2; ++port) {
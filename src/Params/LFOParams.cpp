@@ -154,6 +154,9 @@ void LFOParams::setup()
             throw std::logic_error("Invalid lfo consumer location");
     }
 
+    shared.time  = nullptr;
+    shared.stamp = 0;
+
     defaults();
 }
 
@@ -247,6 +250,14 @@ void LFOParams::defaults()
     denominator = 4;
 }
 
+bool LFOParams::freerunning() const
+{
+    //the phase follows the absolute time and no note has random values
+    return Pcontinous && !Prandomness && !Pfreqrand
+           && (Pstretch == 64 || (numerator && denominator))
+           && PLFOtype != LFO_RANDOM
+           && (PLFOtype != LFO_SQUARE || Pcutoff == 127);
+}
 
 void LFOParams::add2XML(XMLwrapper& xml)
 {
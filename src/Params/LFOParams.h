@@ -58,6 +58,9 @@ class LFOParams:public Presets
         void getfromXML(XMLwrapper& xml);
         void paste(LFOParams &);
 
+        /**Whether all notes of this continuous LFO have the same output*/
+        bool freerunning(void) const;
+
         /*  MIDI Parameters*/
         float         freq;      /**<frequency*/
         unsigned char Pintensity; /**<intensity*/
@@ -81,6 +84,15 @@ class LFOParams:public Presets
         const AbsTime *time;
         int64_t last_update_timestamp;
 
+        //Output of a free running LFO, the first note of each control period
+        //computes it and the others take it
+        struct SharedOut {
+            const AbsTime *time; //of the notes, when it was computed
+            int64_t        stamp;
+            float          phase, startphase, out;
+        };
+        mutable SharedOut shared;
+
         static const rtosc::Ports &ports;
     private:
         //! common functionality of ctors
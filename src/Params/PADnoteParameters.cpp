@@ -18,10 +18,14 @@
 #include "LFOParams.h"
 #include "../Synth/Resonance.h"
 #include "../Synth/OscilGen.h"
+#include "../Misc/Denormals.h"
 #include "../Misc/WavFile.h"
 #include "../Misc/Time.h"
 #include <cstdio>
+#include <cstring>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
 
 #include <rtosc/ports.h>
 #include <rtosc/port-sugar.h>
@@ -93,12 +97,13 @@ static const rtosc::Ports realtime_ports =
             const char *mm = m;
             while(!isdigit(*mm))++mm;
             int n = atoi(mm);
-            float *oldsmp = p->sample[n].smp;
+            PADnoteParameters::SampleData *olddata = p->sample[n].data;
             p->sample[n].size     = rtosc_argument(m,0).i;
             p->sample[n].basefreq = rtosc_argument(m,1).f;
-            p->sample[n].smp      = *(float**)rtosc_argument(m,2).b.data;
-            if (oldsmp)
-                d.reply("/free", "sb", "PADsample", sizeof(void*), &oldsmp);
+            p->sample[n].data     =
+                *(PADnoteParameters::SampleData**)rtosc_argument(m,2).b.data;
+            if (olddata)
+                d.reply("/free", "sb", "PADsample", sizeof(void*), &olddata);
         }},
     //weird stuff for PCoarseDetune
     {"detunevalue:", rMap(unit,cents) rDoc("Get detune value"), NULL,
@@ -248,6 +253,8 @@ static const rtosc::Ports non_realtime_ports =
             "Samples per octave"),
     rParamI(Pquality.oct, rShort("octaves"), rLinear(0,7), rDefault(3),
             "Number of octaves to sample (above the first sample"),
+    rToggle(Pquality.compact, rShort("16 bit"), rDefault(false),
+            "Store the wavetables as 16 bit integers (half the memory)"),
 #undef rDefaultProps
 #define rDefaultProps
 
@@ -352,7 +359,7 @@ PADnoteParameters::PADnoteParameters(const SYNTH_T &synth_, FFTwrapper *fft_,
     FilterLfo = new LFOParams(ad_global_filter, time_);
 
     for(int i = 0; i < PAD_MAX_SAMPLES; ++i)
-        sample[i].smp = NULL;
+        sample[i].data = NULL;
 
     defaults();
 }
@@ -403,6 +410,7 @@ void PADnoteParameters::defaults()
     Pquality.basenote   = 4;
     Pquality.oct    = 3;
     Pquality.smpoct = 2;
+    Pquality.compact = false;
 
     PStereo = 1; //stereo
     /* Frequency Global Parameters */
@@ -443,8 +451,8 @@ void PADnoteParameters::deletesample(int n)
     if((n < 0) || (n >= PAD_MAX_SAMPLES))
         return;
 
-    delete[] sample[n].smp;
-    sample[n].smp = NULL;
+    SampleData::release(sample[n].data);
+    sample[n].data = NULL;
     sample[n].size     = 0;
     sample[n].basefreq = 440.0f;
 }
@@ -455,6 +463,126 @@ void PADnoteParameters::deletesamples()
         deletesample(i);
 }
 
+/*
+ * Shared wavetables
+ */
+
+static std::mutex sample_cache_lock;
+static std::unordered_multimap<uint64_t, PADnoteParameters::SampleData*>
+    sample_cache;
+
+PADnoteParameters::SpectrumKey::SpectrumKey(const float *spectrum, int size_,
+                                             bool compact_)
+    :hash(14695981039346656037ull), check(0), size(size_), compact(compact_)
+{
+    //FNV-1a selects the candidates
+    auto mix = [this](uint32_t x) {
+        hash = (hash ^ x) * 1099511628211ull;
+    };
+    //and a splitmix64 finalizer over the bins and their positions has to
+    //match as well, so a hit needs two unrelated 64 bit hashes to collide
+    auto mixcheck = [this](uint64_t x) {
+        x += check + 0x9e3779b97f4a7c15ull;
+        x  = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x  = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        check = x ^ (x >> 31);
+    };
+    mix(size);
+    mix(compact);
+    mixcheck(((uint64_t)size << 1) | compact);
+    for(int i = 0; i < size; ++i) {
+        uint32_t x;
+        memcpy(&x, spectrum + i, sizeof(x));
+        mix(x);
+        if(x)
+            mixcheck(((uint64_t)i << 32) | x);
+    }
+}
+
+bool PADnoteParameters::SpectrumKey::operator==(const SpectrumKey &other) const
+{
+    return hash == other.hash && check == other.check
+           && size == other.size && compact == other.compact;
+}
+
+size_t PADnoteParameters::SampleData::bytes(void) const
+{
+    const int extra_samples = 5;
+    return (size + extra_samples) * (smp16 ? sizeof(int16_t) : sizeof(float));
+}
+
+//the cached data of an equal key, NULL if there is none
+static PADnoteParameters::SampleData *
+cached(const PADnoteParameters::SpectrumKey &key)
+{
+    auto range = sample_cache.equal_range(key.hash);
+    for(auto itr = range.first; itr != range.second; ++itr)
+        if(itr->second->key == key)
+            return itr->second;
+    return NULL;
+}
+
+PADnoteParameters::SampleData *PADnoteParameters::SampleData::find(
+        const SpectrumKey &key)
+{
+    std::lock_guard<std::mutex> guard(sample_cache_lock);
+    SampleData *data = cached(key);
+    if(data)
+        data->refs++;
+    return data;
+}
+
+PADnoteParameters::SampleData *PADnoteParameters::SampleData::insert(SampleData *data)
+{
+    std::lock_guard<std::mutex> guard(sample_cache_lock);
+    SampleData *other = cached(data->key);
+    if(!other) {
+        sample_cache.emplace(data->key.hash, data);
+        return data;
+    }
+
+    //another thread generated the same spectrum in the meantime
+    delete[] data->smp;
+    delete[] data->smp16;
+    delete data;
+    other->refs++;
+    return other;
+}
+
+void PADnoteParameters::SampleData::release(SampleData *data)
+{
+    if(!data)
+        return;
+    std::lock_guard<std::mutex> guard(sample_cache_lock);
+    if(--data->refs)
+        return;
+    auto range = sample_cache.equal_range(data->key.hash);
+    for(auto itr = range.first; itr != range.second; ++itr)
+        if(itr->second == data) {
+            sample_cache.erase(itr);
+            break;
+        }
+    delete[] data->smp;
+    delete[] data->smp16;
+    delete data;
+}
+
+size_t PADnoteParameters::sampleMemory(size_t *shared) const
+{
+    size_t total = 0;
+    if(shared)
+        *shared = 0;
+    for(int i = 0; i < PAD_MAX_SAMPLES; ++i) {
+        const SampleData *data = sample[i].data;
+        if(!data)
+            continue;
+        total += data->bytes();
+        if(shared && data->refs > 1)
+            *shared += data->bytes();
+    }
+    return total;
+}
+
 /*
  * Get the harmonic profile (i.e. the frequency distributio of a single harmonic)
  */
@@ -865,7 +993,7 @@ void PADnoteParameters::applyparameters(std::function<bool()> do_abort,
         return;
     unsigned num = sampleGenerator([this]
                        (unsigned N, PADnoteParameters::Sample&& smp) {
-                           delete[] sample[N].smp;
+                           SampleData::release(sample[N].data);
                            sample[N] = std::move(smp);
                        },
                        do_abort, max_threads);
@@ -931,8 +1059,9 @@ int PADnoteParameters::sampleGenerator(PADnoteParameters::callback cb,
                       adj_ptr, &profile, this_c](
                       unsigned nthreads, unsigned threadno)
     {
+        DenormalGuard flush;
         //prepare a BIG IFFT
-        FFTwrapper    *fft      = new FFTwrapper(samplesize);
+        FFTwrapper    *fft      = FFTwrapper::acquire(samplesize);
         FFTfreqBuffer  fftfreqs = fft->allocFreqBuf();
         float         *spectrum = new float[spectrumsize];
 
@@ -955,43 +1084,73 @@ int PADnoteParameters::sampleGenerator(PADnoteParameters::callback cb,
                 this_c->generatespectrum_otherModes(spectrum, spectrumsize,
                                                     basefreq * basefreqadjust);
 
+            PADnoteParameters::Sample newsample;
+            newsample.size     = samplesize;
+            newsample.basefreq = basefreq * basefreqadjust;
+
+            //kit items with the same spectrum share the wavetable
+            const bool compact = this_c->Pquality.compact;
+            SpectrumKey key(spectrum, spectrumsize, compact);
+            newsample.data = SampleData::find(key);
+            if(newsample.data) {
+                cb(nsample, std::move(newsample));
+                continue;
+            }
+
             //the last samples contain the first samples
             //(used for linear/cubic interpolation)
             const int extra_samples = 5;
-            PADnoteParameters::Sample newsample;
-            newsample.smp = new float[samplesize + extra_samples];
+            float *smp = new float[samplesize + extra_samples];
 
-            newsample.smp[0] = 0.0f;
+            smp[0] = 0.0f;
             fftfreqs[0] = fft_t(0, 0);
             for(int i = 1; i < spectrumsize; ++i) //randomize the phases
                 fftfreqs[i] = FFTpolar(spectrum[i], (float)RND * 2 * PI);
             //that's all; here is the only ifft for the whole sample;
             //no windows are used ;-)
-            fft->freqs2smps_noconst_input(fftfreqs, fft->allocSampleBuf(newsample.smp));
+            fft->freqs2smps_noconst_input(fftfreqs, fft->allocSampleBuf(smp));
 
             //normalize(rms)
             float rms = 0.0f;
             for(int i = 0; i < samplesize; ++i)
-                rms += newsample.smp[i] * newsample.smp[i];
+                rms += smp[i] * smp[i];
             rms = sqrtf(rms);
             if(rms < 0.000001f)
                 rms = 1.0f;
             rms *= sqrtf(262144.0f / samplesize);//262144=2^18
             for(int i = 0; i < samplesize; ++i)
-                newsample.smp[i] *= 1.0f / rms * 50.0f;
+                smp[i] *= 1.0f / rms * 50.0f;
 
             //prepare extra samples used by the linear or cubic interpolation
             for(int i = 0; i < extra_samples; ++i)
-                newsample.smp[i + samplesize] = newsample.smp[i];
+                smp[i + samplesize] = smp[i];
+
+            SampleData *data = new SampleData(key);
+            data->size  = samplesize;
+            data->smp   = smp;
+            data->smp16 = NULL;
+            data->scale = 1.0f;
+            if(compact) {
+                float peak = 0.0f;
+                for(int i = 0; i < samplesize; ++i)
+                    peak = fmaxf(peak, fabsf(smp[i]));
+                if(peak == 0.0f)
+                    peak = 1.0f;
+                data->scale = peak / 32767.0f;
+                data->smp16 = new int16_t[samplesize + extra_samples];
+                for(int i = 0; i < samplesize + extra_samples; ++i)
+                    data->smp16[i] = lrintf(smp[i] / data->scale);
+                data->smp = NULL;
+                delete[] smp;
+            }
 
             //yield new sample
-            newsample.size     = samplesize;
-            newsample.basefreq = basefreq * basefreqadjust;
+            newsample.data = SampleData::insert(data);
             cb(nsample, std::move(newsample));
         }
 
         //Cleanup
-        delete (fft);
+        FFTwrapper::release(fft);
         delete[] fftfreqs.data;
         delete[] spectrum;
     };
@@ -1021,7 +1180,8 @@ void PADnoteParameters::export2wav(std::string basefilename)
     applyparameters();
     basefilename += "_PADsynth_";
     for(int k = 0; k < PAD_MAX_SAMPLES; ++k) {
-        if(sample[k].smp == NULL)
+        const SampleData *data = sample[k].data;
+        if(data == NULL)
             continue;
         char tmpstr[20];
         snprintf(tmpstr, 20, "_%02d", k + 1);
@@ -1031,7 +1191,9 @@ void PADnoteParameters::export2wav(std::string basefilename)
             int nsmps = sample[k].size;
             short int *smps = new short int[nsmps];
             for(int i = 0; i < nsmps; ++i)
-                smps[i] = (short int)(sample[k].smp[i] * 32767.0f);
+                smps[i] = (short int)((data->smp16 ?
+                            data->smp16[i] * data->scale : data->smp[i])
+                        * 32767.0f);
             wav.writeMonoSamples(nsmps, smps);
         }
     }
@@ -1081,6 +1243,7 @@ void PADnoteParameters::add2XML(XMLwrapper& xml)
     xml.addpar("basenote", Pquality.basenote);
     xml.addpar("octaves", Pquality.oct);
     xml.addpar("samples_per_octave", Pquality.smpoct);
+    xml.addparbool("compact", Pquality.compact);
     xml.endbranch();
 
     xml.beginbranch("AMPLITUDE_PARAMETERS");
@@ -1193,6 +1356,7 @@ void PADnoteParameters::getfromXML(XMLwrapper& xml)
         Pquality.oct    = xml.getpar127("octaves", Pquality.oct);
         Pquality.smpoct = xml.getpar127("samples_per_octave",
                                          Pquality.smpoct);
+        Pquality.compact = xml.getparbool("compact", Pquality.compact);
         xml.exitbranch();
     }
 
@@ -1290,6 +1454,7 @@ void PADnoteParameters::paste(PADnoteParameters &x)
     COPY(Pquality.basenote);
     COPY(Pquality.oct);
     COPY(Pquality.smpoct);
+    COPY(Pquality.compact);
 
     oscilgen->paste(*x.oscilgen);
     resonance->paste(*x.resonance);
@@ -19,6 +19,7 @@
 #include "Presets.h"
 #include <string>
 #include <functional>
+#include <atomic>
 #include <cstdint>
 namespace zyn {
 
@@ -97,6 +98,7 @@ class PADnoteParameters:public Presets
         struct { //quality of the samples (how many samples, the length of them,etc.)
             unsigned char samplesize;
             unsigned char basenote, oct, smpoct;
+            bool compact; //store samples as 16 bit integers
         } Pquality;
 
         //frequency parameters
@@ -163,14 +165,53 @@ class PADnoteParameters:public Presets
         void applyparameters(std::function<bool()> do_abort,
                              unsigned max_threads = 0);
         void export2wav(std::string basefilename);
+        //! Bytes used by the samples
+        //! @param shared returns the bytes also used by other kit items
+        size_t sampleMemory(size_t *shared = NULL) const;
 
         OscilGen  *oscilgen;
         Resonance *resonance;
 
+        //! Identifies the wavetable generated from a spectrum. The hash
+        //! selects the candidates and a hit also has to match the check,
+        //! a second hash of the spectrum computed independently of the first.
+        struct SpectrumKey {
+            uint64_t hash;
+            uint64_t check;
+            int      size;
+            bool     compact;
+
+            SpectrumKey(const float *spectrum, int size, bool compact);
+            bool operator==(const SpectrumKey &other) const;
+        };
+
+        //! Wavetable memory, shared by all kit items (of all parts) which
+        //! generate the same spectrum with the same size and format.
+        //! References are only taken and released by non-RT code.
+        struct SampleData {
+            SpectrumKey key;
+            std::atomic<int> refs;
+            int      size;   //!< without the extra interpolation samples
+            float   *smp;    //!< float wavetable or NULL
+            int16_t *smp16;  //!< compact wavetable or NULL
+            float    scale;  //!< factor from smp16 values to float
+
+            explicit SampleData(SpectrumKey key_)
+                :key(key_), refs(1), size(0), smp(NULL),
+                  smp16(NULL), scale(1.0f) {}
+            size_t bytes(void) const;
+            //! @return data of an equal spectrum with a new reference or NULL
+            static SampleData *find(const SpectrumKey &key);
+            //! Make data available for sharing
+            //! @return data (or an equal one, in which case data is deleted)
+            static SampleData *insert(SampleData *data);
+            static void release(SampleData *data);
+        };
+
         struct Sample {
-            int    size;
-            float  basefreq;
-            float *smp;
+            int         size;
+            float       basefreq;
+            SampleData *data;
         };
 
         //! RT sample data
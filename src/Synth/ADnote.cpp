@@ -19,6 +19,7 @@
 #include <stdint.h>
 
 #include "../globals.h"
+#include "../Misc/Denormals.h"
 #include "../Misc/Util.h"
 #include "../Misc/Allocator.h"
 #include "../Params/ADnoteParameters.h"
@@ -503,7 +504,7 @@ SynthNote *ADnote::cloneLegato(void)
 {
     SynthParams sp{memory, ctl, synth, time, velocity,
                 portamento, legato.param.note_log2_freq, true,
-                initial_seed };
+                initial_seed, modbank };
     return memory.alloc<ADnote>(&pars, sp);
 }
 
@@ -811,7 +812,7 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
     NoteGlobalPar.initparameters(pars.GlobalPar, synth,
                                  time,
                                  memory, basefreq, velocity,
-                                 stereo, wm, prefix);
+                                 stereo, wm, prefix, modbank);
 
     NoteGlobalPar.AmpEnvelope->envout_dB(); //discard the first envelope output
     globalnewamplitude = NoteGlobalPar.Volume
@@ -850,14 +851,14 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
         if(param.PAmpEnvelopeEnabled) {
             vce.AmpEnvelope = memory.alloc<Envelope>(*param.AmpEnvelope,
                     basefreq, synth.dt(), wm,
-                    (pre+"VoicePar"+nvoice+"/AmpEnvelope/").c_str);
+                    (pre+"VoicePar"+nvoice+"/AmpEnvelope/").c_str, modbank);
             vce.AmpEnvelope->envout_dB(); //discard the first envelope sample
             vce.newamplitude *= vce.AmpEnvelope->envout_dB();
         }
 
         if(param.PAmpLfoEnabled) {
             vce.AmpLfo = memory.alloc<LFO>(*param.AmpLfo, basefreq, time, wm,
-                    (pre+"VoicePar"+nvoice+"/AmpLfo/").c_str);
+                    (pre+"VoicePar"+nvoice+"/AmpLfo/").c_str, modbank);
             vce.newamplitude *= vce.AmpLfo->amplfoout();
         }
 
@@ -865,11 +866,11 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
         if(param.PFreqEnvelopeEnabled)
             vce.FreqEnvelope = memory.alloc<Envelope>(*param.FreqEnvelope,
                     basefreq, synth.dt(), wm,
-                    (pre+"VoicePar"+nvoice+"/FreqEnvelope/").c_str);
+                    (pre+"VoicePar"+nvoice+"/FreqEnvelope/").c_str, modbank);
 
         if(param.PFreqLfoEnabled)
             vce.FreqLfo = memory.alloc<LFO>(*param.FreqLfo, basefreq, time, wm,
-                    (pre+"VoicePar"+nvoice+"/FreqLfo/").c_str);
+                    (pre+"VoicePar"+nvoice+"/FreqLfo/").c_str, modbank);
 
         /* Voice Filter Parameters Init */
         if(param.PFilterEnabled) {
@@ -883,13 +884,13 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
                 vce.FilterEnvelope =
                     memory.alloc<Envelope>(*param.FilterEnvelope,
                             basefreq, synth.dt(), wm,
-                            (pre+"VoicePar"+nvoice+"/FilterEnvelope/").c_str);
+                            (pre+"VoicePar"+nvoice+"/FilterEnvelope/").c_str, modbank);
                 vce.Filter->addMod(*vce.FilterEnvelope);
             }
 
             if(param.PFilterLfoEnabled) {
                 vce.FilterLfo = memory.alloc<LFO>(*param.FilterLfo, basefreq, time, wm,
-                        (pre+"VoicePar"+nvoice+"/FilterLfo/").c_str);
+                        (pre+"VoicePar"+nvoice+"/FilterLfo/").c_str, modbank);
                 vce.Filter->addMod(*vce.FilterLfo);
             }
         }
@@ -935,7 +936,7 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
         if(param.PFMFreqEnvelopeEnabled)
             vce.FMFreqEnvelope = memory.alloc<Envelope>(*param.FMFreqEnvelope,
                     basefreq, synth.dt(), wm,
-                    (pre+"VoicePar"+nvoice+"/FMFreqEnvelope/").c_str);
+                    (pre+"VoicePar"+nvoice+"/FMFreqEnvelope/").c_str, modbank);
 
         vce.FMnewamplitude = vce.FMVolume * ctl.fmamp.relamp;
 
@@ -943,7 +944,7 @@ void ADnote::initparameters(WatchManager *wm, const char *prefix)
             vce.FMAmpEnvelope =
                 memory.alloc<Envelope>(*param.FMAmpEnvelope,
                         basefreq, synth.dt(), wm,
-                        (pre+"VoicePar"+nvoice+"/FMAmpEnvelope/").c_str);
+                        (pre+"VoicePar"+nvoice+"/FMAmpEnvelope/").c_str, modbank);
             vce.FMnewamplitude *= vce.FMAmpEnvelope->envout_dB();
         }
     }
@@ -1639,8 +1640,13 @@ inline void ADnote::ComputeVoiceDC(int nvoice)
  */
 int ADnote::noteout(float *outl, float *outr)
 {
+#if ZYN_FLUSH_DENORMALS
+    memset(outl, 0, synth.bufferbytes);
+    memset(outr, 0, synth.bufferbytes);
+#else
     memcpy(outl, synth.denormalkillbuf, synth.bufferbytes);
     memcpy(outr, synth.denormalkillbuf, synth.bufferbytes);
+#endif
 
     if(NoteEnabled == OFF)
         return 0;
@@ -2019,18 +2025,19 @@ void ADnote::Global::initparameters(const ADnoteGlobalParam &param,
                                     float basefreq, float velocity,
                                     bool stereo,
                                     WatchManager *wm,
-                                    const char *prefix)
+                                    const char *prefix,
+                                    ModulationBank *modbank)
 {
     ScratchString pre = prefix;
     FreqEnvelope = memory.alloc<Envelope>(*param.FreqEnvelope, basefreq,
-            synth.dt(), wm, (pre+"GlobalPar/FreqEnvelope/").c_str);
+            synth.dt(), wm, (pre+"GlobalPar/FreqEnvelope/").c_str, modbank);
     FreqLfo      = memory.alloc<LFO>(*param.FreqLfo, basefreq, time, wm,
-                   (pre+"GlobalPar/FreqLfo/").c_str);
+                   (pre+"GlobalPar/FreqLfo/").c_str, modbank);
 
     AmpEnvelope = memory.alloc<Envelope>(*param.AmpEnvelope, basefreq,
-            synth.dt(), wm, (pre+"GlobalPar/AmpEnvelope/").c_str);
+            synth.dt(), wm, (pre+"GlobalPar/AmpEnvelope/").c_str, modbank);
     AmpLfo      = memory.alloc<LFO>(*param.AmpLfo, basefreq, time, wm,
-                   (pre+"GlobalPar/AmpLfo/").c_str);
+                   (pre+"GlobalPar/AmpLfo/").c_str, modbank);
 
     Volume = dB2rap(param.Volume)
              * VelF(velocity, param.PAmpVelocityScaleFunction);     //sensing
@@ -2039,9 +2046,9 @@ void ADnote::Global::initparameters(const ADnoteGlobalParam &param,
             stereo, basefreq);
 
     FilterEnvelope = memory.alloc<Envelope>(*param.FilterEnvelope, basefreq,
-            synth.dt(), wm, (pre+"GlobalPar/FilterEnvelope/").c_str);
+            synth.dt(), wm, (pre+"GlobalPar/FilterEnvelope/").c_str, modbank);
     FilterLfo      = memory.alloc<LFO>(*param.FilterLfo, basefreq, time, wm,
-                   (pre+"GlobalPar/FilterLfo/").c_str);
+                   (pre+"GlobalPar/FilterLfo/").c_str, modbank);
 
     Filter->addMod(*FilterEnvelope);
     Filter->addMod(*FilterLfo);
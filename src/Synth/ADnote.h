@@ -50,6 +50,7 @@ class ADnote:public SynthNote
         void releasekey();
         bool finished() const;
         void entomb(void);
+        float getAmplitude(void) const { return globalnewamplitude; }
 
 
         virtual SynthNote *cloneLegato(void) override;
@@ -134,7 +135,8 @@ class ADnote:public SynthNote
                                 float basefreq, float velocity,
                                 bool stereo,
                                 WatchManager *wm,
-                                const char *prefix);
+                                const char *prefix,
+                                class ModulationBank *modbank);
             /******************************************
             *     FREQUENCY GLOBAL PARAMETERS        *
             ******************************************/
@@ -13,13 +13,14 @@
 
 #include <cmath>
 #include "Envelope.h"
+#include "ModulationBank.h"
 #include "../Params/EnvelopeParams.h"
 
 namespace zyn {
 
 Envelope::Envelope(EnvelopeParams &pars, float basefreq, float bufferdt,
-        WatchManager *m, const char *watch_prefix)
-    :watchOut(m, watch_prefix, "out")
+        WatchManager *m, const char *watch_prefix, ModulationBank *bank_)
+    :bank(bank_), slot(-1), watchOut(m, watch_prefix, "out")
 {
     envpoints = pars.Penvpoints;
     if(envpoints > MAX_ENVELOPE_POINTS)
@@ -79,10 +80,22 @@ Envelope::Envelope(EnvelopeParams &pars, float basefreq, float bufferdt,
     envfinish = false;
     inct      = envdt[1];
     envoutval = 0.0f;
+    startamp[0] = EnvelopeParams::env_dB2rap(envval[0]);
+    startamp[1] = EnvelopeParams::env_dB2rap(envval[1]);
+
+    //only the dB envelopes call the math library for every output
+    if(bank && mode == 2) {
+        slot = bank->addEnvelope();
+        if(slot >= 0)
+            publish();
+    }
 }
 
 Envelope::~Envelope()
-{}
+{
+    if(slot >= 0)
+        bank->removeEnvelope(slot);
+}
 
 
 /*
@@ -202,6 +215,7 @@ float Envelope::envout(bool doWatch)
         else if (repeating && currentpoint == envsustain && !keyreleased) {
             // set first value to sustain value to prevent jump
             envval[0] = envval[currentpoint];
+            startamp[0] = EnvelopeParams::env_dB2rap(envval[0]);
             // reset current point
             currentpoint = 1;
         }
@@ -220,18 +234,47 @@ float Envelope::envout(bool doWatch)
     return out;
 }
 
+/*
+ * The output of the next envout() call, it has to compute the values
+ * exactly like envout()
+ */
+float Envelope::peek() const
+{
+    if(envfinish)
+        return envval[envpoints - 1];
+    if((currentpoint == envsustain + 1) && !keyreleased)
+        return envval[envsustain];
+    if(keyreleased && forcedrelease) {
+        int releaseindex = (envsustain < 0) ? (envpoints - 1) : (envsustain + 1);
+        if(envdt[releaseindex] < 0.00000001f)
+            return envval[releaseindex];
+        return envoutval + (envval[releaseindex] - envoutval) * t;
+    }
+    if(inct >= 1.0f)
+        return envval[currentpoint];
+    return envval[currentpoint - 1]
+           + (envval[currentpoint] - envval[currentpoint - 1]) * t;
+}
+
+void Envelope::publish()
+{
+    //the linear first segment does not use the bank
+    if((currentpoint != 1) || (keyreleased && forcedrelease))
+        bank->setEnvelope(slot, peek());
+}
+
 /*
  * Envelope Output (dB)
  */
 float Envelope::envout_dB()
 {
-    float out;
+    float out, amp;
     if(linearenvelope)
         return envout(true);
 
     if((currentpoint == 1) && (!keyreleased || !forcedrelease)) { //first point is always lineary interpolated <- seems to have odd effects
-        float v1 = EnvelopeParams::env_dB2rap(envval[0]);
-        float v2 = EnvelopeParams::env_dB2rap(envval[1]);
+        float v1 = startamp[0];
+        float v2 = startamp[1];
         out = v1 + (v2 - v1) * t;
 
         t += inct;
@@ -248,12 +291,17 @@ float Envelope::envout_dB()
         else
             envoutval = MIN_ENVELOPE_DB;
         out = envoutval;
-    } else
+        amp = EnvelopeParams::env_dB2rap(out);
+    } else {
         out = envout(false);
+        if(slot < 0 || !bank->envelope(slot, out, amp))
+            amp = EnvelopeParams::env_dB2rap(out);
+    }
 
     watch(currentpoint + t, out);
-    return EnvelopeParams::env_dB2rap(out);
-
+    if(slot >= 0)
+        publish();
+    return amp;
 }
 
 bool Envelope::finished() const
@@ -25,7 +25,7 @@ class Envelope
     public:
         /**Constructor*/
         Envelope(class EnvelopeParams &pars, float basefreq, float dt, WatchManager *m=0,
-                const char *watch_prefix=0);
+                const char *watch_prefix=0, class ModulationBank *bank=0);
         /**Destructor*/
         ~Envelope(void);
         void releasekey(void);
@@ -39,6 +39,11 @@ class Envelope
         void watch(float time, float value);
 
     private:
+        /**Value the next envout() interpolates, without advancing*/
+        float peek(void) const;
+        /**Tell the bank the input of the next envout_dB()*/
+        void publish(void);
+
         int   envpoints;
         int   envsustain;    //"-1" means disabled
         float envdt[MAX_ENVELOPE_POINTS]; //seconds
@@ -55,6 +60,10 @@ class Envelope
         float t; // the time from the last point
         float inct; // the time increment
         float envoutval; //used to do the forced release
+        float startamp[2]; //amplitudes of the linear first segment
+
+        ModulationBank *bank;
+        int   slot; //in the bank, -1 if there is none
 
         VecWatchPoint watchOut;
 };
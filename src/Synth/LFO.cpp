@@ -12,6 +12,7 @@
 */
 
 #include "LFO.h"
+#include "ModulationBank.h"
 #include "../Params/LFOParams.h"
 #include "../Misc/Util.h"
 
@@ -22,7 +23,7 @@
 namespace zyn {
 
 LFO::LFO(const LFOParams &lfopars_, float basefreq_, const AbsTime &t, WatchManager *m,
-        const char *watch_prefix)
+        const char *watch_prefix, ModulationBank *bank_)
     :first_half(-1),
     time(t),
     delayTime(t, lfopars_.delay), //0..4 sec
@@ -30,7 +31,9 @@ LFO::LFO(const LFOParams &lfopars_, float basefreq_, const AbsTime &t, WatchMana
     dt(t.dt()),
     lfopars(lfopars_), 
     basefreq(basefreq_),
-    watchOut(m, watch_prefix, "out")
+    watchOut(m, watch_prefix, "out"),
+    bank(bank_),
+    slot(bank ? bank->addLfo() : -1)
 {
     updatePars();
     
@@ -57,7 +60,7 @@ LFO::LFO(const LFOParams &lfopars_, float basefreq_, const AbsTime &t, WatchMana
         case consumer_location_type_t::freq:
         case consumer_location_type_t::unspecified:
             lfointensity = powf(2, lfopars.Pintensity / 127.0f * 11.0f) - 1.0f; //in centi
-            phase -= 0.25f; //chance the starting phase
+            phase -= startOffset(); //chance the starting phase
             break;
     }
 
@@ -73,10 +76,55 @@ LFO::LFO(const LFOParams &lfopars_, float basefreq_, const AbsTime &t, WatchMana
     computeNextFreqRnd(); //twice because I want incrnd & nextincrnd to be random
     z1 = 0.0;
     z2 = 0.0;
+
+    if(slot >= 0)
+        bank->setLfo(slot, startPhase());
 }
 
 LFO::~LFO()
-{}
+{
+    if(slot >= 0)
+        bank->removeLfo(slot);
+}
+
+//Phase of the waveform with the start phase applied
+float LFO::startPhase() const
+{
+    //same as fmod(p, 1.0f), the fractional part of a float is exact
+    const float p = phase + (lfopars.Pstartphase + 63.0f) / 127.0f;
+    return p - (int)p;
+}
+
+float LFO::startOffset() const
+{
+    return lfopars.fel == consumer_location_type_t::freq
+           || lfopars.fel == consumer_location_type_t::unspecified ? 0.25f : 0.0f;
+}
+
+//All notes of a free running LFO share the phase and the output, so only the
+//first one of a control period computes them
+void LFO::sharedOut(float &phaseWithStartphase, float &out)
+{
+    LFOParams::SharedOut &s = lfopars.shared;
+    const int64_t now = time.time();
+    if(s.time != &time || s.stamp != now) {
+        if(s.time == &time && s.stamp == now - 1) {
+            s.phase += phaseInc;
+            if(s.phase >= 1)
+                s.phase = fmod(s.phase, 1.0f);
+        }
+        else //no note used it in the last period, start like a new note
+            s.phase = fmod((float)now * phaseInc, 1.0f) - startOffset();
+        s.time       = &time;
+        s.stamp      = now;
+        phase        = s.phase;
+        s.startphase = startPhase();
+        s.out        = baseOut(waveShape, s.startphase) * lfointensity;
+    }
+    phase               = s.phase;
+    phaseWithStartphase = s.startphase;
+    out                 = s.out;
+}
 
 void LFO::updatePars()
 {
@@ -215,12 +263,23 @@ float LFO::lfoout()
         float lfofreq = float(tempo) * float(lfopars.denominator)/(240.0f * float(lfopars.numerator));
         phaseInc = fabsf(lfofreq) * dt;
     }
-    float phaseWithStartphase = fmod(phase + (lfopars.Pstartphase + 63.0f) / 127.0f, 1.0f);
-    float out = baseOut(waveShape, phaseWithStartphase);
-    if(waveShape == LFO_SINE || waveShape == LFO_TRIANGLE)
-        out *= lfointensity * (amp1 + phaseWithStartphase * (amp2 - amp1));
-    else
-        out *= lfointensity * amp2;
+    //notes created with random values keep computing their own
+    const bool shared = deterministic && lfornd == 0.0f
+                        && lfopars.freerunning();
+    float phaseWithStartphase;
+    float out;
+    if(shared)
+        sharedOut(phaseWithStartphase, out);
+    else {
+        phaseWithStartphase = startPhase();
+        if(waveShape != LFO_SINE || slot < 0
+           || !bank->lfo(slot, phaseWithStartphase, out))
+            out = baseOut(waveShape, phaseWithStartphase);
+        if(waveShape == LFO_SINE || waveShape == LFO_TRIANGLE)
+            out *= lfointensity * (amp1 + phaseWithStartphase * (amp2 - amp1));
+        else
+            out *= lfointensity * amp2;
+    }
     
     
     // handle lfo state (delay, fade in, fade out)
@@ -288,6 +347,8 @@ float LFO::lfoout()
 
         computeNextFreqRnd();
     }
+    if(slot >= 0 && waveShape == LFO_SINE && !shared)
+        bank->setLfo(slot, startPhase());
             
     float watch_data[2] = {phaseWithStartphase, out};
     watchOut(watch_data, 2);
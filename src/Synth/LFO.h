@@ -32,7 +32,7 @@ class LFO
          * @param basefreq base frequency of LFO
          */
         LFO(const LFOParams &lfopars_, float basefreq_, const AbsTime &t, WatchManager *m=0,
-                const char *watch_prefix=0);
+                const char *watch_prefix=0, class ModulationBank *bank=0);
         ~LFO();
 
         float lfoout();
@@ -47,6 +47,9 @@ class LFO
         } lfo_state_type;
     
         float baseOut(const char waveShape, const float phase);
+        float startPhase(void) const;
+        float startOffset(void) const;
+        void sharedOut(float &phaseWithStartphase, float &out);
         float biquad(float input);
         void updatePars();
         
@@ -111,6 +114,9 @@ class LFO
 
         VecWatchPoint watchOut;
 
+        ModulationBank *bank;
+        int slot; //in the bank, -1 if there is none
+
         void computeNextFreqRnd(void);
 };
 
@@ -29,10 +29,11 @@ ModFilter::ModFilter(const FilterParams &pars_,
                      const SYNTH_T      &synth_,
                      const AbsTime      &time_,
                            Allocator    &alloc_,
-                           bool         stereo,
+                           bool         stereo_,
                            float        notefreq)
     :pars(pars_), synth(synth_), time(time_), alloc(alloc_),
     noteFreq(notefreq),
+    stereo(stereo_),
     left(nullptr),
     right(nullptr),
     env(nullptr),
@@ -46,8 +47,7 @@ ModFilter::ModFilter(const FilterParams &pars_,
             synth.samplerate, synth.buffersize);
 
     if(stereo)
-        right = Filter::generate(alloc, &pars,
-                synth.samplerate, synth.buffersize);
+        stereoUpdate();
 }
 
 ModFilter::~ModFilter(void)
@@ -69,10 +69,15 @@ void ModFilter::addMod(Envelope &env_)
 //Recompute Filter Parameters
 void ModFilter::update(float relfreq, float relq)
 {
-    if(pars.last_update_timestamp == time.time()) {
+    //the parameters are stamped with their own clock, which runs slower
+    //than the note one when notes use a shorter control period
+    if(pars.last_update_timestamp == (pars.time ? pars.time->time()
+                                                : time.time())) {
         paramUpdate(left);
         if(right)
             paramUpdate(right);
+        if(stereo)
+            stereoUpdate();
 
         baseFreq = pars.getfreq();
         baseQ    = pars.getq();
@@ -112,6 +117,11 @@ void ModFilter::updateSense(float velocity, uint8_t scale,
 
 void ModFilter::filter(float *l, float *r)
 {
+    if(stereo && !right) {
+        if(l && r)
+            static_cast<AnalogFilter*>(left)->filterout(l, r);
+        return;
+    }
     if(left && l)
         left->filterout(l);
     if(right && r)
@@ -158,6 +168,16 @@ void ModFilter::paramUpdate(Filter *&f)
         cbParamUpdate(*cb);
 }
 
+void ModFilter::stereoUpdate(void)
+{
+    const bool linked = dynamic_cast<AnalogFilter*>(left);
+    if(linked && right)
+        alloc.dealloc(right);
+    else if(!linked && !right)
+        right = Filter::generate(alloc, &pars,
+                synth.samplerate, synth.buffersize);
+}
+
 void ModFilter::svParamUpdate(SVFilter &sv)
 {
     sv.settype(pars.Ptype);
@@ -43,6 +43,8 @@ class ModFilter
         void filter(float *l, float *r);
     private:
         void paramUpdate(Filter *&f);
+        //Analog filters handle both channels, others need one per channel
+        void stereoUpdate(void);
         void svParamUpdate(SVFilter &sv);
         void anParamUpdate(AnalogFilter &an);
         void mgParamUpdate(MoogFilter &mg);
@@ -62,7 +64,8 @@ class ModFilter
         smooth_float sense;    //shift due to note velocity
 
 
-        Filter       *left; //left  channel filter
+        bool          stereo;
+        Filter       *left; //left  channel filter (or both if right is null)
         Filter       *right;//right channel filter
         Envelope     *env;  //center freq envelope
         LFO          *lfo;  //center freq lfo
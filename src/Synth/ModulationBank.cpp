@@ -0,0 +1,107 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ModulationBank.cpp - Batched evaluation of envelopes and LFOs
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#include <cmath>
+#include "ModulationBank.h"
+#include "../Misc/Allocator.h"
+#include "../globals.h"
+
+namespace zyn {
+
+ModulationBank::ModulationBank(Allocator &memory_, int size_)
+    :memory(memory_), size(size_)
+{
+    init(env);
+    init(lfos);
+}
+
+ModulationBank::~ModulationBank()
+{
+    destroy(env);
+    destroy(lfos);
+}
+
+void ModulationBank::init(Slots &s)
+{
+    s.in        = memory.valloc<float>(size);
+    s.key       = memory.valloc<float>(size);
+    s.out       = memory.valloc<float>(size);
+    s.freeslots = memory.valloc<int>(size);
+    s.nfree     = 0;
+    s.top       = 0;
+    for(int i = 0; i < size; ++i)
+        s.in[i] = s.key[i] = s.out[i] = 0.0f;
+}
+
+void ModulationBank::destroy(Slots &s)
+{
+    memory.devalloc(size, s.in);
+    memory.devalloc(size, s.key);
+    memory.devalloc(size, s.out);
+    memory.devalloc(size, s.freeslots);
+}
+
+int ModulationBank::add(Slots &s)
+{
+    if(s.nfree)
+        return s.freeslots[--s.nfree];
+    if(s.top < size)
+        return s.top++;
+    return -1;
+}
+
+void ModulationBank::remove(Slots &s, int slot)
+{
+    s.freeslots[s.nfree++] = slot;
+    if(s.nfree == s.top) //all free, tick() does not have to visit any
+        s.nfree = s.top = 0;
+}
+
+int ModulationBank::addEnvelope(void)
+{
+    return add(env);
+}
+
+void ModulationBank::removeEnvelope(int slot)
+{
+    remove(env, slot);
+}
+
+int ModulationBank::addLfo(void)
+{
+    return add(lfos);
+}
+
+void ModulationBank::removeLfo(int slot)
+{
+    remove(lfos, slot);
+}
+
+void ModulationBank::tick(void)
+{
+    //EnvelopeParams::env_dB2rap(), with exp() and single precision
+    //constants to stay in the fast vector functions
+    const float ln10 = logf(10.0f);
+    const Slots e    = env;
+    for(int i = 0; i < e.top; ++i) {
+        e.key[i] = e.in[i];
+        e.out[i] = (expf(e.in[i] * (ln10 / 20.0f)) - 0.01f) / 0.99f;
+    }
+
+    //the sine of LFO::baseOut()
+    const Slots l = lfos;
+    for(int i = 0; i < l.top; ++i) {
+        l.key[i] = l.in[i];
+        l.out[i] = cosf(l.in[i] * 2.0f * PI);
+    }
+}
+
+}
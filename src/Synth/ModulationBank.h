@@ -0,0 +1,94 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ModulationBank.h - Batched evaluation of envelopes and LFOs
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+
+#ifndef MODULATION_BANK_H
+#define MODULATION_BANK_H
+
+namespace zyn {
+
+class Allocator;
+
+/**
+ * Evaluates the math of the envelopes and LFOs of all notes of a part in
+ * one pass
+ *
+ * Every amplitude envelope converts its output from dB and every sine LFO
+ * computes a cosine, which are calls to the math library per object and
+ * control period. The objects keep their state and control flow, but
+ * publish the input of their next evaluation to a slot of the bank. tick()
+ * evaluates all slots over contiguous arrays, where the compiler uses the
+ * vector versions of the math functions, and the objects take the result
+ * when their input still matches. Otherwise they compute it themselves, so
+ * the output only differs in the rounding of the vector math functions.
+ */
+class ModulationBank
+{
+    public:
+        ModulationBank(Allocator &memory, int size = 512);
+        ~ModulationBank();
+
+        /**@return a free slot or -1 if all of them are used*/
+        int  addEnvelope(void);
+        void removeEnvelope(int slot);
+        int  addLfo(void);
+        void removeLfo(int slot);
+
+        /**Evaluate all slots, once per control period before the notes*/
+        void tick(void);
+
+        /**Publish the next output of an envelope in dB*/
+        void setEnvelope(int slot, float dB) { env.in[slot] = dB; }
+
+        /**Amplitude for the dB value if tick() computed it*/
+        bool envelope(int slot, float dB, float &amp) const
+        {
+            if(env.key[slot] != dB)
+                return false;
+            amp = env.out[slot];
+            return true;
+        }
+
+        /**Publish the next phase of a LFO*/
+        void setLfo(int slot, float phase) { lfos.in[slot] = phase; }
+
+        /**Sine for the phase if tick() computed it*/
+        bool lfo(int slot, float phase, float &out) const
+        {
+            if(lfos.key[slot] != phase)
+                return false;
+            out = lfos.out[slot];
+            return true;
+        }
+
+    private:
+        ModulationBank(const ModulationBank &) = delete;
+        ModulationBank &operator=(const ModulationBank &) = delete;
+
+        //structure of arrays, indexed by slot
+        struct Slots {
+            float *in, *key, *out;
+            int   *freeslots;
+            int    nfree, top;
+        };
+
+        void init(Slots &s);
+        void destroy(Slots &s);
+        int  add(Slots &s);
+        void remove(Slots &s, int slot);
+
+        Allocator &memory;
+        const int  size;
+        Slots      env, lfos;
+};
+
+}
+
+#endif
@@ -21,8 +21,13 @@
 #include <cstdlib>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <cstddef>
 #include <complex>
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <vector>
 
 #include <unistd.h>
 
@@ -186,6 +191,7 @@ const rtosc::Ports OscilGen::non_realtime_ports = {
                     obj->myBuffers().basefuncFFTfreqs[i+1] =
                         fft_t(buf[2*i], buf[2*i+1]);
                 }
+                obj->myBuffers().stages.harmonics = false;
                 // TODO: Simplify this code section when merging with WT branch
                 char  repath[128];
                 strcpy(repath, data.loc);
@@ -305,6 +311,7 @@ const rtosc::Ports OscilGen::realtime_ports{
             d.reply("/free", "sb", "fft_t", sizeof(void*), &bfrs.oscilFFTfreqs.data);
             assert(bfrs.oscilFFTfreqs.data !=*(fft_t**)rtosc_argument(m,0).b.data);
             bfrs.oscilFFTfreqs.data = *(fft_t**)rtosc_argument(m,0).b.data;
+            bfrs.cachedoscilnyquist = -1;
         }},
 
 };
@@ -409,7 +416,12 @@ OscilGenBuffers::OscilGenBuffers(zyn::OscilGenBuffersCreator c) :
     cachedbasefunc(ctorAllocSamples(c.fft, c.oscilsize)),
     cachedbasevalid(false),
     basefuncFFTfreqs(ctorAllocFreqs(c.fft, c.oscilsize)),
-    scratchFreqs(ctorAllocFreqs(c.fft, c.oscilsize))
+    scratchFreqs(ctorAllocFreqs(c.fft, c.oscilsize)),
+    cachedoscil(ctorAllocSamples(c.fft, c.oscilsize)),
+    cachedoscilsrc(nullptr),
+    cachedoscilnyquist(-1),
+    harmonicsFFTfreqs(ctorAllocFreqs(c.fft, c.oscilsize)),
+    shapedFFTfreqs(ctorAllocFreqs(c.fft, c.oscilsize))
 {
     defaults();
 }
@@ -422,6 +434,9 @@ OscilGenBuffers::~OscilGenBuffers()
     delete[] oscilFFTfreqs.data;
     delete[] cachedbasefunc.data;
     delete[] scratchFreqs.data;
+    delete[] cachedoscil.data;
+    delete[] harmonicsFFTfreqs.data;
+    delete[] shapedFFTfreqs.data;
 }
 
 zyn::OscilGenBuffersCreator OscilGen::createOscilGenBuffers() const
@@ -453,9 +468,12 @@ void OscilGenBuffers::defaults()
 
     clearAll(oscilFFTfreqs.data, oscilsize);
     clearAll(basefuncFFTfreqs.data, oscilsize);
+    cachedoscilnyquist = -1;
     oscilprepared = 0;
     oldfilterpars = 0;
     oldsapars     = 0;
+    stages.harmonics = false;
+    stages.shaped    = false;
 }
 
 OscilGen::OscilGen(const SYNTH_T &synth_, FFTwrapper *fft_, const Resonance *res_)
@@ -535,11 +553,11 @@ void OscilGen::convert2sine()
     float  mag[MAX_AD_HARMONICS], phase[MAX_AD_HARMONICS];
 
     {
-        FFTwrapper *fft = new FFTwrapper(synth.oscilsize);
+        FFTwrapper *fft = FFTwrapper::acquire(synth.oscilsize);
         FFTsampleBuffer oscil = fft->allocSampleBuf();
         get(oscil.data, -1.0f);
         fft->smps2freqs_noconst_input(oscil, bfrs.scratchFreqs);
-        delete (fft);
+        FFTwrapper::release(fft);
     }
 
     normalize(bfrs.scratchFreqs.data, synth.oscilsize);
@@ -672,6 +690,8 @@ void OscilGen::changebasefunction(OscilGenBuffers& bfrs) const
         if(Pcurrentbasefunc == 127 && !Pbasefuncmodulation) {
             // this would be a no-op, skip it
         }
+        else if(Pcurrentbasefunc != 127 && fft)
+            basefunctionspectrum(bfrs);
         else {
             getbasefunction(bfrs, bfrs.tmpsmps);
             if(fft)
@@ -681,7 +701,8 @@ void OscilGen::changebasefunction(OscilGenBuffers& bfrs) const
     }
     else //in this case bfrs.basefuncFFTfreqs are not used
         clearAll(bfrs.basefuncFFTfreqs.data, synth.oscilsize);
-    bfrs.oscilprepared = 0;
+    bfrs.oscilprepared    = 0;
+    bfrs.stages.harmonics = false;
     bfrs.oldbasefunc   = Pcurrentbasefunc;
     bfrs.oldbasepar    = Pbasefuncpar;
     bfrs.oldbasefuncmodulation     = Pbasefuncmodulation;
@@ -690,6 +711,47 @@ void OscilGen::changebasefunction(OscilGenBuffers& bfrs) const
     bfrs.oldbasefuncmodulationpar3 = Pbasefuncmodulationpar3;
 }
 
+//Spectra of the built in base functions, most recently used first. They only
+//depend on the parameters in the key, so voices and parts with the same base
+//function share them
+struct BaseFuncSpectrum {
+    int key[7]; //oscilsize, function, parameter, modulation and its parameters
+    std::vector<fft_t> freqs;
+};
+static std::mutex basefunc_lock;
+static std::list<BaseFuncSpectrum> basefunc_cache;
+static const size_t basefunc_cache_size = 64;
+
+void OscilGen::basefunctionspectrum(OscilGenBuffers& bfrs) const
+{
+    const int key[7] = {synth.oscilsize, Pcurrentbasefunc, Pbasefuncpar,
+                        Pbasefuncmodulation, Pbasefuncmodulationpar1,
+                        Pbasefuncmodulationpar2, Pbasefuncmodulationpar3};
+    const int n = synth.oscilsize / 2 + 1;
+    {
+        std::lock_guard<std::mutex> guard(basefunc_lock);
+        for(auto itr = basefunc_cache.begin(); itr != basefunc_cache.end(); ++itr)
+            if(std::equal(key, key + 7, itr->key)) {
+                std::copy_n(itr->freqs.begin(), n, bfrs.basefuncFFTfreqs.data);
+                basefunc_cache.splice(basefunc_cache.begin(), basefunc_cache, itr);
+                return;
+            }
+    }
+
+    //computed without the lock, concurrent misses only add a duplicate
+    getbasefunction(bfrs, bfrs.tmpsmps);
+    fft->smps2freqs_noconst_input(bfrs.tmpsmps, bfrs.basefuncFFTfreqs);
+
+    std::lock_guard<std::mutex> guard(basefunc_lock);
+    basefunc_cache.emplace_front();
+    BaseFuncSpectrum &entry = basefunc_cache.front();
+    std::copy_n(key, 7, entry.key);
+    entry.freqs.assign(bfrs.basefuncFFTfreqs.data,
+                       bfrs.basefuncFFTfreqs.data + n);
+    if(basefunc_cache.size() > basefunc_cache_size)
+        basefunc_cache.pop_back();
+}
+
 inline void normalize(float *smps, size_t N)
 {
     //Find max
@@ -913,6 +975,9 @@ void OscilGen::prepare(OscilGenBuffers& bfrs) const
 
 void OscilGen::prepare(OscilGenBuffers& bfrs, FFTfreqBuffer freqs) const
 {
+    if(freqs.data == bfrs.oscilFFTfreqs.data)
+        bfrs.cachedoscilnyquist = -1;
+
     if((bfrs.oldbasepar != Pbasefuncpar) || (bfrs.oldbasefunc != Pcurrentbasefunc)
        || DIFF(basefuncmodulation) || DIFF(basefuncmodulationpar1)
        || DIFF(basefuncmodulationpar2) || DIFF(basefuncmodulationpar3))
@@ -951,37 +1016,70 @@ void OscilGen::prepare(OscilGenBuffers& bfrs, FFTfreqBuffer freqs) const
             bfrs.hmag[i] = 0.0f;
 
 
-    clearAll(freqs.data, synth.oscilsize);
-    if(Pcurrentbasefunc == 0)   //the sine case
-        for(int i = 0; i < MAX_AD_HARMONICS - 1; ++i) {
-            freqs[i + 1] =
-                std::complex<float>(-bfrs.hmag[i] * sinf(bfrs.hphase[i] * (i + 1)) / 2.0f,
-                        bfrs.hmag[i] * cosf(bfrs.hphase[i] * (i + 1)) / 2.0f);
-        }
-    else
-        for(int j = 0; j < MAX_AD_HARMONICS; ++j) {
-            if(Phmag[j] == 64)
-                continue;
-            for(int i = 1; i < synth.oscilsize / 2; ++i) {
-                int k = i * (j + 1);
-                if(k >= synth.oscilsize / 2)
-                    break;
-                freqs[k] += bfrs.basefuncFFTfreqs[i] * FFTpolar<fftwf_real>(
-                    bfrs.hmag[j],
-                    bfrs.hphase[j] * k);
+    //every stage only depends on the previous one and its parameters, so
+    //the intermediate spectra are kept until something before them changes
+    OscilGenBuffers::Stages &st = bfrs.stages;
+    const int n = synth.oscilsize / 2;
+    if(!st.harmonics || st.hmagtype != Phmagtype
+       || st.basefunc != Pcurrentbasefunc
+       || memcmp(st.hmag, Phmag, sizeof(Phmag))
+       || memcmp(st.hphase, Phphase, sizeof(Phphase))) {
+        FFTfreqBuffer &sum = bfrs.harmonicsFFTfreqs;
+        clearAll(sum.data, synth.oscilsize);
+        if(Pcurrentbasefunc == 0)   //the sine case
+            for(int i = 0; i < MAX_AD_HARMONICS - 1; ++i) {
+                sum[i + 1] =
+                    std::complex<float>(-bfrs.hmag[i] * sinf(bfrs.hphase[i] * (i + 1)) / 2.0f,
+                            bfrs.hmag[i] * cosf(bfrs.hphase[i] * (i + 1)) / 2.0f);
+            }
+        else
+            for(int j = 0; j < MAX_AD_HARMONICS; ++j) {
+                if(Phmag[j] == 64)
+                    continue;
+                for(int i = 1; i < synth.oscilsize / 2; ++i) {
+                    int k = i * (j + 1);
+                    if(k >= synth.oscilsize / 2)
+                        break;
+                    sum[k] += bfrs.basefuncFFTfreqs[i] * FFTpolar<fftwf_real>(
+                        bfrs.hmag[j],
+                        bfrs.hphase[j] * k);
+                }
             }
-        }
 
-    if(Pharmonicshiftfirst != 0)
-        shiftharmonics(freqs.data);
+        memcpy(st.hmag, Phmag, sizeof(Phmag));
+        memcpy(st.hphase, Phphase, sizeof(Phphase));
+        st.hmagtype  = Phmagtype;
+        st.basefunc  = Pcurrentbasefunc;
+        st.harmonics = true;
+        st.shaped    = false;
+    }
 
-    if(Pfilterbeforews) {
-        oscilfilter(freqs.data);
-        waveshape(bfrs, freqs);
-    } else {
-        waveshape(bfrs, freqs);
-        oscilfilter(freqs.data);
+    const int shiftfirst  = Pharmonicshiftfirst ? Pharmonicshift : 0;
+    const int filterpars  = Pfiltertype * 256 + Pfilterpar1 + Pfilterpar2 * 65536
+                            + Pfilterbeforews * 16777216;
+    const int waveshaping = Pwaveshapingfunction * 256 + Pwaveshaping;
+    if(!st.shaped || st.shiftfirst != shiftfirst
+       || st.filterpars != filterpars || st.waveshaping != waveshaping) {
+        FFTfreqBuffer &shaped = bfrs.shapedFFTfreqs;
+        std::copy_n(bfrs.harmonicsFFTfreqs.data, n, shaped.data);
+
+        if(Pharmonicshiftfirst != 0)
+            shiftharmonics(shaped.data);
+
+        if(Pfilterbeforews) {
+            oscilfilter(shaped.data);
+            waveshape(bfrs, shaped);
+        } else {
+            waveshape(bfrs, shaped);
+            oscilfilter(shaped.data);
+        }
+
+        st.shiftfirst  = shiftfirst;
+        st.filterpars  = filterpars;
+        st.waveshaping = waveshaping;
+        st.shaped      = true;
     }
+    std::copy_n(bfrs.shapedFFTfreqs.data, n, freqs.data);
 
     modulation(bfrs, freqs);
     spectrumadjust(freqs.data);
@@ -1157,6 +1255,19 @@ short int OscilGen::get(OscilGenBuffers& bfrs, float* smps, float freqHz, int re
     if(nyquist > synth.oscilsize / 2)
         nyquist = synth.oscilsize / 2;
 
+    //Without adaptive harmonics, randomness and resonance the result only
+    //depends on the band limit, so repeating the last one skips the IFFT
+    const bool reusable = (freqHz > 0.0f) && (!ADvsPAD)
+                          && (Padaptiveharmonics == 0) && (Prand <= 64)
+                          && (Pamprandtype == 0)
+                          && (resonance == 0 || !res || res->Penabled == 0);
+    if(reusable && bfrs.cachedoscilnyquist == nyquist
+       && bfrs.cachedoscilsrc == input) {
+        memcpy(smps, bfrs.cachedoscil.data, synth.oscilsize * sizeof(float));
+        sprng(realrnd + 1);
+        return Prand < 64 ? outpos : 0;
+    }
+
     //Process harmonics
     {
         int realnyquist = nyquist;
@@ -1221,6 +1332,12 @@ short int OscilGen::get(OscilGenBuffers& bfrs, float* smps, float freqHz, int re
         fft->freqs2smps(bfrs.outoscilFFTfreqs, bfrs.tmpsmps, bfrs.scratchFreqs);
         for(int i = 0; i < synth.oscilsize; ++i)
             smps[i] = bfrs.tmpsmps[i] * 0.25f;            //correct the amplitude
+
+        if(reusable) {
+            memcpy(bfrs.cachedoscil.data, smps, synth.oscilsize * sizeof(float));
+            bfrs.cachedoscilsrc     = input;
+            bfrs.cachedoscilnyquist = nyquist;
+        }
     }
 
     sprng(realrnd + 1);
@@ -1303,6 +1420,7 @@ void OscilGen::useasbase()
         bfrs.basefuncFFTfreqs[i] = bfrs.oscilFFTfreqs[i];
 
     bfrs.oldbasefunc = Pcurrentbasefunc = 127;
+    bfrs.stages.harmonics = false;
     prepare(bfrs);
     bfrs.cachedbasevalid = false;
 }
@@ -1426,6 +1544,7 @@ void OscilGen::add2XML(XMLwrapper& xml)
 
     if(Pcurrentbasefunc == 127) {
         normalize(bfrs.basefuncFFTfreqs.data, synth.oscilsize);
+        myBuffers().stages.harmonics = false;
 
         xml.beginbranch("BASE_FUNCTION");
         for(int i = 1; i < synth.oscilsize / 2; ++i) {
@@ -1539,7 +1658,8 @@ void OscilGen::getfromXML(XMLwrapper& xml)
 
         clearDC(bfrs.basefuncFFTfreqs.data);
         normalize(bfrs.basefuncFFTfreqs.data, synth.oscilsize);
-        bfrs.cachedbasevalid = false;
+        bfrs.cachedbasevalid  = false;
+        bfrs.stages.harmonics = false;
     }
 }
 
@@ -67,6 +67,13 @@ private:
     FFTfreqBuffer basefuncFFTfreqs; //Base function frequencies
     FFTfreqBuffer scratchFreqs; //Yet another tmp buffer
 
+    //Last oscillator computed by get() without per note randomness,
+    //so following notes with the same band limit can copy it. Only one
+    //band limit is kept: the notes of a chord each compute their own.
+    FFTsampleBuffer cachedoscil;
+    const fft_t *cachedoscilsrc;
+    int cachedoscilnyquist; //-1 if invalid
+
     //Internal Data
     unsigned char oldbasefunc, oldbasepar, oldhmagtype,
                   oldwaveshapingfunction, oldwaveshaping;
@@ -78,6 +85,19 @@ private:
 
     int    oscilprepared;   //1 if the oscil is prepared, 0 if it is not prepared and is need to call ::prepare() before ::get()
 
+    //Intermediate spectra of prepare(), so editing a later stage does not
+    //compute the earlier ones again
+    FFTfreqBuffer harmonicsFFTfreqs; //sum of the harmonics
+    FFTfreqBuffer shapedFFTfreqs;    //after the filter and the waveshaping
+
+    //Parameters the intermediate spectra were computed with
+    struct Stages {
+        bool          harmonics, shaped; //false if they have to be computed
+        unsigned char hmag[MAX_AD_HARMONICS], hphase[MAX_AD_HARMONICS];
+        unsigned char hmagtype, basefunc;
+        int           shiftfirst, filterpars, waveshaping;
+    } stages;
+
     float hmag[MAX_AD_HARMONICS], hphase[MAX_AD_HARMONICS]; //the magnituides and the phases of the sine/nonsine harmonics
 };
 
@@ -196,6 +216,8 @@ class OscilGen:public Presets, NoCopyNoMove
         FFTwrapper *fft;
         //computes the basefunction and make the FFT; newbasefunc<0  = same basefunc
         void changebasefunction(OscilGenBuffers& bfrs) const;
+        //spectrum of a built in base function, shared by all instances
+        void basefunctionspectrum(OscilGenBuffers& bfrs) const;
         //Waveshaping
         void waveshape(OscilGenBuffers& bfrs, FFTfreqBuffer freqs) const;
 
@@ -91,7 +91,7 @@ void PADnote::setup(float velocity_,
     float mindist = fabsf(log2freq - log2f(pars.sample[0].basefreq + 0.0001f));
     nsample = 0;
     for(int i = 1; i < PAD_MAX_SAMPLES; ++i) {
-        if(pars.sample[i].smp == NULL)
+        if(pars.sample[i].data == NULL)
             break;
         const float dist = fabsf(log2freq - log2f(pars.sample[i].basefreq + 0.0001f));
 
@@ -146,17 +146,17 @@ void PADnote::setup(float velocity_,
 
         NoteGlobalPar.FreqEnvelope =
             memory.alloc<Envelope>(*pars.FreqEnvelope, basefreq, synth.dt(),
-                    wm, (pre+"FreqEnvelope/").c_str);
+                    wm, (pre+"FreqEnvelope/").c_str, modbank);
         NoteGlobalPar.FreqLfo      =
             memory.alloc<LFO>(*pars.FreqLfo, basefreq, time,
-                    wm, (pre+"FreqLfo/").c_str);
+                    wm, (pre+"FreqLfo/").c_str, modbank);
 
         NoteGlobalPar.AmpEnvelope =
             memory.alloc<Envelope>(*pars.AmpEnvelope, basefreq, synth.dt(),
-                    wm, (pre+"AmpEnvelope/").c_str);
+                    wm, (pre+"AmpEnvelope/").c_str, modbank);
         NoteGlobalPar.AmpLfo      =
             memory.alloc<LFO>(*pars.AmpLfo, basefreq, time,
-                    wm, (pre+"AmpLfo/").c_str);
+                    wm, (pre+"AmpLfo/").c_str, modbank);
     }
 
     NoteGlobalPar.Volume = 4.0f
@@ -181,9 +181,9 @@ void PADnote::setup(float velocity_,
 
         //setup mod
         env = memory.alloc<Envelope>(*pars.FilterEnvelope, basefreq,
-                synth.dt(), wm, (pre+"FilterEnvelope/").c_str);
+                synth.dt(), wm, (pre+"FilterEnvelope/").c_str, modbank);
         lfo = memory.alloc<LFO>(*pars.FilterLfo, basefreq, time,
-                wm, (pre+"FilterLfo/").c_str);
+                wm, (pre+"FilterLfo/").c_str, modbank);
         flt->addMod(*env);
         flt->addMod(*lfo);
     }
@@ -195,7 +195,7 @@ void PADnote::setup(float velocity_,
         flt.updateNoteFreq(basefreq);
     }
 
-    if(!pars.sample[nsample].smp) {
+    if(!pars.sample[nsample].data) {
         finished_ = true;
         return;
     }
@@ -204,7 +204,8 @@ void PADnote::setup(float velocity_,
 SynthNote *PADnote::cloneLegato(void)
 {
     SynthParams sp{memory, ctl, synth, time, velocity,
-                   portamento, legato.param.note_log2_freq, true, legato.param.seed};
+                   portamento, legato.param.note_log2_freq, true, legato.param.seed,
+                   modbank};
     return memory.alloc<PADnote>(&pars, sp, interpolation);
 }
 
@@ -280,16 +281,42 @@ void PADnote::computecurrentparameters()
 }
 
 
+//Compact wavetables are decoded while interpolating
+static inline float smpval(const float *smps, int i)
+{
+    return smps[i];
+}
+
+static inline float smpval(const int16_t *smps, int i)
+{
+    return smps[i];
+}
+
 int PADnote::Compute_Linear(float *outl,
                             float *outr,
                             int freqhi,
                             float freqlo)
 {
-    const float *smps = pars.sample[nsample].smp;
-    if(smps == NULL) {
+    const PADnoteParameters::SampleData *data = pars.sample[nsample].data;
+    if(data == NULL) {
         finished_ = true;
         return 1;
     }
+    if(data->smp16)
+        Compute_Linear(data->smp16, data->scale, outl, outr, freqhi, freqlo);
+    else
+        Compute_Linear(data->smp, 1.0f, outl, outr, freqhi, freqlo);
+    return 1;
+}
+
+template<class T>
+void PADnote::Compute_Linear(const T *smps,
+                             float scale,
+                             float *outl,
+                             float *outr,
+                             int freqhi,
+                             float freqlo)
+{
     int size = pars.sample[nsample].size;
     for(int i = 0; i < synth.buffersize; ++i) {
         poshi_l += freqhi;
@@ -305,21 +332,38 @@ int PADnote::Compute_Linear(float *outl,
         if(poshi_r >= size)
             poshi_r %= size;
 
-        outl[i] = smps[poshi_l] * (1.0f - poslo) + smps[poshi_l + 1] * poslo;
-        outr[i] = smps[poshi_r] * (1.0f - poslo) + smps[poshi_r + 1] * poslo;
+        outl[i] = (smpval(smps, poshi_l) * (1.0f - poslo)
+                   + smpval(smps, poshi_l + 1) * poslo) * scale;
+        outr[i] = (smpval(smps, poshi_r) * (1.0f - poslo)
+                   + smpval(smps, poshi_r + 1) * poslo) * scale;
     }
-    return 1;
 }
+
 int PADnote::Compute_Cubic(float *outl,
                            float *outr,
                            int freqhi,
                            float freqlo)
 {
-    float *smps = pars.sample[nsample].smp;
-    if(smps == NULL) {
+    const PADnoteParameters::SampleData *data = pars.sample[nsample].data;
+    if(data == NULL) {
         finished_ = true;
         return 1;
     }
+    if(data->smp16)
+        Compute_Cubic(data->smp16, data->scale, outl, outr, freqhi, freqlo);
+    else
+        Compute_Cubic(data->smp, 1.0f, outl, outr, freqhi, freqlo);
+    return 1;
+}
+
+template<class T>
+void PADnote::Compute_Cubic(const T *smps,
+                            float scale,
+                            float *outl,
+                            float *outr,
+                            int freqhi,
+                            float freqlo)
+{
     int   size = pars.sample[nsample].size;
     float xm1, x0, x1, x2, a, b, c;
     for(int i = 0; i < synth.buffersize; ++i) {
@@ -338,33 +382,31 @@ int PADnote::Compute_Cubic(float *outl,
 
 
         //left
-        xm1     = smps[poshi_l];
-        x0      = smps[poshi_l + 1];
-        x1      = smps[poshi_l + 2];
-        x2      = smps[poshi_l + 3];
+        xm1     = smpval(smps, poshi_l);
+        x0      = smpval(smps, poshi_l + 1);
+        x1      = smpval(smps, poshi_l + 2);
+        x2      = smpval(smps, poshi_l + 3);
         a       = (3.0f * (x0 - x1) - xm1 + x2) * 0.5f;
         b       = 2.0f * x1 + xm1 - (5.0f * x0 + x2) * 0.5f;
         c       = (x1 - xm1) * 0.5f;
-        outl[i] = (((a * poslo) + b) * poslo + c) * poslo + x0;
+        outl[i] = ((((a * poslo) + b) * poslo + c) * poslo + x0) * scale;
         //right
-        xm1     = smps[poshi_r];
-        x0      = smps[poshi_r + 1];
-        x1      = smps[poshi_r + 2];
-        x2      = smps[poshi_r + 3];
+        xm1     = smpval(smps, poshi_r);
+        x0      = smpval(smps, poshi_r + 1);
+        x1      = smpval(smps, poshi_r + 2);
+        x2      = smpval(smps, poshi_r + 3);
         a       = (3.0f * (x0 - x1) - xm1 + x2) * 0.5f;
         b       = 2.0f * x1 + xm1 - (5.0f * x0 + x2) * 0.5f;
         c       = (x1 - xm1) * 0.5f;
-        outr[i] = (((a * poslo) + b) * poslo + c) * poslo + x0;
+        outr[i] = ((((a * poslo) + b) * poslo + c) * poslo + x0) * scale;
     }
-    return 1;
 }
 
 
 int PADnote::noteout(float *outl, float *outr)
 {
     computecurrentparameters();
-    float *smps = pars.sample[nsample].smp;
-    if(smps == NULL) {
+    if(pars.sample[nsample].data == NULL) {
         for(int i = 0; i < synth.buffersize; ++i) {
             outl[i] = 0.0f;
             outr[i] = 0.0f;
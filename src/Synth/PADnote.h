@@ -34,6 +34,7 @@ class PADnote:public SynthNote
         int noteout(float *outl, float *outr);
         bool finished() const;
         void entomb(void);
+        float getAmplitude(void) const { return globalnewamplitude; }
 
         VecWatchPoint watch_int,watch_punch, watch_amp_int, watch_legato;
 
@@ -65,6 +66,13 @@ class PADnote:public SynthNote
                           float *outr,
                           int freqhi,
                           float freqlo);
+        //Interpolation of float or compact (16 bit) wavetables
+        template<class T>
+        void Compute_Linear(const T *smps, float scale, float *outl,
+                            float *outr, int freqhi, float freqlo);
+        template<class T>
+        void Compute_Cubic(const T *smps, float scale, float *outl,
+                           float *outr, int freqhi, float freqlo);
 
 
         struct {
@@ -34,6 +34,7 @@ class SUBnote:public SynthNote
         void releasekey();
         bool finished() const;
         void entomb(void);
+        float getAmplitude(void) const { return newamplitude; }
     private:
 
         void setup(float velocity,
@@ -22,7 +22,8 @@ namespace zyn {
 SynthNote::SynthNote(const SynthParams &pars)
     :memory(pars.memory),
     legato(pars.synth, pars.velocity, pars.portamento,
-            pars.note_log2_freq, pars.quiet, pars.seed), ctl(pars.ctl), synth(pars.synth), time(pars.time)
+            pars.note_log2_freq, pars.quiet, pars.seed), ctl(pars.ctl), synth(pars.synth), time(pars.time),
+    modbank(pars.modbank)
 {}
 
 SynthNote::Legato::Legato(const SYNTH_T &synth_, float vel,
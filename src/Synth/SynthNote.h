@@ -20,9 +20,22 @@ namespace zyn {
 
 class Allocator;
 class Controller;
+class ModulationBank;
 class Portamento;
 struct SynthParams
 {
+    //modbank is optional, as a default member initializer would make this
+    //no aggregate in C++11
+    SynthParams(Allocator &memory_, const Controller &ctl_,
+                const SYNTH_T &synth_, const AbsTime &time_, float velocity_,
+                Portamento *portamento_, float note_log2_freq_, bool quiet_,
+                prng_t seed_, ModulationBank *modbank_ = nullptr)
+        :memory(memory_), ctl(ctl_), synth(synth_), time(time_),
+          velocity(velocity_), portamento(portamento_),
+          note_log2_freq(note_log2_freq_), quiet(quiet_), seed(seed_),
+          modbank(modbank_)
+    {}
+
     Allocator &memory;   //Memory Allocator for the Note to use
     const Controller &ctl;
     const SYNTH_T    &synth;
@@ -32,6 +45,7 @@ struct SynthParams
     float     note_log2_freq; //Floating point value of the note
     bool      quiet;     //Initial output condition for legato notes
     prng_t    seed;      //Random seed
+    ModulationBank *modbank; //Batched envelopes and LFOs, may be null
 };
 
 struct LegatoParams
@@ -66,6 +80,9 @@ class SynthNote
 
         virtual void legatonote(const LegatoParams &pars) = 0;
 
+        /**Current amplitude of the note envelope, used to find quiet notes*/
+        virtual float getAmplitude(void) const = 0;
+
         virtual SynthNote *cloneLegato(void) = 0;
 
         /* For polyphonic aftertouch needed */
@@ -131,6 +148,7 @@ class SynthNote
         const Controller &ctl;
         const SYNTH_T    &synth;
         const AbsTime    &time;
+        ModulationBank   *modbank;
         WatchManager     *wm;
         smooth_float     filtercutoff_relfreq;
 };
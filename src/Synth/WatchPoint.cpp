@@ -27,29 +27,25 @@
 namespace zyn {
 
 WatchPoint::WatchPoint(WatchManager *ref, const char *prefix, const char *id)
-    :active(false), samples_left(0), reference(ref)
+    :active(false), samples_left(0), reference(ref), hash(0), slot(-1), epoch(0)
 {
     identity[0] = 0;
+    if(!reference)
+        return;
+
     if(prefix)
         fast_strcpy(identity, prefix, sizeof(identity));
     if(id)
-        strncat(identity, id, sizeof(identity)-1);
+        strncat(identity, id, sizeof(identity)-1-strlen(identity));
+
+    hash = WatchManager::hash(identity);
+    resolve();
 }
 
-bool WatchPoint::is_active(void)
+void WatchPoint::resolve(void)
 {
-    //Either the watchpoint is already active or the watchpoint manager has
-    //received another activation this frame
-    if(active)
-        return true;
-
-    if(reference && reference->active(identity)) {
-        active       = true;
-        samples_left = 1;
-        return true;
-    }
-
-    return false;
+    epoch = reference->epoch;
+    slot  = reference->slot(identity, hash);
 }
 
 bool WatchPoint::is_empty(void)
@@ -67,9 +63,10 @@ VecWatchPoint::VecWatchPoint(WatchManager *ref, const char *prefix, const char *
 {}
 
 WatchManager::WatchManager(thrlnk *link)
-    :write_back(link), new_active(false)
+    :write_back(link), epoch(0)
 {
     memset(active_list, 0, sizeof(active_list));
+    memset(active_hash, 0, sizeof(active_hash));
     memset(sample_list, 0, sizeof(sample_list));
     memset(prebuffer_sample, 0, sizeof(prebuffer_sample));
     memset(data_list,   0, sizeof(data_list));
@@ -91,7 +88,8 @@ void WatchManager::add_watch(const char *id)
     for(int i=0; i<MAX_WATCH; ++i) {
         if(!active_list[i][0]) {
             fast_strcpy(active_list[i], id, MAX_WATCH_PATH);
-            new_active = true;
+            active_hash[i] = hash(active_list[i]);
+            epoch++;
             sample_list[i] = 0;
             call_count[i] = 0;
             //printf("\n added watchpoint ID %s\n",id);
@@ -128,12 +126,11 @@ void WatchManager::tick(void)
         }
     }
 
-    //Cleanup internal data
-    new_active = false;
-
     //Clear deleted slots
     for(int i=0; i<MAX_WATCH; ++i) {
         if(deactivate[i]) {
+            active_hash[i] = 0;
+            epoch++;
             memset(active_list[i], 0, MAX_SAMPLE);
             sample_list[i] = 0;
             memset(data_list[i], 0, sizeof(float)*MAX_SAMPLE);
@@ -148,14 +145,40 @@ void WatchManager::tick(void)
 
 bool WatchManager::active(const char *id) const
 {
-    assert(this);
     assert(id);
-    if(new_active || true)
-        for(int i=0; i<MAX_WATCH; ++i)
-            if(!strcmp(active_list[i], id))
-                return true;
+    return slot(id) >= 0;
+}
 
-    return false;
+int WatchManager::slot(const char *id) const
+{
+    if(!id[0])
+        return -1;
+    for(int i=0; i<MAX_WATCH; ++i)
+        if(!strcmp(active_list[i], id))
+            return i;
+    return -1;
+}
+
+//Slot lookup for watch points, which only compare the paths of the slots
+//with the same hash. There are at most MAX_WATCH slots to check, so this
+//is bounded no matter how many distinct paths have been seen.
+int WatchManager::slot(const char *id, unsigned hash_) const
+{
+    if(!id[0])
+        return -1;
+    for(int i=0; i<MAX_WATCH; ++i)
+        if(active_hash[i] == hash_ && !strcmp(active_list[i], id))
+            return i;
+    return -1;
+}
+
+//FNV-1a
+unsigned WatchManager::hash(const char *id)
+{
+    unsigned h = 2166136261u;
+    for(const char *c = id; *c; ++c)
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    return h;
 }
 
 bool WatchManager::trigger_active(const char *id) const
@@ -184,12 +207,21 @@ void WatchManager::satisfy(const char *id, float f)
 
 void WatchManager::satisfy(const char *id, float *f, int n)
 {
-    int selected = -1;
-    for(int i=0; i<MAX_WATCH; ++i)
-        if(!strcmp(active_list[i], id))
-            selected = i;
+    satisfy(slot(id), f, n);
+}
 
-    if(selected == -1)
+void WatchManager::satisfy(int selected, float f)
+{
+    if(selected < 0)
+        return;
+    if(write_back)
+        write_back->write(active_list[selected], "f", f);
+    deactivate[selected] = true;
+}
+
+void WatchManager::satisfy(int selected, float *f, int n)
+{
+    if(selected < 0)
         return;
 
     int space = MAX_SAMPLE - sample_list[selected];
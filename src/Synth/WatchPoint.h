@@ -19,27 +19,37 @@ namespace zyn {
 
 struct WatchManager;
 
+#define MAX_WATCH 16
+#define MAX_WATCH_PATH 128
+#define MAX_SAMPLE 128
+
 struct WatchPoint
 {
     bool          active;
     int           samples_left;
     WatchManager *reference;
-    char          identity[128];
+    char          identity[MAX_WATCH_PATH];
+    //Hash of identity, compared before the paths of the watch slots
+    unsigned      hash;
+    //Slot of the active watch for this path as of the cached epoch
+    int           slot;
+    unsigned      epoch;
 
     WatchPoint(WatchManager *ref, const char *prefix, const char *id);
-    bool is_active(void);
+    inline bool is_active(void);
     bool is_empty(void);
+    private:
+    void resolve(void);
 };
 
-#define MAX_WATCH 16
-#define MAX_WATCH_PATH 128
-#define MAX_SAMPLE 128
 struct WatchManager
 {
     typedef rtosc::ThreadLink thrlnk;
     thrlnk *write_back;
-    bool    new_active;
+    //Incremented whenever a watch slot gets added or cleared
+    unsigned epoch;
     char    active_list[MAX_WATCH][MAX_WATCH_PATH];
+    unsigned active_hash[MAX_WATCH];
     float   data_list[MAX_WATCH][MAX_SAMPLE];
     float   prebuffer[MAX_WATCH][MAX_SAMPLE/2];
     int     sample_list[MAX_WATCH];
@@ -61,19 +71,43 @@ struct WatchManager
     //Watch Point Query API
     bool active(const char *) const;
     int  samples(const char *) const;
+    int  slot(const char *) const;
+    int  slot(const char *, unsigned hash) const;
+    static unsigned hash(const char *);
 
     //Watch Point Response API
     void satisfy(const char *, float);
     void satisfy(const char *, float*, int);
+    void satisfy(int slot, float);
+    void satisfy(int slot, float*, int);
 };
 
+//Inactive watch points only compare the cached epoch
+bool WatchPoint::is_active(void)
+{
+    //Either the watchpoint is already active or the watchpoint manager has
+    //received another activation since the last check
+    if(active)
+        return true;
+    if(!reference)
+        return false;
+    if(reference->epoch != epoch)
+        resolve();
+    if(slot < 0)
+        return false;
+
+    active       = true;
+    samples_left = 1;
+    return true;
+}
+
 struct FloatWatchPoint:public WatchPoint
 {
     FloatWatchPoint(WatchManager *ref, const char *prefix, const char *id);
     inline void operator()(float f)
     {
         if(is_active() && reference) {
-            reference->satisfy(identity, f);
+            reference->satisfy(slot, f);
             active = false;
         }
     }
@@ -86,7 +120,7 @@ struct VecWatchPoint : public WatchPoint
     inline void operator()(float *f, int n)
     {
         if(is_active() && reference) {
-            reference->satisfy(identity, f, n);
+            reference->satisfy(slot, f, n);
             active = false;
         }
     }
@@ -235,6 +235,35 @@ class AdNoteTest
 
         }
 
+        //Polyphonic rendering with a watch manager, but no open watches, so
+        //the cost of the inactive watch points shows up here
+        void testPolyphonySpeed() {
+            const int voices = 16;
+            const int bufs   = 2000;
+            ADnote   *notes[voices];
+            for(int i = 0; i < voices; ++i) {
+                const float freq_log2 = log2f(440.0f) + (38 + i - 69.0f) / 12.0f;
+                SynthParams pars{memory, *controller, *synth, *time, 120, 0,
+                                 freq_log2, false, prng()};
+                notes[i] = new ADnote(defaultPreset, pars, w, "/part0/kit0/");
+            }
+
+            int t_on = clock();
+            for(int b = 0; b < bufs; ++b) {
+                for(int i = 0; i < voices; ++i)
+                    notes[i]->noteout(outL, outR);
+                w->tick();
+            }
+            int t_off = clock();
+            TS_ASSERT(!tr->hasNext());
+
+            printf("AdNoteTest: %f seconds for %d voices over %d buffers with closed watches.\n",
+                   (static_cast<float>(t_off - t_on)) / CLOCKS_PER_SEC,
+                   voices, bufs);
+            for(int i = 0; i < voices; ++i)
+                delete notes[i];
+        }
+
 #define OUTPUT_PROFILE
 #ifdef OUTPUT_PROFILE
         void testSpeed() {
@@ -258,5 +287,8 @@ int main()
     test.setUp();
     test.testDefaults();
     test.tearDown();
+    test.setUp();
+    test.testPolyphonySpeed();
+    test.tearDown();
     return test_summary();
 }
@@ -0,0 +1,116 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  AlsaEngineTest.cpp - Test for the ALSA output with a file PCM
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include "../Misc/Config.h"
+#include "../Misc/Master.h"
+#include "../Nio/AlsaEngine.h"
+#include "../Nio/OutMgr.h"
+#include "../globals.h"
+using namespace std;
+using namespace zyn;
+
+class NSM_Client *nsm = 0;
+class MiddleWare *middleware = 0;
+
+char *instance_name = (char *)"";
+
+//OutMgr keeps the first SYNTH_T it is given
+SYNTH_T synth;
+
+#define OUT_FILE "alsa-engine-test.raw"
+
+class AlsaEngineTest
+{
+    public:
+        void setUp() {
+            master = new Master(synth, &config);
+            master->initialize_rt();
+            OutMgr::getInstance(&synth).setMaster(master);
+            master->noteOn(0, 60, 100);
+            remove(OUT_FILE);
+        }
+
+        void tearDown() {
+            OutMgr::getInstance().setMaster(NULL);
+            delete master;
+            remove(OUT_FILE);
+        }
+
+        //Play into the file PCM (a null PCM which writes everything it gets
+        //to a file) for a moment and read back what was written
+        vector<unsigned char> play(bool mmap) {
+            setenv("ALSA_DEVICE", "file:FILE=" OUT_FILE ",FORMAT=raw", 1);
+            setenv("ALSA_MMAP", mmap ? "1" : "0", 1);
+            {
+                AlsaEngine engine(synth);
+                engine.setAudioEn(true);
+                TS_ASSERT(engine.getAudioEn());
+                this_thread::sleep_for(chrono::milliseconds(200));
+                engine.setAudioEn(false);
+                TS_ASSERT(!engine.getAudioEn());
+            }
+
+            vector<unsigned char> data;
+            FILE *f = fopen(OUT_FILE, "rb");
+            TS_ASSERT(f);
+            if(!f)
+                return data;
+            unsigned char buf[4096];
+            size_t len;
+            while((len = fread(buf, 1, sizeof(buf), f)))
+                data.insert(data.end(), buf, buf + len);
+            fclose(f);
+            remove(OUT_FILE);
+            return data;
+        }
+
+        static bool silent(const vector<unsigned char> &data) {
+            for(unsigned char c : data)
+                if(c)
+                    return false;
+            return true;
+        }
+
+        //16 bit frames written by snd_pcm_writei()
+        void testWrite() {
+            vector<unsigned char> data = play(false);
+            TS_ASSERT(data.size() >= 4u * synth.buffersize);
+            TS_ASSERT_EQUAL_INT((int)(data.size() % 4), 0);
+            TS_ASSERT(!silent(data));
+        }
+
+        //float or 32 bit frames rendered into the mmapped ring
+        void testMmap() {
+            vector<unsigned char> data = play(true);
+            TS_ASSERT(data.size() >= 8u * synth.buffersize);
+            TS_ASSERT_EQUAL_INT((int)(data.size() % 8), 0);
+            TS_ASSERT(!silent(data));
+        }
+
+    private:
+        Config  config;
+        Master *master;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    AlsaEngineTest test;
+    RUN_TEST(testWrite);
+    RUN_TEST(testMmap);
+    return test_summary();
+}
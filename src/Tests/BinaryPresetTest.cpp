@@ -0,0 +1,281 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  BinaryPresetTest.cpp - Test for the binary preset format
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include "../Misc/BinaryPreset.h"
+#include "../Misc/Config.h"
+#include "../Misc/Master.h"
+#include "../Misc/XMLwrapper.h"
+#include "../Misc/XmlDocument.h"
+#include "../globals.h"
+
+using namespace std;
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define BINARY_FILE "BinaryPresetTest.zynb"
+
+class BinaryPresetTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+        }
+
+        void tearDown() {
+            remove(BINARY_FILE);
+            delete synth;
+        }
+
+        static string encode(const char *filename) {
+            XmlDocument doc;
+            if(!doc.loadFile(filename) || !doc.parse())
+                return "";
+            return BinaryPresetWriter::fromXml(
+                doc.findElement("ZynAddSubFX-data"));
+        }
+
+        static bool write(const string &filename, const string &image) {
+            FILE *file = fopen(filename.c_str(), "wb");
+            if(!file)
+                return false;
+            fwrite(image.data(), 1, image.size(), file);
+            return fclose(file) == 0;
+        }
+
+        void testSaveLoad() {
+            XMLwrapper out;
+            out.beginbranch("BRANCH", 7);
+            out.addpar("par", -1234);
+            out.addparreal("real", 1.0f / 3.0f);
+            out.addparbool("yes", 1);
+            out.addparbool("no", 0);
+            out.addparstr("string", "\"quoted\" & <tagged>");
+            out.addparstr("empty", "");
+            out.beginbranch("INNER");
+            out.addpar("par", 5);
+            out.endbranch();
+            out.endbranch();
+            out.setPadSynth(true);
+            TS_ASSERT_EQUAL_INT(out.saveBinaryFile(BINARY_FILE), 0);
+            TS_ASSERT(BinaryPreset::isBinaryFile(BINARY_FILE));
+
+            XMLwrapper in;
+            TS_ASSERT_EQUAL_INT(in.loadXMLfile(BINARY_FILE), 0);
+            TS_ASSERT(in.hasPadSynth());
+            TS_ASSERT(!in.enterbranch("BRANCH", 6));
+            TS_ASSERT(in.enterbranch("BRANCH", 7));
+            TS_ASSERT_EQUAL_INT(in.getbranchid(0, 0), 7);
+            TS_ASSERT_EQUAL_INT(in.getpar("par", 0, -5000, 5000), -1234);
+            TS_ASSERT_EQUAL_INT(in.getpar127("par", 64), 0);
+            TS_ASSERT_EQUAL_INT(in.getpar127("missing", 64), 64);
+            TS_ASSERT(in.getparreal("real", 0.0f) == 1.0f / 3.0f);
+            TS_ASSERT(in.hasparreal("real"));
+            TS_ASSERT(!in.hasparreal("par"));
+            TS_ASSERT_EQUAL_INT(in.getparbool("yes", 0), 1);
+            TS_ASSERT_EQUAL_INT(in.getparbool("no", 1), 0);
+            TS_ASSERT(in.getparstr("string", "") == "\"quoted\" & <tagged>");
+            TS_ASSERT(in.getparstr("empty", "default") == "default");
+            TS_ASSERT_EQUAL_INT((int)in.getBranch().size(), 7);
+            TS_ASSERT(in.enterbranch("INNER"));
+            TS_ASSERT_EQUAL_INT(in.getpar("par", 0, 0, 127), 5);
+            in.exitbranch();
+            in.exitbranch();
+            TS_ASSERT(!in.enterbranch("INNER"));
+        }
+
+        //XML -> binary -> XML has to give the same tree
+        void testConversion() {
+            const string image = encode(SOURCE_DIR "/guitar-adnote.xmz");
+            TS_ASSERT(!image.empty());
+
+            BinaryPreset bin;
+            TS_ASSERT(bin.setData(image.data(), image.size()));
+            const string xml = bin.toXml();
+
+            XmlDocument doc;
+            doc.setData(xml.c_str());
+            TS_ASSERT(doc.parse());
+            TS_ASSERT(BinaryPresetWriter::fromXml(
+                          doc.findElement("ZynAddSubFX-data")) == image);
+
+            //the converted file is read like the original
+            TS_ASSERT(write(BINARY_FILE, image));
+            XMLwrapper a, b;
+            TS_ASSERT_EQUAL_INT(a.loadXMLfile(SOURCE_DIR "/guitar-adnote.xmz"),
+                                0);
+            TS_ASSERT_EQUAL_INT(b.loadXMLfile(BINARY_FILE), 0);
+            TS_ASSERT_EQUAL_INT(compare(a, b), 0);
+        }
+
+        //Compare the values of all branches reachable from the current one
+        static int compare(XMLwrapper &a, XMLwrapper &b) {
+            int diff = 0;
+            const vector<XmlNode> nodes = a.getBranch();
+            if(nodes.size() != b.getBranch().size())
+                return 1;
+            for(auto n:nodes) {
+                const string name = n["name"];
+                if(n.name == "par")
+                    diff += a.getpar(name, -1, -100000, 100000)
+                            != b.getpar(name, -2, -100000, 100000);
+                else if(n.name == "par_real")
+                    diff += a.getparreal(name.c_str(), -1.0f)
+                            != b.getparreal(name.c_str(), -2.0f);
+                else if(n.name == "par_bool")
+                    diff += a.getparbool(name, 0) != b.getparbool(name, 1);
+                else if(n.name == "string")
+                    diff += a.getparstr(name, "?") != b.getparstr(name, "?");
+                else {
+                    const bool id = n.has("id");
+                    const int  ra = id ? a.enterbranch(n.name, stoi(n["id"]))
+                                       : a.enterbranch(n.name);
+                    const int  rb = id ? b.enterbranch(n.name, stoi(n["id"]))
+                                       : b.enterbranch(n.name);
+                    if(ra != rb)
+                        return diff + 1;
+                    if(ra) {
+                        diff += compare(a, b);
+                        a.exitbranch();
+                        b.exitbranch();
+                    }
+                }
+            }
+            return diff;
+        }
+
+        //Damaged files have to be rejected or at least be safe to read
+        void testCorrupted() {
+            const string image = encode(SOURCE_DIR "/guitar-adnote.xmz");
+            BinaryPreset bin;
+            TS_ASSERT(!bin.setData(image.data(), image.size() - 4));
+            TS_ASSERT(!bin.setData(image.data(), 16));
+
+            int accepted = 0;
+            for(size_t i = 0; i < image.size(); i += 97) {
+                string damaged = image;
+                damaged[i] ^= 0x5a;
+                if(bin.setData(damaged.data(), damaged.size())) {
+                    ++accepted;
+                    bin.toXml();
+                }
+            }
+            printf("BinaryPresetTest: %d of %d damaged files were readable\n",
+                   accepted, (int)(image.size() / 97));
+        }
+
+        static void findfiles(string dirname, vector<string> &files)
+        {
+            DIR *dir = opendir(dirname.c_str());
+            if(dir == NULL)
+                return;
+
+            struct dirent *fn;
+            while((fn = readdir(dir))) {
+                const char *filename = fn->d_name;
+                const size_t len     = strlen(filename);
+                if(fn->d_type == DT_DIR) {
+                    if(strcmp(filename, ".") && strcmp(filename, ".."))
+                        findfiles(dirname + "/" + filename, files);
+                }
+                else if(len > 4 && !strcmp(filename + len - 4, ".xiz"))
+                    files.push_back(dirname + "/" + filename);
+            }
+            closedir(dir);
+        }
+
+        static float load(const string &filename, int times) {
+            const clock_t t_on = clock();
+            for(int i = 0; i < times; ++i) {
+                XMLwrapper xml;
+                xml.loadXMLfile(filename);
+                xml.hasPadSynth();
+            }
+            return (float)(clock() - t_on) / CLOCKS_PER_SEC;
+        }
+
+        void testLoadSpeed() {
+            vector<string> files;
+            findfiles(string(SOURCE_DIR) + "/../../instruments/banks", files);
+            if(files.empty()) {
+                printf("BinaryPresetTest: no instrument banks found, "
+                       "using the test instrument\n");
+                files.assign(50, SOURCE_DIR "/guitar-adnote.xmz");
+            }
+
+            float  txml = 0.0f, tbin = 0.0f;
+            size_t sxml = 0, sbin = 0;
+            for(auto &f:files) {
+                const string image = encode(f.c_str());
+                TS_ASSERT(!image.empty());
+                TS_ASSERT(write(BINARY_FILE, image));
+                txml += load(f, 1);
+                tbin += load(BINARY_FILE, 1);
+                FILE *file = fopen(f.c_str(), "rb");
+                fseek(file, 0, SEEK_END);
+                sxml += ftell(file);
+                fclose(file);
+                sbin += image.size();
+            }
+            printf("BinaryPresetTest: loading %d instruments took %f seconds "
+                   "from XML (%d kB) and %f seconds from binary (%d kB)\n",
+                   (int)files.size(), txml, (int)(sxml / 1024), tbin,
+                   (int)(sbin / 1024));
+            TS_ASSERT(tbin < txml);
+        }
+
+        void testSaveSpeed() {
+            Config config;
+            Master master(*synth, &config);
+            XMLwrapper xml;
+            xml.beginbranch("MASTER");
+            master.add2XML(xml);
+            xml.endbranch();
+
+            const int times = 10;
+            float t[3];
+            for(int mode = 0; mode < 3; ++mode) {
+                const clock_t t_on = clock();
+                for(int i = 0; i < times; ++i)
+                    if(mode == 2)
+                        xml.saveBinaryFile(BINARY_FILE);
+                    else
+                        xml.saveXMLfile(BINARY_FILE, mode ? 3 : 0);
+                t[mode] = (float)(clock() - t_on) / CLOCKS_PER_SEC / times;
+            }
+            printf("BinaryPresetTest: saving a session took %f seconds as "
+                   "XML, %f seconds as compressed XML and %f seconds as "
+                   "binary\n", t[0], t[1], t[2]);
+
+            XMLwrapper in;
+            TS_ASSERT_EQUAL_INT(in.loadXMLfile(BINARY_FILE), 0);
+            TS_ASSERT(in.enterbranch("MASTER"));
+            TS_ASSERT(in.enterbranch("PART", 0));
+        }
+};
+
+int main()
+{
+    tap_quiet = 1;
+    BinaryPresetTest test;
+    RUN_TEST(testSaveLoad);
+    RUN_TEST(testConversion);
+    RUN_TEST(testCorrupted);
+    RUN_TEST(testLoadSpeed);
+    RUN_TEST(testSaveSpeed);
+    return test_summary();
+}
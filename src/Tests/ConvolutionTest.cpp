@@ -0,0 +1,236 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ConvolutionTest.cpp - Test for the partitioned convolution and its effect
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include "../DSP/Convolver.h"
+#include "../Effects/Convolution.h"
+#include "../Effects/EffectMgr.h"
+#include "../Misc/Allocator.h"
+#include "../Misc/WavFile.h"
+#include "../Misc/XMLwrapper.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define IR_FILE "convolution-test.wav"
+
+class ConvolutionTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            alloc = new AllocatorClass;
+            seed  = 1;
+        }
+
+        void tearDown() {
+            delete alloc;
+            delete synth;
+        }
+
+        float noise() {
+            seed = seed * 1103515245u + 12345u;
+            return (seed >> 16) / 32768.0f - 1.0f;
+        }
+
+        //Decaying noise as impulse response
+        void makeIR(std::vector<float> &ir, int len) {
+            ir.resize(len);
+            for(int i = 0; i < len; ++i)
+                ir[i] = noise() * expf(-4.0f * i / len);
+        }
+
+        //Run the convolver and compare it with the direct convolution
+        float convolve(int len, int bufsize, bool threaded, int *tail) {
+            std::vector<float> ir[2];
+            makeIR(ir[0], len);
+            makeIR(ir[1], len);
+            const float *irs[2] = {ir[0].data(), ir[1].data()};
+            Convolver conv(2, irs, len, bufsize, threaded);
+            *tail = conv.tailsize();
+
+            const int n = (len / bufsize + 20) * bufsize;
+            std::vector<float> in[2], out[2];
+            for(int c = 0; c < 2; ++c) {
+                in[c].resize(n);
+                out[c].resize(n);
+                for(int i = 0; i < n; ++i)
+                    in[c][i] = noise();
+            }
+            for(int b = 0; b < n; b += bufsize) {
+                const float *i[2] = {&in[0][b], &in[1][b]};
+                float       *o[2] = {&out[0][b], &out[1][b]};
+                conv.process(i, o);
+                //a late tail would be dropped rather than waited for
+                conv.drain();
+            }
+
+            float err = 0.0f, peak = 0.0f;
+            for(int c = 0; c < 2; ++c)
+                for(int i = 0; i < n; ++i) {
+                    double sum = 0.0;
+                    for(int k = 0; k < len && k <= i; ++k)
+                        sum += ir[c][k] * in[c][i - k];
+                    err  = fmaxf(err, fabsf(sum - out[c][i]));
+                    peak = fmaxf(peak, fabsf(sum));
+                }
+            return err / peak;
+        }
+
+        void testConvolver() {
+            int tail;
+            //head only
+            TS_ASSERT(convolve(200, 64, true, &tail) < 1e-5f);
+            TS_ASSERT_EQUAL_INT(tail, 0);
+            //head and a tail computed inline or in the background
+            TS_ASSERT(convolve(6000, 64, false, &tail) < 1e-5f);
+            TS_ASSERT(tail > 0);
+            TS_ASSERT(convolve(6000, 64, true, &tail) < 1e-5f);
+            TS_ASSERT(convolve(20000, 256, true, &tail) < 1e-5f);
+        }
+
+        void testWavFile() {
+            const int n = 1000;
+            short int smps[2 * n];
+            for(int i = 0; i < 2 * n; ++i)
+                smps[i] = noise() * 32767;
+            {
+                WavFile wav(IR_FILE, 22050, 2);
+                TS_ASSERT(wav.good());
+                wav.writeStereoSamples(n, smps);
+            }
+
+            std::vector<float> data;
+            int channels, samplerate;
+            TS_ASSERT_EQUAL_INT(readWavFile(IR_FILE, data, channels,
+                                            samplerate), 0);
+            TS_ASSERT_EQUAL_INT(channels, 2);
+            TS_ASSERT_EQUAL_INT(samplerate, 22050);
+            TS_ASSERT_EQUAL_INT((int)data.size(), 2 * n);
+            float err = 0.0f;
+            for(int i = 0; i < 2 * n && i < (int)data.size(); ++i)
+                err = fmaxf(err, fabsf(data[i] - smps[i] / 32768.0f));
+            TS_ASSERT(err < 1e-6f);
+            TS_ASSERT(readWavFile("nonexistent.wav", data, channels,
+                                  samplerate) != 0);
+            remove(IR_FILE);
+        }
+
+        //An impulse through the effect has to give the impulse response back
+        void testEffect() {
+            const int len = 3000;
+            short int smps[len];
+            smps[0] = 32767;
+            for(int i = 1; i < len; ++i)
+                smps[i] = noise() * 16000 * expf(-4.0f * i / len);
+            {
+                WavFile wav(IR_FILE, synth->samplerate, 1);
+                wav.writeMonoSamples(len, smps);
+            }
+
+            EffectMgr mgr(*alloc, *synth, true);
+            mgr.changeeffect(10);
+            mgr.init();
+            TS_NON_NULL(dynamic_cast<Convolution*>(mgr.efx));
+
+            //the effect is silent without an impulse response
+            const int bs = synth->buffersize;
+            float l[bs], r[bs];
+            memset(l, 0, sizeof(l));
+            memset(r, 0, sizeof(r));
+            mgr.out(l, r);
+            mgr.cleanup();
+
+            mgr.ir = ImpulseResponse::load(IR_FILE, *synth);
+            TS_NON_NULL(mgr.ir);
+            dynamic_cast<Convolution*>(mgr.efx)->setir(mgr.ir);
+
+            std::vector<float> out;
+            for(int b = 0; b < len / bs + 2; ++b) {
+                memset(l, 0, sizeof(l));
+                memset(r, 0, sizeof(r));
+                if(b == 0)
+                    l[0] = r[0] = 1.0f;
+                mgr.out(l, r);
+                out.insert(out.end(), mgr.efxoutl, mgr.efxoutl + bs);
+            }
+            const float gain = out[0] / smps[0];
+            float err = 0.0f;
+            for(int i = 0; i < len; ++i)
+                err = fmaxf(err, fabsf(out[i] - gain * smps[i]));
+            TS_ASSERT(gain > 0.0f);
+            TS_ASSERT(err < fabsf(out[0]) * 1e-4f);
+
+            //the file name is saved and the response loaded again
+            XMLwrapper xml;
+            xml.beginbranch("EFFECT");
+            mgr.add2XML(xml);
+            xml.endbranch();
+            EffectMgr loaded(*alloc, *synth, true);
+            TS_ASSERT(xml.enterbranch("EFFECT"));
+            loaded.getfromXML(xml);
+            xml.exitbranch();
+            TS_NON_NULL(loaded.ir);
+            if(loaded.ir)
+                TS_ASSERT(loaded.ir->filename == IR_FILE);
+            remove(IR_FILE);
+        }
+
+        //Several seconds of stereo impulse response with small buffers
+        void testSpeed() {
+            const int seconds = 3, bs = 64, samplerate = 48000;
+            std::vector<float> ir[2];
+            makeIR(ir[0], seconds * samplerate);
+            makeIR(ir[1], seconds * samplerate);
+            const float *irs[2] = {ir[0].data(), ir[1].data()};
+            Convolver conv(2, irs, seconds * samplerate, bs);
+
+            float in[2][bs], out[2][bs];
+            for(int i = 0; i < bs; ++i)
+                in[0][i] = in[1][i] = noise();
+            const float *i[2] = {in[0], in[1]};
+            float       *o[2] = {out[0], out[1]};
+
+            //the process time includes the background thread
+            const int     blocks = 10 * samplerate / bs;
+            const clock_t t_on   = clock();
+            for(int b = 0; b < blocks; ++b)
+                conv.process(i, o);
+            conv.drain();
+            const clock_t t_off  = clock();
+            const float   t      = (float)(t_off - t_on) / CLOCKS_PER_SEC;
+            printf("ConvolutionTest: %f seconds for 10 seconds of audio "
+                   "(%.1f%% CPU) with %d partitions of %d and %d samples.\n",
+                   t, 10.0f * t, Convolver::delay * conv.tailsize() / bs, bs,
+                   conv.tailsize());
+        }
+
+    private:
+        Allocator *alloc;
+        unsigned   seed;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    ConvolutionTest test;
+    RUN_TEST(testConvolver);
+    RUN_TEST(testWavFile);
+    RUN_TEST(testEffect);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
@@ -0,0 +1,313 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  DelayLineTest.cpp - Test for the delay line shared by the effects
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include "../DSP/CombFilter.h"
+#include "../DSP/DelayLine.h"
+#include "../Effects/CombFilterBank.h"
+#include "../Effects/EffectMgr.h"
+#include "../Misc/Allocator.h"
+#include "../globals.h"
+
+using namespace std;
+using namespace zyn;
+
+SYNTH_T *synth;
+
+class DelayLineTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            alloc = new AllocatorClass;
+            seed  = 1;
+        }
+
+        void tearDown() {
+            delete alloc;
+            delete synth;
+        }
+
+        float noise() {
+            seed = seed * 1103515245u + 12345u;
+            return (seed >> 16) / 32768.0f - 1.0f;
+        }
+
+        //Sample written delay samples ago in the reference history
+        static float past(const vector<float> &history, int delay) {
+            return history[history.size() - delay];
+        }
+
+        void testSize() {
+            DelayLine<float> a(*alloc, 100), b(*alloc, 127), c(*alloc, 128);
+            TS_ASSERT_EQUAL_INT(128, a.size());
+            TS_ASSERT_EQUAL_INT(128, b.size());
+            TS_ASSERT_EQUAL_INT(256, c.size());
+            for(int i = 1; i < a.size(); ++i)
+                TS_ASSERT(a.read(i) == 0.0f);
+        }
+
+        //Single and block accesses have to match a plain history of samples
+        void testReadWrite() {
+            DelayLine<float> line(*alloc, 100);
+            vector<float> history(line.size(), 0.0f);
+            int errors = 0;
+            for(int step = 0; step < 2000; ++step) {
+                if(step % 3) {
+                    const float smp = noise();
+                    line.write(smp);
+                    history.push_back(smp);
+                }
+                else {
+                    float block[64];
+                    const int n = 1 + step % 64;
+                    for(int i = 0; i < n; ++i)
+                        history.push_back(block[i] = noise());
+                    line.write(block, n);
+                }
+
+                for(int delay = 1; delay < line.size(); ++delay)
+                    errors += line.read(delay) != past(history, delay);
+
+                float block[40];
+                line.read(60, block, 40);
+                for(int i = 0; i < 40; ++i)
+                    errors += block[i] != past(history, 60 - i);
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+
+            //writing ahead of the read position like the echo does
+            DelayLine<float> ahead(*alloc, 10);
+            for(int i = 0; i < 20; ++i) {
+                if(i >= 7)
+                    errors += ahead.at(0) != i - 7;
+                ahead.at(7) = i;
+                ahead.advance();
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+        }
+
+        //Block processing has to split the block where the runs would
+        //overlap or wrap around
+        void testProcess() {
+            DelayLine<float> line(*alloc, 100);
+            vector<float> history(line.size(), 0.0f);
+            int errors = 0;
+            for(int step = 0; step < 500; ++step) {
+                const int delay = 1 + step % (line.size() - 1);
+                const int n     = 1 + (step * 7) % 300;
+                vector<float> in(n), expected(n), out(n);
+                for(int i = 0; i < n; ++i) {
+                    in[i]       = noise();
+                    expected[i] = past(history, delay);
+                    history.push_back(in[i] + 0.5f * expected[i]);
+                }
+                line.process(delay, n, [&](const float *src, float *dst,
+                                           int i, int len) {
+                    for(int k = 0; k < len; ++k) {
+                        out[i + k] = src[k];
+                        dst[k]     = in[i + k] + 0.5f * src[k];
+                    }
+                });
+                for(int i = 0; i < n; ++i)
+                    errors += out[i] != expected[i];
+                for(int i = 1; i < line.size(); ++i)
+                    errors += line.read(i) != past(history, i);
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+        }
+
+        //The longest delay reads the slot written next, block by block
+        void testMaxDelay() {
+            DelayLine<float> line(*alloc, 100);
+            const int delay = line.size() - 1;
+            vector<float> history(line.size(), 0.0f);
+            int errors = 0;
+            for(int step = 0; step < 50; ++step) {
+                const int n = 1 + (step * 37) % 300;
+                vector<float> in(n), out(n);
+                for(int i = 0; i < n; ++i)
+                    in[i] = noise();
+                line.process(delay, n, [&](const float *src, float *dst,
+                                           int i, int len) {
+                    for(int k = 0; k < len; ++k) {
+                        out[i + k] = src[k];
+                        dst[k]     = in[i + k];
+                    }
+                });
+                for(int i = 0; i < n; ++i) {
+                    errors += out[i] != past(history, delay);
+                    history.push_back(in[i]);
+                }
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+        }
+
+        void testInterpolation() {
+            DelayLine<float> line(*alloc, 64);
+            float state = 0.0f, linerr = 0.0f, cuberr = 0.0f, aperr = 0.0f;
+            for(int i = 0; i < 1000; ++i) {
+                //a ramp is linear and a parabola is reproduced by the
+                //cubic interpolation
+                const float lin = line.linear(10.25f);
+                const float ap  = line.allpass(20.6f, state);
+                if(i > 64) {
+                    linerr = fmaxf(linerr, fabsf(lin - (i - 10.25f)));
+                    aperr  = fmaxf(aperr, fabsf(ap - (i - 20.6f)));
+                }
+                line.write(i);
+            }
+            TS_ASSERT_DELTA(linerr, 0.0f, 1e-3);
+            TS_ASSERT_DELTA(aperr, 0.0f, 1e-3);
+
+            line.clear();
+            for(int i = 0; i < 200; ++i) {
+                const float x   = (i - 37.4f) / 100.0f;
+                const float cub = line.cubic(37.4f);
+                if(i > 64)
+                    cuberr = fmaxf(cuberr, fabsf(cub - x * x));
+                line.write(i / 100.0f * i / 100.0f);
+            }
+            TS_ASSERT_DELTA(cuberr, 0.0f, 1e-5);
+
+            //integer delays give the stored samples
+            TS_ASSERT(line.linear(5.0f) == line.read(5));
+            TS_ASSERT_DELTA(line.cubic(5.0f), line.read(5), 1e-5);
+
+            DelayLine<complex<float>> cline(*alloc, 8);
+            cline.write(complex<float>(1.0f, -2.0f));
+            cline.write(complex<float>(3.0f, 4.0f));
+            TS_ASSERT(cline.read(2) == complex<float>(1.0f, -2.0f));
+            TS_ASSERT(cline.linear(1.5f) == complex<float>(2.0f, 1.0f));
+        }
+
+        //Above samplerate Hz the feedback comb stays at a delay of one
+        //sample, also once the ring has wrapped
+        void testCombLimit() {
+            const int bs = 64;
+            CombFilter a(alloc, 0, 40000.0f, 300.0f, 22050, bs);
+            CombFilter b(alloc, 0, 22050.0f, 300.0f, 22050, bs);
+            float sa[bs], sb[bs];
+            int errors = 0;
+            for(int k = 0; k < 64; ++k) {
+                for(int i = 0; i < bs; ++i)
+                    sa[i] = sb[i] = noise();
+                a.filterout(sa);
+                b.filterout(sb);
+                for(int i = 0; i < bs; ++i)
+                    errors += sa[i] != sb[i];
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+        }
+
+        //The strings of the comb filter bank are limited the same way
+        void testCombBankLimit() {
+            const int bs = 64;
+            CombFilterBank a(alloc, 22050, bs, 0.9f), b(alloc, 22050, bs, 0.9f);
+            a.setStrings(2, 110.0f);
+            b.setStrings(2, 110.0f);
+            a.delays[0] = 0.3f;
+            b.delays[0] = 1.0f;
+            a.delays[1] = b.delays[1] = 22050.0f / 440.0f;
+            float sa[bs], sb[bs];
+            int errors = 0;
+            for(int k = 0; k < 64; ++k) {
+                for(int i = 0; i < bs; ++i)
+                    sa[i] = sb[i] = noise();
+                a.filterout(sa);
+                b.filterout(sb);
+                for(int i = 0; i < bs; ++i)
+                    errors += sa[i] != sb[i];
+            }
+            TS_ASSERT_EQUAL_INT(0, errors);
+        }
+
+        //CPU time for one second of audio
+        float process(EffectMgr &mgr) {
+            const int bs     = synth->buffersize;
+            const int blocks = synth->samplerate / bs;
+            float l[bs], r[bs];
+            const clock_t t_on = clock();
+            for(int b = 0; b < blocks; ++b) {
+                for(int i = 0; i < bs; ++i) {
+                    l[i] = noise();
+                    r[i] = noise();
+                }
+                mgr.out(l, r);
+            }
+            return (float)(clock() - t_on) / CLOCKS_PER_SEC;
+        }
+
+        void testEffectSpeed() {
+            //reverb, echo, chorus, alienwah and the comb filter bank
+            const int   effects[] = {1, 2, 3, 5, 9};
+            const char *names[]   = {"reverb", "echo", "chorus", "alienwah",
+                                     "sympathetic"};
+            for(int e = 0; e < 5; ++e) {
+                EffectMgr mgr(*alloc, *synth, true);
+                mgr.changeeffect(effects[e]);
+                mgr.init();
+                if(effects[e] == 3)
+                    mgr.seteffectparrt(10, 1); //flange mode
+                const float t = process(mgr);
+                printf("DelayLineTest: %f seconds for one second of %s.\n",
+                       t, names[e]);
+                TS_ASSERT(t < 1.0f);
+            }
+
+            //the bandwidth reverb runs the input through the unison
+            EffectMgr mgr(*alloc, *synth, true);
+            mgr.changeeffect(1);
+            mgr.init();
+            mgr.seteffectparrt(10, 2);
+            float t = process(mgr);
+            printf("DelayLineTest: %f seconds for one second of bandwidth "
+                   "reverb.\n", t);
+            TS_ASSERT(t < 1.0f);
+
+            const int bs = synth->buffersize;
+            float smp[bs];
+            CombFilter comb(alloc, 2, 440.0f, 300.0f, synth->samplerate, bs);
+            const clock_t t_on = clock();
+            for(int b = 0; b < (int)synth->samplerate / bs; ++b) {
+                for(int i = 0; i < bs; ++i)
+                    smp[i] = noise();
+                comb.filterout(smp);
+            }
+            t = (float)(clock() - t_on) / CLOCKS_PER_SEC;
+            printf("DelayLineTest: %f seconds for one second of the comb "
+                   "filter.\n", t);
+            TS_ASSERT(t < 1.0f);
+        }
+
+    private:
+        Allocator *alloc;
+        unsigned   seed;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    DelayLineTest test;
+    RUN_TEST(testSize);
+    RUN_TEST(testReadWrite);
+    RUN_TEST(testProcess);
+    RUN_TEST(testMaxDelay);
+    RUN_TEST(testInterpolation);
+    RUN_TEST(testCombLimit);
+    RUN_TEST(testCombBankLimit);
+    RUN_TEST(testEffectSpeed);
+    return test_summary();
+}
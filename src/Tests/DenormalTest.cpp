@@ -0,0 +1,122 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  DenormalTest.cpp - Test that decaying signals do not slow down processing
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include "../Effects/EffectMgr.h"
+#include "../Misc/Allocator.h"
+#include "../Misc/Denormals.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+class DenormalTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            //the noise is used where denormals are not flushed in hardware
+            synth->alias();
+            alloc = new AllocatorClass;
+            seed  = 1;
+        }
+
+        void tearDown() {
+            delete alloc;
+            delete synth;
+        }
+
+        float noise() {
+            seed = seed * 1103515245u + 12345u;
+            return (seed >> 16) / 32768.0f - 1.0f;
+        }
+
+        static int subnormals(const float *smps, int n) {
+            int count = 0;
+            for(int i = 0; i < n; ++i)
+                count += std::fpclassify(smps[i]) == FP_SUBNORMAL;
+            return count;
+        }
+
+        void testGuard() {
+            const bool before = DenormalGuard::active();
+            {
+                DenormalGuard flush;
+                TS_ASSERT(DenormalGuard::active() == (ZYN_FLUSH_DENORMALS != 0));
+
+                //2^-130 is below the smallest normal float
+                volatile float x = 1.0f;
+                for(int i = 0; i < 130; ++i)
+                    x = x * 0.5f;
+                if(ZYN_FLUSH_DENORMALS)
+                    TS_ASSERT_EQUAL_INT(std::fpclassify(x), FP_ZERO);
+            }
+            TS_ASSERT(DenormalGuard::active() == before);
+        }
+
+        //Process one second of the effect and return the CPU time
+        float process(EffectMgr &mgr, bool silent, int *denormal) {
+            const int bs     = synth->buffersize;
+            const int blocks = synth->samplerate / bs;
+            float l[bs], r[bs];
+            const clock_t t_on = clock();
+            for(int b = 0; b < blocks; ++b) {
+                for(int i = 0; i < bs; ++i) {
+                    l[i] = silent ? 0.0f : noise();
+                    r[i] = silent ? 0.0f : noise();
+                }
+                mgr.out(l, r);
+                *denormal += subnormals(l, bs) + subnormals(r, bs)
+                             + subnormals(mgr.efxoutl, bs)
+                             + subnormals(mgr.efxoutr, bs);
+            }
+            return (float)(clock() - t_on) / CLOCKS_PER_SEC;
+        }
+
+        //Feedback paths of all effects decay for a while after the input
+        //stopped, the silent tail has to be as fast as the loud input
+        void testEffectTails() {
+            DenormalGuard flush;
+            for(int nefx = 1; nefx <= 9; ++nefx) {
+                EffectMgr mgr(*alloc, *synth, true);
+                mgr.changeeffect(nefx);
+                mgr.init();
+
+                int   denormal = 0;
+                const float loud = process(mgr, false, &denormal);
+                for(int s = 0; s < 30; ++s)
+                    process(mgr, true, &denormal);
+                const float tail = process(mgr, true, &denormal);
+
+                printf("DenormalTest: effect %d took %f seconds with input "
+                       "and %f seconds for its tail.\n", nefx, loud, tail);
+                TS_ASSERT_EQUAL_INT(denormal, 0);
+                TS_ASSERT(tail < 4.0f * loud + 0.005f);
+            }
+        }
+
+    private:
+        Allocator *alloc;
+        unsigned   seed;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    DenormalTest test;
+    RUN_TEST(testGuard);
+    RUN_TEST(testEffectTails);
+    return test_summary();
+}
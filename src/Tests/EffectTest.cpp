@@ -12,6 +12,8 @@
 #include "test-suite.h"
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <ctime>
 #include "../Misc/Allocator.h"
 #include "../Misc/Stereo.h"
 #include "../Effects/EffectMgr.h"
@@ -79,6 +81,146 @@ class EffectTest
             TS_NON_NULL(dynamic_cast<Echo*>(mgr->efx));
         }
 
+        //Both channels of the EQ cascade have to follow the frequency response
+        void testEQ() {
+            mgr->changeeffect(7);
+            mgr->init();
+            mgr->seteffectparrt(10, 7);   //peak
+            mgr->seteffectparrt(11, 64);  //600Hz
+            mgr->seteffectparrt(12, 100); //+17dB
+            mgr->seteffectparrt(14, 1);   //two stages
+            mgr->seteffectparrt(15, 3);   //LP2
+            mgr->seteffectparrt(16, 100);
+
+            const int bufs = 400;
+            float l[synth->buffersize], r[synth->buffersize];
+            float peak = 0.0f;
+            bool  linked = true;
+            for(int b = 0; b < bufs; ++b) {
+                //Change the gain half way through
+                if(b == bufs / 2)
+                    mgr->seteffectparrt(12, 40);
+                for(int i = 0; i < synth->buffersize; ++i) {
+                    const int t = b * synth->buffersize + i;
+                    l[i] = r[i] = 0.1f * sinf(2 * PI * 600.0f * t
+                                              / synth->samplerate_f);
+                }
+                mgr->out(l, r);
+                for(int i = 0; i < synth->buffersize; ++i) {
+                    linked &= l[i] == r[i];
+                    if(b > bufs - 20)
+                        peak = fmaxf(peak, fabsf(l[i]));
+                }
+            }
+            TS_ASSERT(linked);
+            const float expected = 0.1f * dB2rap(mgr->getEQfreqresponse(600.0f));
+            TS_ASSERT_DELTA(peak, expected, expected * 0.02f);
+        }
+
+        //Freeverb with one comb per buffer processed independently
+        struct RefReverb {
+            float comb[REV_COMBS * 2][2000], lpcomb[REV_COMBS * 2];
+            float combfb[REV_COMBS * 2];
+            int   comblen[REV_COMBS * 2], combk[REV_COMBS * 2];
+            float ap[REV_APS * 2][1000];
+            int   aplen[REV_APS * 2], apk[REV_APS * 2];
+            float lohifb;
+
+            RefReverb(float samplerate, float t, float lohifb_)
+                :comb(), lpcomb(), combk(), ap(), apk(), lohifb(lohifb_) {
+                const int combs[REV_COMBS] = {1116, 1188, 1277, 1356,
+                                              1422, 1491, 1557, 1617};
+                const int aps[REV_APS] = {225, 341, 441, 556};
+                for(int i = 0; i < REV_COMBS * 2; ++i) {
+                    comblen[i] = combs[i % REV_COMBS] + (i > REV_COMBS ? 23 : 0);
+                    combfb[i]  = -expf((float)comblen[i] / samplerate
+                                       * logf(0.001f) / t);
+                }
+                for(int i = 0; i < REV_APS * 2; ++i)
+                    aplen[i] = aps[i % REV_APS] + (i > REV_APS ? 23 : 0);
+            }
+
+            void process(int ch, float *output, const float *in, int n) {
+                for(int j = REV_COMBS * ch; j < REV_COMBS * (ch + 1); ++j)
+                    for(int i = 0; i < n; ++i) {
+                        int  &ck    = combk[j];
+                        float fbout = comb[j][ck] * combfb[j];
+                        fbout = fbout * (1.0f - lohifb) + lpcomb[j] * lohifb;
+                        lpcomb[j]   = fbout;
+                        comb[j][ck] = in[i] + fbout;
+                        output[i]  += fbout;
+                        if((++ck) >= comblen[j])
+                            ck = 0;
+                    }
+                for(int j = REV_APS * ch; j < REV_APS * (ch + 1); ++j)
+                    for(int i = 0; i < n; ++i) {
+                        int  &ak  = apk[j];
+                        float tmp = ap[j][ak];
+                        ap[j][ak] = 0.7f * tmp + output[i];
+                        output[i] = tmp - 0.7f * ap[j][ak];
+                        if((++ak) >= aplen[j])
+                            ak = 0;
+                    }
+            }
+        };
+
+        //The interleaved comb processing has to match the comb by comb
+        //processing of the Freeverb topology
+        void testReverb() {
+            const int bs = synth->buffersize;
+            float     outl[bs], outr[bs], l[bs], r[bs], in[bs];
+            EffectParams pars{*alloc, true, outl, outr, 0,
+                              synth->samplerate, bs, nullptr};
+            Reverb rev(pars);
+            rev.changepar(2, 64);   //time
+            rev.changepar(3, 0);    //no initial delay
+            rev.changepar(7, 127);  //no lpf
+            rev.changepar(8, 0);    //no hpf
+            rev.changepar(9, 100);  //damping
+            rev.changepar(11, 64);  //room size
+            rev.changepar(10, 1);   //Freeverb
+
+            const float x = (100 - 64) / 64.1f;
+            RefReverb *ref = new RefReverb(synth->samplerate_f,
+                                           powf(60.0f, 64 / 127.0f) - 0.97f,
+                                           x * x);
+            unsigned seed = 1;
+            float err = 0.0f, peak = 0.0f, gainl = 0.0f, gainr = 0.0f;
+            clock_t t = 0;
+            for(int b = 0; b < 400; ++b) {
+                for(int i = 0; i < bs; ++i) {
+                    seed  = seed * 1103515245u + 12345u;
+                    in[i] = b < 20 ? (seed >> 16) / 32768.0f - 1.0f : 0.0f;
+                }
+                memset(outl, 0, sizeof(outl));
+                memset(outr, 0, sizeof(outr));
+                const clock_t t_on = clock();
+                rev.out(Stereo<float *>(in, in));
+                t += clock() - t_on;
+
+                memset(l, 0, sizeof(l));
+                memset(r, 0, sizeof(r));
+                ref->process(0, l, in, bs);
+                ref->process(1, r, in, bs);
+                for(int i = 0; i < bs; ++i) {
+                    //the output gain depends on the panning law only
+                    if(gainl == 0.0f && l[i] != 0.0f) {
+                        gainl = outl[i] / l[i];
+                        gainr = outr[i] / r[i];
+                    }
+                    err  = fmaxf(err, fabsf(outl[i] - gainl * l[i]));
+                    err  = fmaxf(err, fabsf(outr[i] - gainr * r[i]));
+                    peak = fmaxf(peak, fabsf(outl[i]));
+                }
+            }
+            delete ref;
+            TS_ASSERT(gainl > 0.0f);
+            TS_ASSERT(peak > 0.01f);
+            TS_ASSERT(err <= peak * 1e-5f);
+            printf("EffectTest: %f seconds for reverb over %d samples.\n",
+                   (static_cast<float>(t)) / CLOCKS_PER_SEC, 400 * bs);
+        }
+
     private:
         EffectMgr *mgr;
         Allocator *alloc;
@@ -91,5 +233,7 @@ int main()
     RUN_TEST(testInit);
     RUN_TEST(testClear);
     RUN_TEST(testSwap);
+    RUN_TEST(testEQ);
+    RUN_TEST(testReverb);
     return test_summary();
 }
@@ -0,0 +1,154 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  FormantFilterTest.cpp - Test for DSP/FormantFilter
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include "../DSP/Filter.h"
+#include "../DSP/AnalogFilter.h"
+#include "../Misc/Allocator.h"
+#include "../Params/FilterParams.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define BUF 256
+#define SRATE 48000
+class FormantFilterTest
+{
+    public:
+        void setUp() {
+            pars = new FilterParams();
+            pars->Pcategory    = 1;
+            pars->Pstages      = 1;
+            pars->Pnumformants = 5;
+            pars->Psequencesize = 1;
+            pars->Psequence[0].nvowel = 0;
+            const unsigned char freqs[5] = {30, 50, 70, 90, 110};
+            for(int i = 0; i < 5; ++i) {
+                pars->Pvowels[0].formants[i].freq = freqs[i];
+                pars->Pvowels[0].formants[i].amp  = 127 - 15 * i;
+                pars->Pvowels[0].formants[i].q    = 40 + 10 * i;
+            }
+            filter = Filter::generate(alloc, pars, SRATE, BUF);
+            seed   = 1;
+        }
+
+        void tearDown() {
+            alloc.dealloc(filter);
+            delete pars;
+        }
+
+        void noise(float *smp) {
+            for(int i = 0; i < BUF; ++i) {
+                seed   = seed * 1103515245u + 12345u;
+                smp[i] = (seed >> 16) / 32768.0f - 1.0f;
+            }
+        }
+
+        //With a single vowel the formant bank has to match a sum of
+        //independent AnalogFilter bandpasses
+        void testSingleVowel() {
+            const int n = pars->Pnumformants;
+            AnalogFilter *ref[FF_MAX_FORMANTS];
+            for(int i = 0; i < n; ++i) {
+                const auto &f = pars->Pvowels[0].formants[i];
+                ref[i] = alloc.alloc<AnalogFilter>(4, 1000.0f, 10.0f,
+                        pars->Pstages, SRATE, BUF);
+                ref[i]->setfreq_and_q(pars->getformantfreq(f.freq),
+                        pars->getformantq(f.q) * pars->getq());
+            }
+            const float gain = dB2rap(pars->getgain());
+
+            float in[BUF], out[BUF], expected[BUF], tmp[BUF];
+            float maxerr = 0.0f, peak = 0.0f;
+            for(int b = 0; b < 200; ++b) {
+                noise(in);
+                memcpy(out, in, sizeof(in));
+                filter->setfreq(700.0f);
+                filter->filterout(out);
+
+                memset(expected, 0, sizeof(expected));
+                for(int i = 0; i < n; ++i) {
+                    const float amp = pars->getformantamp(
+                            pars->Pvowels[0].formants[i].amp);
+                    for(int j = 0; j < BUF; ++j)
+                        tmp[j] = in[j] * gain;
+                    ref[i]->filterout(tmp);
+                    for(int j = 0; j < BUF; ++j)
+                        expected[j] += tmp[j] * amp;
+                }
+
+                //skip the amplitude fade in of the first buffers
+                if(b < 10)
+                    continue;
+                for(int j = 0; j < BUF; ++j) {
+                    maxerr = fmaxf(maxerr, fabsf(out[j] - expected[j]));
+                    peak   = fmaxf(peak, fabsf(expected[j]));
+                }
+            }
+            TS_ASSERT(peak > 0.01f);
+            TS_ASSERT(maxerr < peak * 1e-4f);
+
+            for(int i = 0; i < n; ++i)
+                alloc.dealloc(ref[i]);
+        }
+
+        //Coefficients are interpolated between vowels, which must keep all
+        //formants stable
+        void testMorph() {
+            alloc.dealloc(filter);
+            pars->Pnumformants  = FF_MAX_FORMANTS;
+            pars->Pstages       = 2;
+            pars->Psequencesize = 4;
+            for(int k = 0; k < 4; ++k)
+                pars->Psequence[k].nvowel = k;
+            filter = Filter::generate(alloc, pars, SRATE, BUF);
+
+            float smp[BUF];
+            float peak = 0.0f;
+            bool  finite = true;
+            const int t_on = clock();
+            for(int b = 0; b < 2000; ++b) {
+                noise(smp);
+                filter->setfreq(300.0f * powf(2.0f, 3.0f * sinf(b * 0.05f)));
+                filter->filterout(smp);
+                for(int j = 0; j < BUF; ++j) {
+                    finite &= std::isfinite(smp[j]);
+                    peak    = fmaxf(peak, fabsf(smp[j]));
+                }
+            }
+            const int t_off = clock();
+            TS_ASSERT(finite);
+            TS_ASSERT(peak > 0.01f);
+            TS_ASSERT(peak < 1000.0f);
+            printf("FormantFilterTest: %f seconds for %d formants over %d samples.\n",
+                   (static_cast<float>(t_off - t_on)) / CLOCKS_PER_SEC,
+                   FF_MAX_FORMANTS, 2000 * BUF);
+        }
+
+    private:
+        FilterParams *pars;
+        Filter       *filter;
+        Alloc         alloc;
+        unsigned      seed;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    FormantFilterTest test;
+    RUN_TEST(testSingleVowel);
+    RUN_TEST(testMorph);
+    return test_summary();
+}
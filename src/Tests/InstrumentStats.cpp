@@ -11,9 +11,11 @@
 */
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
 #include "../Misc/Time.h"
 #include "../Misc/MiddleWare.h"
 #include "../Misc/Part.h"
@@ -41,6 +43,7 @@ MiddleWare *middleware;
 enum RunMode {
     MODE_PROFILE,
     MODE_TEST,
+    MODE_STORM,
 };
 
 RunMode mode;
@@ -144,6 +147,31 @@ void noteOff()
         printf("%f, ", t_off - t_on);
 }
 
+//Worst case latency of note on bursts (e.g. all pads of a drum kit hit in
+//the same buffer), reported as worst and mean burst time in seconds.
+//This has its own mode, so the columns of the profile stay as they are
+void noteOnStorm()
+{
+    const int bursts = 32;
+    const int burst  = 16;
+    double worst = 0.0;
+    double total = 0.0;
+    for(int i=0; i<bursts; ++i) {
+        double t_on = tic();
+        for(int j=0; j<burst; ++j)
+            p->NoteOn(36+j,100,0);
+        p->ComputePartSmps();
+        double t_off = toc();
+        total += t_off - t_on;
+        worst  = std::max(worst, t_off - t_on);
+
+        p->AllNotesOff();
+        p->ComputePartSmps();
+    }
+    if(mode == MODE_STORM)
+        printf("%f, %f", worst, total/bursts);
+}
+
 void memUsage()
 {
     if(mode == MODE_PROFILE)
@@ -389,6 +417,13 @@ int main(int argc, char **argv)
         noteOff();
         memUsage();
         printf("\n");
+    } else if(argc == 3 && !strcmp(argv[1], "--storm")) {
+        mode = MODE_STORM;
+        setup();
+        xml(argv[2]);
+        load();
+        noteOnStorm();
+        printf("\n");
     } else if(argc == 3) {
         mode = MODE_TEST;
         setup();
@@ -1655,6 +1655,45 @@ class KitTest
             verifyPortamento();
         }
 
+        //Notes are rendered in control periods inside of the buffer
+        void testControlPeriod(void)
+        {
+            SYNTH_T s;
+            s.buffersize  = 1024;
+            TS_ASSERT_EQUAL_INT(1024, s.controlperiod());
+            s.controlsize = 64;
+            TS_ASSERT_EQUAL_INT(64, s.controlperiod());
+            s.controlsize = 100;
+            TS_ASSERT_EQUAL_INT(64, s.controlperiod());
+            s.buffersize  = 96;
+            TS_ASSERT_EQUAL_INT(48, s.controlperiod());
+            s.controlsize = 200;
+            TS_ASSERT_EQUAL_INT(96, s.controlperiod());
+
+            s.buffersize  = 1024;
+            s.controlsize = 64;
+            s.alias(false);
+            AbsTime t(s);
+            Part p(alloc, s, t, dummy, dummy, &microtonal, &fft);
+            TS_ASSERT_EQUAL_INT(64, p.ctlsynth.buffersize);
+
+            p.Penabled = true;
+            p.NoteOn(64, 127, 0);
+            float peak = 0.0f;
+            bool  finite = true;
+            for(int b = 0; b < 4; ++b, t++) {
+                p.ComputePartSmps();
+                for(int i = 0; i < s.buffersize; ++i) {
+                    peak    = fmaxf(peak, fabsf(p.partoutl[i]));
+                    finite &= std::isfinite(p.partoutl[i]);
+                }
+            }
+            TS_ASSERT(finite);
+            TS_ASSERT(peak > 0.0f);
+            //the note clock runs once per control period
+            TS_ASSERT_EQUAL_INT(4 * 16, (int)p.ctltime.time());
+        }
+
         void tearDown() {
             delete part;
             delete[] outL;
@@ -1695,5 +1734,6 @@ int main()
     RUN_TEST(testPortamentoOnMonoPlayingLegatoAuto);
     RUN_TEST(testPortamentoOnMonoPlayingStaccatoAuto);
     RUN_TEST(testPortamentoOnMonoPlayingStaccato);
+    RUN_TEST(testControlPeriod);
     return test_summary();
 }
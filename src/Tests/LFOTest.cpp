@@ -0,0 +1,141 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  LFOTest.cpp - Test for the LFOs shared by all notes
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include "../Synth/LFO.h"
+#include "../Params/LFOParams.h"
+#include "../Misc/Time.h"
+#include "../globals.h"
+
+using namespace std;
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define NOTES 16
+
+class LFOTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            time  = new AbsTime(*synth);
+            //the same LFO, but the stretch makes every note compute its own
+            //while it does not change the frequency at 440Hz
+            pars  = new LFOParams(ad_global_amp, time);
+            ref   = new LFOParams(ad_global_amp, time);
+            for(LFOParams *p : {pars, ref}) {
+                p->Pcontinous  = 1;
+                p->Pintensity  = 90;
+                p->freq        = 7.3f;
+                p->Pstartphase = 20;
+                p->fadeout     = 0.1f;
+            }
+            ref->Pstretch = 63;
+        }
+
+        void tearDown() {
+            delete ref;
+            delete pars;
+            delete time;
+            delete synth;
+        }
+
+        void testFreerunning() {
+            TS_ASSERT(pars->freerunning());
+            TS_ASSERT(!ref->freerunning());
+
+            LFOParams p(ad_global_amp, time);
+            TS_ASSERT(!p.freerunning());
+            p.Pcontinous = 1;
+            TS_ASSERT(p.freerunning());
+            p.Prandomness = 1;
+            TS_ASSERT(!p.freerunning());
+            p.Prandomness = 0;
+            p.PLFOtype    = LFO_RANDOM;
+            TS_ASSERT(!p.freerunning());
+            p.PLFOtype = LFO_SQUARE;
+            TS_ASSERT(p.freerunning());
+            p.Pcutoff = 100;
+            TS_ASSERT(!p.freerunning());
+        }
+
+        //Notes started at different times and released in the middle have to
+        //follow the ones computing their own output
+        void testOutput() {
+            for(int shape : {LFO_SINE, LFO_TRIANGLE, LFO_EXP_DOWN1}) {
+                pars->PLFOtype = ref->PLFOtype = shape;
+                LFO *a[NOTES] = {}, *b[NOTES] = {};
+                float err = 0.0f;
+                for(int step = 0; step < 2000; ++step) {
+                    for(int i = 0; i < NOTES; ++i) {
+                        if(step == 50 * i) {
+                            a[i] = new LFO(*pars, 440.0f, *time);
+                            b[i] = new LFO(*ref, 440.0f, *time);
+                        }
+                        if(step == 1000 + 20 * i) {
+                            a[i]->releasekey();
+                            b[i]->releasekey();
+                        }
+                        if(a[i])
+                            err = fmaxf(err, fabsf(a[i]->lfoout()
+                                                   - b[i]->lfoout()));
+                    }
+                    (*time)++;
+                }
+                TS_ASSERT_DELTA(err, 0.0f, 1e-3);
+
+                for(int i = 0; i < NOTES; ++i) {
+                    delete a[i];
+                    delete b[i];
+                }
+            }
+        }
+
+        void testSpeed() {
+            for(LFOParams *p : {ref, pars}) {
+                LFO *l[64];
+                for(int i = 0; i < 64; ++i)
+                    l[i] = new LFO(*p, 440.0f, *time);
+
+                float sum = 0.0f;
+                const clock_t t_on = clock();
+                for(int step = 0; step < 20000; ++step) {
+                    for(int i = 0; i < 64; ++i)
+                        sum += l[i]->lfoout();
+                    (*time)++;
+                }
+                const float t = (float)(clock() - t_on) / CLOCKS_PER_SEC;
+                printf("LFOTest: %f seconds for 64 %s LFOs (%g).\n", t,
+                       p == pars ? "shared" : "separate", sum);
+                TS_ASSERT(t < 1.0f);
+
+                for(int i = 0; i < 64; ++i)
+                    delete l[i];
+            }
+        }
+
+    private:
+        AbsTime   *time;
+        LFOParams *pars, *ref;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    LFOTest test;
+    RUN_TEST(testFreerunning);
+    RUN_TEST(testOutput);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
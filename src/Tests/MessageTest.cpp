@@ -17,6 +17,7 @@
 #include <fstream>
 #include <string>
 #include <thread>
+#include <chrono>
 #include <rtosc/thread-link.h>
 #include <unistd.h>
 #include "../Misc/MiddleWare.h"
@@ -356,6 +357,95 @@ class MessageTest
             }
         }
 
+        void testParamBlock(void)
+        {
+            //Collect one change per part into a single message
+            mw->beginParamBlock();
+            for(int i=0; i<NUM_MIDI_PARTS; ++i)
+                mw->transmitMsg(("/part"+to_s(i)+"/Ppanning").c_str(), "i", 10+i);
+            mw->transmitMsg("/Pkeyshift", "i", 70);
+            TS_ASSERT(!ms->uToB->hasNext());
+            mw->endParamBlock();
+
+            TS_ASSERT(ms->uToB->hasNext());
+            const char *msg = ms->uToB->read();
+            TS_ASSERT_EQUAL_STR("/param-block", msg);
+            TS_ASSERT(!ms->uToB->hasNext());
+            ms->applyOscEvent(msg);
+
+            for(int i=0; i<NUM_MIDI_PARTS; ++i)
+                TS_ASSERT_EQUAL_INT(ms->part[i]->Ppanning, 10+i);
+            TS_ASSERT_EQUAL_INT(ms->Pkeyshift, 70);
+
+            //Only undo events, the damage broadcast and one reply come back
+            int replies = 0;
+            while(ms->bToU->hasNext()) {
+                msg = ms->bToU->read();
+                if(!strcmp(msg, "/param-block")) {
+                    TS_ASSERT_EQUAL_INT(rtosc_argument(msg, 0).i, NUM_MIDI_PARTS+1);
+                    TS_ASSERT_EQUAL_INT(rtosc_argument(msg, 1).i, 0);
+                    replies++;
+                } else if(!strcmp(msg, "/damage"))
+                    TS_ASSERT_EQUAL_STR("/", rtosc_argument(msg, 0).s);
+                else
+                    TS_ASSERT(!strcmp(msg, "/undo_change") ||
+                              !strcmp(msg, "/broadcast"));
+            }
+            TS_ASSERT_EQUAL_INT(replies, 1);
+
+            //Other replies than the echoes of the changes come back, e.g.
+            //the request for the table of a new distortion shape
+            mw->transmitMsg("/sysefx0/efftype", "i", 6);
+            while(ms->uToB->hasNext())
+                ms->applyOscEvent(ms->uToB->read());
+            while(ms->bToU->hasNext())
+                ms->bToU->read();
+            mw->beginParamBlock();
+            mw->transmitMsg("/sysefx0/Distortion/Pdrive", "i", 100);
+            mw->endParamBlock();
+            ms->applyOscEvent(ms->uToB->read());
+            int tables = 0;
+            while(ms->bToU->hasNext()) {
+                msg = ms->bToU->read();
+                TS_ASSERT(strcmp(msg, "/sysefx0/Distortion/Pdrive"));
+                if(!strcmp(msg, "/shapetable")) {
+                    TS_ASSERT(!strncmp(rtosc_argument(msg, 0).s, "/sysefx0/", 9));
+                    TS_ASSERT_EQUAL_INT(rtosc_argument(msg, 2).i, 100);
+                    tables++;
+                }
+            }
+            TS_ASSERT_EQUAL_INT(tables, 1);
+
+            //Compare against the per message path
+            using clk = std::chrono::steady_clock;
+            const int N = 1000;
+            auto t0 = clk::now();
+            for(int j=0; j<N; ++j) {
+                for(int i=0; i<NUM_MIDI_PARTS; ++i)
+                    mw->transmitMsg(("/part"+to_s(i)+"/Ppanning").c_str(), "i", j%128);
+                while(ms->uToB->hasNext())
+                    ms->applyOscEvent(ms->uToB->read());
+                while(ms->bToU->hasNext())
+                    ms->bToU->read();
+            }
+            auto t1 = clk::now();
+            for(int j=0; j<N; ++j) {
+                mw->beginParamBlock();
+                for(int i=0; i<NUM_MIDI_PARTS; ++i)
+                    mw->transmitMsg(("/part"+to_s(i)+"/Ppanning").c_str(), "i", j%128);
+                mw->endParamBlock();
+                while(ms->uToB->hasNext())
+                    ms->applyOscEvent(ms->uToB->read());
+                while(ms->bToU->hasNext())
+                    ms->bToU->read();
+            }
+            auto t2 = clk::now();
+            printf("# per message: %lld us, param block: %lld us (%d x %d changes)\n",
+                   (long long)std::chrono::duration_cast<std::chrono::microseconds>(t1-t0).count(),
+                   (long long)std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count(),
+                   N, NUM_MIDI_PARTS);
+            TS_ASSERT_EQUAL_INT(ms->part[3]->Ppanning, (N-1)%128);
+        }
 
     private:
         SYNTH_T     *synth;
@@ -376,5 +466,6 @@ int main()
     RUN_TEST(testLfoPaste);
     RUN_TEST(testPadPaste);
     RUN_TEST(testFilterDepricated);
+    RUN_TEST(testParamBlock);
     return test_summary();
 }
@@ -17,6 +17,7 @@
 #include <cstring>
 #include <string>
 #include <cstdio>
+#include <cmath>
 #include "../globals.h"
 using namespace std;
 using namespace zyn;
@@ -98,32 +99,80 @@ class MicrotonalTest
             free(tmpo);
         }
 
-#if 0
-        /**\todo Test Saving/loading from file*/
-
-        //Test texttomapping TODO finish
-        void _testTextToMapping() {
-            //the mapping is from old documentation for "Intense Diatonic" scale
-            const char *mapping[12] =
-            {"0", "x", "1", "x", "2", "3", "x", "4", "x", "5", "x", "6"};
-            //for(int i=0;i<20;++i)
-            //    cout << i << ':' << testMicro->getnotefreq(i,0) << endl;
-            //
-            //    octave size == 7
-            //    find dead notes
+        /**\todo test loading from scl and kbm files*/
+
+        //Compares the notes to the frequencies of the computation per note
+        //before the key table, -1 for the unmapped keys
+        void checkNotes(const float *expected, int keyshift) {
+            const int notes[13] = {0, 19, 55, 60, 61, 62, 63, 69, 72, 81,
+                                   100, 101, 127};
+            for(int i = 0; i < 13; ++i)
+                TS_ASSERT_DELTA(testMicro->getnotefreq(notes[i] / 12.0f,
+                                                       keyshift),
+                                expected[i], fabsf(expected[i]) * 1e-5f);
         }
-        //Test texttotunings TODO finish
-        void _testTextToTunings() {
-            //the tuning is from old documentation for "Intense Diatonic" scale
-            const char *tuning[7] =
-            {"9/8", "5/4", "4/3", "3/2", "5/3", "15/8", "2/1"};
-            const int numTunings = 7;
-            //for(int i=0;i<20;++i)
-            //    cout << i << ':' << testMicro->getnotefreq(i,0) << endl;
-            //    go to middle key and verify the proportions
+
+        //Tests the key table with the "Intense Diatonic" scale of the old
+        //documentation
+        void testKeyTable() {
+            const float tet[13] = {8.175798f, 24.4997f, 195.9977f, 261.6255f,
+                277.1826f, 293.6648f, 311.1270f, 440.0f, 523.2511f, 880.0f,
+                2637.0198f, 2793.8264f, 12543.8506f};
+            checkNotes(tet, 0);
+            const float tet3[13] = {9.722718f, 29.1352f, 233.0819f, 311.1270f,
+                329.6275f, 349.2283f, 369.9944f, 523.2511f, 622.2540f,
+                1046.5022f, 3135.9626f, 3322.4382f, 14917.2363f};
+            checkNotes(tet3, 3);
+
+            //the scale without a mapping
+            testMicro->Penabled = 1;
+            testMicro->updatekeytable();
+            TS_ASSERT_EQUAL_INT(-1, testMicro->texttotunings(
+                        "9/8\n5/4\n4/3\n3/2\n5/3\n15/8\n2/1\n"));
+            const float diat[13] = {0.4833983f, 3.222656f, 110.0f, 183.3333f,
+                206.25f, 220.0f, 247.5f, 440.0f, 586.6665f, 1466.6663f,
+                9386.6699f, 10559.9951f, 140799.8906f};
+            checkNotes(diat, 0);
+            const float diat3[13] = {0.644531f, 4.296875f, 146.6667f, 244.4445f,
+                275.0f, 293.3333f, 330.0001f, 586.6665f, 782.2224f,
+                1955.5558f, 12515.5576f, 14080.0f, 187733.3906f};
+            checkNotes(diat3, 3);
+
+            testMicro->Pscaleshift = 66;
+            testMicro->updatekeytable();
+            const float shift[13] = {0.2864583f, 1.933594f, 68.75f, 110.0f,
+                123.75f, 137.5f, 146.6667f, 275.0f, 366.6666f, 880.0f,
+                5866.6685f, 6599.9966f, 84479.9609f};
+            checkNotes(shift, -5);
+
+            //the scale with the mapping of the old documentation
+            testMicro->Pscaleshift     = 64;
+            testMicro->Pmappingenabled = 1;
+            testMicro->Pfirstkey       = 20;
+            testMicro->Plastkey        = 100;
+            testMicro->Pmiddlenote     = 62;
+            testMicro->texttomapping("0\nx\n1\nx\n2\n3\nx\n4\nx\n5\nx\n6\n");
+            TS_ASSERT_EQUAL_INT(12, testMicro->Pmapsize);
+            const float map[13] = {-1.0f, -1.0f, 195.5556f, -1.0f, 275.0f,
+                293.3333f, -1.0f, 440.0f, -1.0f, 880.0f, 2639.9988f, -1.0f,
+                -1.0f};
+            checkNotes(map, 0);
+            const float map5[13] = {-1.0f, -1.0f, 122.2222f, -1.0f,
+                171.875f, 183.3333f, -1.0f, 275.0f, -1.0f, 549.9999f,
+                1649.9991f, -1.0f, -1.0f};
+            checkNotes(map5, -5);
+
+            testMicro->Pinvertupdown = 1;
+            testMicro->updatekeytable();
+            const float inv[13] = {-1.0f, -1.0f, 782.2224f, -1.0f, 586.6665f,
+                549.9999f, -1.0f, 366.6666f, -1.0f, 183.3333f, 61.1111f,
+                -1.0f, -1.0f};
+            checkNotes(inv, 0);
+
+            //loading the defaults has to rebuild the table
+            testMicro->defaults();
+            checkNotes(tet, 0);
         }
-        /**\TODO test loading from scl and kbm files*/
-#endif
 
     private:
         Microtonal *testMicro;
@@ -134,5 +183,6 @@ int main()
     MicrotonalTest test;
     RUN_TEST(testinit);
     RUN_TEST(testXML);
+    RUN_TEST(testKeyTable);
     return test_summary();
 }
@@ -12,10 +12,21 @@
 */
 #include "test-suite.h"
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "../Misc/BankDb.h"
 #include "../Misc/MiddleWare.h"
 #include "../Misc/Master.h"
 #include "../Misc/PresetExtractor.h"
@@ -144,6 +155,154 @@ class MiddleWareTest
             // if this logic gets broken.
         }
 
+        //Instances share the FFT plans, but not their realtime state
+        void testSharedResources()
+        {
+            for(int i = 1; i < NUM_MIDDLEWARE; ++i)
+                TS_ASSERT(master[i]->fft == master[0]->fft);
+
+            master[0]->noteOn(0,64,64);
+            master[1]->AudioOut(outL, outR);
+            float sum = 0.0f;
+            for(int i = 0; i < synth->buffersize; ++i)
+                sum += fabsf(outL[i]);
+            TS_ASSERT(sum == 0.0f);
+
+            master[0]->AudioOut(outL, outR);
+            sum = 0.0f;
+            for(int i = 0; i < synth->buffersize; ++i)
+                sum += fabsf(outL[i]);
+            TS_ASSERT(0.1f < sum);
+        }
+
+        void testSharedBankIndex()
+        {
+            const string dir = "MiddlewareTest-bank/";
+            const string ins = loadfile(string(SOURCE_DIR) + "/guitar-adnote.xmz");
+            mkdir(dir.c_str(), 0755);
+            std::ofstream(dir + "0001-First.xiz") << ins;
+
+            BankDb a, b;
+            a.addBankDir(dir);
+            a.scanBanks();
+            TS_ASSERT_EQUAL_INT(1, (int)a.search("First").size());
+
+            //the second instance reuses the index of the first one
+            std::ofstream(dir + "0002-Second.xiz") << ins;
+            b.addBankDir(dir);
+            b.scanBanks(true);
+            TS_ASSERT_EQUAL_INT(1, (int)b.search("First").size());
+            TS_ASSERT_EQUAL_INT(0, (int)b.search("Second").size());
+
+            //a rescan updates the index of both
+            b.scanBanks();
+            TS_ASSERT_EQUAL_INT(1, (int)b.search("Second").size());
+            TS_ASSERT_EQUAL_INT(1, (int)a.search("Second").size());
+
+            remove((dir + "0001-First.xiz").c_str());
+            remove((dir + "0002-Second.xiz").c_str());
+            rmdir(dir.c_str());
+        }
+
+        //Average time from a backend reply until the MiddleWare handles it,
+        //when sleeping until woken up or polling every millisecond
+        float replyLatency(bool wait)
+        {
+            using clk = std::chrono::steady_clock;
+            const int rounds = 20;
+            static std::atomic<bool> replied;
+            middleware[0]->setUiCallback([](void*, const char *) {
+                    replied = true;}, NULL);
+
+            double total = 0.0;
+            for(int i = 0; i < rounds; ++i) {
+                middleware[0]->tick();
+                replied = false;
+                middleware[0]->transmitMsg("/part0/Pvolume", "");
+                clk::time_point sent;
+                std::thread backend([this, &sent]() {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                        sent = clk::now();
+                        master[0]->AudioOut(outL, outR);});
+                while(!replied) {
+                    if(wait)
+                        middleware[0]->waitForEvents(100);
+                    else
+                        usleep(1000);
+                    middleware[0]->tick();
+                }
+                const clk::time_point handled = clk::now();
+                backend.join();
+                total += std::chrono::duration<double>(handled - sent).count();
+            }
+            return total / rounds;
+        }
+
+        //Share of CPU time used by an idle loop
+        float idleLoad(bool wait)
+        {
+            const auto    until = std::chrono::steady_clock::now()
+                                  + std::chrono::milliseconds(500);
+            const clock_t t_on  = clock();
+            while(std::chrono::steady_clock::now() < until) {
+                if(wait)
+                    middleware[0]->waitForEvents(100);
+                else
+                    usleep(1000);
+                middleware[0]->tick();
+            }
+            return 2.0f * (clock() - t_on) / CLOCKS_PER_SEC;
+        }
+
+        void testEventLoop()
+        {
+            const float poll_latency = replyLatency(false);
+            const float wait_latency = replyLatency(true);
+            const float poll_load    = idleLoad(false);
+            const float wait_load    = idleLoad(true);
+            printf("MiddlewareTest: replies took %f ms when polling and %f ms "
+                   "when waiting for events\n", poll_latency * 1e3,
+                   wait_latency * 1e3);
+            printf("MiddlewareTest: idle loop used %f%% CPU when polling and "
+                   "%f%% when waiting for events\n", poll_load * 100,
+                   wait_load * 100);
+            //a missed wakeup would wait for the 100 ms timeout
+            TS_ASSERT(wait_latency < 0.05f);
+            TS_ASSERT(wait_load < 0.05f);
+        }
+
+        static size_t heapUsage(void)
+        {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+            return mallinfo2().uordblks;
+#else
+            return 0;
+#endif
+        }
+
+        //Cost of one more instance in this process
+        void testInstanceCost()
+        {
+            const int extra = 4;
+            MiddleWare *mw[extra];
+            const size_t  heap   = heapUsage();
+            const clock_t t_on   = clock();
+            for(int i = 0; i < extra; ++i) {
+                SYNTH_T s;
+                s.buffersize = 256;
+                s.samplerate = 48000;
+                mw[i] = new MiddleWare(std::move(s), &config);
+                TS_ASSERT(mw[i]->spawnMaster()->fft == master[0]->fft);
+            }
+            const float  t     = (float)(clock() - t_on) / CLOCKS_PER_SEC;
+            const size_t bytes = heapUsage() - heap;
+            printf("MiddlewareTest: each extra instance took %f seconds to "
+                   "start and %d kB of heap\n", t / extra,
+                   (int)(bytes / extra / 1024));
+            for(int i = 0; i < extra; ++i)
+                delete mw[i];
+        }
+
     private:
         SYNTH_T *synth;
         float *outR, *outL;
@@ -158,5 +317,9 @@ int main()
     RUN_TEST(testPanic);
     RUN_TEST(testLoad);
     RUN_TEST(testChangeToOutOfRangeProgram);
+    RUN_TEST(testSharedResources);
+    RUN_TEST(testSharedBankIndex);
+    RUN_TEST(testEventLoop);
+    RUN_TEST(testInstanceCost);
     return test_summary();
 }
@@ -0,0 +1,170 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  ModulationBankTest.cpp - Test for the batched envelopes and LFOs
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include "../Synth/Envelope.h"
+#include "../Synth/LFO.h"
+#include "../Synth/ModulationBank.h"
+#include "../Params/EnvelopeParams.h"
+#include "../Params/LFOParams.h"
+#include "../Misc/Allocator.h"
+#include "../Misc/Time.h"
+#include "../globals.h"
+
+using namespace std;
+using namespace zyn;
+
+SYNTH_T *synth;
+
+#define NOTES 64
+
+class ModulationBankTest
+{
+    public:
+        void setUp() {
+            synth = new SYNTH_T;
+            time  = new AbsTime(*synth);
+            alloc = new AllocatorClass;
+            bank  = new ModulationBank(*alloc);
+            env   = new EnvelopeParams(64, 1, time);
+            env->init(ad_global_amp);
+            //sine, exponential down and random
+            const int shapes[3] = {0, 5, 6};
+            for(int i = 0; i < 3; ++i) {
+                lfo[i] = new LFOParams(time);
+                lfo[i]->PLFOtype    = shapes[i];
+                lfo[i]->Pintensity  = 90;
+                lfo[i]->freq        = 7.3f;
+                lfo[i]->Pstartphase = 20;
+            }
+        }
+
+        void tearDown() {
+            for(int i = 0; i < 3; ++i)
+                delete lfo[i];
+            delete env;
+            delete bank;
+            delete alloc;
+            delete time;
+            delete synth;
+        }
+
+        void testSlots() {
+            int a = bank->addLfo(), b = bank->addLfo();
+            TS_ASSERT(a != b);
+            bank->removeLfo(a);
+            TS_ASSERT_EQUAL_INT(a, bank->addLfo());
+            bank->removeLfo(a);
+            bank->removeLfo(b);
+
+            ModulationBank small(*alloc, 2);
+            TS_ASSERT(small.addEnvelope() >= 0);
+            TS_ASSERT(small.addEnvelope() >= 0);
+            TS_ASSERT_EQUAL_INT(-1, small.addEnvelope());
+
+            //a full bank leaves the objects to compute their output
+            Envelope e(*env, 440.0f, synth->dt(), 0, 0, &small);
+            Envelope ref(*env, 440.0f, synth->dt());
+            for(int i = 0; i < 100; ++i) {
+                small.tick();
+                TS_ASSERT(e.envout_dB() == ref.envout_dB());
+            }
+        }
+
+        //Notes with a bank have to follow the ones without it, with releases
+        //in the middle of the segments
+        void testOutput() {
+            Envelope *ea[NOTES], *eb[NOTES];
+            LFO      *la[NOTES], *lb[NOTES];
+            for(int i = 0; i < NOTES; ++i) {
+                const LFOParams &lp = *lfo[i % 3];
+                ea[i] = new Envelope(*env, 440.0f, synth->dt());
+                eb[i] = new Envelope(*env, 440.0f, synth->dt(), 0, 0, bank);
+                la[i] = new LFO(lp, 440.0f, *time);
+                lb[i] = new LFO(lp, 440.0f, *time, 0, 0, bank);
+            }
+
+            float err = 0.0f;
+            for(int step = 0; step < 2000; ++step) {
+                bank->tick();
+                for(int i = 0; i < NOTES; ++i) {
+                    if(step == 1000 + i) {
+                        ea[i]->releasekey();
+                        eb[i]->releasekey();
+                        la[i]->releasekey();
+                        lb[i]->releasekey();
+                    }
+                    err = fmaxf(err, fabsf(ea[i]->envout_dB()
+                                           - eb[i]->envout_dB()));
+                    err = fmaxf(err, fabsf(la[i]->lfoout() - lb[i]->lfoout()));
+                }
+                (*time)++;
+            }
+            TS_ASSERT_DELTA(err, 0.0f, 1e-4);
+
+            for(int i = 0; i < NOTES; ++i) {
+                delete ea[i];
+                delete eb[i];
+                delete la[i];
+                delete lb[i];
+            }
+        }
+
+        void testSpeed() {
+            for(int batched = 0; batched < 2; ++batched) {
+                ModulationBank *b = batched ? bank : nullptr;
+                Envelope *e[NOTES];
+                LFO      *l[NOTES];
+                for(int i = 0; i < NOTES; ++i) {
+                    e[i] = new Envelope(*env, 440.0f, synth->dt(), 0, 0, b);
+                    l[i] = new LFO(*lfo[0], 440.0f, *time, 0, 0, b);
+                }
+
+                float sum = 0.0f;
+                const clock_t t_on = clock();
+                for(int step = 0; step < 20000; ++step) {
+                    if(b)
+                        b->tick();
+                    for(int i = 0; i < NOTES; ++i)
+                        sum += e[i]->envout_dB() + l[i]->lfoout();
+                }
+                const float t = (float)(clock() - t_on) / CLOCKS_PER_SEC;
+                printf("ModulationBankTest: %f seconds for %d envelopes and "
+                       "LFOs %s the bank (%g).\n", t, NOTES,
+                       batched ? "with" : "without", sum);
+                TS_ASSERT(t < 1.0f);
+
+                for(int i = 0; i < NOTES; ++i) {
+                    delete e[i];
+                    delete l[i];
+                }
+            }
+        }
+
+    private:
+        AbsTime        *time;
+        Allocator      *alloc;
+        ModulationBank *bank;
+        EnvelopeParams *env;
+        LFOParams      *lfo[3];
+};
+
+int main()
+{
+    tap_quiet = 1;
+    ModulationBankTest test;
+    RUN_TEST(testSlots);
+    RUN_TEST(testOutput);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
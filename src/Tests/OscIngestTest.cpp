@@ -0,0 +1,198 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  OscIngestTest.cpp - Test for the batched reading of OSC packets
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <rtosc/rtosc.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../Misc/OscIngest.h"
+using namespace std;
+using namespace zyn;
+
+class OscIngestTest
+{
+    public:
+        void setUp() {
+            ingest = new OscIngest([this](char *msg, const char *source) {
+                    received.push_back(msg);
+                    if(source)
+                        last_source = source;
+                    },
+                [this](bool begin) {
+                    (begin ? begun : ended).push_back(received.size());
+                    });
+            received.clear();
+            begun.clear();
+            ended.clear();
+            last_source.clear();
+        }
+
+        void tearDown() {
+            delete ingest;
+        }
+
+        void testBundle() {
+            char a[64], b[64], c[64], bundle[256];
+            rtosc_message(a, sizeof(a), "/part0/Pvolume", "i", 10);
+            rtosc_message(b, sizeof(b), "/part1/Pvolume", "i", 20);
+            rtosc_message(c, sizeof(c), "/Pkeyshift", "i", 70);
+            //timetag 1 is "immediately"
+            size_t len = rtosc_bundle(bundle, sizeof(bundle), 1, 3, a, b, c);
+            ingest->dispatch(bundle, len, nullptr, OscIngest::now());
+            len = rtosc_message(a, sizeof(a), "/Pvolume", "f", 0.5f);
+            ingest->dispatch(a, len, "osc.udp://127.0.0.1:1234/", 0);
+
+            TS_ASSERT_EQUAL_INT(4, (int)received.size());
+            TS_ASSERT_EQUAL_STR("/part0/Pvolume", received[0].c_str());
+            TS_ASSERT_EQUAL_STR("/part1/Pvolume", received[1].c_str());
+            TS_ASSERT_EQUAL_STR("/Pkeyshift", received[2].c_str());
+            TS_ASSERT_EQUAL_STR("/Pvolume", received[3].c_str());
+            TS_ASSERT_EQUAL_STR("osc.udp://127.0.0.1:1234/",
+                                last_source.c_str());
+            //the bundle handler encloses the messages of the bundle
+            TS_ASSERT_EQUAL_INT(1, (int)begun.size());
+            TS_ASSERT_EQUAL_INT(1, (int)ended.size());
+            TS_ASSERT_EQUAL_INT(0, (int)begun[0]);
+            TS_ASSERT_EQUAL_INT(3, (int)ended[0]);
+
+            //truncated packets are dropped
+            ingest->dispatch(a, len - 4, nullptr, 0);
+            ingest->dispatch(bundle, 12, nullptr, 0);
+            TS_ASSERT_EQUAL_INT(4, (int)received.size());
+        }
+
+        void testSchedule() {
+            const uint64_t now = OscIngest::now();
+            const uint64_t sec = 1ull << 32;
+            char a[64], b[64], bundle[256], later[256];
+            rtosc_message(a, sizeof(a), "/part0/Pvolume", "i", 10);
+            rtosc_message(b, sizeof(b), "/part1/Pvolume", "i", 20);
+            size_t len = rtosc_bundle(bundle, sizeof(bundle), now + sec / 4,
+                                      1, a);
+            size_t len2 = rtosc_bundle(later, sizeof(later), now + sec / 4,
+                                       1, b);
+
+            TS_ASSERT_EQUAL_INT(-1, ingest->timeout(now));
+            ingest->dispatch(bundle, len, nullptr, now);
+            ingest->dispatch(later, len2, nullptr, now);
+            TS_ASSERT_EQUAL_INT(2, (int)ingest->scheduled());
+            TS_ASSERT_EQUAL_INT(0, (int)received.size());
+            TS_ASSERT_EQUAL_INT(250, ingest->timeout(now));
+
+            TS_ASSERT_EQUAL_INT(0, ingest->tick(now + sec / 8));
+            TS_ASSERT_EQUAL_INT(0, (int)received.size());
+
+            //bundles with the same time keep their order
+            TS_ASSERT_EQUAL_INT(2, ingest->tick(now + sec / 2));
+            TS_ASSERT_EQUAL_INT(2, (int)received.size());
+            TS_ASSERT_EQUAL_STR("/part0/Pvolume", received[0].c_str());
+            TS_ASSERT_EQUAL_STR("/part1/Pvolume", received[1].c_str());
+            TS_ASSERT_EQUAL_INT(0, (int)ingest->scheduled());
+            TS_ASSERT_EQUAL_INT(-1, ingest->timeout(now));
+        }
+
+        //Wait until count messages arrived
+        bool receive(int fd, size_t count) {
+            while(received.size() < count) {
+                pollfd pfd = {fd, POLLIN, 0};
+                if(poll(&pfd, 1, 1000) <= 0)
+                    return false;
+                ingest->drain(fd);
+            }
+            return true;
+        }
+
+        void testSocket() {
+            int rx = socket(AF_INET, SOCK_DGRAM, 0);
+            int tx = socket(AF_INET, SOCK_DGRAM, 0);
+            sockaddr_in addr = {};
+            addr.sin_family      = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t addrlen    = sizeof(addr);
+            TS_ASSERT(!bind(rx, (sockaddr *)&addr, addrlen));
+            TS_ASSERT(!getsockname(rx, (sockaddr *)&addr, &addrlen));
+
+            //one update per datagram, then the same updates in bundles
+            const int rounds = 500, per_round = 64;
+            char msgs[per_round][64];
+            for(int i = 0; i < per_round; ++i)
+                rtosc_message(msgs[i], sizeof(msgs[i]),
+                              ("/part" + to_string(i % 16) + "/Pvolume").c_str(),
+                              "i", i);
+            char bundle[per_round / 4 * 64 + 64];
+            size_t bundle_len = 16;
+            rtosc_bundle(bundle, sizeof(bundle), 1, 0);
+            for(int i = 0; i < per_round / 4; ++i) {
+                const size_t len = rtosc_message_length(msgs[i], -1);
+                const uint32_t be = htonl(len);
+                memcpy(bundle + bundle_len, &be, 4);
+                memcpy(bundle + bundle_len + 4, msgs[i], len);
+                bundle_len += 4 + len;
+            }
+
+            for(int bundled = 0; bundled < 2; ++bundled) {
+                received.clear();
+                using clk = std::chrono::steady_clock;
+                clk::duration latency{};
+                const auto t_on = clk::now();
+                for(int r = 0; r < rounds; ++r) {
+                    const auto t = clk::now();
+                    if(bundled)
+                        for(int i = 0; i < 4; ++i)
+                            sendto(tx, bundle, bundle_len, 0,
+                                   (sockaddr *)&addr, addrlen);
+                    else
+                        for(int i = 0; i < per_round; ++i)
+                            sendto(tx, msgs[i],
+                                   rtosc_message_length(msgs[i], -1), 0,
+                                   (sockaddr *)&addr, addrlen);
+                    TS_ASSERT(receive(rx, (r + 1) * per_round));
+                    latency += clk::now() - t;
+                }
+                const double total = std::chrono::duration<double>(
+                        clk::now() - t_on).count();
+                TS_ASSERT_EQUAL_INT(rounds * per_round, (int)received.size());
+                printf("OscIngestTest: %s: %.0f messages/s, %.1f us from "
+                       "sending %d updates until all were read\n",
+                       bundled ? "bundles" : "messages",
+                       rounds * per_round / total,
+                       std::chrono::duration<double, std::micro>(latency)
+                       .count() / rounds, per_round);
+            }
+            TS_ASSERT(!last_source.compare(0, 20, "osc.udp://127.0.0.1:"));
+
+            close(tx);
+            close(rx);
+        }
+
+    private:
+        OscIngest     *ingest;
+        vector<string> received;
+        vector<size_t> begun, ended;
+        string         last_source;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    OscIngestTest test;
+    RUN_TEST(testBundle);
+    RUN_TEST(testSchedule);
+    RUN_TEST(testSocket);
+    return test_summary();
+}
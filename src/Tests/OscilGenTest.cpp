@@ -105,6 +105,61 @@ class OscilGenTest
             TS_ASSERT_DELTA(outR[66], 0.001293f, 0.0001f);
         }
 
+        //repeated notes may reuse the last oscillator, which must not
+        //change the result
+        void testRepeatedGet(void)
+        {
+            oscil->Prand = 64;
+            oscil->Pamprandtype = 0;
+            oscil->Padaptiveharmonics = 0;
+
+            oscil->get(outL, freq);
+            oscil->get(outR, freq * 8.0f);
+            oscil->get(outR, freq);
+            for(int i = 0; i < synth->oscilsize; ++i)
+                TS_ASSERT_EQUAL_FLT(outL[i], outR[i]);
+
+            //changed parameters must not return the old oscillator
+            oscil->Pharmonicshift = 1;
+            oscil->get(outR, freq);
+            bool changed = false;
+            for(int i = 0; i < synth->oscilsize; ++i)
+                changed |= outL[i] != outR[i];
+            TS_ASSERT(changed);
+        }
+
+        //editing any stage after the cached ones has to give the same
+        //oscillator as computing all of them again
+        void testStages(void)
+        {
+            oscil->Prand = 64;
+            FFTwrapper *fft2 = new FFTwrapper(synth->oscilsize);
+            for(int edit = 0; edit < 8; ++edit) {
+                switch(edit) {
+                    case 0: oscil->Pmodulation = 1; break;
+                    case 1: oscil->Pwaveshapingfunction = 3; break;
+                    case 2: oscil->Pfilterpar1 = 30; break;
+                    case 3: oscil->Phmag[3] = 100; break;
+                    case 4: oscil->Pcurrentbasefunc = 3; break;
+                    case 5: oscil->Pbasefuncpar = 20; break;
+                    case 6: oscil->Pharmonicshiftfirst = 1;
+                            oscil->Pharmonicshift = 2; break;
+                    case 7: oscil->Psatype = 1; break;
+                }
+                oscil->prepare();
+                oscil->get(outL, -1.0f);
+
+                OscilGen fresh(*synth, fft2, NULL);
+                fresh.paste(*oscil);
+                fresh.get(outR, -1.0f);
+                int errors = 0;
+                for(int i = 0; i < synth->oscilsize; ++i)
+                    errors += outL[i] != outR[i];
+                TS_ASSERT_EQUAL_INT(0, errors);
+            }
+            delete fft2;
+        }
+
         //performance testing
 #ifdef __linux__
         void testSpeed() {
@@ -125,6 +180,34 @@ class OscilGenTest
 
             printf("OscilGenTest: %f seconds for %d gets.\n",
                    (static_cast<float>(t_off - t_on)) / CLOCKS_PER_SEC, samps);
+
+            //switching between base functions takes them from the cache
+            t_on = clock();
+            for(int i = 0; i < samps / 10; ++i) {
+                oscil->Pbasefuncpar = 32 + i % 2;
+                oscil->prepare();
+            }
+            t_off = clock();
+
+            printf("OscilGenTest: %f seconds for %d base function changes.\n",
+                   (static_cast<float>(t_off - t_on)) / CLOCKS_PER_SEC,
+                   samps / 10);
+
+            //note on cost of get(): only repeating the last band limit can
+            //reuse the oscillator, each note of a chord computes its own
+            oscil->Prand = 64;
+            oscil->Pamprandtype = 0;
+            oscil->Padaptiveharmonics = 0;
+            oscil->prepare();
+            for(int chord = 0; chord < 2; ++chord) {
+                t_on = clock();
+                for(int i = 0; i < samps; ++i)
+                    oscil->get(outL, chord ? freq * (1 + i % 16) : freq);
+                t_off = clock();
+                printf("OscilGenTest: %f us per get() for %s.\n",
+                       1e6f * (t_off - t_on) / CLOCKS_PER_SEC / samps,
+                       chord ? "a chord of 16 pitches" : "a repeated pitch");
+            }
         }
 #endif
 };
@@ -135,6 +218,8 @@ int main()
     RUN_TEST(testInit);
     RUN_TEST(testOutput);
     RUN_TEST(testSpectrum);
+    RUN_TEST(testRepeatedGet);
+    RUN_TEST(testStages);
 #ifdef __linux__
     RUN_TEST(testSpeed);
 #endif
@@ -209,30 +209,30 @@ class PadNoteTest
 
 
             for(int i=0; i<8; ++i)
-                TS_NON_NULL(pars->sample[i].smp);
+                TS_NON_NULL(pars->sample[i].data);
             for(int i=8; i<PAD_MAX_SAMPLES; ++i)
-                TS_ASSERT(!pars->sample[i].smp);
-
-            TS_ASSERT_DELTA(pars->sample[0].smp[0],   0.0516f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[1],   0.0845f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[2],   0.1021f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[3],   0.0919f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[4],   0.0708f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[5],   0.0414f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[6],   0.0318f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[7],   0.0217f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[8],   0.0309f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[9],   0.0584f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[10],  0.0266f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[11],  0.0436f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[12],  0.0199f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[13],  0.0505f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[14],  0.0438f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[15],  0.0024f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[16],  0.0052f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[17], -0.0180f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[18],  0.0342f, 0.0005f);
-            TS_ASSERT_DELTA(pars->sample[0].smp[19],  0.0051f, 0.0005f);
+                TS_ASSERT(!pars->sample[i].data);
+
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[0],   0.0516f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[1],   0.0845f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[2],   0.1021f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[3],   0.0919f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[4],   0.0708f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[5],   0.0414f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[6],   0.0318f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[7],   0.0217f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[8],   0.0309f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[9],   0.0584f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[10],  0.0266f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[11],  0.0436f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[12],  0.0199f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[13],  0.0505f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[14],  0.0438f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[15],  0.0024f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[16],  0.0052f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[17], -0.0180f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[18],  0.0342f, 0.0005f);
+            TS_ASSERT_DELTA(pars->sample[0].data->smp[19],  0.0051f, 0.0005f);
 
 
             //Verify Harmonic Input
@@ -276,6 +276,77 @@ class PadNoteTest
 
         }
 
+        static float rms(const PADnoteParameters::SampleData *data) {
+            double sum = 0.0;
+            for(int i = 0; i < data->size; ++i) {
+                const float x = data->smp16 ? data->smp16[i] * data->scale
+                                            : data->smp[i];
+                sum += x * x;
+            }
+            return sqrt(sum / data->size);
+        }
+
+        //Kit items with the same spectrum share their wavetables and
+        //compact wavetables use half the memory at the same level
+        void testSharedCompact() {
+            PADnoteParameters *copy = new PADnoteParameters(*synth, fft, time);
+            copy->paste(*pars);
+            copy->applyparameters([]{return false;}, 1);
+            for(int i = 0; i < PAD_MAX_SAMPLES; ++i)
+                TS_ASSERT(copy->sample[i].data == pars->sample[i].data);
+            size_t shared = 0;
+            const size_t bytes = pars->sampleMemory(&shared);
+            TS_ASSERT(bytes > 0);
+            TS_ASSERT(shared == bytes);
+
+            copy->Pquality.compact = true;
+            copy->applyparameters([]{return false;}, 1);
+            pars->sampleMemory(&shared);
+            TS_ASSERT(shared == 0);
+            TS_ASSERT(2 * copy->sampleMemory() == bytes);
+            for(int i = 0; i < 8; ++i) {
+                const auto *data = copy->sample[i].data;
+                TS_NON_NULL(data);
+                TS_NON_NULL(data->smp16);
+                TS_ASSERT(!data->smp);
+                TS_ASSERT_DELTA(rms(data), rms(pars->sample[i].data), 1e-3f);
+            }
+
+            //Notes play the compact wavetables
+            SynthParams pars_{memory, *controller, *synth, *time, 120, 0,
+                              test_freq_log2, false, prng()};
+            PADnote *compact = new PADnote(copy, pars_, interpolation);
+            float peak = 0.0f;
+            for(int b = 0; b < 10; ++b) {
+                compact->noteout(outL, outR);
+                for(int i = 0; i < synth->buffersize; ++i)
+                    peak = fmaxf(peak, fabsf(outL[i]));
+            }
+            TS_ASSERT(peak > 0.01f);
+            TS_ASSERT(peak < 10.0f);
+            delete compact;
+            delete copy;
+        }
+
+        //Spectra with the same hash must not share their wavetable
+        void testKeyCollision() {
+            typedef PADnoteParameters::SampleData SampleData;
+            const float a[4] = {0.0f, 1.0f, 2.0f, 0.0f};
+            const float b[4] = {0.0f, 1.0f, 3.0f, 0.0f};
+            PADnoteParameters::SpectrumKey key_a(a, 4, false);
+            PADnoteParameters::SpectrumKey key_b(b, 4, false);
+            TS_ASSERT(key_a.hash != key_b.hash);
+            TS_ASSERT(key_a.check != key_b.check);
+            key_b.hash = key_a.hash;
+
+            SampleData *data = SampleData::insert(new SampleData(key_a));
+            TS_ASSERT(!SampleData::find(key_b));
+            SampleData *same = SampleData::find(key_a);
+            TS_ASSERT(same == data);
+            SampleData::release(same);
+            SampleData::release(data);
+        }
+
 #define OUTPUT_PROFILE
 #ifdef OUTPUT_PROFILE
         void testSpeed() {
@@ -297,6 +368,8 @@ int main()
     PadNoteTest test;
     RUN_TEST(testDefaults);
     RUN_TEST(testInitialization);
+    RUN_TEST(testSharedCompact);
+    RUN_TEST(testKeyCollision);
     RUN_TEST(testSpeed);
     return test_summary();
 }
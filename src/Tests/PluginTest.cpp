@@ -16,8 +16,12 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <chrono>
 #include "../Misc/MiddleWare.h"
 #include "../Misc/Master.h"
+#include "../Misc/Part.h"
+#include "../Misc/XMLwrapper.h"
+#include "../Params/PADnoteParameters.h"
 #include "../Misc/PresetExtractor.h"
 #include "../Misc/PresetExtractor.cpp"
 #include "../Misc/Util.h"
@@ -242,6 +246,60 @@ class PluginTest
             free(result);
         }
 
+        //Parts are parsed and prepared in parallel, which has to give the
+        //same session as a serial load
+        void testParallelLoad(void)
+        {
+            const string fname = string(SOURCE_DIR) + "/guitar-adnote.xmz";
+            TS_ASSERT_EQUAL_INT(0, master[0]->loadXML(fname.c_str()));
+
+            //Make a session of 16 parts with additional PADsynth kit items
+            XMLwrapper part_xml;
+            part_xml.beginbranch("PART");
+            master[0]->part[0]->add2XML(part_xml);
+            part_xml.endbranch();
+            for(int i = 1; i < NUM_MIDI_PARTS; ++i) {
+                TS_ASSERT(part_xml.enterbranch("PART"));
+                master[0]->part[i]->getfromXML(part_xml);
+                part_xml.exitbranch();
+                master[0]->part[i]->setkititemstatus(1, true);
+                master[0]->part[i]->kit[1].Ppadenabled = true;
+            }
+            char *session = NULL;
+            master[0]->getalldata(&session);
+
+            //Load it serially into master 1 and in parallel into master 2
+            float load_time[2];
+            for(int k = 0; k < 2; ++k) {
+                XMLwrapper xml;
+                TS_ASSERT(xml.putXMLdata(session));
+                TS_ASSERT(xml.enterbranch("MASTER"));
+                const auto t_on = std::chrono::steady_clock::now();
+                master[k+1]->getfromXML(xml, k ? 0 : 1);
+                master[k+1]->applyparameters(k ? 0 : 1);
+                const std::chrono::duration<float> t =
+                    std::chrono::steady_clock::now() - t_on;
+                load_time[k] = t.count();
+            }
+
+            char *serial = NULL, *parallel = NULL;
+            master[1]->getalldata(&serial);
+            master[2]->getalldata(&parallel);
+            TS_ASSERT(!strcmp(serial, parallel));
+            if(strcmp(serial, parallel))
+                print_string_differences(serial, parallel);
+            for(int i = 1; i < NUM_MIDI_PARTS; ++i)
+                TS_ASSERT(master[2]->part[i]->kit[1].padpars->sample[0].data);
+
+            printf("PluginTest: loaded %d parts in %f seconds serially, "
+                   "in %f seconds in parallel.\n",
+                   NUM_MIDI_PARTS, load_time[0], load_time[1]);
+
+            free(session);
+            free(serial);
+            free(parallel);
+        }
+
 
     private:
         float *outR, *outL;
@@ -254,5 +312,6 @@ int main()
     RUN_TEST(testInit);
     RUN_TEST(testPanic);
     RUN_TEST(testLoadSave);
+    RUN_TEST(testParallelLoad);
     return test_summary();
 }
@@ -0,0 +1,246 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  UndoStoreTest.cpp - Test for the bounded undo history
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <rtosc/rtosc.h>
+#include "../Misc/UndoStore.h"
+using namespace std;
+using namespace zyn;
+
+class UndoStoreTest
+{
+    public:
+        void setUp() {
+            undo = new UndoStore();
+            undo->setCallback([this](const char *msg) {
+                    replayed.push_back(msg);
+                    const char *types = rtosc_argument_string(msg);
+                    if(types[0] == 'i')
+                        value = rtosc_argument(msg, 0).i;
+                    else if(types[0] == 'f')
+                        fvalue = rtosc_argument(msg, 0).f;
+                    else if(types[0] == 's')
+                        svalue = rtosc_argument(msg, 0).s;
+                    else if(types[0] == 'b')
+                        svalue.assign((const char *)
+                                      rtosc_argument(msg, 0).b.data,
+                                      rtosc_argument(msg, 0).b.len);
+                    else
+                        value = types[0] == 'T';
+                    });
+            replayed.clear();
+            value  = 0;
+            fvalue = 0;
+            svalue.clear();
+        }
+
+        void tearDown() {
+            delete undo;
+        }
+
+        //The message of the backend for a changed integer
+        void change(const char *path, int from, int to, double time) {
+            rtosc_message(buf, sizeof(buf), "/undo_change", "sii",
+                          path, from, to);
+            undo->recordEvent(buf, time);
+        }
+
+        void testUndoRedo() {
+            change("/part0/Pvolume", 96, 100, 0);
+            rtosc_message(buf, sizeof(buf), "/undo_change", "sff",
+                          "/part0/Ppanning", 0.5f, 0.25f);
+            undo->recordEvent(buf, 10);
+            rtosc_message(buf, sizeof(buf), "/undo_change", "sFT",
+                          "/part0/Penabled");
+            undo->recordEvent(buf, 20);
+            TS_ASSERT_EQUAL_INT(3, (int)undo->size());
+
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("/part0/Penabled", replayed.back().c_str());
+            TS_ASSERT_EQUAL_INT(0, value);
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("/part0/Ppanning", replayed.back().c_str());
+            TS_ASSERT_DELTA(0.5f, fvalue, 0.0f);
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("/part0/Pvolume", replayed.back().c_str());
+            TS_ASSERT_EQUAL_INT(96, value);
+            //nothing left to undo
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_INT(3, (int)replayed.size());
+            TS_ASSERT_EQUAL_INT(0, (int)undo->position());
+
+            undo->seekHistory(2);
+            TS_ASSERT_EQUAL_INT(100, value);
+            TS_ASSERT_DELTA(0.25f, fvalue, 0.0f);
+            TS_ASSERT_EQUAL_INT(2, (int)undo->position());
+
+            //a new change drops the step which could be redone
+            change("/part0/Pkeyshift", 64, 60, 30);
+            TS_ASSERT_EQUAL_INT(3, (int)undo->size());
+            undo->seekHistory(1);
+            TS_ASSERT_EQUAL_INT(5, (int)replayed.size());
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("/part0/Pkeyshift", replayed.back().c_str());
+            TS_ASSERT_EQUAL_INT(64, value);
+        }
+
+        void testStrings() {
+            rtosc_message(buf, sizeof(buf), "/undo_change", "sss",
+                          "/part0/Pname", "Piano", "Strings");
+            undo->recordEvent(buf, 0);
+            const char blob_a[] = "abc", blob_b[] = "defgh";
+            rtosc_message(buf, sizeof(buf), "/undo_change", "sbb",
+                          "/part0/data", 3, blob_a, 5, blob_b);
+            undo->recordEvent(buf, 10);
+
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("abc", svalue.c_str());
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("Piano", svalue.c_str());
+            undo->seekHistory(2);
+            TS_ASSERT_EQUAL_STR("defgh", svalue.c_str());
+            undo->seekHistory(-2);
+            undo->seekHistory(1);
+            TS_ASSERT_EQUAL_STR("Strings", svalue.c_str());
+
+            //other messages are not recorded
+            rtosc_message(buf, sizeof(buf), "/undo_change", "ii", 1, 2);
+            undo->recordEvent(buf, 20);
+            TS_ASSERT_EQUAL_INT(2, (int)undo->size());
+        }
+
+        void testMerge() {
+            //a sweep of one knob is undone at once
+            for(int i = 0; i < 100; ++i)
+                change("/part0/Pvolume", i, i + 1, i * 0.01);
+            TS_ASSERT_EQUAL_INT(1, (int)undo->size());
+            //another path and a pause start new entries
+            change("/part1/Pvolume", 0, 1, 1.0);
+            change("/part1/Pvolume", 1, 2, 10.0);
+            TS_ASSERT_EQUAL_INT(3, (int)undo->size());
+
+            undo->seekHistory(-3);
+            TS_ASSERT_EQUAL_INT(0, value);
+            undo->seekHistory(1);
+            TS_ASSERT_EQUAL_INT(100, value);
+
+            //nor does undoing merge the next change with an older one
+            change("/part0/Pvolume", 100, 50, 10.5);
+            TS_ASSERT_EQUAL_INT(2, (int)undo->size());
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_INT(100, value);
+        }
+
+        void testLimit() {
+            undo->setMaxMemory(4096);
+            for(int i = 0; i < 10000; ++i)
+                change(("/part" + to_string(i % 16) + "/Pvolume").c_str(),
+                       i, i + 1, i * 10.0);
+            TS_ASSERT(undo->memoryUsage() <= 4096);
+            TS_ASSERT(undo->size() > 100);
+            TS_ASSERT_EQUAL_INT((int)undo->size(), (int)undo->position());
+
+            //the newest changes are kept
+            const int kept = undo->size();
+            undo->seekHistory(-kept);
+            TS_ASSERT_EQUAL_INT(10000 - kept, value);
+            TS_ASSERT_EQUAL_INT(kept, (int)replayed.size());
+            undo->seekHistory(kept);
+            TS_ASSERT_EQUAL_INT(10000, value);
+
+            //the paths of dropped entries do not stay in the path table
+            undo->clear();
+            for(int i = 0; i < 10000; ++i)
+                change(("/part0/kit" + to_string(i) + "/Padenabled").c_str(),
+                       i, i + 1, i * 10.0);
+            TS_ASSERT(undo->memoryUsage() <= 4096);
+            TS_ASSERT(undo->size() > 10);
+            replayed.clear();
+            undo->seekHistory(-1);
+            TS_ASSERT_EQUAL_STR("/part0/kit9999/Padenabled",
+                                replayed.back().c_str());
+            TS_ASSERT_EQUAL_INT(9999, value);
+            const string oldest = "/part0/kit"
+                                  + to_string(10000 - undo->size())
+                                  + "/Padenabled";
+            undo->seekHistory(-(int)undo->size());
+            TS_ASSERT(replayed.back() == oldest);
+        }
+
+        void testSpeed() {
+            //a long session: one million changes of 1024 parameters
+            const int changes = 1000000, params = 1024;
+            vector<string> paths;
+            for(int i = 0; i < params; ++i)
+                paths.push_back("/part" + to_string(i % 16) + "/kit0/adpars/"
+                                "VoicePar" + to_string(i / 16 % 8)
+                                + "/Pparam" + to_string(i / 128));
+            undo->setMaxMemory(1ull << 30);
+            int replays = 0;
+            undo->setCallback([&replays](const char *) {++replays;});
+
+            size_t osc_bytes = 0;
+            unsigned seed = 1;
+            using clk = std::chrono::steady_clock;
+            const auto t_on = clk::now();
+            for(int i = 0; i < changes; ++i) {
+                seed = seed * 1103515245 + 12345;
+                const int p = (seed >> 8) % params;
+                const int v = (seed >> 4) % 128;
+                osc_bytes += rtosc_message(buf, sizeof(buf), "/undo_change",
+                                           "sii", paths[p].c_str(), v,
+                                           (v + 1) % 128);
+                undo->recordEvent(buf, i * 10.0);
+            }
+            const auto t_rec = clk::now();
+            undo->seekHistory(-changes);
+            const auto t_undo = clk::now();
+            undo->seekHistory(changes);
+            const auto t_redo = clk::now();
+
+            TS_ASSERT_EQUAL_INT(changes, (int)undo->size());
+            TS_ASSERT_EQUAL_INT(2 * changes, replays);
+            TS_ASSERT(undo->memoryUsage() < osc_bytes / 3);
+
+            auto us = [](clk::duration d) {
+                return std::chrono::duration<double, std::micro>(d).count();
+            };
+            printf("UndoStoreTest: %d changes: %.1f MiB for %.1f MiB of OSC, "
+                   "%.3f us to record, %.3f us to undo, %.3f us to redo\n",
+                   changes, undo->memoryUsage() / 1048576.0,
+                   osc_bytes / 1048576.0, us(t_rec - t_on) / changes,
+                   us(t_undo - t_rec) / changes, us(t_redo - t_undo) / changes);
+        }
+
+    private:
+        UndoStore     *undo;
+        vector<string> replayed;
+        int            value;
+        float          fvalue;
+        string         svalue;
+        char           buf[256];
+};
+
+int main()
+{
+    tap_quiet = 1;
+    UndoStoreTest test;
+    RUN_TEST(testUndoRedo);
+    RUN_TEST(testStrings);
+    RUN_TEST(testMerge);
+    RUN_TEST(testLimit);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
@@ -0,0 +1,135 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  VoiceGovernorTest.cpp - Test for the adaptive polyphony limit
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include "../Misc/Config.h"
+#include "../Misc/Master.h"
+#include "../Misc/Part.h"
+#include "../Misc/VoiceGovernor.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+SYNTH_T *synth;
+
+class VoiceGovernorTest
+{
+    public:
+        void setUp() {
+            synth  = new SYNTH_T;
+            master = new Master(*synth, &config);
+            master->initialize_rt();
+            outl   = new float[synth->buffersize];
+            outr   = new float[synth->buffersize];
+
+            //two parts with the same instrument, the second one quieter
+            master->partonoff(1, 1);
+            master->part[1]->Prcvchn = 1;
+            master->part[1]->setVolumedB(-20.0f);
+            for(int i = 0; i < 6; ++i) {
+                master->noteOn(0, 60 + i, 100);
+                master->noteOn(1, 60 + i, 100);
+            }
+        }
+
+        void tearDown() {
+            delete master;
+            delete[] outl;
+            delete[] outr;
+            delete synth;
+        }
+
+        int voices(int part) {
+            return VoiceGovernor::runningVoices(master->part + part, 1);
+        }
+
+        //Whether a note of the part is still running
+        bool running(int part, int note) {
+            NotePool &pool = master->part[part]->notePool;
+            for(auto &desc:pool.activeDesc())
+                if(desc.note == note && !desc.entombed())
+                    return true;
+            return false;
+        }
+
+        void run(int buffers, float load) {
+            master->governor.testload = load;
+            for(int i = 0; i < buffers; ++i)
+                master->AudioOut(outl, outr);
+        }
+
+        void testDisabled() {
+            VoiceGovernor &gov = master->governor;
+            run(10, 2.0f);
+            TS_ASSERT_DELTA(gov.load, 2.0f, 0.001f);
+            TS_ASSERT_EQUAL_INT(gov.limit, 0);
+            TS_ASSERT_EQUAL_INT((int)gov.shed, 0);
+            TS_ASSERT_EQUAL_INT(voices(0) + voices(1), 12);
+        }
+
+        void testShedAndRestore() {
+            VoiceGovernor &gov = master->governor;
+            gov.Penabled = true;
+            //let the envelopes rise without any pressure, past the time
+            //during which notes are only shed after older ones
+            run(synth->samplerate / synth->buffersize / 2, 0.2f);
+            TS_ASSERT_EQUAL_INT(gov.limit, 0);
+            TS_ASSERT_EQUAL_INT(voices(0) + voices(1), 12);
+
+            //twice the buffer time keeps 12 * 0.8 / 2 voices,
+            //the quiet part is shed first
+            run(1, 2.0f);
+            TS_ASSERT_EQUAL_INT(gov.limit, 4);
+            TS_ASSERT_EQUAL_INT((int)gov.shed, 8);
+            TS_ASSERT_EQUAL_INT(voices(0), 4);
+            TS_ASSERT_EQUAL_INT(voices(1), 0);
+
+            //the limit holds for new notes, but an older note is shed
+            //instead of the new one which is still in its attack
+            master->noteOn(0, 70, 100);
+            run(1, 0.2f);
+            TS_ASSERT_EQUAL_INT(voices(0), 4);
+            TS_ASSERT_EQUAL_INT((int)gov.shed, 9);
+            TS_ASSERT(running(0, 70));
+            TS_ASSERT(gov.load > 0.2f);
+
+            //with enough headroom the limit is raised and then dropped
+            run(synth->samplerate / synth->buffersize * 2, 0.2f);
+            TS_ASSERT_EQUAL_INT(gov.limit, 0);
+            TS_ASSERT_DELTA(gov.load, 0.2f, 0.01f);
+            master->noteOn(0, 71, 100);
+            master->noteOn(0, 72, 100);
+            run(1, 0.2f);
+            TS_ASSERT_EQUAL_INT(voices(0), 6);
+            TS_ASSERT_EQUAL_INT((int)gov.shed, 9);
+        }
+
+        //The measured render time is used without a test load
+        void testMeasured() {
+            VoiceGovernor &gov = master->governor;
+            run(10, -1.0f);
+            TS_ASSERT(gov.load > 0.0f);
+        }
+
+    private:
+        Config config;
+        Master *master;
+        float  *outl, *outr;
+};
+
+int main()
+{
+    tap_quiet = 1;
+    VoiceGovernorTest test;
+    RUN_TEST(testDisabled);
+    RUN_TEST(testShedAndRestore);
+    RUN_TEST(testMeasured);
+    return test_summary();
+}
@@ -82,6 +82,37 @@ class WatchTest
             TS_ASSERT(!tr->hasNext());
         }
 
+        //Watch points resolve their slot only when the set of watches
+        //changes
+        void testInternedWatch(void)
+        {
+            //any number of distinct paths can be watched later on
+            for(int i=0; i<2000; ++i) {
+                LFO *tmp = new LFO(*par, 440.0, *at, w,
+                                   ("/tmp" + to_string(i) + "/").c_str());
+                delete tmp;
+            }
+            LFO *a = new LFO(*par, 440.0, *at, w, "/a/");
+            LFO *b = new LFO(*par, 440.0, *at, w, "/b/");
+            TS_ASSERT(WatchManager::hash("/a/out") != WatchManager::hash("/b/out"));
+
+            w->add_watch("/b/out");
+            a->lfoout();
+            b->lfoout();
+            w->tick();
+            TS_ASSERT(tr->hasNext());
+            TS_ASSERT_EQUAL_STR("/b/out", tr->read());
+            TS_ASSERT(!tr->hasNext());
+
+            //The slot was released by the tick
+            TS_ASSERT(!w->active("/b/out"));
+            b->lfoout();
+            w->tick();
+            TS_ASSERT(!tr->hasNext());
+            delete a;
+            delete b;
+        }
+
 };
 
 int main()
@@ -89,5 +120,6 @@ int main()
     WatchTest test;
     RUN_TEST(testNoWatch);
     RUN_TEST(testPhaseWatch);
+    RUN_TEST(testInternedWatch);
     return test_summary();
 }
@@ -0,0 +1,169 @@
+/*
+  ZynAddSubFX - a software synthesizer
+
+  WaveShaperTest.cpp - Test for the tabulated and oversampled waveshaper
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License
+  as published by the Free Software Foundation; either version 2
+  of the License, or (at your option) any later version.
+*/
+#include "test-suite.h"
+#include <cmath>
+#include <ctime>
+#include "../Misc/WaveShapeSmps.h"
+#include "../globals.h"
+
+using namespace zyn;
+
+#define TYPES 17
+#define BUF   256
+#define N     4096
+//input sine exactly on bin 83, so each harmonic falls on a multiple of it
+#define BIN   83
+
+class WaveShaperTest
+{
+    public:
+        void setUp() {}
+        void tearDown() {}
+
+        static void sine(float *smps, int n, int offset) {
+            for(int i = 0; i < n; ++i)
+                smps[i] = 0.9f * sinf(2 * PI * BIN * (i + offset) / N);
+        }
+
+        //Energy of everything which is not a harmonic of the input
+        //(i.e. aliases) relative to the total energy
+        static float aliasing(const float *smps) {
+            double total = 0.0, harmonics = 0.0;
+            for(int i = 0; i < N; ++i)
+                total += smps[i] * smps[i];
+            for(int k = 0; k * BIN < N / 2; ++k) {
+                double re = 0.0, im = 0.0;
+                for(int i = 0; i < N; ++i) {
+                    const double phase = 2 * M_PI * ((k * BIN * i) % N) / N;
+                    re += smps[i] * cos(phase);
+                    im += smps[i] * sin(phase);
+                }
+                harmonics += (k ? 2.0 : 1.0) * (re * re + im * im) / N;
+            }
+            return fmax(total - harmonics, 0.0) / (total + 1e-20);
+        }
+
+        //Set the parameters and the table as Distortion does
+        static WaveShaper::Table *setup(WaveShaper &ws, int type, int drive,
+                                        int os) {
+            ws.setup(type, drive, 64, 32, os);
+            WaveShaper::Table *table = nullptr;
+            if(ws.needstable())
+                table = WaveShaper::buildtable(type, drive, 64, 32);
+            ws.settable(table);
+            return table;
+        }
+
+        //Run a sine through the shaper, returning the last N samples
+        static void run(WaveShaper &ws, float *out) {
+            float buf[BUF];
+            for(int b = 0; b < N / BUF + 1; ++b) {
+                sine(buf, BUF, b * BUF);
+                ws.shape(BUF, buf);
+                if(b)
+                    memcpy(out + (b - 1) * BUF, buf, sizeof(buf));
+            }
+        }
+
+        //Tables have to match the direct evaluation
+        void testTable() {
+            int tabulated = 0;
+            for(int type = 1; type <= TYPES; ++type)
+                for(int drive = 0; drive < 128; drive += 21) {
+                    WaveShaper ws;
+                    ws.setup(type, drive, 64, 32);
+                    TS_ASSERT(!ws.tabulated());
+                    WaveShaper::Table *table = setup(ws, type, drive, 1);
+                    TS_ASSERT(!ws.needstable());
+                    if(!ws.tabulated()) {
+                        delete table;
+                        continue;
+                    }
+                    tabulated++;
+
+                    float a[BUF], b[BUF];
+                    for(int i = 0; i < BUF; ++i)
+                        a[i] = b[i] = 5.0f * (i - BUF / 2) / BUF;
+                    ws.shape(BUF, a);
+                    waveShapeSmps(BUF, b, type, drive, 64, 32);
+                    float err = 0.0f;
+                    for(int i = 0; i < BUF; ++i)
+                        err = fmaxf(err, fabsf(a[i] - b[i]));
+                    TS_ASSERT(err < WaveShaper::table_error);
+
+                    //a table for other parameters is not used
+                    ws.setup(type, drive + 1, 64, 32);
+                    TS_ASSERT(!ws.tabulated());
+                    TS_ASSERT(ws.needstable());
+                    delete table;
+                }
+            TS_ASSERT(tabulated > 0);
+        }
+
+        //Oversampling has to reduce aliasing for each type
+        void testAliasing() {
+            static float base[N], over[N];
+            printf("# type  table  alias 1x[dB]  alias 4x[dB]\n");
+            for(int type = 1; type <= TYPES; ++type) {
+                WaveShaper ws1, ws4;
+                WaveShaper::Table *t1 = setup(ws1, type, 90, 1);
+                WaveShaper::Table *t4 = setup(ws4, type, 90, 4);
+                run(ws1, base);
+                run(ws4, over);
+                const float a1 = aliasing(base);
+                const float a4 = aliasing(over);
+                printf("# %4d  %5s  %12.1f  %12.1f\n", type,
+                       ws1.tabulated() ? "yes" : "no",
+                       10 * log10f(a1 + 1e-12f), 10 * log10f(a4 + 1e-12f));
+                TS_ASSERT(a4 <= a1 * 1.1f + 1e-6f);
+                delete t1;
+                delete t4;
+            }
+        }
+
+        void testSpeed() {
+            const int reps = 2000;
+            float     in[BUF], buf[BUF];
+            sine(in, BUF, 0);
+            printf("# type  direct[ms]  shaper 1x[ms]  shaper 4x[ms]\n");
+            for(int type = 1; type <= TYPES; ++type) {
+                WaveShaper ws1, ws4;
+                WaveShaper::Table *t1 = setup(ws1, type, 60, 1);
+                WaveShaper::Table *t4 = setup(ws4, type, 60, 4);
+                double t[3];
+                for(int m = 0; m < 3; ++m) {
+                    const clock_t t_on = clock();
+                    for(int r = 0; r < reps; ++r) {
+                        memcpy(buf, in, sizeof(buf));
+                        if(m == 0)
+                            waveShapeSmps(BUF, buf, type, 60, 64, 32);
+                        else
+                            (m == 1 ? ws1 : ws4).shape(BUF, buf);
+                    }
+                    t[m] = 1000.0 * (clock() - t_on) / CLOCKS_PER_SEC;
+                }
+                printf("# %4d  %10.2f  %13.2f  %13.2f\n", type, t[0], t[1],
+                       t[2]);
+                delete t1;
+                delete t4;
+            }
+        }
+};
+
+int main()
+{
+    tap_quiet = 1;
+    WaveShaperTest test;
+    RUN_TEST(testTable);
+    RUN_TEST(testAliasing);
+    RUN_TEST(testSpeed);
+    return test_summary();
+}
@@ -12,7 +12,13 @@
 */
 #include "test-suite.h"
 #include "../Misc/XMLwrapper.h"
+#include "../Misc/XmlDocument.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
 #include <string>
+#include <vector>
 #include "../globals.h"
 using namespace std;
 using namespace zyn;
@@ -36,8 +42,58 @@ class XMLwrapperTest
         //here to verify that no leaks occur
         void testLoad() {
             string location = string(SOURCE_DIR) + string(
-                "/Tests/guitar-adnote.xmz");
-            xmla->loadXMLfile(location);
+                "/guitar-adnote.xmz");
+            TS_ASSERT_EQUAL_INT(xmla->loadXMLfile(location), 0);
+        }
+
+        void testRead() {
+            string location = string(SOURCE_DIR) + string(
+                "/guitar-adnote.xmz");
+            TS_ASSERT_EQUAL_INT(xmla->loadXMLfile(location), 0);
+            TS_ASSERT(xmla->hasPadSynth());
+            TS_ASSERT(xmla->enterbranch("MASTER"));
+            TS_ASSERT(xmla->enterbranch("PART", 0));
+            TS_ASSERT_EQUAL_INT(xmla->getbranchid(0, 0), 0);
+            TS_ASSERT(xmla->enterbranch("INSTRUMENT"));
+            TS_ASSERT(xmla->enterbranch("INFO"));
+            TS_ASSERT(xmla->getparstr("name", "") == "Dist Guitar 2");
+            TS_ASSERT(xmla->getparstr("author", "none") == "none");
+            xmla->exitbranch();
+            TS_ASSERT(xmla->enterbranch("INSTRUMENT_KIT"));
+            TS_ASSERT(xmla->enterbranch("INSTRUMENT_KIT_ITEM", 0));
+            TS_ASSERT_EQUAL_INT(xmla->getparbool("enabled", 0), 1);
+            TS_ASSERT_EQUAL_INT(xmla->getpar127("max_key", 0), 127);
+            TS_ASSERT_EQUAL_INT(xmla->getpar127("missing", 12), 12);
+            TS_ASSERT(xmla->enterbranch("ADD_SYNTH_PARAMETERS"));
+            TS_ASSERT(xmla->enterbranch("AMPLITUDE_PARAMETERS"));
+            TS_ASSERT(xmla->hasparreal("volume"));
+            TS_ASSERT_DELTA(xmla->getparreal("volume", 0.0f), -2.3338f, 0.0001f);
+            TS_ASSERT(!xmla->enterbranch("FOO"));
+            xmla->exitbranch();
+            xmla->exitbranch();
+            xmla->exitbranch();
+            TS_ASSERT(!xmla->enterbranch("INSTRUMENT_KIT_ITEM", 200));
+            TS_ASSERT(xmla->enterbranch("INSTRUMENT_KIT_ITEM", 1));
+        }
+
+        //A written and compressed tree has to read back the same
+        void testSaveLoad() {
+            const char *filename = "XMLwrapperTest.xmz";
+            xmla->beginbranch("BRANCH", 3);
+            xmla->addpar("par", -42);
+            xmla->addparbool("bool", 1);
+            xmla->addparreal("real", 0.125f);
+            xmla->addparstr("str", "a < b & c");
+            xmla->endbranch();
+            TS_ASSERT_EQUAL_INT(xmla->saveXMLfile(filename, 6), 0);
+
+            TS_ASSERT_EQUAL_INT(xmlb->loadXMLfile(filename), 0);
+            TS_ASSERT(xmlb->enterbranch("BRANCH", 3));
+            TS_ASSERT_EQUAL_INT(xmlb->getpar("par", 0, -100, 100), -42);
+            TS_ASSERT_EQUAL_INT(xmlb->getparbool("bool", 0), 1);
+            TS_ASSERT(xmlb->getparreal("real", 0.0f) == 0.125f);
+            TS_ASSERT(xmlb->getparstr("str", "") == "a < b & c");
+            remove(filename);
         }
 
         void testAnotherLoad()
@@ -51,6 +107,95 @@ version-revision=\"1\" ZynAddSubFX-author=\"Nasca Octavian Paul\">\n\
             xmlb->putXMLdata(dat.c_str());
         }
 
+        //Lookups in the index of an element with many children
+        void testFind() {
+            string data = "<list>";
+            for(int i = 0; i < 16; ++i)
+                data += "<par name=\"p" + to_string(i) + "\" id=\""
+                        + to_string(i) + "\" value=\"" + to_string(2 * i)
+                        + "\"/>";
+            //the value of one attribute appears in the other one first
+            data += "<par id=\"dual\"/><par name=\"dual\"/><other/></list>";
+            XmlDocument doc;
+            doc.setData(data.c_str());
+            TS_ASSERT(doc.parse());
+            const XmlElement *list = doc.findElement("list");
+            TS_ASSERT(list != NULL);
+            if(!list)
+                return;
+
+            TS_ASSERT(list->find("par") == list->child);
+            TS_ASSERT(list->find("other") != NULL);
+            TS_ASSERT(!list->find("missing"));
+            const XmlElement *e = list->find("par", "name", "p7");
+            TS_ASSERT(e && !strcmp(e->attr("id"), "7"));
+            e = list->find("par", "id", "12");
+            TS_ASSERT(e && !strcmp(e->attr("name"), "p12"));
+            TS_ASSERT(!list->find("par", "name", "p16"));
+            TS_ASSERT(!list->find("par", "id", "p7"));
+            TS_ASSERT(!list->find("other", "name", "p7"));
+            e = list->find("par", "name", "dual");
+            TS_ASSERT(e && !e->attr("id"));
+            e = list->find("par", "id", "dual");
+            TS_ASSERT(e && !e->attr("name"));
+            //other attributes are not indexed
+            e = list->find("par", "value", "10");
+            TS_ASSERT(e && !strcmp(e->attr("name"), "p5"));
+        }
+
+        static void findfiles(string dirname, vector<string> &files)
+        {
+            DIR *dir = opendir(dirname.c_str());
+            if(dir == NULL)
+                return;
+
+            struct dirent *fn;
+            while((fn = readdir(dir))) {
+                const char *filename = fn->d_name;
+                const size_t len     = strlen(filename);
+                if(fn->d_type == DT_DIR) {
+                    if(strcmp(filename, ".") && strcmp(filename, ".."))
+                        findfiles(dirname + "/" + filename, files);
+                }
+                else if(len > 4 && !strcmp(filename + len - 4, ".xiz"))
+                    files.push_back(dirname + "/" + filename);
+            }
+            closedir(dir);
+        }
+
+        //Load and walk all instruments of the banks, which is what a bank
+        //scan does
+        void testLoadBanks() {
+            vector<string> files;
+            findfiles(string(SOURCE_DIR) + "/../../instruments/banks", files);
+            if(files.empty()) {
+                printf("XMLwrapperTest: no instrument banks found, skipped\n");
+                return;
+            }
+
+            int    failed   = 0;
+            size_t children = 0;
+            const clock_t t_on = clock();
+            for(auto &f:files) {
+                XMLwrapper xml;
+                if(xml.loadXMLfile(f) != 0) {
+                    ++failed;
+                    continue;
+                }
+                xml.hasPadSynth();
+                if(xml.enterbranch("INSTRUMENT")) {
+                    children += xml.getBranch().size();
+                    xml.exitbranch();
+                }
+            }
+            const float t = (float)(clock() - t_on) / CLOCKS_PER_SEC;
+            printf("XMLwrapperTest: %d instruments loaded in %f seconds, "
+                   "%f ms per instrument\n", (int)files.size(), t,
+                   1000.0f * t / files.size());
+            TS_ASSERT_EQUAL_INT(failed, 0);
+            TS_ASSERT(children > 0);
+        }
+
         void tearDown() {
             delete xmla;
             delete xmlb;
@@ -67,7 +212,11 @@ int main()
     XMLwrapperTest test;
     RUN_TEST(testAddPar);
     RUN_TEST(testLoad);
+    RUN_TEST(testRead);
+    RUN_TEST(testSaveLoad);
     RUN_TEST(testAnotherLoad);
+    RUN_TEST(testFind);
+    RUN_TEST(testLoadBanks);
     return test_summary();
 }
 
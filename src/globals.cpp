@@ -12,11 +12,22 @@
   of the License, or (at your option) any later version.
 */
 
+#include "Misc/Denormals.h"
 #include "Misc/Util.h"
 #include "globals.h"
 
 namespace zyn {
 
+int SYNTH_T::controlperiod(void) const
+{
+    if(controlsize <= 0 || controlsize >= buffersize)
+        return buffersize;
+    int period = controlsize;
+    while(buffersize % period)
+        --period;
+    return period;
+}
+
 void SYNTH_T::alias(bool randomize)
 {
     halfsamplerate_f = (samplerate_f = samplerate) / 2.0f;
@@ -27,9 +38,10 @@ void SYNTH_T::alias(bool randomize)
     //produce denormal buf
     // note: once there will be more buffers, use a cleanup function
     // for deleting the buffers and also call it in the dtor
+    // The noise is only needed if denormals can not be flushed in hardware
     denormalkillbuf.resize(buffersize);
     for(int i = 0; i < buffersize; ++i)
-        if(randomize)
+        if(randomize && !ZYN_FLUSH_DENORMALS)
             denormalkillbuf[i] = (RND - 0.5f) * 1e-16;
         else
             denormalkillbuf[i] = 0;
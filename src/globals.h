@@ -309,7 +309,7 @@ public:
 struct SYNTH_T {
 
     SYNTH_T(void)
-        :samplerate(44100), buffersize(256), oscilsize(1024)
+        :samplerate(44100), buffersize(256), controlsize(0), oscilsize(1024)
     {
         alias(false);
     }
@@ -335,6 +335,14 @@ struct SYNTH_T {
      */
     int buffersize;
 
+    /**
+     * The number of samples after which notes update their envelopes, LFOs
+     * and filters. Buffers are split into such control periods, so large
+     * buffers do not coarsen the modulation.
+     * 0 updates once per buffer.
+     */
+    int controlsize;
+
     /**
      * The size of ADnote Oscillator
      * Decrease this => poor quality
@@ -353,6 +361,9 @@ struct SYNTH_T {
     {
         return buffersize_f / samplerate_f;
     }
+    /**@return the control period, the largest divisor of buffersize which
+     * is not above controlsize*/
+    int controlperiod(void) const;
     void alias(bool randomize=true);
     static float numRandom(void); //defined in Util.cpp for now
 };
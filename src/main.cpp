@@ -241,6 +241,7 @@ int main(int argc, char *argv[])
     synth.samplerate = config.cfg.SampleRate;
     synth.buffersize = config.cfg.SoundBufferSize;
     synth.oscilsize  = config.cfg.OscilSize;
+    synth.controlsize = config.cfg.ControlSize;
     swaplr = config.cfg.SwapStereo;
     compr = config.cfg.AudioOutputCompressor;
 
@@ -275,6 +276,9 @@ int main(int argc, char *argv[])
         {
             "oscil-size", 2, NULL, 'o'
         },
+        {
+            "control-size", 2, NULL, 'c'
+        },
         {
             "swap", 2, NULL, 'S'
         },
@@ -354,7 +358,7 @@ int main(int argc, char *argv[])
         /**\todo check this process for a small memory leak*/
         opt = getopt_long(argc,
                           argv,
-                          "l:L:M:r:b:o:I:O:N:e:P:A:d:D:hvapSDUYZ",
+                          "l:L:M:r:b:o:c:I:O:N:e:P:A:d:D:hvapSDUYZ",
                           opts,
                           &option_index);
         char *optarguments = optarg;
@@ -424,6 +428,14 @@ int main(int argc, char *argv[])
                     "synth.oscilsize is wrong (must be 2^n) or too small. Adjusting to "
                     << synth.oscilsize << "." << endl;
                 break;
+            case 'c':
+                GETOPNUM(synth.controlsize);
+                if(synth.controlsize < 0) {
+                    cerr << "ERROR:Incorrect control size: " << optarguments
+                         << endl;
+                    exit(1);
+                }
+                break;
             case 'S':
                 swaplr = 1;
                 break;
@@ -516,6 +528,8 @@ int main(int argc, char *argv[])
                  <<
             "  -b BS, --buffer-size=SR\t\t Set the buffer size (granularity)\n"
                  << "  -o OS, --oscil-size=OS\t\t Set the ADsynth oscil. size\n"
+                 << "  -c CS, --control-size=CS\t\t Set the samples between note\n"
+                 << "\t\t\t\t\t modulation updates (0 for every buffer)\n"
                  << "  -S , --swap\t\t\t\t Swap Left <--> Right\n"
                  <<
             "  -U , --no-gui\t\t\t\t Run ZynAddSubFX without user interface\n"
@@ -559,6 +573,7 @@ int main(int argc, char *argv[])
     cerr << std::fixed;
     cerr << "\nSample Rate = \t\t" << synth.samplerate << endl;
     cerr << "Sound Buffer Size = \t" << synth.buffersize << " samples" << endl;
+    cerr << "Control Period = \t" << synth.controlperiod() << " samples" << endl;
     cerr << "Internal latency = \t" << synth.dt() * 1000.0f << " ms" << endl;
     cerr << "ADsynth Oscil.Size = \t" << synth.oscilsize << " samples" << endl;
 
@@ -802,7 +817,14 @@ int main(int argc, char *argv[])
 #if USE_NSM
 done:
 #endif
-        GUI::tickUi(gui);
+#if defined(FLTK_GUI) || defined(NTK_GUI)
+        if(!noui)
+            GUI::tickUi(gui);
+        else
+#endif
+            //Sleep until the backend, another thread or an OSC client
+            //has something for us
+            middleware->waitForEvents(100);
 #endif // !WIN32
         middleware->tick();
 #ifdef WIN32